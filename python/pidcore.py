@@ -0,0 +1,246 @@
+"""Python bindings of the pidcore library.
+
+Wraps the C ABI of src/PidCore.h with ctypes. The batch entry points take
+NumPy arrays of CTE and speed and write steering and throttle into NumPy
+arrays in place: contiguous float64 arrays are passed to the library without
+copying, and the library runs without holding the GIL. The scalar entry
+points work without NumPy.
+
+The library is quiet by default; set_logging(True) logs tuning progress to
+the standard output.
+
+The library is looked up in $PIDCORE_LIBRARY, next to this module, then on
+the system library path, e.g.
+
+    PIDCORE_LIBRARY=build/libpidcore.so python3 -c "import pidcore"
+"""
+
+import ctypes
+import ctypes.util
+import os
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+# Version of the ABI these bindings are written against
+VERSION = 3
+
+_double_p = ctypes.POINTER(ctypes.c_double)
+
+
+def _load_library():
+    candidates = []
+    if os.environ.get("PIDCORE_LIBRARY"):
+        candidates.append(os.environ["PIDCORE_LIBRARY"])
+    here = os.path.dirname(os.path.abspath(__file__))
+    candidates += [os.path.join(here, name)
+                   for name in ("libpidcore.so", "libpidcore.dylib")]
+    found = ctypes.util.find_library("pidcore")
+    if found:
+        candidates.append(found)
+    for candidate in candidates:
+        if os.path.exists(candidate) or candidate == found:
+            return ctypes.CDLL(candidate)
+    raise OSError("pidcore library not found, set PIDCORE_LIBRARY")
+
+
+_lib = _load_library()
+_lib.pidcore_get_version.restype = ctypes.c_int
+_lib.pidcore_set_logging.argtypes = [ctypes.c_int]
+_lib.pidcore_session_create.restype = ctypes.c_void_p
+_lib.pidcore_session_create.argtypes = [ctypes.c_double] * 4
+_lib.pidcore_session_create_tuning.restype = ctypes.c_void_p
+_lib.pidcore_session_create_tuning.argtypes = [ctypes.c_double] * 8
+_lib.pidcore_session_destroy.argtypes = [ctypes.c_void_p]
+_lib.pidcore_session_update.restype = ctypes.c_int
+_lib.pidcore_session_update.argtypes = [ctypes.c_void_p, ctypes.c_double,
+                                        ctypes.c_double, _double_p, _double_p]
+_lib.pidcore_session_update_batch.restype = ctypes.c_size_t
+_lib.pidcore_session_update_batch.argtypes = [
+    ctypes.c_void_p, _double_p, _double_p, ctypes.c_size_t, _double_p,
+    _double_p]
+_lib.pidcore_sessions_update.restype = ctypes.c_size_t
+_lib.pidcore_sessions_update.argtypes = [
+    ctypes.POINTER(ctypes.c_void_p), _double_p, _double_p, ctypes.c_size_t,
+    _double_p, _double_p]
+_lib.pidcore_session_get_coefficients.argtypes = [ctypes.c_void_p, _double_p]
+_lib.pidcore_session_add_shadow.restype = ctypes.c_int
+_lib.pidcore_session_add_shadow.argtypes = [ctypes.c_void_p] + \
+    [ctypes.c_double] * 3
+_lib.pidcore_session_get_shadow_statistics.restype = ctypes.c_int
+_lib.pidcore_session_get_shadow_statistics.argtypes = [
+    ctypes.c_void_p, ctypes.c_size_t, _double_p]
+_lib.pidcore_twiddler_create.restype = ctypes.c_void_p
+_lib.pidcore_twiddler_create.argtypes = [_double_p, _double_p, ctypes.c_size_t]
+_lib.pidcore_twiddler_destroy.argtypes = [ctypes.c_void_p]
+_lib.pidcore_twiddler_update.argtypes = [ctypes.c_void_p, ctypes.c_double,
+                                         _double_p]
+
+if _lib.pidcore_get_version() < VERSION:
+    raise OSError("pidcore library is older than the bindings")
+
+
+def set_logging(enabled):
+    """Sets whether sessions log tuning progress to the standard output."""
+    _lib.pidcore_set_logging(1 if enabled else 0)
+
+
+def _input(values, n=None):
+    """Gets a contiguous float64 array, copying only if it isn't one."""
+    if np is None:
+        raise ImportError("the batch entry points require NumPy")
+    array = np.ascontiguousarray(values, dtype=np.float64)
+    if array.ndim != 1 or (n is not None and array.size != n):
+        raise ValueError("expected a 1-D array of %s values" % (n or "any"))
+    return array
+
+
+def _output(out, n):
+    """Gets an output array, new or the given one if it can be written in
+    place."""
+    if np is None:
+        raise ImportError("the batch entry points require NumPy")
+    if out is None:
+        return np.empty(n, dtype=np.float64)
+    if (not isinstance(out, np.ndarray) or out.dtype != np.float64
+            or out.shape != (n,) or not out.flags.c_contiguous
+            or not out.flags.writeable):
+        raise ValueError("output must be a writable contiguous float64 array "
+                         "of %d values" % n)
+    return out
+
+
+def _pointer(array):
+    return array.ctypes.data_as(_double_p)
+
+
+class Session(object):
+    """Controller session, final or tuning PID coefficients."""
+
+    def __init__(self, kp, ki, kd, off_track_cte):
+        self._handle = _lib.pidcore_session_create(kp, ki, kd, off_track_cte)
+        if not self._handle:
+            raise ValueError("invalid session arguments")
+
+    @classmethod
+    def tuning(cls, kp, ki, kd, off_track_cte, dkp, dki, dkd, track_length):
+        """Creates a session tuning the coefficients by Twiddle."""
+        session = cls.__new__(cls)
+        session._handle = _lib.pidcore_session_create_tuning(
+            kp, ki, kd, off_track_cte, dkp, dki, dkd, track_length)
+        if not session._handle:
+            raise ValueError("invalid session arguments")
+        return session
+
+    def close(self):
+        if self._handle:
+            _lib.pidcore_session_destroy(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def update(self, cte, speed):
+        """Updates with a frame, returns (steering, throttle), or None to
+        reset the simulator."""
+        steering = ctypes.c_double()
+        throttle = ctypes.c_double()
+        if not _lib.pidcore_session_update(self._handle, cte, speed,
+                                           ctypes.byref(steering),
+                                           ctypes.byref(throttle)):
+            return None
+        return steering.value, throttle.value
+
+    def update_batch(self, cte, speed, steering=None, throttle=None):
+        """Updates with consecutive frames, returns (steering, throttle)
+        arrays, NaN where the simulator is reset."""
+        cte = _input(cte)
+        speed = _input(speed, cte.size)
+        steering = _output(steering, cte.size)
+        throttle = _output(throttle, cte.size)
+        _lib.pidcore_session_update_batch(self._handle, _pointer(cte),
+                                          _pointer(speed), cte.size,
+                                          _pointer(steering),
+                                          _pointer(throttle))
+        return steering, throttle
+
+    @property
+    def coefficients(self):
+        """Current Kp, Ki and Kd."""
+        coefficients = (ctypes.c_double * 3)()
+        _lib.pidcore_session_get_coefficients(self._handle, coefficients)
+        return tuple(coefficients)
+
+    def add_shadow(self, kp, ki, kd):
+        """Adds a shadow candidate run on the same CTE without actuating."""
+        if not _lib.pidcore_session_add_shadow(self._handle, kp, ki, kd):
+            raise ValueError("no shadow candidates on this session")
+
+    def shadow_statistics(self, i):
+        """Gets (mean divergence, max divergence, saturation rate) of a
+        shadow candidate."""
+        statistics = (ctypes.c_double * 3)()
+        if not _lib.pidcore_session_get_shadow_statistics(self._handle, i,
+                                                          statistics):
+            raise IndexError("no shadow candidate %d" % i)
+        return tuple(statistics)
+
+
+class Fleet(object):
+    """Sessions with final PID coefficients updated in lockstep, one frame
+    of every session per update."""
+
+    def __init__(self, n, kp, ki, kd, off_track_cte):
+        self._sessions = [Session(kp, ki, kd, off_track_cte)
+                          for _ in range(n)]
+        self._handles = (ctypes.c_void_p * n)(
+            *[session._handle for session in self._sessions])
+
+    def __len__(self):
+        return len(self._sessions)
+
+    def update(self, cte, speed, steering=None, throttle=None):
+        """Updates every session with its frame, returns (steering,
+        throttle) arrays."""
+        n = len(self._sessions)
+        cte = _input(cte, n)
+        speed = _input(speed, n)
+        steering = _output(steering, n)
+        throttle = _output(throttle, n)
+        _lib.pidcore_sessions_update(self._handles, _pointer(cte),
+                                     _pointer(speed), n, _pointer(steering),
+                                     _pointer(throttle))
+        return steering, throttle
+
+
+class Twiddler(object):
+    """Twiddle tuner with the ask/tell protocol."""
+
+    def __init__(self, p, dp):
+        p = _input(p)
+        dp = _input(dp, p.size)
+        self._size = p.size
+        self._handle = _lib.pidcore_twiddler_create(_pointer(p), _pointer(dp),
+                                                    p.size)
+        if not self._handle:
+            raise ValueError("invalid tuner arguments")
+
+    def __del__(self):
+        if self._handle:
+            _lib.pidcore_twiddler_destroy(self._handle)
+            self._handle = None
+
+    def update(self, error):
+        """Reports the error of the current parameters, returns the next
+        ones."""
+        p = np.empty(self._size, dtype=np.float64)
+        _lib.pidcore_twiddler_update(self._handle, error, _pointer(p))
+        return p
@@ -0,0 +1,80 @@
+#include "AsyncLogger.h"
+#include <iostream>
+#include <utility>
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+AsyncLogger::AsyncLogger(std::ostream& os)
+  : os_(os),
+    is_quiet_(false),
+    n_queued_(),
+    n_written_(),
+    is_stopping_(false) {
+  // Empty.
+}
+
+AsyncLogger::~AsyncLogger() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  queued_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void AsyncLogger::Log(std::string line) {
+  if (is_quiet_) {
+    return;
+  }
+  if (!line.empty() && line.back() == '\n') {
+    line.pop_back();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!thread_.joinable()) {
+      thread_ = std::thread(&AsyncLogger::Run, this);
+    }
+    lines_.push_back(std::move(line));
+    ++n_queued_;
+  }
+  queued_.notify_one();
+}
+
+void AsyncLogger::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto n_queued = n_queued_;
+  written_.wait(lock, [this, n_queued]() { return n_written_ >= n_queued; });
+}
+
+AsyncLogger& AsyncLogger::GetDefault() {
+  static AsyncLogger logger(std::cout);
+  return logger;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void AsyncLogger::Run() {
+  std::vector<std::string> lines;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    queued_.wait(lock, [this]() { return !lines_.empty() || is_stopping_; });
+    if (lines_.empty()) {
+      return;
+    }
+    // Write the lines without the lock, the callers keep queuing meanwhile
+    lines.swap(lines_);
+    lock.unlock();
+    for (const auto& line : lines) {
+      os_ << line << '\n';
+    }
+    os_.flush();
+    lock.lock();
+    n_written_ += lines.size();
+    lines.clear();
+    written_.notify_all();
+  }
+}
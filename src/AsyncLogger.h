@@ -0,0 +1,76 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Logger writing lines to a stream from a background thread, so a caller on
+// the connection path only moves the line into a queue under a short lock and
+// never blocks on the stream. The thread starts with the first line, so a
+// quiet logger never starts it.
+class AsyncLogger {
+public:
+  // Constructor.
+  // @param os  Stream to write the lines to
+  explicit AsyncLogger(std::ostream& os);
+
+  // Destructor, writes the queued lines and stops the background thread.
+  ~AsyncLogger();
+
+  AsyncLogger(const AsyncLogger&) = delete;
+  AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+  // Queues a line, or several ones separated by ends of line, e.g. printed
+  // statistics. The end of line of the last one is optional.
+  // @param line  Line
+  void Log(std::string line);
+
+  // Waits until all queued lines are written.
+  void Flush();
+
+  // Sets whether lines are dropped, e.g. while a benchmark measures or in a
+  // library embedded by a host.
+  // @param is_quiet  Indicates lines are dropped
+  void SetQuiet(bool is_quiet) { is_quiet_ = is_quiet; }
+
+  // Gets the process-wide logger writing to the standard output.
+  static AsyncLogger& GetDefault();
+
+private:
+  // Stream to write the lines to
+  std::ostream& os_;
+
+  // Indicates lines are dropped
+  std::atomic<bool> is_quiet_;
+
+  // Guards all members below
+  std::mutex mutex_;
+
+  // Signals queued lines or stopping to the background thread, and written
+  // lines to flushing callers
+  std::condition_variable queued_;
+  std::condition_variable written_;
+
+  // Lines not taken by the background thread yet
+  std::vector<std::string> lines_;
+
+  // Number of lines queued and written since the start
+  unsigned long int n_queued_;
+  unsigned long int n_written_;
+
+  // Indication whether the background thread should stop
+  bool is_stopping_;
+
+  // Background thread, started with the first line
+  std::thread thread_;
+
+  // Writes the queued lines until stopped.
+  void Run();
+};
+
+#endif // ASYNC_LOGGER_H
@@ -0,0 +1,262 @@
+#include "BayesOptimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Kernel length scale in normalized units
+const auto kLengthScale = 0.2;
+
+// Observation noise relative to the prior variance
+const auto kNoise = 1e-4;
+
+// Smallest error taken into account, since the logarithm is modelled
+const auto kMinError = 1e-12;
+
+// Number of candidates evaluated by every thread
+const auto kCandidatesPerThread = 1024;
+
+// Standard deviation of candidates around the best point in normalized units
+const auto kLocalSearchDeviation = 0.05;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Computes the CDF of the standard normal distribution.
+double NormalCdf(double z) {
+  return 0.5 * std::erfc(-z / std::sqrt(2.));
+}
+
+// Computes the PDF of the standard normal distribution.
+double NormalPdf(double z) {
+  return std::exp(-0.5 * z * z) / std::sqrt(2. * M_PI);
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+BayesOptimizer::BayesOptimizer(const ParameterSequence& parameters,
+                               unsigned int n_threads,
+                               unsigned int seed,
+                               size_t max_observations)
+  : parameters_(parameters),
+    best_parameters_(parameters),
+    best_error_(std::numeric_limits<double>::infinity()),
+    pending_(parameters.size(), 0.5),
+    y_mean_(),
+    y_scale_(1.),
+    n_threads_(n_threads ? n_threads
+                         : std::max(1u, std::thread::hardware_concurrency())),
+    seed_(seed),
+    max_observations_(max_observations) {
+  for (size_t i = 0; i < parameters.size(); ++i) {
+    const auto& parameter = parameters[i];
+    auto lower = parameter.p - kSearchRadius * std::fabs(parameter.dp);
+    auto upper = parameter.p + kSearchRadius * std::fabs(parameter.dp);
+    // The search box is clipped to the feasible range, so every candidate is
+    // feasible, and values of the log scale stay positive
+    if (parameter.lower != parameter.upper) {
+      lower = std::max(lower, std::min(parameter.lower, parameter.p));
+      upper = std::min(upper, std::max(parameter.upper, parameter.p));
+    } else if (parameter.transform != Transform::kLinear) {
+      lower = std::max(lower, std::min(0., parameter.p));
+    }
+    lower_.push_back(lower);
+    size_.push_back(upper - lower);
+    if (upper > lower) {
+      pending_[i] = (parameter.p - lower) / (upper - lower);
+    }
+  }
+}
+
+Tuner::ParameterSequence BayesOptimizer::UpdateError(double error) {
+  if (parameters_.empty()) {
+    return parameters_;
+  }
+  if (error < best_error_) {
+    best_error_ = error;
+    best_parameters_ = parameters_;
+  }
+  if (max_observations_ > 0 && y_.size() >= max_observations_) {
+    DropObservation();
+  }
+  AddObservation(pending_, std::log(std::max(error, kMinError)));
+
+  if (y_.size() < GetDimensions() + 2) {
+    // Initial design is random
+    std::mt19937 rng(seed_++);
+    std::uniform_real_distribution<double> uniform;
+    for (auto& x : pending_) {
+      x = uniform(rng);
+    }
+  } else {
+    pending_ = MaximizeExpectedImprovement();
+  }
+  SetParameters(pending_);
+  return parameters_;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+double BayesOptimizer::Kernel(const double* a, const double* b) const {
+  auto distance2 = 0.;
+  for (size_t i = 0; i < GetDimensions(); ++i) {
+    distance2 += (a[i] - b[i]) * (a[i] - b[i]);
+  }
+  return std::exp(-0.5 * distance2 / (kLengthScale * kLengthScale));
+}
+
+void BayesOptimizer::AddObservation(const std::vector<double>& x, double y) {
+  assert(x.size() == GetDimensions());
+  // New row l of the factor solves L * l = k, and its diagonal element is
+  // sqrt(k(x, x) + noise - l * l)
+  auto n = y_.size();
+  auto row = cholesky_.size();
+  auto sum2 = 0.;
+  for (size_t i = 0; i < n; ++i) {
+    auto value = Kernel(&x_[i * GetDimensions()], x.data());
+    const auto* l = &cholesky_[i * (i + 1) / 2];
+    for (size_t j = 0; j < i; ++j) {
+      value -= l[j] * cholesky_[row + j];
+    }
+    value /= l[i];
+    cholesky_.push_back(value);
+    sum2 += value * value;
+  }
+  cholesky_.push_back(std::sqrt(std::max(1. + kNoise - sum2, kNoise)));
+  x_.insert(x_.end(), x.begin(), x.end());
+  y_.push_back(y);
+  ++n;
+
+  // Standardize observations
+  y_mean_ = 0.;
+  for (auto value : y_) {
+    y_mean_ += value;
+  }
+  y_mean_ /= n;
+  auto variance = 0.;
+  for (auto value : y_) {
+    variance += (value - y_mean_) * (value - y_mean_);
+  }
+  y_scale_ = n > 1 && variance > 0. ? std::sqrt(variance / (n - 1)) : 1.;
+
+  // Solve L * z = y and L' * alpha = z
+  alpha_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    const auto* l = &cholesky_[i * (i + 1) / 2];
+    auto value = (y_[i] - y_mean_) / y_scale_;
+    for (size_t j = 0; j < i; ++j) {
+      value -= l[j] * alpha_[j];
+    }
+    alpha_[i] = value / l[i];
+  }
+  for (size_t i = n; i-- > 0;) {
+    auto value = alpha_[i];
+    for (auto j = i + 1; j < n; ++j) {
+      value -= cholesky_[j * (j + 1) / 2 + i] * alpha_[j];
+    }
+    alpha_[i] = value / cholesky_[i * (i + 1) / 2 + i];
+  }
+}
+
+void BayesOptimizer::DropObservation() {
+  auto best_index = static_cast<size_t>(
+    std::min_element(y_.begin(), y_.end()) - y_.begin());
+  size_t dropped = best_index == 0 && y_.size() > 1 ? 1 : 0;
+  std::vector<double> x;
+  x.swap(x_);
+  std::vector<double> y;
+  y.swap(y_);
+  cholesky_.clear();
+  std::vector<double> point(GetDimensions());
+  for (size_t i = 0; i < y.size(); ++i) {
+    if (i != dropped) {
+      std::copy(x.begin() + i * GetDimensions(),
+                x.begin() + (i + 1) * GetDimensions(), point.begin());
+      AddObservation(point, y[i]);
+    }
+  }
+}
+
+double BayesOptimizer::GetExpectedImprovement(const double* x, double best,
+                                              std::vector<double>& work) const {
+  auto n = y_.size();
+  auto mean = 0.;
+  for (size_t i = 0; i < n; ++i) {
+    work[i] = Kernel(&x_[i * GetDimensions()], x);
+    mean += work[i] * alpha_[i];
+  }
+  // Variance is k(x, x) - v * v, where L * v = k
+  auto variance = 1.;
+  for (size_t i = 0; i < n; ++i) {
+    const auto* l = &cholesky_[i * (i + 1) / 2];
+    auto value = work[i];
+    for (size_t j = 0; j < i; ++j) {
+      value -= l[j] * work[j];
+    }
+    work[i] = value / l[i];
+    variance -= work[i] * work[i];
+  }
+  auto deviation = std::sqrt(std::max(variance, 1e-12));
+  auto z = (best - mean) / deviation;
+  return (best - mean) * NormalCdf(z) + deviation * NormalPdf(z);
+}
+
+std::vector<double> BayesOptimizer::MaximizeExpectedImprovement() {
+  auto n = y_.size();
+  auto best_index = static_cast<size_t>(
+    std::min_element(y_.begin(), y_.end()) - y_.begin());
+  auto best = (y_[best_index] - y_mean_) / y_scale_;
+  const auto* best_x = &x_[best_index * GetDimensions()];
+
+  // Every thread searches its own candidates, half of them uniformly, half
+  // around the best observed point
+  std::vector<std::vector<double>> thread_x(n_threads_);
+  std::vector<double> thread_ei(n_threads_,
+                                -std::numeric_limits<double>::infinity());
+  auto search = [&](unsigned int thread) {
+    std::mt19937 rng(seed_ + thread);
+    std::uniform_real_distribution<double> uniform;
+    std::normal_distribution<double> normal(0., kLocalSearchDeviation);
+    std::vector<double> work(n);
+    std::vector<double> x(GetDimensions());
+    for (auto c = 0; c < kCandidatesPerThread; ++c) {
+      for (size_t d = 0; d < GetDimensions(); ++d) {
+        x[d] = c % 2 ? uniform(rng)
+                     : std::max(0., std::min(1., best_x[d] + normal(rng)));
+      }
+      auto ei = GetExpectedImprovement(x.data(), best, work);
+      if (ei > thread_ei[thread]) {
+        thread_ei[thread] = ei;
+        thread_x[thread] = x;
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned int thread = 1; thread < n_threads_; ++thread) {
+    threads.emplace_back(search, thread);
+  }
+  search(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  seed_ += n_threads_;
+  auto best_thread = std::max_element(thread_ei.begin(), thread_ei.end())
+                     - thread_ei.begin();
+  return thread_x[best_thread];
+}
+
+void BayesOptimizer::SetParameters(const std::vector<double>& x) {
+  for (size_t i = 0; i < parameters_.size(); ++i) {
+    parameters_[i].p = lower_[i] + x[i] * size_[i];
+  }
+}
@@ -0,0 +1,120 @@
+#ifndef BAYES_OPTIMIZER_H
+#define BAYES_OPTIMIZER_H
+
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "Tuner.h"
+
+// Bayesian optimization for expensive objectives, such as a simulator lap per
+// evaluation. The logarithm of the error is modelled by a Gaussian process with
+// a squared-exponential kernel over the parameters normalized within the
+// search box. Its Cholesky factor is extended incrementally by one row per
+// observation. The next parameters maximize the expected improvement, which is
+// searched by several threads in parallel. Its cost grows with the square of
+// the observations, so they may be limited to a window of the best and the
+// latest ones.
+class BayesOptimizer : public Tuner {
+public:
+  // Constructor.
+  // @param parameters  Initial parameters, the search box of every parameter
+  //                    is p +/- kSearchRadius * dp, clipped to its feasible
+  //                    range
+  // @param n_threads   Number of threads maximizing the expected improvement,
+  //                    0 means the number of hardware threads. Every update
+  //                    spawns and joins all but one of them, with 1 the
+  //                    search runs on the calling thread only.
+  // @param seed        Seed of the random generator
+  // @param max_observations  Max number of observations modelled, the oldest
+  //                          one but the best is dropped beyond it. 0 keeps
+  //                          all of them.
+  BayesOptimizer(const ParameterSequence& parameters,
+                 unsigned int n_threads = 0,
+                 unsigned int seed = 1,
+                 size_t max_observations = 0);
+
+  // Implements Tuner.
+  ParameterSequence UpdateError(double error) override;
+
+  // Gets the best parameters observed so far.
+  const ParameterSequence& GetBestParameters() const {
+    return best_parameters_;
+  }
+
+  // Gets the best error observed so far.
+  double GetBestError() const { return best_error_; }
+
+  // Gets the number of observed errors which are modelled.
+  size_t GetObservationCount() const { return y_.size(); }
+
+private:
+  // Search box radius in units of the parameter deltas
+  static constexpr double kSearchRadius = 10.;
+
+  // Parameters being evaluated
+  ParameterSequence parameters_;
+
+  // Best parameters and error so far
+  ParameterSequence best_parameters_;
+  double best_error_;
+
+  // Lower corner and size of the search box
+  std::vector<double> lower_;
+  std::vector<double> size_;
+
+  // Normalized point being evaluated
+  std::vector<double> pending_;
+
+  // Observed normalized points, one after another, and the log errors
+  std::vector<double> x_;
+  std::vector<double> y_;
+
+  // Lower-triangular Cholesky factor of the kernel matrix, packed by rows
+  std::vector<double> cholesky_;
+
+  // Kernel matrix inverse times standardized observations
+  std::vector<double> alpha_;
+
+  // Standardization of observations
+  double y_mean_;
+  double y_scale_;
+
+  // Number of threads maximizing the expected improvement
+  unsigned int n_threads_;
+
+  // Seed of the random generator, advanced by every search
+  unsigned int seed_;
+
+  // Max number of observations modelled, 0 if unlimited
+  size_t max_observations_;
+
+  // Gets the number of dimensions.
+  size_t GetDimensions() const { return lower_.size(); }
+
+  // Computes the kernel of two normalized points.
+  double Kernel(const double* a, const double* b) const;
+
+  // Adds an observation, extends the Cholesky factor by one row.
+  // @param x  Normalized point
+  // @param y  Log error
+  void AddObservation(const std::vector<double>& x, double y);
+
+  // Drops the oldest observation but the best one, factors the kernel matrix
+  // of the others again.
+  void DropObservation();
+
+  // Computes the expected improvement at a normalized point.
+  // @param[in]  x     Normalized point
+  // @param[in]  best  Best standardized observation
+  // @param[out] work  Scratch space of the size of observations
+  double GetExpectedImprovement(const double* x, double best,
+                                std::vector<double>& work) const;
+
+  // Finds the normalized point maximizing the expected improvement.
+  std::vector<double> MaximizeExpectedImprovement();
+
+  // Sets parameters_ from a normalized point.
+  void SetParameters(const std::vector<double>& x);
+};
+
+#endif // BAYES_OPTIMIZER_H
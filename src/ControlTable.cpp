@@ -0,0 +1,274 @@
+#include "ControlTable.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Header of the table file, occupies exactly one cache line
+struct Header {
+  char magic[8];
+  uint32_t size[ControlTable::kDimensions];
+  float min[ControlTable::kDimensions];
+  float step[ControlTable::kDimensions];
+  uint32_t n_outputs;
+  uint32_t reserved;
+};
+static_assert(sizeof(Header) == 64, "Table header must be one cache line");
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Magic bytes identifying the table file format and its version
+const char kMagic[8] = {'P', 'I', 'D', 'T', 'B', 'L', '0', '1'};
+
+// Number of outputs per grid point: steering and throttle
+const uint32_t kOutputs = 2;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the number of grid points.
+// @param[in] size  Grid size along every dimension
+size_t GetPointCount(const uint32_t size[ControlTable::kDimensions]) {
+  size_t count = 1;
+  for (auto d = 0; d < ControlTable::kDimensions; ++d) {
+    count *= size[d];
+  }
+  return count;
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+ControlTable::ControlTable()
+  : mapped_(),
+    mapped_size_(),
+    min_(),
+    inverse_step_(),
+    size_(),
+    stride_(),
+    corners_(),
+    values_() {
+  // Empty.
+}
+
+ControlTable::~ControlTable() {
+  Unload();
+}
+
+bool ControlTable::Compile(const std::string& path,
+                           const Grid& grid,
+                           const Source& source) {
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  for (auto d = 0; d < kDimensions; ++d) {
+    if (grid.size[d] < 2 || !(grid.max[d] > grid.min[d])) {
+      return false;
+    }
+    header.size[d] = grid.size[d];
+    header.min[d] = static_cast<float>(grid.min[d]);
+    header.step[d] = static_cast<float>((grid.max[d] - grid.min[d])
+                                        / (grid.size[d] - 1));
+  }
+  header.n_outputs = kOutputs;
+
+  // The last dimension is the fastest changing one
+  std::vector<float> values(kOutputs * GetPointCount(grid.size));
+  uint32_t index[kDimensions] = {};
+  double point[kDimensions];
+  for (size_t i = 0; i < values.size(); i += kOutputs) {
+    for (auto d = 0; d < kDimensions; ++d) {
+      point[d] = grid.min[d] + index[d] * (grid.max[d] - grid.min[d])
+                               / (grid.size[d] - 1);
+    }
+    auto steering = 0.;
+    auto throttle = 0.;
+    source(point, steering, throttle);
+    values[i] = static_cast<float>(steering);
+    values[i + 1] = static_cast<float>(throttle);
+    for (auto d = kDimensions - 1; d >= 0; --d) {
+      if (++index[d] < grid.size[d]) {
+        break;
+      }
+      index[d] = 0;
+    }
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(values.data()),
+             values.size() * sizeof(float));
+  return static_cast<bool>(file);
+}
+
+bool ControlTable::Load(const std::string& path) {
+  Unload();
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  auto is_mapped = fstat(fd, &st) == 0
+    && static_cast<size_t>(st.st_size) >= sizeof(Header);
+  if (is_mapped) {
+    mapped_ = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    is_mapped = mapped_ != MAP_FAILED;
+  }
+  close(fd);
+  if (!is_mapped) {
+    mapped_ = nullptr;
+    return false;
+  }
+  mapped_size_ = st.st_size;
+
+  const auto& header = *static_cast<const Header*>(mapped_);
+  auto is_valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+    && header.n_outputs == kOutputs;
+  for (auto d = 0; d < kDimensions && is_valid; ++d) {
+    is_valid = header.size[d] >= 2 && header.step[d] > 0;
+  }
+  if (!is_valid || mapped_size_ != sizeof(Header) + kOutputs * sizeof(float)
+                                   * GetPointCount(header.size)) {
+    Unload();
+    return false;
+  }
+
+  uint32_t stride = kOutputs;
+  for (auto d = kDimensions - 1; d >= 0; --d) {
+    min_[d] = header.min[d];
+    inverse_step_[d] = 1.f / header.step[d];
+    size_[d] = header.size[d];
+    stride_[d] = stride;
+    stride *= header.size[d];
+  }
+  for (auto c = 0; c < (1 << kDimensions); ++c) {
+    corners_[c] = 0;
+    for (auto d = 0; d < kDimensions; ++d) {
+      corners_[c] += (c >> d & 1) * stride_[d];
+    }
+  }
+  values_ = reinterpret_cast<const float*>(static_cast<const char*>(mapped_)
+                                           + sizeof(Header));
+  return true;
+}
+
+void ControlTable::Evaluate(double cte, double d_cte, double sum_cte,
+                            double speed,
+                            double& steering, double& throttle) const {
+  const float point[kDimensions] = {static_cast<float>(cte),
+                                    static_cast<float>(d_cte),
+                                    static_cast<float>(sum_cte),
+                                    static_cast<float>(speed)};
+  float fraction[kDimensions];
+  uint32_t base = 0;
+  for (auto d = 0; d < kDimensions; ++d) {
+    auto x = std::max(0.f, std::min((point[d] - min_[d]) * inverse_step_[d],
+                                    static_cast<float>(size_[d] - 1)));
+    auto i = std::min(static_cast<uint32_t>(x), size_[d] - 2);
+    fraction[d] = x - i;
+    base += i * stride_[d];
+  }
+  const auto* cell = values_ + base;
+
+  // Corner c has the weight w01[c & 3] * w23[c >> 2]
+  const float w01[4] = {(1 - fraction[0]) * (1 - fraction[1]),
+                        fraction[0] * (1 - fraction[1]),
+                        (1 - fraction[0]) * fraction[1],
+                        fraction[0] * fraction[1]};
+  const float w23[4] = {(1 - fraction[2]) * (1 - fraction[3]),
+                        fraction[2] * (1 - fraction[3]),
+                        (1 - fraction[2]) * fraction[3],
+                        fraction[2] * fraction[3]};
+#ifdef __SSE2__
+  auto low = _mm_loadu_ps(w01);
+  auto sum = _mm_setzero_ps();
+  for (auto high = 0; high < 4; ++high) {
+    auto weights = _mm_mul_ps(low, _mm_set1_ps(w23[high]));
+    const auto* corners = corners_ + 4 * high;
+    // Every register holds (steering, throttle) of two corners
+    auto v01 = _mm_loadh_pi(
+      _mm_loadl_pi(_mm_setzero_ps(),
+                   reinterpret_cast<const __m64*>(cell + corners[0])),
+      reinterpret_cast<const __m64*>(cell + corners[1]));
+    auto v23 = _mm_loadh_pi(
+      _mm_loadl_pi(_mm_setzero_ps(),
+                   reinterpret_cast<const __m64*>(cell + corners[2])),
+      reinterpret_cast<const __m64*>(cell + corners[3]));
+    sum = _mm_add_ps(sum, _mm_mul_ps(v01, _mm_unpacklo_ps(weights, weights)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(v23, _mm_unpackhi_ps(weights, weights)));
+  }
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  float result[4];
+  _mm_storeu_ps(result, sum);
+  steering = result[0];
+  throttle = result[1];
+#else
+  auto s = 0.f;
+  auto t = 0.f;
+  for (auto c = 0; c < (1 << kDimensions); ++c) {
+    auto w = w01[c & 3] * w23[c >> 2];
+    s += w * cell[corners_[c]];
+    t += w * cell[corners_[c] + 1];
+  }
+  steering = s;
+  throttle = t;
+#endif
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void ControlTable::Unload() {
+  if (mapped_) {
+    munmap(mapped_, mapped_size_);
+  }
+  mapped_ = nullptr;
+  mapped_size_ = 0;
+  values_ = nullptr;
+}
+
+// TableSteering Public Members
+// -----------------------------------------------------------------------------
+
+TableSteering::TableSteering(const ControlTable& table)
+  : table_(table),
+    sum_cte_(),
+    cte_prev_(),
+    is_cte_prev_initialized_(),
+    throttle_() {
+  // Empty.
+}
+
+void TableSteering::Reset() {
+  sum_cte_ = 0;
+  cte_prev_ = 0;
+  is_cte_prev_initialized_ = false;
+  throttle_ = 0;
+}
+
+double TableSteering::ComputeSteering(double cte, double speed) {
+  sum_cte_ += cte;
+  if (!is_cte_prev_initialized_) {
+    cte_prev_ = cte;
+    is_cte_prev_initialized_ = true;
+  }
+  auto steering = 0.;
+  table_.Evaluate(cte, cte - cte_prev_, sum_cte_, speed, steering, throttle_);
+  cte_prev_ = cte;
+  return steering;
+}
@@ -0,0 +1,128 @@
+#ifndef CONTROL_TABLE_H
+#define CONTROL_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "SteeringLaw.h"
+
+// Explicit controller: steering and throttle precomputed over a regular grid
+// of (CTE, change of CTE, sum of CTE, speed), evaluated by multilinear
+// interpolation in constant time. The table is a file with a 64-byte header
+// followed by interleaved float pairs (steering, throttle), and is memory-
+// mapped for reading, so many processes share one copy.
+class ControlTable {
+public:
+  // Number of grid dimensions
+  enum { kDimensions = 4 };
+
+  // Describes the grid, dimensions are CTE, change of CTE, sum of CTE, speed
+  struct Grid {
+    double min[kDimensions];
+    double max[kDimensions];
+    uint32_t size[kDimensions];
+  };
+
+  // Source controller to sample: takes the point (CTE, change of CTE, sum of
+  // CTE, speed) and returns steering and throttle.
+  typedef std::function<void(const double point[kDimensions],
+                             double& steering, double& throttle)> Source;
+
+  // Constructor, creates an empty table.
+  ControlTable();
+
+  // Destructor, unmaps the table.
+  ~ControlTable();
+
+  ControlTable(const ControlTable&) = delete;
+  ControlTable& operator=(const ControlTable&) = delete;
+
+  // Samples the source controller over the grid and writes the table file.
+  // @param path    Path of the table file
+  // @param grid    Grid to sample, every size must be at least 2
+  // @param source  Source controller
+  // @return        True on success
+  static bool Compile(const std::string& path,
+                      const Grid& grid,
+                      const Source& source);
+
+  // Maps a table file into memory.
+  // @param path  Path of the table file
+  // @return      True on success
+  bool Load(const std::string& path);
+
+  // Indicates whether a table is loaded.
+  bool IsLoaded() const { return values_ != nullptr; }
+
+  // Gets the size of the mapped table in bytes.
+  size_t GetSize() const { return mapped_size_; }
+
+  // Evaluates the table at a point, coordinates outside the grid are clamped.
+  // @param[in]  cte       Cross-track error (CTE)
+  // @param[in]  d_cte     Change of CTE since the previous frame
+  // @param[in]  sum_cte   Sum of CTE
+  // @param[in]  speed     Speed in miles-per-hour
+  // @param[out] steering  Interpolated steering value
+  // @param[out] throttle  Interpolated throttle value
+  void Evaluate(double cte, double d_cte, double sum_cte, double speed,
+                double& steering, double& throttle) const;
+
+private:
+  // Mapped file and its size
+  void* mapped_;
+  size_t mapped_size_;
+
+  // Grid description, copied from the header
+  float min_[kDimensions];
+  float inverse_step_[kDimensions];
+  uint32_t size_[kDimensions];
+
+  // Distances in floats between neighbor grid points along each dimension
+  uint32_t stride_[kDimensions];
+
+  // Offsets in floats of the 16 corners of a grid cell
+  uint32_t corners_[1 << kDimensions];
+
+  // Interleaved steering and throttle values
+  const float* values_;
+
+  // Unmaps the table.
+  void Unload();
+};
+
+// Steering backend evaluating a ControlTable. Keeps the sum and the change of
+// CTE like Pid, and also provides the throttle of the last evaluation.
+class TableSteering : public SteeringLaw<TableSteering> {
+public:
+  // Constructor.
+  // @param table  Loaded table, must outlive this object
+  explicit TableSteering(const ControlTable& table);
+
+  // Implements SteeringLaw.
+  // @param cte    Cross-track error (CTE)
+  // @param speed  Speed in miles-per-hour
+  double ComputeSteering(double cte, double speed);
+
+  // Gets the throttle value of the last evaluation.
+  double GetThrottle() const { return throttle_; }
+
+  // Resets the sum and previous CTE, e.g. for a new simulator connection.
+  void Reset();
+
+private:
+  // Table to evaluate
+  const ControlTable& table_;
+
+  // Sum of CTE
+  double sum_cte_;
+
+  // Previous CTE and indication whether it's initialized
+  double cte_prev_;
+  bool is_cte_prev_initialized_;
+
+  // Throttle value of the last evaluation
+  double throttle_;
+};
+
+#endif // CONTROL_TABLE_H
@@ -0,0 +1,75 @@
+#include <cstdlib>
+#include <new>
+#include "StageProfiler.h"
+
+// Counting global allocator of instrumentation builds, see StageProfiler:
+// every allocation is counted for the calling thread, then served by malloc.
+
+namespace {
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Counts and allocates memory.
+// @param size  Size in bytes
+// @return      Memory, nullptr if out of memory
+void* Allocate(std::size_t size) {
+  StageProfiler::CountAllocation(size);
+  return std::malloc(size > 0 ? size : 1);
+}
+
+// Counts and allocates memory, throws if out of memory.
+// @param size  Size in bytes
+// @return      Memory
+void* AllocateOrThrow(std::size_t size) {
+  auto memory = Allocate(size);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+// Marks the allocator as linked
+const bool kIsEnabled = (StageProfiler::EnableAllocationCounting(), true);
+
+} // namespace
+
+void* operator new(std::size_t size) {
+  return AllocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size) {
+  return AllocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
@@ -0,0 +1,281 @@
+#include "Dashboard.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Number of last tuning events kept per session between messages
+const size_t kEventCapacity = 64;
+
+// Page of the dashboard: a row of CTE, steering and speed plots per session,
+// and the log of tuning events
+const std::string kPage = R"page(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>PID sessions</title>
+<style>
+body { font-family: sans-serif; margin: 1em; }
+canvas { border: 1px solid #ccc; margin: 2px; }
+#events { font-family: monospace; white-space: pre; height: 12em;
+          overflow-y: scroll; }
+</style></head>
+<body><h3>Sessions: CTE, steering, speed</h3><div id="sessions"></div>
+<h3>Tuning events</h3><div id="events"></div>
+<script>
+var kChannels = ["cte", "steering", "speed"];
+function Plot(canvas, points) {
+  var context = canvas.getContext("2d");
+  if (points.length < 2) {
+    return;
+  }
+  var values = points.map(function(p) { return p[1]; });
+  var min = Math.min.apply(null, values);
+  var max = Math.max.apply(null, values);
+  var t0 = points[0][0];
+  var t1 = points[points.length - 1][0];
+  context.beginPath();
+  points.forEach(function(p, i) {
+    var x = (p[0] - t0) / (t1 - t0 || 1) * canvas.width;
+    var y = canvas.height * (1 - (p[1] - min) / (max - min || 1));
+    i ? context.lineTo(x, y) : context.moveTo(x, y);
+  });
+  context.stroke();
+  context.fillText(min.toFixed(2) + ".." + max.toFixed(2), 2, 10);
+}
+var socket = new WebSocket("ws://" + location.host + "/dashboard");
+socket.onmessage = function(message) {
+  var data = JSON.parse(message.data);
+  var sessions = document.getElementById("sessions");
+  var events = document.getElementById("events");
+  sessions.innerHTML = "";
+  data.sessions.forEach(function(session) {
+    var row = document.createElement("div");
+    row.textContent = "#" + session.id + " ";
+    kChannels.forEach(function(channel) {
+      var canvas = document.createElement("canvas");
+      canvas.width = 300;
+      canvas.height = 80;
+      Plot(canvas, session[channel]);
+      row.appendChild(canvas);
+    });
+    sessions.appendChild(row);
+    session.events.forEach(function(event) {
+      events.textContent += "#" + session.id + " " + event.event + " "
+        + event.coefficients.join(", ") + " error " + event.error
+        + (event.full_lap ? "" : " (part of the lap)") + "\n";
+      events.scrollTop = events.scrollHeight;
+    });
+  });
+};
+</script></body></html>
+)page";
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Writes a channel downsampled as a JSON array of [time, value] pairs.
+// @param[in]  os        Output stream
+// @param[in]  times     Times of the samples
+// @param[in]  values    Values of the channel
+// @param[in]  n_points  Max number of points
+// @param[out] indices   Buffer of the kept indices
+void WriteChannel(std::ostream& os, const std::vector<double>& times,
+                  const std::vector<double>& values, size_t n_points,
+                  std::vector<size_t>& indices) {
+  Dashboard::Downsample(times.data(), values.data(), times.size(), n_points,
+                        indices);
+  os << '[';
+  for (size_t i = 0; i < indices.size(); ++i) {
+    os << (i ? ",[" : "[") << std::setprecision(3) << times[indices[i]] << ','
+       << std::setprecision(4) << values[indices[i]] << ']';
+  }
+  os << ']';
+}
+
+} // namespace
+
+constexpr size_t Dashboard::kMinPointCount;
+
+// Feed Public Members
+// -----------------------------------------------------------------------------
+
+Dashboard::Feed::Feed(uint32_t id, size_t window)
+  : id_(id),
+    samples_(window),
+    events_(kEventCapacity),
+    next_event_() {
+  // Empty.
+}
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+Dashboard::Dashboard(const Settings& settings)
+  : settings_(settings),
+    next_id_(),
+    is_watched_(false),
+    is_stopping_(false) {
+  // Empty.
+}
+
+Dashboard::~Dashboard() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  stopping_.notify_one();
+  thread_.join();
+}
+
+void Dashboard::Start(unsigned int interval_ms) {
+  thread_ = std::thread(&Dashboard::Run, this, interval_ms);
+}
+
+std::shared_ptr<const std::string> Dashboard::GetMessage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return message_;
+}
+
+std::shared_ptr<Dashboard::Feed> Dashboard::AddFeed() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  feeds_.emplace_back(new Feed(next_id_++, settings_.window));
+  return feeds_.back();
+}
+
+void Dashboard::RemoveFeed(const std::shared_ptr<Feed>& feed) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  feeds_.erase(std::remove(feeds_.begin(), feeds_.end(), feed), feeds_.end());
+}
+
+void Dashboard::Collect(std::string& message) {
+  // The feeds are collected without the lock, a removed feed lives on until
+  // collected
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collected_feeds_.assign(feeds_.begin(), feeds_.end());
+  }
+  const auto& feeds = collected_feeds_;
+  auto n_points = std::max(kMinPointCount, feeds.empty() ?
+                                           0 :
+                                           settings_.n_points / feeds.size());
+  std::ostringstream oss;
+  oss << std::fixed << "{\"sessions\":[";
+  for (size_t f = 0; f < feeds.size(); ++f) {
+    auto& feed = *feeds[f];
+    auto count = feed.samples_.GetCount();
+    samples_.clear();
+    feed.samples_.Read(count > settings_.window ? count - settings_.window : 0,
+                       samples_);
+    events_.clear();
+    feed.next_event_ = feed.events_.Read(feed.next_event_, events_);
+
+    oss << (f ? "," : "") << "{\"id\":" << feed.id_;
+    times_.clear();
+    for (const auto& sample : samples_) {
+      times_.push_back(sample.time);
+    }
+    const char* kChannels[] = {"cte", "steering", "speed"};
+    double Sample::* const kMembers[] = {&Sample::cte, &Sample::steering,
+                                         &Sample::speed};
+    for (auto c = 0; c < 3; ++c) {
+      values_.clear();
+      for (const auto& sample : samples_) {
+        values_.push_back(sample.*kMembers[c]);
+      }
+      oss << ",\"" << kChannels[c] << "\":";
+      WriteChannel(oss, times_, values_, n_points, indices_);
+    }
+    oss << ",\"events\":[";
+    for (size_t e = 0; e < events_.size(); ++e) {
+      const auto& event = events_[e];
+      oss << (e ? "," : "") << "{\"event\":\""
+          << (event.outcome ? event.outcome : "evaluated") << "\",\"time\":"
+          << std::setprecision(3) << event.time << ",\"coefficients\":["
+          << std::defaultfloat << std::setprecision(6)
+          << event.coefficients[0] << ',' << event.coefficients[1] << ','
+          << event.coefficients[2] << "],\"error\":"
+          << (std::isfinite(event.error) ? event.error : -1.)
+          << ",\"full_lap\":" << (event.is_full_lap ? "true" : "false")
+          << '}' << std::fixed;
+    }
+    oss << "]}";
+  }
+  oss << "]}";
+  message = oss.str();
+  collected_feeds_.clear();
+}
+
+void Dashboard::Downsample(const double* x, const double* y, size_t n,
+                           size_t n_out, std::vector<size_t>& indices) {
+  indices.clear();
+  if (n_out >= n || n_out < kMinPointCount) {
+    for (size_t i = 0; i < std::min(n, n_out); ++i) {
+      indices.push_back(n_out >= n || i == 0 ? i : n - 1);
+    }
+    return;
+  }
+  // Buckets of the points between the first and the last ones, the last
+  // bucket is followed by the last point alone
+  auto bucket_size = static_cast<double>(n - 2) / (n_out - 2);
+  size_t a = 0;
+  indices.push_back(a);
+  for (size_t bucket = 0; bucket < n_out - 2; ++bucket) {
+    auto is_last = bucket + 3 == n_out;
+    auto begin = static_cast<size_t>(bucket * bucket_size) + 1;
+    auto end = is_last ? n - 1 :
+               static_cast<size_t>((bucket + 1) * bucket_size) + 1;
+    auto next_end = is_last ? n : std::min(
+      static_cast<size_t>((bucket + 2) * bucket_size) + 1, n - 1);
+    auto average_x = 0.;
+    auto average_y = 0.;
+    for (auto i = end; i < next_end; ++i) {
+      average_x += x[i];
+      average_y += y[i];
+    }
+    average_x /= next_end - end;
+    average_y /= next_end - end;
+    auto max_area = -1.;
+    auto selected = begin;
+    for (auto i = begin; i < end; ++i) {
+      auto area = std::fabs((x[a] - average_x) * (y[i] - y[a])
+                            - (x[a] - x[i]) * (average_y - y[a]));
+      if (area > max_area) {
+        max_area = area;
+        selected = i;
+      }
+    }
+    indices.push_back(selected);
+    a = selected;
+  }
+  indices.push_back(n - 1);
+}
+
+const std::string& Dashboard::GetPage() {
+  return kPage;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void Dashboard::Run(unsigned int interval_ms) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                             [this]() { return is_stopping_; })) {
+    if (!is_watched_.load()) {
+      continue;
+    }
+    lock.unlock();
+    std::shared_ptr<std::string> message(new std::string());
+    Collect(*message);
+    lock.lock();
+    message_ = std::move(message);
+  }
+}
@@ -0,0 +1,184 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TelemetryRing.h"
+
+// Live feed of the sessions for the viewers of the dashboard. The control path
+// of a session only writes its samples and tuning events to the lock-free
+// rings of its Feed. Periodically a background thread collects one message for
+// all viewers: the last window of every session downsampled by
+// Largest-Triangle-Three-Buckets (LTTB), and the events since the previous
+// message, so a message is bounded regardless of the frame rate and neither
+// viewers nor collecting touch the control path.
+class Dashboard {
+public:
+  // Settings of the dashboard
+  struct Settings {
+    // Number of last frames of a session in a message
+    size_t window;
+    // Max number of points of a channel in a message, shared by all
+    // sessions, every session gets at least kMinPointCount of them
+    size_t n_points;
+  };
+
+  // Sample of a frame
+  struct Sample {
+    // Arrival time in seconds
+    double time;
+    // Cross-track error (CTE), steering value and speed in miles-per-hour
+    double cte;
+    double steering;
+    double speed;
+  };
+
+  // Tuning event of a session
+  struct Event {
+    // Time in seconds
+    double time;
+    // Evaluated or final coefficients, and their error
+    double coefficients[3];
+    double error;
+    // Indicates the evaluation was a whole lap
+    bool is_full_lap;
+    // Outcome of tuning, or nullptr for an evaluation
+    const char* outcome;
+  };
+
+  // Feed of a session, written by its control path
+  class Feed {
+  public:
+    // Constructor.
+    // @param id      Session identifier
+    // @param window  Number of last frames kept
+    Feed(uint32_t id, size_t window);
+
+    // Writes the sample of a frame.
+    void Push(const Sample& sample) { samples_.Push(sample); }
+
+    // Writes a tuning event.
+    void PushEvent(const Event& event) { events_.Push(event); }
+
+    // Gets the session identifier.
+    uint32_t GetId() const { return id_; }
+
+  private:
+    friend class Dashboard;
+
+    // Session identifier
+    uint32_t id_;
+
+    // Samples and events
+    TelemetryRing<Sample> samples_;
+    TelemetryRing<Event> events_;
+
+    // Sequence number of the next event to collect
+    uint64_t next_event_;
+  };
+
+  // Min number of points of a channel of a session
+  static constexpr size_t kMinPointCount = 3;
+
+  // Constructor.
+  // @param settings  Settings of the dashboard
+  explicit Dashboard(const Settings& settings);
+
+  // Destructor, stops the background thread if started.
+  ~Dashboard();
+
+  Dashboard(const Dashboard&) = delete;
+  Dashboard& operator=(const Dashboard&) = delete;
+
+  // Starts the background thread collecting a message every interval while
+  // watched.
+  // @param interval_ms  Interval in milliseconds
+  void Start(unsigned int interval_ms);
+
+  // Indicates whether there are viewers, collecting stops without them.
+  // @param is_watched  True if there are viewers
+  void SetWatched(bool is_watched) { is_watched_.store(is_watched); }
+
+  // Gets the last message collected by the background thread.
+  // @return  Message, nullptr if none yet
+  std::shared_ptr<const std::string> GetMessage() const;
+
+  // Adds the feed of a new session.
+  // @return  Feed, shared with the control path of the session
+  std::shared_ptr<Feed> AddFeed();
+
+  // Removes the feed of a closed session.
+  // @param feed  Feed
+  void RemoveFeed(const std::shared_ptr<Feed>& feed);
+
+  // Collects the message for the viewers: a JSON object with the sessions,
+  // every one with the downsampled "cte", "steering" and "speed" as arrays of
+  // [time, value] pairs, and the new "events". Feeds may be added and removed
+  // meanwhile, but it must not be called while the background thread runs.
+  // @param[out] message  Message
+  void Collect(std::string& message);
+
+  // Downsamples a series by Largest-Triangle-Three-Buckets: keeps the first
+  // and the last points, and of every bucket in between the point forming
+  // the largest triangle with the point kept before it and the average of
+  // the next bucket, so peaks survive.
+  // @param[in]  x        Abscissas, increasing
+  // @param[in]  y        Ordinates
+  // @param[in]  n        Number of points
+  // @param[in]  n_out    Max number of points kept
+  // @param[out] indices  Indices of the kept points, increasing
+  static void Downsample(const double* x, const double* y, size_t n,
+                         size_t n_out, std::vector<size_t>& indices);
+
+  // Gets the HTML page of the dashboard, plotting the messages of the feed.
+  static const std::string& GetPage();
+
+private:
+  // Settings of the dashboard
+  Settings settings_;
+
+  // Guards the feeds, the identifier of the next session, the last message
+  // and stopping
+  mutable std::mutex mutex_;
+
+  // Feeds of the open sessions
+  std::vector<std::shared_ptr<Feed>> feeds_;
+
+  // Identifier of the next session
+  uint32_t next_id_;
+
+  // Last collected message
+  std::shared_ptr<const std::string> message_;
+
+  // Indication whether there are viewers
+  std::atomic<bool> is_watched_;
+
+  // Signals stopping to the background thread, and the indication whether it
+  // should stop
+  std::condition_variable stopping_;
+  bool is_stopping_;
+
+  // Background thread, if started
+  std::thread thread_;
+
+  // Buffers of collecting, reused
+  std::vector<std::shared_ptr<Feed>> collected_feeds_;
+  std::vector<Sample> samples_;
+  std::vector<Event> events_;
+  std::vector<double> times_;
+  std::vector<double> values_;
+  std::vector<size_t> indices_;
+
+  // Collects a message every interval while watched, until stopped.
+  // @param interval_ms  Interval in milliseconds
+  void Run(unsigned int interval_ms);
+};
+
+#endif // DASHBOARD_H
@@ -0,0 +1,148 @@
+#include "DynamicBicycle.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Min longitudinal velocity in the slip angles, which are undefined at rest
+const auto kMinSlipSpeed = 1.;
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+DynamicBicycle::Parameters DynamicBicycle::GetSedan() {
+  return {1500.,   // mass
+          2500.,   // yaw_inertia
+          1.2,     // front_distance
+          1.47,    // rear_distance
+          80000.,  // front_stiffness
+          90000.,  // rear_stiffness
+          0.1};    // steering_lag
+}
+
+DynamicBicycle::DynamicBicycle(const Parameters& parameters,
+                               size_t n,
+                               double dt)
+  : parameters_(parameters),
+    n_(n),
+    n_active_(n),
+    dt_(dt),
+    state_(kComponentCount * n),
+    stage_(kComponentCount * n),
+    k1_(kComponentCount * n),
+    k2_(kComponentCount * n),
+    k3_(kComponentCount * n),
+    k4_(kComponentCount * n) {
+  // Empty.
+}
+
+void DynamicBicycle::Reset(size_t i,
+                           double x,
+                           double y,
+                           double yaw,
+                           double speed) {
+  for (auto c = 0; c < kComponentCount; ++c) {
+    state_[c * n_ + i] = 0.;
+  }
+  state_[kX * n_ + i] = x;
+  state_[kY * n_ + i] = y;
+  state_[kYaw * n_ + i] = yaw;
+  state_[kVx * n_ + i] = speed;
+}
+
+void DynamicBicycle::Move(size_t from, size_t to) {
+  for (auto c = 0; c < kComponentCount; ++c) {
+    state_[c * n_ + to] = state_[c * n_ + from];
+  }
+}
+
+void DynamicBicycle::SetActiveCount(size_t n) {
+  n_active_ = std::min(n, n_);
+}
+
+void DynamicBicycle::Step(const double* steering,
+                          const double* acceleration,
+                          double max_speed) {
+  auto* state = state_.data();
+  auto* stage = stage_.data();
+  auto* k1 = k1_.data();
+  auto* k2 = k2_.data();
+  auto* k3 = k3_.data();
+  auto* k4 = k4_.data();
+  Derive(state, steering, acceleration, k1);
+  Combine(state, k1, 0.5 * dt_, stage);
+  Derive(stage, steering, acceleration, k2);
+  Combine(state, k2, 0.5 * dt_, stage);
+  Derive(stage, steering, acceleration, k3);
+  Combine(state, k3, dt_, stage);
+  Derive(stage, steering, acceleration, k4);
+  for (auto c = 0; c < kComponentCount; ++c) {
+    for (auto j = c * n_; j < c * n_ + n_active_; ++j) {
+      state[j] += dt_ / 6. * (k1[j] + 2. * (k2[j] + k3[j]) + k4[j]);
+    }
+  }
+  auto* vx = state + kVx * n_;
+  for (size_t i = 0; i < n_active_; ++i) {
+    vx[i] = std::min(max_speed, std::max(0., vx[i]));
+  }
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void DynamicBicycle::Combine(const double* base,
+                             const double* derivatives,
+                             double scale,
+                             double* stage) const {
+  for (auto c = 0; c < kComponentCount; ++c) {
+    for (auto j = c * n_; j < c * n_ + n_active_; ++j) {
+      stage[j] = base[j] + scale * derivatives[j];
+    }
+  }
+}
+
+void DynamicBicycle::Derive(const double* state,
+                            const double* steering,
+                            const double* acceleration,
+                            double* derivatives) const {
+  const auto* yaw = state + kYaw * n_;
+  const auto* vx = state + kVx * n_;
+  const auto* vy = state + kVy * n_;
+  const auto* yaw_rate = state + kYawRate * n_;
+  const auto* delta = state + kSteering * n_;
+  auto* dx = derivatives + kX * n_;
+  auto* dy = derivatives + kY * n_;
+  auto* dyaw = derivatives + kYaw * n_;
+  auto* dvx = derivatives + kVx * n_;
+  auto* dvy = derivatives + kVy * n_;
+  auto* dyaw_rate = derivatives + kYawRate * n_;
+  auto* ddelta = derivatives + kSteering * n_;
+  const auto m = parameters_.mass;
+  const auto iz = parameters_.yaw_inertia;
+  const auto lf = parameters_.front_distance;
+  const auto lr = parameters_.rear_distance;
+  const auto cf = parameters_.front_stiffness;
+  const auto cr = parameters_.rear_stiffness;
+  const auto lag = parameters_.steering_lag;
+  for (size_t i = 0; i < n_active_; ++i) {
+    auto cos_yaw = std::cos(yaw[i]);
+    auto sin_yaw = std::sin(yaw[i]);
+    auto slip_speed = std::max(kMinSlipSpeed, vx[i]);
+    // Linear lateral forces by the small-angle slip of both axles
+    auto front_force = cf * (delta[i]
+                             - (vy[i] + lf * yaw_rate[i]) / slip_speed);
+    auto rear_force = -cr * (vy[i] - lr * yaw_rate[i]) / slip_speed;
+    dx[i] = vx[i] * cos_yaw - vy[i] * sin_yaw;
+    dy[i] = vx[i] * sin_yaw + vy[i] * cos_yaw;
+    dyaw[i] = yaw_rate[i];
+    dvx[i] = acceleration[i] + vy[i] * yaw_rate[i];
+    dvy[i] = (front_force + rear_force) / m - vx[i] * yaw_rate[i];
+    dyaw_rate[i] = (lf * front_force - lr * rear_force) / iz;
+    ddelta[i] = (steering[i] - delta[i]) / lag;
+  }
+}
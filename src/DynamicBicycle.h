@@ -0,0 +1,140 @@
+#ifndef DYNAMIC_BICYCLE_H
+#define DYNAMIC_BICYCLE_H
+
+#include <cstddef>
+#include <vector>
+
+// Dynamic single-track (bicycle) model of a batch of vehicles. Lateral tire
+// forces are linear in the slip angles, so the vehicles understeer with speed
+// unlike the kinematic model, and the steering angle follows the command with
+// a first-order lag. All vehicles are integrated together by fixed-step RK4
+// over structure-of-arrays state, preallocated on construction, so a step
+// never allocates and the loops over the vehicles are vectorizable.
+class DynamicBicycle {
+public:
+  // Parameters of the vehicles
+  struct Parameters {
+    // Mass in kg and yaw moment of inertia in kg*m^2
+    double mass;
+    double yaw_inertia;
+    // Distances of the front and rear axles from the center of gravity in
+    // meters
+    double front_distance;
+    double rear_distance;
+    // Cornering stiffness of the front and rear axles in N/rad
+    double front_stiffness;
+    double rear_stiffness;
+    // Time constant of the steering actuator in seconds
+    double steering_lag;
+  };
+
+  // Components of the state of a vehicle
+  enum Component {
+    kX,          // Position in meters
+    kY,
+    kYaw,        // Heading in radians
+    kVx,         // Longitudinal and lateral velocity in meters-per-second
+    kVy,
+    kYawRate,    // Yaw rate in radians-per-second
+    kSteering,   // Front wheel angle in radians
+    kComponentCount
+  };
+
+  // Gets parameters of a mid-size sedan, understeering, with the wheelbase of
+  // the kinematic model of the simulator.
+  static Parameters GetSedan();
+
+  // Constructor.
+  // @param parameters  Parameters of the vehicles
+  // @param n           Number of vehicles
+  // @param dt          Fixed step in seconds
+  DynamicBicycle(const Parameters& parameters, size_t n, double dt);
+
+  // Puts a vehicle at a pose, at rest.
+  // @param i      Index of the vehicle
+  // @param x      X coordinate in meters
+  // @param y      Y coordinate in meters
+  // @param yaw    Heading in radians
+  // @param speed  Longitudinal velocity in meters-per-second
+  void Reset(size_t i, double x, double y, double yaw, double speed = 0.);
+
+  // Moves the state of a vehicle to another index, e.g. to keep the active
+  // vehicles first.
+  // @param from  Index of the vehicle
+  // @param to    Index the state is moved to, its previous state is lost
+  void Move(size_t from, size_t to);
+
+  // Sets the number of active vehicles, which are the first ones. Only they
+  // are stepped, the others keep their state. All vehicles are active on
+  // construction.
+  // @param n  Number of active vehicles, at most the number of vehicles
+  void SetActiveCount(size_t n);
+
+  // Advances the active vehicles by one fixed step.
+  // @param steering      Commanded front wheel angle of every active vehicle
+  //                      in radians
+  // @param acceleration  Commanded longitudinal acceleration of every active
+  //                      vehicle in meters-per-second^2
+  // @param max_speed     Longitudinal velocity is kept within 0..max_speed
+  void Step(const double* steering,
+            const double* acceleration,
+            double max_speed);
+
+  // Gets a component of the state of all vehicles.
+  // @param component  Component
+  // @return           Values of all vehicles, contiguous
+  const double* Get(Component component) const {
+    return &state_[component * n_];
+  }
+
+  // Gets the number of vehicles.
+  size_t GetCount() const { return n_; }
+
+  // Gets the number of active vehicles.
+  size_t GetActiveCount() const { return n_active_; }
+
+  // Gets the fixed step in seconds.
+  double GetStep() const { return dt_; }
+
+private:
+  // Computes a stage of RK4, base + scale * derivatives, of the active
+  // vehicles.
+  // @param[in]  base         State of all vehicles
+  // @param[in]  derivatives  Derivatives of the state
+  // @param[in]  scale        Scale of the derivatives
+  // @param[out] stage        Stage of all vehicles
+  void Combine(const double* base,
+               const double* derivatives,
+               double scale,
+               double* stage) const;
+
+  // Computes the derivatives of a state of the active vehicles.
+  // @param[in]  state         State of all vehicles
+  // @param[in]  steering      Commanded front wheel angles
+  // @param[in]  acceleration  Commanded longitudinal accelerations
+  // @param[out] derivatives   Derivatives of the state
+  void Derive(const double* state,
+              const double* steering,
+              const double* acceleration,
+              double* derivatives) const;
+
+  // Parameters of the vehicles
+  Parameters parameters_;
+
+  // Number of vehicles, of the active ones, and the fixed step
+  size_t n_;
+  size_t n_active_;
+  double dt_;
+
+  // State, component c of vehicle i at c * n_ + i
+  std::vector<double> state_;
+
+  // Intermediate state and the derivatives of the four stages of RK4
+  std::vector<double> stage_;
+  std::vector<double> k1_;
+  std::vector<double> k2_;
+  std::vector<double> k3_;
+  std::vector<double> k4_;
+};
+
+#endif // DYNAMIC_BICYCLE_H
@@ -0,0 +1,189 @@
+#include "EpisodeDriver.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <thread>
+#include <utility>
+#include "Simulator.h"
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+Episode::Episode(Coroutine coroutine)
+  : coroutine_(std::move(coroutine)) {
+  assert(coroutine_.GetHandle());
+}
+
+bool Episode::Resume(const Tick& tick, Command& command) {
+  auto handle = coroutine_.GetHandle();
+  assert(handle);
+  auto& promise = handle.promise();
+  if (!handle.done()) {
+    promise.step = {tick, {}};
+    handle.resume();
+  }
+  if (promise.exception) {
+    std::rethrow_exception(std::exchange(promise.exception, nullptr));
+  }
+  if (handle.done()) {
+    return false;
+  }
+  command = promise.step.command;
+  return true;
+}
+
+ControllerEpisode::ControllerEpisode(std::unique_ptr<PidController> controller,
+                                     double max_distance)
+  : controller_(std::move(controller)),
+    max_distance_(max_distance),
+    distance_(),
+    tick_distance_() {
+  Start(Drive());
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+Episode::Coroutine ControllerEpisode::Drive() {
+  // Tuning completes the episode once the coefficients are final
+  auto is_tuning = !controller_->HasFinalCoefficients();
+  for (;;) {
+    auto& step = co_await NextTick();
+    tick_distance_ = step.tick.distance;
+    if (GetDistance() >= max_distance_
+        || (is_tuning && controller_->HasFinalCoefficients())) {
+      co_return;
+    }
+    auto& command = step.command;
+    controller_->Update(step.tick.cte, step.tick.speed,
+                        [&command](double steering, double throttle) {
+                          command.steering = steering;
+                          command.throttle = throttle;
+                        },
+                        [&command]() { command.is_reset = true; });
+    if (command.is_reset) {
+      distance_ += tick_distance_;
+      tick_distance_ = 0;
+    }
+  }
+}
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+EpisodeDriver::EpisodeDriver(const Settings& settings)
+  : settings_(settings) {
+  assert(settings.batch_size > 0);
+}
+
+void EpisodeDriver::Add(Episode* episode) {
+  episodes_.push_back(episode);
+}
+
+unsigned long int EpisodeDriver::Run() {
+  auto batch_size = settings_.batch_size;
+  auto n_batches = (episodes_.size() + batch_size - 1) / batch_size;
+  auto n_threads = settings_.n_threads ?
+                   settings_.n_threads :
+                   std::max(1u, std::thread::hardware_concurrency());
+  std::atomic<size_t> next(0);
+  std::atomic<unsigned long int> n_ticks(0);
+  auto work = [this, batch_size, n_batches, &next, &n_ticks]() {
+    for (auto i = next++; i < n_batches; i = next++) {
+      auto begin = i * batch_size;
+      n_ticks += RunBatch(&episodes_[begin],
+                          std::min(batch_size, episodes_.size() - begin));
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned int t = 1; t < std::min<size_t>(n_threads, n_batches); ++t) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  episodes_.clear();
+  return n_ticks;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+unsigned long int EpisodeDriver::RunBatch(Episode* const* begin,
+                                          size_t count) const {
+  // Start pose, initial CTE to the left of the centerline
+  auto start_x = 0.;
+  auto start_y = settings_.initial_cte;
+  auto start_heading = 0.;
+  if (settings_.track) {
+    settings_.track->GetPose(0., start_x, start_y, start_heading);
+    start_x -= settings_.initial_cte * std::sin(start_heading);
+    start_y += settings_.initial_cte * std::cos(start_heading);
+  }
+  DynamicBicycle vehicles(DynamicBicycle::GetSedan(), count,
+                          1. / (Simulator::kFrameRate
+                                * Simulator::kDynamicStepCount));
+  for (size_t i = 0; i < count; ++i) {
+    vehicles.Reset(i, start_x, start_y, start_heading);
+  }
+  // The running episodes are the first ones, with their vehicles
+  std::vector<Episode*> episodes(begin, begin + count);
+  std::vector<double> steering(count);
+  std::vector<double> acceleration(count);
+  std::vector<double> ctes(count);
+  std::vector<double> distances(count);
+  std::vector<unsigned long int> n_ticks(count);
+  const auto* x = vehicles.Get(DynamicBicycle::kX);
+  const auto* y = vehicles.Get(DynamicBicycle::kY);
+  const auto* vx = vehicles.Get(DynamicBicycle::kVx);
+  auto max_speed = Simulator::kMphToMps * settings_.max_speed;
+  auto n_running = count;
+  unsigned long int n_batch_ticks = 0;
+  while (n_running) {
+    if (settings_.track) {
+      settings_.track->GetCtes(x, y, n_running, ctes.data());
+    } else {
+      std::copy(y, y + n_running, ctes.begin());
+    }
+    for (size_t i = 0; i < n_running;) {
+      Episode::Tick tick = {ctes[i], vx[i] / Simulator::kMphToMps,
+                            distances[i], n_ticks[i]};
+      Episode::Command command = {};
+      if ((settings_.max_ticks && n_ticks[i] >= settings_.max_ticks)
+          || !episodes[i]->Resume(tick, command)) {
+        // The last running episode takes the place of the completed one, and
+        // is resumed next
+        --n_running;
+        episodes[i] = episodes[n_running];
+        vehicles.Move(n_running, i);
+        ctes[i] = ctes[n_running];
+        distances[i] = distances[n_running];
+        n_ticks[i] = n_ticks[n_running];
+        continue;
+      }
+      ++n_ticks[i];
+      ++n_batch_ticks;
+      if (command.is_reset) {
+        vehicles.Reset(i, start_x, start_y, start_heading);
+        distances[i] = 0.;
+        steering[i] = 0.;
+        acceleration[i] = 0.;
+      } else {
+        steering[i] = Simulator::kMaxSteeringAngle * command.steering;
+        acceleration[i] = Simulator::kMaxAcceleration * command.throttle;
+      }
+      ++i;
+    }
+    vehicles.SetActiveCount(n_running);
+    for (auto step = 0; n_running && step < Simulator::kDynamicStepCount;
+         ++step) {
+      vehicles.Step(steering.data(), acceleration.data(), max_speed);
+      for (size_t i = 0; i < n_running; ++i) {
+        distances[i] += vx[i] * vehicles.GetStep();
+      }
+    }
+  }
+  return n_batch_ticks;
+}
@@ -0,0 +1,243 @@
+#ifndef EPISODE_DRIVER_H
+#define EPISODE_DRIVER_H
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "DynamicBicycle.h"
+#include "PidController.h"
+#include "Track.h"
+
+// Offline episode, such as a controller tuning its coefficients: a C++20
+// coroutine awaiting every simulation tick with the telemetry of its vehicle,
+// and setting the command of the vehicle until the next tick. Its state lives
+// in the coroutine frame between ticks, so one thread interleaves thousands of
+// episodes without a thread or a stack per episode. An episode completes by
+// returning from the coroutine, e.g.
+//
+//   Episode::Coroutine Accelerate(double speed) {
+//     for (;;) {
+//       auto& step = co_await Episode::NextTick();
+//       if (step.tick.speed >= speed) {
+//         co_return;
+//       }
+//       step.command.throttle = 1.;
+//     }
+//   }
+//
+// This header and the sources including it are built with -std=c++20
+// -fcoroutines.
+class Episode {
+public:
+  // Telemetry of a tick
+  struct Tick {
+    // Cross-track error (CTE) and speed in miles-per-hour
+    double cte;
+    double speed;
+    // Distance driven since the vehicle was reset in meters, and the number
+    // of ticks since the episode started
+    double distance;
+    unsigned long int n_ticks;
+  };
+
+  // Command of a tick
+  struct Command {
+    // Steering and throttle values within -1..1
+    double steering;
+    double throttle;
+    // Puts the vehicle back to the start instead
+    bool is_reset;
+  };
+
+  // Tick awaited by the coroutine, and the command it sets, all zero on entry
+  struct Step {
+    Tick tick;
+    Command command;
+  };
+
+  // Coroutine of an episode, owning its frame. It runs up to awaiting the
+  // first tick once called.
+  class Coroutine {
+  public:
+    struct promise_type {
+      Coroutine get_return_object() {
+        return Coroutine(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      // The frame is kept until the episode is destroyed
+      std::suspend_always final_suspend() noexcept { return {}; }
+      void return_void() { }
+      void unhandled_exception() { exception = std::current_exception(); }
+
+      // Step of the current tick, and the exception the coroutine exited by
+      Step step;
+      std::exception_ptr exception;
+    };
+
+    // Constructor of no coroutine.
+    Coroutine() : handle_() { }
+
+    // Constructor.
+    // @param handle  Handle of the coroutine, owned
+    explicit Coroutine(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {
+      // Empty.
+    }
+
+    Coroutine(Coroutine&& other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {
+      // Empty.
+    }
+
+    Coroutine& operator=(Coroutine&& other) noexcept {
+      std::swap(handle_, other.handle_);
+      return *this;
+    }
+
+    // Destructor, destroys the frame.
+    ~Coroutine() {
+      if (handle_) {
+        handle_.destroy();
+      }
+    }
+
+    // Gets the handle of the coroutine.
+    std::coroutine_handle<promise_type> GetHandle() const { return handle_; }
+
+  private:
+    std::coroutine_handle<promise_type> handle_;
+  };
+
+  // Awaitable of the next tick, resumes with its step.
+  class NextTick {
+  public:
+    NextTick() : promise_() { }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(
+      std::coroutine_handle<Coroutine::promise_type> handle) noexcept {
+      promise_ = &handle.promise();
+    }
+
+    Step& await_resume() const noexcept { return promise_->step; }
+
+  private:
+    Coroutine::promise_type* promise_;
+  };
+
+  // Constructor.
+  // @param coroutine  Coroutine of the episode
+  explicit Episode(Coroutine coroutine);
+
+  virtual ~Episode() { }
+
+  // Resumes the episode at a tick, and rethrows what the coroutine threw.
+  // @param[in]  tick     Telemetry of the vehicle
+  // @param[out] command  Command of the vehicle
+  // @return              True to await the next tick, false once complete
+  bool Resume(const Tick& tick, Command& command);
+
+protected:
+  // Constructor of a derived episode, which starts its coroutine once its
+  // members are constructed.
+  Episode() { }
+
+  // Starts the coroutine of a derived episode.
+  // @param coroutine  Coroutine of the episode
+  void Start(Coroutine coroutine) { coroutine_ = std::move(coroutine); }
+
+private:
+  // Coroutine of the episode
+  Coroutine coroutine_;
+};
+
+// Episode of a PidController: tuning until it has final coefficients, or
+// driving with final ones over a distance.
+class ControllerEpisode : public Episode {
+public:
+  // Constructor.
+  // @param controller    Controller
+  // @param max_distance  Distance in meters after which the episode completes
+  //                      anyway
+  ControllerEpisode(std::unique_ptr<PidController> controller,
+                    double max_distance);
+
+  // Gets the controller.
+  PidController& GetController() const { return *controller_; }
+
+  // Gets the distance driven over all resets in meters.
+  double GetDistance() const { return distance_ + tick_distance_; }
+
+private:
+  // Drives the controller tick by tick.
+  Coroutine Drive();
+
+  // Controller
+  std::unique_ptr<PidController> controller_;
+
+  // Distance after which the episode completes
+  double max_distance_;
+
+  // Distance driven before the last reset, and since it
+  double distance_;
+  double tick_distance_;
+};
+
+// Drives many episodes by worker threads. Every thread takes batches of
+// episodes, and steps the vehicles of a batch together until all its episodes
+// complete: the CTE of the whole batch is one Track query, and its dynamics one
+// fixed-step DynamicBicycle integration over structure-of-arrays state, so the
+// state of a batch stays cache-resident and the kernels run on full batches.
+// A completed episode leaves the batch, the last running one takes its place,
+// so the kernels only run on the running episodes.
+class EpisodeDriver {
+public:
+  // Settings of the driver
+  struct Settings {
+    // Number of episodes stepped together
+    size_t batch_size;
+    // Number of worker threads, 0 means the number of hardware threads
+    unsigned int n_threads;
+    // Max speed in miles-per-hour
+    double max_speed;
+    // CTE after reset
+    double initial_cte;
+    // Max number of ticks of an episode, 0 is unlimited
+    unsigned long int max_ticks;
+    // Track, must outlive the driver, nullptr for a straight one
+    const Track* track;
+  };
+
+  // Constructor.
+  // @param settings  Settings of the driver
+  explicit EpisodeDriver(const Settings& settings);
+
+  // Adds an episode, must not be called while running.
+  // @param episode  Episode, owned by the caller, must outlive the run
+  void Add(Episode* episode);
+
+  // Runs all added episodes to completion, or to the max number of ticks,
+  // and removes them.
+  // @return  Number of ticks of all episodes
+  unsigned long int Run();
+
+private:
+  // Runs a batch of episodes to completion.
+  // @param begin  First episode of the batch
+  // @param count  Number of episodes of the batch
+  // @return       Number of ticks of all episodes of the batch
+  unsigned long int RunBatch(Episode* const* begin, size_t count) const;
+
+  // Settings of the driver
+  Settings settings_;
+
+  // Episodes to run
+  std::vector<Episode*> episodes_;
+};
+
+#endif // EPISODE_DRIVER_H
@@ -0,0 +1,298 @@
+#include "ExperimentStore.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Header of the store file, occupies exactly one cache line
+struct Header {
+  char magic[8];
+  uint32_t record_size;
+  uint32_t reserved0;
+  // Number of committed records, updated after the record is written
+  uint64_t count;
+  char reserved[40];
+};
+static_assert(sizeof(Header) == 64, "Store header must be one cache line");
+static_assert(sizeof(ExperimentStore::Record) == 64,
+              "Store record must be one cache line");
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Magic bytes identifying the store file format and its version
+const char kMagic[8] = {'P', 'I', 'D', 'E', 'X', 'P', '0', '1'};
+
+// Capacity of a new store file in records
+const size_t kInitialCapacity = 1024;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the wall-clock time in nanoseconds since the epoch.
+uint64_t GetTimestamp() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+ExperimentStore::ExperimentStore()
+  : fd_(-1),
+    mapped_(),
+    mapped_size_(),
+    records_() {
+  // Empty.
+}
+
+ExperimentStore::~ExperimentStore() {
+  Close();
+}
+
+bool ExperimentStore::Open(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Close();
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    return false;
+  }
+  struct stat st;
+  if (flock(fd_, LOCK_EX | LOCK_NB) != 0 || fstat(fd_, &st) != 0) {
+    Close();
+    return false;
+  }
+
+  if (st.st_size == 0) {
+    if (!Map(kInitialCapacity)) {
+      Close();
+      return false;
+    }
+    auto& header = *static_cast<Header*>(mapped_);
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.record_size = sizeof(Record);
+    return true;
+  }
+
+  auto size = static_cast<size_t>(st.st_size);
+  if (size < sizeof(Header) || (size - sizeof(Header)) % sizeof(Record) != 0
+      || !Map((size - sizeof(Header)) / sizeof(Record))) {
+    Close();
+    return false;
+  }
+  const auto& header = *static_cast<const Header*>(mapped_);
+  auto capacity = (mapped_size_ - sizeof(Header)) / sizeof(Record);
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+      || header.record_size != sizeof(Record) || header.count > capacity) {
+    Close();
+    return false;
+  }
+  for (uint32_t i = 0; i < header.count; ++i) {
+    Index(i);
+  }
+  return true;
+}
+
+bool ExperimentStore::Append(uint32_t scenario,
+                             const double coefficients[kCoefficientCount],
+                             double budget,
+                             double error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!records_) {
+    return false;
+  }
+  auto count = static_cast<Header*>(mapped_)->count;
+  auto capacity = (mapped_size_ - sizeof(Header)) / sizeof(Record);
+  if (count == capacity && !Map(2 * capacity)) {
+    return false;
+  }
+
+  auto& record = records_[count];
+  std::memset(&record, 0, sizeof(record));
+  std::copy(coefficients, coefficients + kCoefficientCount,
+            record.coefficients);
+  record.error = error;
+  record.budget = budget;
+  record.timestamp_ns = GetTimestamp();
+  record.scenario = scenario;
+  // The record is complete before it is counted
+  std::atomic_thread_fence(std::memory_order_release);
+  static_cast<Header*>(mapped_)->count = count + 1;
+  Index(static_cast<uint32_t>(count));
+  return true;
+}
+
+size_t ExperimentStore::GetCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return records_ ? static_cast<const Header*>(mapped_)->count : 0;
+}
+
+bool ExperimentStore::Find(uint32_t scenario,
+                           const double coefficients[kCoefficientCount],
+                           double budget,
+                           Record& record) const {
+  Key key;
+  key.scenario = scenario;
+  key.budget = budget;
+  std::copy(coefficients, coefficients + kCoefficientCount,
+            key.coefficients);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = by_key_.find(key);
+  if (it == by_key_.end()) {
+    return false;
+  }
+  record = records_[it->second];
+  return true;
+}
+
+std::vector<ExperimentStore::Record> ExperimentStore::FindBest(
+  uint32_t scenario,
+  const double center[kCoefficientCount],
+  const double radius[kCoefficientCount],
+  size_t count) const {
+
+  std::vector<Record> found;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = full_laps_by_error_.find(scenario);
+  if (it == full_laps_by_error_.end()) {
+    return found;
+  }
+  // Records are ordered by error, so the first ones within the box are best
+  for (const auto& entry : it->second) {
+    if (found.size() >= count) {
+      break;
+    }
+    const auto& record = records_[entry.second];
+    auto is_inside = true;
+    for (auto j = 0; j < kCoefficientCount && is_inside; ++j) {
+      is_inside = std::fabs(record.coefficients[j] - center[j]) <= radius[j];
+    }
+    if (is_inside) {
+      found.push_back(record);
+    }
+  }
+  return found;
+}
+
+bool ExperimentStore::Seed(uint32_t scenario,
+                           Tuner::ParameterSequence& parameters) const {
+  if (parameters.size() != kCoefficientCount) {
+    return false;
+  }
+  double center[kCoefficientCount];
+  double radius[kCoefficientCount];
+  for (auto j = 0; j < kCoefficientCount; ++j) {
+    center[j] = parameters[j].p;
+    radius[j] = kSeedRadius * std::fabs(parameters[j].dp);
+  }
+  auto best = FindBest(scenario, center, radius, kSeedCount);
+  if (best.empty()) {
+    return false;
+  }
+  for (auto j = 0; j < kCoefficientCount; ++j) {
+    auto& parameter = parameters[j];
+    parameter.p = best[0].coefficients[j];
+    // The transform and the feasible range of the search space are kept
+    if (parameter.lower < parameter.upper) {
+      parameter.p = std::min(std::max(parameter.p, parameter.lower),
+                             parameter.upper);
+    }
+    // The best results are spread along the directions still worth exploring
+    auto spread = 0.;
+    for (const auto& record : best) {
+      spread = std::max(spread, std::fabs(record.coefficients[j]
+                                          - parameter.p));
+    }
+    auto dp = std::fabs(parameter.dp);
+    auto seeded_dp = best.size() > 1 ?
+                     std::max(0.1 * dp, std::min(dp, spread)) : 0.5 * dp;
+    parameter.dp = std::copysign(seeded_dp, parameter.dp);
+  }
+  return true;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+bool ExperimentStore::Key::operator==(const Key& rhs) const {
+  return scenario == rhs.scenario && budget == rhs.budget
+    && std::equal(coefficients, coefficients + kCoefficientCount,
+                  rhs.coefficients);
+}
+
+size_t ExperimentStore::KeyHash::operator()(const Key& key) const {
+  std::hash<double> hash;
+  auto h = std::hash<uint32_t>()(key.scenario) ^ hash(key.budget) << 1;
+  for (auto c : key.coefficients) {
+    h = h * 31 + hash(c);
+  }
+  return h;
+}
+
+bool ExperimentStore::Map(size_t capacity) {
+  // The old mapping stays valid until the new one is in place, so the indices
+  // still refer to mapped records if growing fails
+  auto size = sizeof(Header) + capacity * sizeof(Record);
+  struct stat st;
+  if (fstat(fd_, &st) != 0
+      || (static_cast<size_t>(st.st_size) < size
+          && ftruncate(fd_, size) != 0)) {
+    return false;
+  }
+  auto mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                     0);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+  if (mapped_) {
+    munmap(mapped_, mapped_size_);
+  }
+  mapped_ = mapped;
+  mapped_size_ = size;
+  records_ = reinterpret_cast<Record*>(static_cast<char*>(mapped_)
+                                       + sizeof(Header));
+  return true;
+}
+
+void ExperimentStore::Index(uint32_t i) {
+  const auto& record = records_[i];
+  if (record.budget >= 1.) {
+    full_laps_by_error_[record.scenario].emplace(record.error, i);
+  }
+  Key key;
+  key.scenario = record.scenario;
+  key.budget = record.budget;
+  std::copy(record.coefficients, record.coefficients + kCoefficientCount,
+            key.coefficients);
+  // The latest evaluation wins
+  by_key_[key] = i;
+}
+
+void ExperimentStore::Close() {
+  if (mapped_) {
+    munmap(mapped_, mapped_size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  fd_ = -1;
+  mapped_ = nullptr;
+  mapped_size_ = 0;
+  records_ = nullptr;
+  full_laps_by_error_.clear();
+  by_key_.clear();
+}
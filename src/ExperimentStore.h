@@ -0,0 +1,155 @@
+#ifndef EXPERIMENT_STORE_H
+#define EXPERIMENT_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Tuner.h"
+
+// Embedded store of tuning experiments: an append-only file of fixed-size
+// records, one per evaluated set of coefficients, memory-mapped for reading
+// and writing. The file has a 64-byte header followed by 64-byte records, and
+// grows by doubling. Whole-lap records are indexed in memory by scenario in
+// the order of error, and all records by exact coefficients, so lookups are
+// cheap enough for every reset. One process writes a store at a time.
+class ExperimentStore {
+public:
+  // Number of coefficients per record
+  enum { kCoefficientCount = 3 };
+
+  // One evaluation, occupies exactly one cache line
+  struct Record {
+    // Evaluated coefficients
+    double coefficients[kCoefficientCount];
+    // Error of the evaluation
+    double error;
+    // Driven part of the lap within 0..1, 1 is the whole lap
+    double budget;
+    // Wall-clock time in nanoseconds since the epoch
+    uint64_t timestamp_ns;
+    // Scenario identifier, such as a track or a speed profile
+    uint32_t scenario;
+    // Reserved, zero
+    uint32_t reserved[3];
+  };
+
+  // Constructor, creates a closed store.
+  ExperimentStore();
+
+  // Destructor, closes the store.
+  ~ExperimentStore();
+
+  ExperimentStore(const ExperimentStore&) = delete;
+  ExperimentStore& operator=(const ExperimentStore&) = delete;
+
+  // Opens or creates a store file and indexes its records.
+  // @param path  Path of the store file
+  // @return      True on success, false if the file is invalid or another
+  //              process has it open
+  bool Open(const std::string& path);
+
+  // Indicates the store is open.
+  bool IsOpen() const { return records_ != nullptr; }
+
+  // Appends an evaluation.
+  // @param scenario      Scenario identifier
+  // @param coefficients  Evaluated coefficients
+  // @param budget        Driven part of the lap within 0..1
+  // @param error         Error of the evaluation
+  // @return              True on success
+  bool Append(uint32_t scenario,
+              const double coefficients[kCoefficientCount],
+              double budget,
+              double error);
+
+  // Gets the number of records.
+  size_t GetCount() const;
+
+  // Finds a previous evaluation of exactly the same coefficients and budget.
+  // @param[in]  scenario      Scenario identifier
+  // @param[in]  coefficients  Coefficients
+  // @param[in]  budget        Driven part of the lap
+  // @param[out] record        Found record
+  // @return                   True if found
+  bool Find(uint32_t scenario,
+            const double coefficients[kCoefficientCount],
+            double budget,
+            Record& record) const;
+
+  // Finds the best whole-lap evaluations within a box.
+  // @param[in] scenario  Scenario identifier
+  // @param[in] center    Center of the box
+  // @param[in] radius    Half-size of the box along every coefficient
+  // @param[in] count     Max number of records
+  // @return              Records in the order of increasing error
+  std::vector<Record> FindBest(uint32_t scenario,
+                               const double center[kCoefficientCount],
+                               const double radius[kCoefficientCount],
+                               size_t count) const;
+
+  // Seeds tuning from prior results: moves the parameters to the best
+  // whole-lap evaluation within kSeedRadius deltas, within their feasible
+  // ranges, and narrows the deltas to the spread of the best evaluations
+  // there. The transforms and ranges are kept.
+  // @param[in]     scenario    Scenario identifier
+  // @param[in,out] parameters  Initial parameters and deltas
+  // @return                    True if seeded
+  bool Seed(uint32_t scenario, Tuner::ParameterSequence& parameters) const;
+
+private:
+  // Search box radius of seeding in units of the parameter deltas
+  static constexpr double kSeedRadius = 10.;
+
+  // Number of best evaluations defining the deltas when seeding
+  static constexpr size_t kSeedCount = 5;
+
+  // Key of the exact index
+  struct Key {
+    uint32_t scenario;
+    double budget;
+    double coefficients[kCoefficientCount];
+    bool operator==(const Key& rhs) const;
+  };
+
+  // Hash of the exact index
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  // Guards all members below
+  mutable std::mutex mutex_;
+
+  // Descriptor of the locked file
+  int fd_;
+
+  // Mapped file and its size
+  void* mapped_;
+  size_t mapped_size_;
+
+  // First record within the mapped file
+  Record* records_;
+
+  // Indices of whole-lap records per scenario, by increasing error, then in
+  // the order of appending
+  std::unordered_map<uint32_t, std::multimap<double, uint32_t>>
+    full_laps_by_error_;
+
+  // Index of records by exact coefficients
+  std::unordered_map<Key, uint32_t, KeyHash> by_key_;
+
+  // Maps the file with the given capacity of records, growing the file if
+  // needed. The current mapping is kept if it fails.
+  bool Map(size_t capacity);
+
+  // Adds a record to the in-memory indices.
+  void Index(uint32_t i);
+
+  // Unmaps and closes the file.
+  void Close();
+};
+
+#endif // EXPERIMENT_STORE_H
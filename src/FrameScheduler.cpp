@@ -0,0 +1,72 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+FrameScheduler::FrameScheduler(const Settings& settings)
+  : settings_(settings),
+    n_pushed_() {
+  // Empty.
+}
+
+double FrameScheduler::Push(void* context,
+                            double arrival,
+                            double cte,
+                            double speed) {
+  auto urgency = std::min(1., std::fabs(cte) / settings_.off_track_cte);
+  auto deadline = arrival + settings_.budget * (1. - urgency);
+  // A frame never overtakes an earlier one of its session
+  auto& pending = pending_[context];
+  if (pending.count > 0) {
+    deadline = std::max(deadline, pending.deadline);
+  }
+  ++pending.count;
+  pending.deadline = deadline;
+  frames_.push_back({context, arrival, deadline, cte, speed, n_pushed_++});
+  std::push_heap(frames_.begin(), frames_.end(), IsLater);
+  return deadline;
+}
+
+size_t FrameScheduler::Run(const Handler& handle, size_t max_count) {
+  size_t n_run = 0;
+  while (!frames_.empty() && n_run < max_count) {
+    std::pop_heap(frames_.begin(), frames_.end(), IsLater);
+    auto frame = frames_.back();
+    frames_.pop_back();
+    // A session keeps its entry until removed, so steady frames don't
+    // allocate
+    --pending_.find(frame.context)->second.count;
+    // The handler may push or remove frames
+    handle(frame);
+    ++n_run;
+  }
+  return n_run;
+}
+
+void FrameScheduler::Remove(void* context) {
+  auto it = pending_.find(context);
+  if (it == pending_.end()) {
+    return;
+  }
+  auto count = it->second.count;
+  pending_.erase(it);
+  if (count == 0) {
+    return;
+  }
+  frames_.erase(std::remove_if(frames_.begin(), frames_.end(),
+                               [context](const Frame& frame) {
+                                 return frame.context == context;
+                               }),
+                frames_.end());
+  std::make_heap(frames_.begin(), frames_.end(), IsLater);
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+bool FrameScheduler::IsLater(const Frame& a, const Frame& b) {
+  return a.deadline > b.deadline
+         || (a.deadline == b.deadline && a.sequence > b.sequence);
+}
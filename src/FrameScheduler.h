@@ -0,0 +1,93 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Earliest-deadline-first scheduler of the frames of many sessions served by
+// one event-loop thread, not thread-safe. The frames of all ready sockets are
+// pushed first, then run in the order of their deadlines: the arrival time
+// plus a budget shrinking with the urgency |CTE| / off-track CTE, so a vehicle
+// close to getting off track doesn't wait behind comfortable ones. The frames
+// of one session still run in the order of arrival.
+class FrameScheduler {
+public:
+  // Settings of the scheduler
+  struct Settings {
+    // Budget in seconds of a frame with zero CTE, 0 runs frames in the order
+    // of arrival
+    double budget;
+    // CTE when the vehicle is considered off-track, positive, frames at it
+    // have no budget
+    double off_track_cte;
+  };
+
+  // Pending frame
+  struct Frame {
+    // Session of the frame, e.g. its connection
+    void* context;
+    // Arrival and deadline times in seconds
+    double arrival;
+    double deadline;
+    // Cross-track error (CTE) and speed in miles-per-hour
+    double cte;
+    double speed;
+    // Order of pushing, breaks ties of deadlines
+    uint64_t sequence;
+  };
+
+  // Runs a frame.
+  typedef std::function<void(const Frame& frame)> Handler;
+
+  // Constructor.
+  // @param settings  Settings of the scheduler
+  explicit FrameScheduler(const Settings& settings);
+
+  // Pushes a frame.
+  // @param context  Session of the frame
+  // @param arrival  Arrival time in seconds
+  // @param cte      Cross-track error (CTE)
+  // @param speed    Speed in miles-per-hour
+  // @return         Deadline of the frame in seconds
+  double Push(void* context, double arrival, double cte, double speed);
+
+  // Runs pending frames in the order of their deadlines.
+  // @param handle     Handler of every frame
+  // @param max_count  Max number of frames to run, so that the loop drains
+  //                   newly ready sockets in between
+  // @return           Number of frames run
+  size_t Run(const Handler& handle, size_t max_count = SIZE_MAX);
+
+  // Drops the pending frames of a session, e.g. on disconnection.
+  // @param context  Session
+  void Remove(void* context);
+
+  // Gets the number of pending frames.
+  size_t GetPendingCount() const { return frames_.size(); }
+
+private:
+  // Indicates a frame runs after another one, orders the heap of frames.
+  static bool IsLater(const Frame& a, const Frame& b);
+
+  // Settings of the scheduler
+  Settings settings_;
+
+  // Heap of pending frames
+  std::vector<Frame> frames_;
+
+  // Number of pending frames and the latest deadline of every session, kept
+  // until the session is removed
+  struct Pending {
+    size_t count;
+    double deadline;
+  };
+  std::unordered_map<void*, Pending> pending_;
+
+  // Number of frames pushed
+  uint64_t n_pushed_;
+};
+
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,85 @@
+#include "Histogram.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the bucket index of a sample.
+// @param[in] nanoseconds  Sample value
+// @return                 Index of the bucket, saturated at the last bucket
+size_t GetBucket(uint64_t nanoseconds) {
+  size_t bucket = 0;
+  while (nanoseconds > 1 && bucket + 1 < Histogram::kBucketCount) {
+    nanoseconds >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+Histogram::Histogram() {
+  Clear();
+}
+
+void Histogram::Add(uint64_t nanoseconds) {
+  ++buckets_[GetBucket(nanoseconds)];
+  ++count_;
+  sum_ += nanoseconds;
+  max_ = std::max(max_, nanoseconds);
+}
+
+void Histogram::Merge(const Histogram& other) {
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+}
+
+void Histogram::Clear() {
+  std::fill(buckets_, buckets_ + kBucketCount, 0);
+  count_ = 0;
+  sum_ = 0;
+  max_ = 0;
+}
+
+double Histogram::GetMean() const {
+  return count_ ? static_cast<double>(sum_) / count_ : 0.;
+}
+
+uint64_t Histogram::GetPercentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(percentile / 100. * count_ + 0.5);
+  rank = std::max<uint64_t>(1, std::min(rank, count_));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::min(max_, (uint64_t(2) << i) - 1);
+    }
+  }
+  return max_;
+}
+
+void Histogram::Print(std::ostream& os, const std::string& label) const {
+  os << label << ": n=" << count_ << std::fixed << std::setprecision(0)
+     << ", mean=" << GetMean() << "ns, p50=" << GetPercentile(50)
+     << "ns, p99=" << GetPercentile(99) << "ns, p99.9=" << GetPercentile(99.9)
+     << "ns, max=" << max_ << "ns" << std::defaultfloat << std::endl;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    if (buckets_[i]) {
+      os << "  [" << (uint64_t(1) << i) << ", " << (uint64_t(2) << i)
+         << ")ns " << buckets_[i] << std::endl;
+    }
+  }
+}
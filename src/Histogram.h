@@ -0,0 +1,63 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Histogram of durations in nanoseconds with power-of-two buckets. Recording a
+// sample is O(1) and never allocates.
+class Histogram {
+public:
+  // Number of buckets, bucket i holds samples in the range [2^i, 2^(i+1)) ns
+  enum { kBucketCount = 40 };
+
+  // Constructor.
+  Histogram();
+
+  // Records a sample.
+  // @param nanoseconds  Sample value in nanoseconds
+  void Add(uint64_t nanoseconds);
+
+  // Merges samples of another histogram into this one.
+  // @param other  Histogram to merge
+  void Merge(const Histogram& other);
+
+  // Clears all samples.
+  void Clear();
+
+  // Gets the number of recorded samples.
+  uint64_t GetCount() const { return count_; }
+
+  // Gets the maximum recorded sample in nanoseconds.
+  uint64_t GetMax() const { return max_; }
+
+  // Gets the mean of recorded samples in nanoseconds.
+  double GetMean() const;
+
+  // Gets the upper boundary of the bucket containing the given percentile.
+  // @param percentile  Percentile within 0..100
+  // @return            Upper boundary in nanoseconds, 0 if there are no samples
+  uint64_t GetPercentile(double percentile) const;
+
+  // Prints a summary line followed by non-empty buckets.
+  // @param os     Output stream
+  // @param label  Name of the measured quantity
+  void Print(std::ostream& os, const std::string& label) const;
+
+private:
+  // Sample counts per bucket
+  uint64_t buckets_[kBucketCount];
+
+  // Total number of samples
+  uint64_t count_;
+
+  // Sum of samples in nanoseconds
+  uint64_t sum_;
+
+  // Maximum sample in nanoseconds
+  uint64_t max_;
+};
+
+#endif // HISTOGRAM_H
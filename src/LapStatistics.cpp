@@ -0,0 +1,127 @@
+#include "LapStatistics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Initial part of track where off track detection is not applied
+const auto kSkipOffTrackPart = 0.00125;
+
+// Initial part of track where max CTE updates are skipped
+const auto kSkipMaxCtePart = 0.025;
+
+// Error penalty when going off track
+const auto kOffTrackPenalty = 1e+6;
+
+// Meters in mile per international agreement of 1959
+const auto kMetersInMile = 1609.344;
+
+// Default framerate
+const auto kFrameRate = 25.;
+
+// Time passed between frames
+const auto kSecondsPerFrame = 1. / kFrameRate;
+
+// Coefficient of conversion miles-per-hour to meters-per-second
+const auto kMphToMps = kMetersInMile / (60. * 60.);
+
+// Coefficient for computing distance passed since a previous frame, given the
+// instant speed
+const auto kSpeedToDistanceCoeff = kMphToMps / kFrameRate;
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+LapStatistics::LapStatistics(double off_track_cte, double track_length)
+  : off_track_cte_(off_track_cte),
+    track_length_(track_length),
+    budget_(track_length),
+    no_max_cte_distance_(kSkipMaxCtePart * track_length),
+    no_off_track_distance_(kSkipOffTrackPart * track_length),
+    distance_(),
+    abort_distance_(),
+    n_frames_(),
+    max_cte_(),
+    max_absolute_cte_(),
+    sum_cte_(),
+    sum_steering_squared_(),
+    n_steering_(),
+    is_off_track_() {
+  // Empty.
+}
+
+void LapStatistics::Reset(double budget) {
+  budget_ = std::min(budget, track_length_);
+  distance_ = 0;
+  abort_distance_ = 0;
+  n_frames_ = 0;
+  max_cte_ = 0;
+  max_absolute_cte_ = 0;
+  sum_cte_ = 0;
+  sum_steering_squared_ = 0;
+  n_steering_ = 0;
+  is_off_track_ = false;
+}
+
+LapStatistics::Status LapStatistics::Update(double cte, double speed) {
+  ++n_frames_;
+  distance_ += kSpeedToDistanceCoeff * speed;
+  sum_cte_ += std::fabs(cte);
+  if (distance_ > no_max_cte_distance_) {
+    max_cte_ = std::max(max_cte_, cte);
+    max_absolute_cte_ = std::max(max_absolute_cte_, std::fabs(cte));
+  }
+
+  if (distance_ > no_off_track_distance_
+      && (std::fabs(cte) > off_track_cte_ || speed < 1.0)) {
+    is_off_track_ = true;
+    return Status::kOffTrack;
+  }
+  return distance_ > budget_ ? Status::kComplete : Status::kDriving;
+}
+
+void LapStatistics::AddSteering(double steering) {
+  sum_steering_squared_ += steering * steering;
+  ++n_steering_;
+}
+
+bool LapStatistics::Abort(double n_frames, double speed) {
+  auto abort_distance = kSpeedToDistanceCoeff * speed * n_frames;
+  if (distance_ + abort_distance >= budget_) {
+    return false;
+  }
+  abort_distance_ = abort_distance;
+  is_off_track_ = true;
+  return true;
+}
+
+double LapStatistics::GetError() const {
+  if (is_off_track_) {
+    // Scaled by the completed fraction of the budget, equals the penalty per
+    // meter for the whole lap
+    return kOffTrackPenalty * budget_
+      / (track_length_ * (distance_ + abort_distance_));
+  }
+  return max_cte_ * GetAverageCte();
+}
+
+double LapStatistics::GetTime() const {
+  return kSecondsPerFrame * n_frames_;
+}
+
+double LapStatistics::GetAverageSpeed() const {
+  return n_frames_ ? distance_ / (kMphToMps * GetTime()) : 0.;
+}
+
+double LapStatistics::GetAverageCte() const {
+  return n_frames_ ? sum_cte_ / n_frames_ : 0.;
+}
+
+double LapStatistics::GetSteeringEffort() const {
+  return n_steering_ ? sum_steering_squared_ / n_steering_ : 0.;
+}
@@ -0,0 +1,123 @@
+#ifndef LAP_STATISTICS_H
+#define LAP_STATISTICS_H
+
+// Scores driving with a set of coefficients over a distance budget, which is
+// the whole lap or a part of it. The error of a completed budget is the max
+// CTE times the average CTE, both independent of the distance driven, and the
+// error of going off-track depends only on the completed fraction of the
+// budget, so scores of different budgets are comparable. The initial part of
+// the track, where the vehicle accelerates, is excluded the same way for every
+// budget.
+class LapStatistics {
+public:
+  // Defines the outcome of an update
+  enum class Status {
+    // The budget is not yet driven
+    kDriving,
+    // The vehicle got off track
+    kOffTrack,
+    // The budget is driven
+    kComplete
+  };
+
+  // Constructor, the budget is the whole lap.
+  // @param off_track_cte  CTE when the vehicle is considered off-track
+  // @param track_length   Track length in meters
+  LapStatistics(double off_track_cte, double track_length);
+
+  // Clears the statistics and sets the distance budget.
+  // @param budget  Distance to drive in meters, at most the track length
+  void Reset(double budget);
+
+  // Updates the statistics with the new values of CTE and speed.
+  // @param cte    Cross-track error (CTE)
+  // @param speed  Speed in miles-per-hour
+  // @return       Outcome of the update
+  Status Update(double cte, double speed);
+
+  // Records the steering value applied after an update.
+  // @param steering  Steering value within -1..1
+  void AddSteering(double steering);
+
+  // Stops driving ahead of getting off track, which is predicted after the
+  // given number of frames at the given speed. The error is then the off-track
+  // penalty at the predicted distance, graded like getting off track there.
+  // @param n_frames  Predicted number of frames until getting off track
+  // @param speed     Speed in miles-per-hour
+  // @return          True if stopped, false if the budget is driven before
+  //                  the predicted distance
+  bool Abort(double n_frames, double speed);
+
+  // Gets the error of the completed budget, or the off-track penalty.
+  double GetError() const;
+
+  // Gets the distance budget in meters.
+  double GetBudget() const { return budget_; }
+
+  // Indicates the budget is the whole lap.
+  bool IsFullLap() const { return budget_ >= track_length_; }
+
+  // Gets the travel distance in meters.
+  double GetDistance() const { return distance_; }
+
+  // Gets the travel time in seconds.
+  double GetTime() const;
+
+  // Gets the average speed in miles-per-hour.
+  double GetAverageSpeed() const;
+
+  // Gets the max CTE after the initial part of the track.
+  double GetMaxCte() const { return max_cte_; }
+
+  // Gets the max absolute CTE after the initial part of the track.
+  double GetMaxAbsoluteCte() const { return max_absolute_cte_; }
+
+  // Gets the average absolute CTE.
+  double GetAverageCte() const;
+
+  // Gets the steering effort: the mean squared steering value.
+  double GetSteeringEffort() const;
+
+private:
+  // CTE when the vehicle is considered off-track
+  double off_track_cte_;
+
+  // Track length in meters
+  double track_length_;
+
+  // Distance budget in meters
+  double budget_;
+
+  // Initial distance where max CTE tracking is not yet done
+  double no_max_cte_distance_;
+
+  // Initial distance where going off-track is not detected
+  double no_off_track_distance_;
+
+  // Travel distance in meters
+  double distance_;
+
+  // Predicted distance to getting off track after an abort in meters
+  double abort_distance_;
+
+  // Number of frames observed
+  unsigned long int n_frames_;
+
+  // Maximum CTE registered so far
+  double max_cte_;
+
+  // Maximum absolute CTE registered so far
+  double max_absolute_cte_;
+
+  // Sum of absolute CTE
+  double sum_cte_;
+
+  // Sum of squared steering values and their number
+  double sum_steering_squared_;
+  unsigned long int n_steering_;
+
+  // Indicates the vehicle got off track
+  bool is_off_track_;
+};
+
+#endif // LAP_STATISTICS_H
@@ -0,0 +1,196 @@
+#include "Mpc.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Default framerate
+const auto kFrameRate = 25.;
+
+// Time passed between frames
+const auto kSecondsPerFrame = 1. / kFrameRate;
+
+// Coefficient of conversion miles-per-hour to meters-per-second
+const auto kMphToMps = 1609.344 / (60. * 60.);
+
+// Distance between the front axle and the center of gravity in meters
+const auto kLf = 2.67;
+
+// Max steering angle in radians corresponding to the steering value of 1
+const auto kMaxSteeringAngle = 25. / 180. * M_PI;
+
+// Minimum speed in meters-per-second used for estimating the heading
+const auto kMinSpeed = 0.5;
+
+// Cost weights of the CTE, the heading, the steering, and the steering change
+const auto kCteWeight = 1.0;
+const auto kHeadingWeight = 1.0;
+const auto kSteeringWeight = 0.01;
+const auto kSteeringChangeWeight = 0.5;
+
+// Max number of solver iterations per frame
+const auto kMaxIterations = 200;
+
+// Convergence tolerance of the solution
+const auto kTolerance = 1e-5;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the monotonic time in nanoseconds.
+uint64_t GetNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+Mpc::Mpc(uint64_t deadline_ns)
+  : deadline_ns_(deadline_ns),
+    cte_prev_(),
+    is_cte_prev_initialized_(),
+    steering_prev_(),
+    solution_(),
+    hessian_(),
+    gradient_(),
+    cte_gain_(),
+    free_cte_(),
+    free_heading_(),
+    n_deadline_misses_() {
+  // Empty.
+}
+
+double Mpc::ComputeSteering(double cte, double speed) {
+  auto start = GetNanoseconds();
+  if (!is_cte_prev_initialized_) {
+    cte_prev_ = cte;
+    is_cte_prev_initialized_ = true;
+  }
+  auto distance = std::max(kMphToMps * speed, kMinSpeed) * kSecondsPerFrame;
+  auto heading = (cte - cte_prev_) / distance;
+  cte_prev_ = cte;
+
+  BuildProblem(cte, heading, distance, distance * kMaxSteeringAngle / kLf);
+  auto is_solved = SolveProblem(start);
+  solve_times_.Add(GetNanoseconds() - start);
+  // Shift the solution to warm-start the next frame, a partial one on a miss
+  // is still feasible and closer than the previous frame's
+  auto steering = solution_[0];
+  std::copy(solution_ + 1, solution_ + kHorizon, solution_);
+  if (!is_solved) {
+    ++n_deadline_misses_;
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  steering_prev_ = steering;
+  return steering;
+}
+
+void Mpc::SetApplied(double steering) {
+  steering_prev_ = std::max(-1., std::min(1., steering));
+}
+
+void Mpc::Reset() {
+  cte_prev_ = 0;
+  is_cte_prev_initialized_ = false;
+  steering_prev_ = 0;
+  std::fill(solution_, solution_ + kHorizon, 0.);
+}
+
+void Mpc::ClearStatistics() {
+  solve_times_.Clear();
+  n_deadline_misses_ = 0;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void Mpc::BuildProblem(double cte, double heading, double a, double b) {
+  // Heading at step k+1 is heading + b * sum(u[0..k]), CTE at step k+1 is
+  // cte + (k+1) * a * heading + a * b * sum((k-j) * u[j], j < k)
+  for (auto k = 0; k < kHorizon; ++k) {
+    free_cte_[k] = cte + (k + 1) * a * heading;
+    free_heading_[k] = heading;
+    for (auto j = 0; j < kHorizon; ++j) {
+      cte_gain_[k][j] = j < k ? a * b * (k - j) : 0.;
+    }
+  }
+
+  for (auto i = 0; i < kHorizon; ++i) {
+    for (auto j = i; j < kHorizon; ++j) {
+      auto cte_term = 0.;
+      for (auto k = std::max(i, j) + 1; k < kHorizon; ++k) {
+        cte_term += cte_gain_[k][i] * cte_gain_[k][j];
+      }
+      auto heading_term = b * b * (kHorizon - j);
+      auto h = kCteWeight * cte_term + kHeadingWeight * heading_term;
+      if (i == j) {
+        h += kSteeringWeight
+          + kSteeringChangeWeight * (i + 1 < kHorizon ? 2. : 1.);
+      } else if (j == i + 1) {
+        h -= kSteeringChangeWeight;
+      }
+      hessian_[i][j] = h;
+      hessian_[j][i] = h;
+    }
+    auto cte_term = 0.;
+    auto heading_term = 0.;
+    for (auto k = i + 1; k < kHorizon; ++k) {
+      cte_term += cte_gain_[k][i] * free_cte_[k];
+    }
+    for (auto k = i; k < kHorizon; ++k) {
+      heading_term += b * free_heading_[k];
+    }
+    gradient_[i] = kCteWeight * cte_term + kHeadingWeight * heading_term;
+  }
+  gradient_[0] -= kSteeringChangeWeight * steering_prev_;
+}
+
+bool Mpc::SolveProblem(uint64_t start) {
+  // Gershgorin bound of the largest eigenvalue gives a safe step size
+  auto lipschitz = 0.;
+  for (auto i = 0; i < kHorizon; ++i) {
+    auto row_sum = 0.;
+    for (auto j = 0; j < kHorizon; ++j) {
+      row_sum += std::fabs(hessian_[i][j]);
+    }
+    lipschitz = std::max(lipschitz, row_sum);
+  }
+
+  double y[kHorizon];
+  double next[kHorizon];
+  std::copy(solution_, solution_ + kHorizon, y);
+  auto t = 1.;
+  for (auto iteration = 0; iteration < kMaxIterations; ++iteration) {
+    if (GetNanoseconds() - start > deadline_ns_) {
+      return false;
+    }
+    auto change = 0.;
+    for (auto i = 0; i < kHorizon; ++i) {
+      auto g = gradient_[i];
+      for (auto j = 0; j < kHorizon; ++j) {
+        g += hessian_[i][j] * y[j];
+      }
+      next[i] = std::max(-1., std::min(1., y[i] - g / lipschitz));
+      change = std::max(change, std::fabs(next[i] - solution_[i]));
+    }
+    auto t_next = 0.5 * (1. + std::sqrt(1. + 4. * t * t));
+    for (auto i = 0; i < kHorizon; ++i) {
+      y[i] = next[i] + (t - 1.) / t_next * (next[i] - solution_[i]);
+      solution_[i] = next[i];
+    }
+    t = t_next;
+    if (change < kTolerance) {
+      break;
+    }
+  }
+  return true;
+}
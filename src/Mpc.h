@@ -0,0 +1,92 @@
+#ifndef MPC_H
+#define MPC_H
+
+#include <cstdint>
+#include "Histogram.h"
+#include "SteeringLaw.h"
+
+// Model-predictive steering control. Every frame solves a small box-constrained
+// quadratic program over a fixed horizon of a linear lateral error model,
+// warm-started from the previous solution. The solver is bounded by a
+// per-frame compute deadline, when it overruns the steering value is NaN, and
+// the caller is supposed to fall back to another steering law.
+class Mpc : public SteeringLaw<Mpc> {
+public:
+  // Number of frames in the prediction horizon
+  enum { kHorizon = 10 };
+
+  // Constructor.
+  // @param deadline_ns  Per-frame compute deadline in nanoseconds
+  explicit Mpc(uint64_t deadline_ns);
+
+  // Implements SteeringLaw.
+  // @param cte    Cross-track error (CTE)
+  // @param speed  Speed in miles-per-hour
+  // @return       Steering value within -1..1, or NaN if the solver overran
+  //               the deadline
+  double ComputeSteering(double cte, double speed);
+
+  // Sets the steering applied instead after a deadline miss, which the next
+  // frame penalizes changes against.
+  // @param steering  Steering value, clamped to -1..1
+  void SetApplied(double steering);
+
+  // Resets the vehicle state and the warm start, keeps the statistics.
+  void Reset();
+
+  // Clears the solve times and the deadline misses.
+  void ClearStatistics();
+
+  // Gets the histogram of solve times.
+  const Histogram& GetSolveTimes() const { return solve_times_; }
+
+  // Gets the number of solves which overran the deadline.
+  unsigned long int GetDeadlineMisses() const { return n_deadline_misses_; }
+
+  // Gets the per-frame compute deadline in nanoseconds.
+  uint64_t GetDeadline() const { return deadline_ns_; }
+
+private:
+  // Per-frame compute deadline in nanoseconds
+  uint64_t deadline_ns_;
+
+  // Previous CTE and indication whether it's initialized
+  double cte_prev_;
+  bool is_cte_prev_initialized_;
+
+  // Steering applied at the previous frame
+  double steering_prev_;
+
+  // Solution over the horizon, shifted to warm-start the next frame
+  double solution_[kHorizon];
+
+  // Preallocated QP matrices: cost is u'Hu + 2g'u
+  double hessian_[kHorizon][kHorizon];
+  double gradient_[kHorizon];
+
+  // Preallocated prediction matrices: the error and the heading over the
+  // horizon are free_cte_ + cte_gain_ * u and free_heading_ + heading_gain_ * u
+  double cte_gain_[kHorizon][kHorizon];
+  double free_cte_[kHorizon];
+  double free_heading_[kHorizon];
+
+  // Solve times
+  Histogram solve_times_;
+
+  // Number of solves which overran the deadline
+  unsigned long int n_deadline_misses_;
+
+  // Builds the QP for the current state.
+  // @param cte      Current CTE
+  // @param heading  Current heading w.r.t. the track
+  // @param a        Lateral displacement per unit of heading within a frame
+  // @param b        Heading change per unit of steering within a frame
+  void BuildProblem(double cte, double heading, double a, double b);
+
+  // Solves the QP with accelerated projected gradient.
+  // @param start  Start time of the frame in nanoseconds
+  // @return       True if solved within the deadline
+  bool SolveProblem(uint64_t start);
+};
+
+#endif // MPC_H
@@ -0,0 +1,88 @@
+#include "NetworkImpairment.h"
+#include <cmath>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Names of the distributions
+const char* kDistributionNames[] = {"constant", "uniform", "normal",
+                                    "exponential", "pareto"};
+
+// Shape of the Pareto distribution
+const auto kParetoShape = 2.;
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+NetworkImpairment::NetworkImpairment(const Settings& settings,
+                                     unsigned int seed)
+  : settings_(settings),
+    generator_(seed),
+    last_delivery_(-HUGE_VAL) {
+  // Empty.
+}
+
+bool NetworkImpairment::Send(double time, double& delivery,
+                             bool is_impaired) {
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  if (is_impaired && settings_.drop_rate > 0
+      && uniform(generator_) < settings_.drop_rate) {
+    return false;
+  }
+  delivery = time + settings_.latency + DrawJitter();
+  if (is_impaired && settings_.reorder_rate > 0
+      && uniform(generator_) < settings_.reorder_rate) {
+    // Neither held back by the earlier messages nor holding back the next
+    // ones
+    return true;
+  }
+  delivery = std::max(delivery, last_delivery_);
+  last_delivery_ = delivery;
+  return true;
+}
+
+bool NetworkImpairment::GetDistribution(const std::string& name,
+                                        Distribution& distribution) {
+  for (size_t i = 0; i < sizeof(kDistributionNames) / sizeof(const char*);
+       ++i) {
+    if (name == kDistributionNames[i]) {
+      distribution = static_cast<Distribution>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+double NetworkImpairment::DrawJitter() {
+  auto jitter = settings_.jitter;
+  if (!(jitter > 0)) {
+    return 0.;
+  }
+  switch (settings_.distribution) {
+    case Distribution::kConstant:
+      return 0.;
+    case Distribution::kUniform:
+      return std::uniform_real_distribution<double>(0., 2. * jitter)(
+        generator_);
+    case Distribution::kNormal:
+      // The mean of the half-normal is sigma * sqrt(2 / pi)
+      return std::fabs(std::normal_distribution<double>(
+        0., jitter * std::sqrt(M_PI / 2.))(generator_));
+    case Distribution::kExponential:
+      return std::exponential_distribution<double>(1. / jitter)(generator_);
+    case Distribution::kPareto:
+      // Pareto of the scale jitter * (shape - 1) less the scale, so its mean
+      // is the jitter
+      return jitter * (kParetoShape - 1.)
+             * (std::pow(1. - std::uniform_real_distribution<double>(0., 1.)(
+                           generator_), -1. / kParetoShape) - 1.);
+  }
+  return 0.;
+}
@@ -0,0 +1,171 @@
+#ifndef NETWORK_IMPAIRMENT_H
+#define NETWORK_IMPAIRMENT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Model of an impaired network link between the simulator and pid. Every
+// message is delayed by the base latency plus jitter drawn from a
+// distribution, and may be dropped. Messages keep the order of sending, a
+// late one holds back the next ones like on a TCP connection, unless a message
+// is picked to be reordered, then it may overtake the earlier ones.
+class NetworkImpairment {
+public:
+  // Distributions of the jitter
+  enum class Distribution {
+    // No jitter
+    kConstant,
+    // Uniform within 0..2 * jitter
+    kUniform,
+    // Half-normal, the absolute value of a normal distribution
+    kNormal,
+    // Exponential
+    kExponential,
+    // Pareto of shape 2, heavy-tailed
+    kPareto
+  };
+
+  // Settings of the link
+  struct Settings {
+    // Base latency in seconds
+    double latency;
+    // Mean jitter on top of the base latency in seconds, and its
+    // distribution
+    double jitter;
+    Distribution distribution;
+    // Part of the messages that may overtake earlier ones, within 0..1
+    double reorder_rate;
+    // Part of the messages dropped, within 0..1
+    double drop_rate;
+  };
+
+  // Constructor.
+  // @param settings  Settings of the link
+  // @param seed      Seed of the random generator
+  NetworkImpairment(const Settings& settings, unsigned int seed);
+
+  // Sends a message.
+  // @param[in]  time         Time of sending in seconds, non-decreasing
+  // @param[out] delivery     Time of delivery in seconds, if not dropped
+  // @param[in]  is_impaired  False to only delay the message, it's then
+  //                          neither dropped nor reordered
+  // @return                  False if the message is dropped
+  bool Send(double time, double& delivery, bool is_impaired = true);
+
+  // Gets a distribution by its name: "constant", "uniform", "normal",
+  // "exponential" or "pareto".
+  // @param[in]  name          Name
+  // @param[out] distribution  Distribution
+  // @return                   False if the name is unknown
+  static bool GetDistribution(const std::string& name,
+                              Distribution& distribution);
+
+private:
+  // Draws the jitter of a message.
+  // @return  Jitter in seconds
+  double DrawJitter();
+
+  // Settings of the link
+  Settings settings_;
+
+  // Random generator
+  std::mt19937 generator_;
+
+  // Latest delivery time of the messages kept in order
+  double last_delivery_;
+};
+
+// Messages in flight over an impaired link, received by their delivery time.
+// @tparam T  Type of a message
+template<typename T>
+class ImpairedChannel {
+public:
+  // Constructor.
+  // @param settings  Settings of the link
+  // @param seed      Seed of the random generator
+  ImpairedChannel(const NetworkImpairment::Settings& settings,
+                  unsigned int seed)
+    : impairment_(settings, seed),
+      n_sent_(),
+      n_dropped_() {
+    // Empty.
+  }
+
+  // Sends a message, unless the link drops it.
+  // @param time         Time of sending in seconds, non-decreasing
+  // @param message      Message
+  // @param is_impaired  False to only delay the message, it's then neither
+  //                     dropped nor reordered
+  void Send(double time, const T& message, bool is_impaired = true) {
+    double delivery;
+    if (!impairment_.Send(time, delivery, is_impaired)) {
+      ++n_dropped_;
+      return;
+    }
+    messages_.push_back({delivery, n_sent_++, message});
+    std::push_heap(messages_.begin(), messages_.end(), IsLater);
+  }
+
+  // Receives the messages delivered by a time, in the order of delivery.
+  // @param[in]  time        Time in seconds
+  // @param[out] messages    Messages, appended
+  // @param[out] deliveries  Delivery times of the messages in seconds,
+  //                         appended if not nullptr
+  // @return                 Number of messages received
+  size_t Receive(double time, std::vector<T>& messages,
+                 std::vector<double>* deliveries = nullptr) {
+    size_t n_received = 0;
+    while (!messages_.empty() && messages_.front().delivery <= time) {
+      std::pop_heap(messages_.begin(), messages_.end(), IsLater);
+      if (deliveries) {
+        deliveries->push_back(messages_.back().delivery);
+      }
+      messages.push_back(std::move(messages_.back().message));
+      messages_.pop_back();
+      ++n_received;
+    }
+    return n_received;
+  }
+
+  // Gets the delivery time of the next message in flight.
+  // @return  Delivery time in seconds, or infinity if none is in flight
+  double GetNextDelivery() const {
+    return messages_.empty() ? HUGE_VAL : messages_.front().delivery;
+  }
+
+  // Gets the number of messages in flight.
+  size_t GetPendingCount() const { return messages_.size(); }
+
+  // Gets the number of dropped messages.
+  uint64_t GetDroppedCount() const { return n_dropped_; }
+
+private:
+  // Message in flight
+  struct InFlight {
+    double delivery;
+    uint64_t sequence;
+    T message;
+  };
+
+  // Indicates a message is delivered after another one, orders the heap.
+  static bool IsLater(const InFlight& a, const InFlight& b) {
+    return a.delivery > b.delivery
+           || (a.delivery == b.delivery && a.sequence > b.sequence);
+  }
+
+  // Model of the link
+  NetworkImpairment impairment_;
+
+  // Heap of the messages in flight
+  std::vector<InFlight> messages_;
+
+  // Number of messages sent and dropped
+  uint64_t n_sent_;
+  uint64_t n_dropped_;
+};
+
+#endif // NETWORK_IMPAIRMENT_H
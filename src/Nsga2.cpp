@@ -0,0 +1,290 @@
+#include "Nsga2.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Probability of crossover of a pair of parents
+const auto kCrossoverProbability = 0.9;
+
+// Distribution index of simulated binary crossover
+const auto kCrossoverIndex = 15.;
+
+// Distribution index of polynomial mutation
+const auto kMutationIndex = 20.;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Indicates the first individual is better for selection.
+bool IsBetter(const Nsga2::Individual& a, const Nsga2::Individual& b) {
+  return a.rank < b.rank || (a.rank == b.rank && a.crowding > b.crowding);
+}
+
+// Computes crowding distances within a front.
+// @param[in,out] individuals  All individuals
+// @param[in]     front        Indices of individuals of the front
+void ComputeCrowding(std::vector<Nsga2::Individual>& individuals,
+                     std::vector<size_t> front) {
+  for (auto i : front) {
+    individuals[i].crowding = 0;
+  }
+  if (front.empty()) {
+    return;
+  }
+  auto n_objectives = individuals[front[0]].objectives.size();
+  for (size_t m = 0; m < n_objectives; ++m) {
+    std::sort(front.begin(), front.end(), [&individuals, m](size_t a,
+                                                            size_t b) {
+      return individuals[a].objectives[m] < individuals[b].objectives[m];
+    });
+    auto min = individuals[front.front()].objectives[m];
+    auto max = individuals[front.back()].objectives[m];
+    individuals[front.front()].crowding =
+      std::numeric_limits<double>::infinity();
+    individuals[front.back()].crowding =
+      std::numeric_limits<double>::infinity();
+    if (!(max > min)) {
+      continue;
+    }
+    for (size_t k = 1; k + 1 < front.size(); ++k) {
+      individuals[front[k]].crowding +=
+        (individuals[front[k + 1]].objectives[m]
+         - individuals[front[k - 1]].objectives[m]) / (max - min);
+    }
+  }
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+Nsga2::Nsga2(const Tuner::ParameterSequence& parameters,
+             size_t population,
+             const Evaluate& evaluate,
+             unsigned int n_threads,
+             unsigned int seed)
+  : population_size_(std::max<size_t>(2, population + population % 2)),
+    evaluate_(evaluate),
+    n_threads_(n_threads ? n_threads
+                         : std::max(1u, std::thread::hardware_concurrency())),
+    rng_(seed),
+    initial_parameters_(parameters),
+    n_evaluations_() {
+  for (const auto& parameter : parameters) {
+    lower_.push_back(parameter.p - kSearchRadius * std::fabs(parameter.dp));
+    upper_.push_back(parameter.p + kSearchRadius * std::fabs(parameter.dp));
+  }
+}
+
+void Nsga2::Initialize() {
+  std::vector<Individual> individuals(population_size_);
+  std::uniform_real_distribution<double> uniform;
+  for (size_t i = 0; i < individuals.size(); ++i) {
+    individuals[i].parameters = initial_parameters_;
+    for (size_t j = 0; i > 0 && j < lower_.size(); ++j) {
+      individuals[i].parameters[j].p =
+        lower_[j] + (upper_[j] - lower_[j]) * uniform(rng_);
+    }
+  }
+  EvaluateAll(individuals);
+  Select(individuals);
+}
+
+void Nsga2::Evolve() {
+  assert(!population_.empty());
+  std::vector<Individual> offspring(population_size_);
+  for (size_t i = 0; i < offspring.size(); i += 2) {
+    Reproduce(Tournament(), Tournament(), offspring[i], offspring[i + 1]);
+  }
+  EvaluateAll(offspring);
+  offspring.insert(offspring.end(), population_.begin(), population_.end());
+  Select(offspring);
+}
+
+std::vector<Nsga2::Individual> Nsga2::GetFront() const {
+  std::vector<Individual> front;
+  for (const auto& individual : population_) {
+    if (individual.rank == 0 && individual.violation <= 0) {
+      front.push_back(individual);
+    }
+  }
+  std::sort(front.begin(), front.end(), [](const Individual& a,
+                                           const Individual& b) {
+    return a.objectives.front() < b.objectives.front();
+  });
+  return front;
+}
+
+void Nsga2::WriteCsv(std::ostream& os,
+                     const std::vector<Individual>& individuals,
+                     const std::vector<std::string>& parameter_names,
+                     const std::vector<std::string>& objective_names) {
+  auto separator = "";
+  for (const auto& name : parameter_names) {
+    os << separator << name;
+    separator = ",";
+  }
+  for (const auto& name : objective_names) {
+    os << separator << name;
+    separator = ",";
+  }
+  os << std::endl;
+  for (const auto& individual : individuals) {
+    separator = "";
+    for (const auto& parameter : individual.parameters) {
+      os << separator << parameter.p;
+      separator = ",";
+    }
+    for (auto objective : individual.objectives) {
+      os << separator << objective;
+      separator = ",";
+    }
+    os << std::endl;
+  }
+}
+
+bool Nsga2::Dominates(const Individual& a, const Individual& b) {
+  if (a.violation > 0 || b.violation > 0) {
+    return a.violation < b.violation;
+  }
+  auto is_better = false;
+  for (size_t m = 0; m < a.objectives.size(); ++m) {
+    if (a.objectives[m] > b.objectives[m]) {
+      return false;
+    }
+    is_better = is_better || a.objectives[m] < b.objectives[m];
+  }
+  return is_better;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void Nsga2::EvaluateAll(std::vector<Individual>& individuals) {
+  std::atomic<size_t> next(0);
+  auto work = [this, &individuals, &next]() {
+    for (auto i = next++; i < individuals.size(); i = next++) {
+      auto& individual = individuals[i];
+      individual.objectives.clear();
+      individual.violation = 0;
+      evaluate_(individual.parameters, individual.objectives,
+                individual.violation);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned int t = 1; t < std::min<size_t>(n_threads_,
+                                                individuals.size()); ++t) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  n_evaluations_ += individuals.size();
+}
+
+void Nsga2::Select(std::vector<Individual>& individuals) {
+  // Fast non-dominated sort
+  auto n = individuals.size();
+  std::vector<std::vector<size_t>> dominated(n);
+  std::vector<size_t> n_dominating(n);
+  std::vector<size_t> front;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = i + 1; j < n; ++j) {
+      if (Dominates(individuals[i], individuals[j])) {
+        dominated[i].push_back(j);
+        ++n_dominating[j];
+      } else if (Dominates(individuals[j], individuals[i])) {
+        dominated[j].push_back(i);
+        ++n_dominating[i];
+      }
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (n_dominating[i] == 0) {
+      front.push_back(i);
+    }
+  }
+
+  std::vector<Individual> selected;
+  for (size_t rank = 0; !front.empty() && selected.size() < population_size_;
+       ++rank) {
+    ComputeCrowding(individuals, front);
+    std::vector<size_t> next;
+    for (auto i : front) {
+      individuals[i].rank = rank;
+      for (auto j : dominated[i]) {
+        if (--n_dominating[j] == 0) {
+          next.push_back(j);
+        }
+      }
+    }
+    std::sort(front.begin(), front.end(), [&individuals](size_t a, size_t b) {
+      return IsBetter(individuals[a], individuals[b]);
+    });
+    for (size_t k = 0; k < front.size()
+                       && selected.size() < population_size_; ++k) {
+      selected.push_back(individuals[front[k]]);
+    }
+    front.swap(next);
+  }
+  population_.swap(selected);
+}
+
+const Nsga2::Individual& Nsga2::Tournament() {
+  std::uniform_int_distribution<size_t> pick(0, population_.size() - 1);
+  const auto& a = population_[pick(rng_)];
+  const auto& b = population_[pick(rng_)];
+  return IsBetter(a, b) ? a : b;
+}
+
+void Nsga2::Reproduce(const Individual& a, const Individual& b,
+                      Individual& c, Individual& d) {
+  std::uniform_real_distribution<double> uniform;
+  c.parameters = a.parameters;
+  d.parameters = b.parameters;
+  if (uniform(rng_) < kCrossoverProbability) {
+    for (size_t j = 0; j < lower_.size(); ++j) {
+      if (uniform(rng_) < 0.5) {
+        continue;
+      }
+      auto u = uniform(rng_);
+      auto beta = u <= 0.5 ?
+        std::pow(2. * u, 1. / (kCrossoverIndex + 1.)) :
+        std::pow(1. / (2. * (1. - u)), 1. / (kCrossoverIndex + 1.));
+      auto x1 = a.parameters[j].p;
+      auto x2 = b.parameters[j].p;
+      c.parameters[j].p = std::max(lower_[j], std::min(upper_[j],
+        0.5 * ((1. + beta) * x1 + (1. - beta) * x2)));
+      d.parameters[j].p = std::max(lower_[j], std::min(upper_[j],
+        0.5 * ((1. - beta) * x1 + (1. + beta) * x2)));
+    }
+  }
+  Mutate(c);
+  Mutate(d);
+}
+
+void Nsga2::Mutate(Individual& individual) {
+  std::uniform_real_distribution<double> uniform;
+  for (size_t j = 0; j < lower_.size(); ++j) {
+    if (uniform(rng_) * lower_.size() >= 1.) {
+      continue;
+    }
+    auto u = uniform(rng_);
+    auto delta = u < 0.5 ?
+      std::pow(2. * u, 1. / (kMutationIndex + 1.)) - 1. :
+      1. - std::pow(2. * (1. - u), 1. / (kMutationIndex + 1.));
+    auto& p = individual.parameters[j].p;
+    p = std::max(lower_[j], std::min(upper_[j],
+                                     p + delta * (upper_[j] - lower_[j])));
+  }
+}
@@ -0,0 +1,135 @@
+#ifndef NSGA2_H
+#define NSGA2_H
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Tuner.h"
+
+// Multi-objective optimization by the NSGA-II genetic algorithm. Keeps a
+// population of parameter sets ranked by non-dominated sorting, with the
+// crowding distance preserving diversity along every front. Objectives are
+// minimized. Constraints follow Deb's rules: a feasible individual dominates
+// an infeasible one, and of two infeasible ones the smaller violation wins.
+// Offspring of a generation are evaluated in parallel.
+class Nsga2 {
+public:
+  // Evaluated parameter set
+  struct Individual {
+    Tuner::ParameterSequence parameters;
+    // Objective values, all minimized
+    std::vector<double> objectives;
+    // Constraint violation, 0 if feasible
+    double violation;
+    // Index of the non-dominated front, 0 is the Pareto front
+    size_t rank;
+    // Crowding distance within the front
+    double crowding;
+  };
+
+  // Evaluates a parameter set, must be callable from several threads at once.
+  // @param[in]  parameters  Parameter set
+  // @param[out] objectives  Objective values, provided even if infeasible
+  // @param[out] violation   Constraint violation, 0 if feasible
+  typedef std::function<void(const Tuner::ParameterSequence& parameters,
+                             std::vector<double>& objectives,
+                             double& violation)> Evaluate;
+
+  // Constructor.
+  // @param parameters  Initial parameters, the search box of every parameter
+  //                    is p +/- kSearchRadius * dp
+  // @param population  Population size, rounded up to an even number
+  // @param evaluate    Objective function
+  // @param n_threads   Number of threads evaluating individuals, 0 means the
+  //                    number of hardware threads
+  // @param seed        Seed of the random generator
+  Nsga2(const Tuner::ParameterSequence& parameters,
+        size_t population,
+        const Evaluate& evaluate,
+        unsigned int n_threads = 0,
+        unsigned int seed = 1);
+
+  // Evaluates the initial population: the initial parameters and random ones
+  // within the search box.
+  void Initialize();
+
+  // Creates and evaluates offspring, and selects the next population out of
+  // parents and offspring.
+  void Evolve();
+
+  // Gets the population sorted by rank and decreasing crowding distance.
+  const std::vector<Individual>& GetPopulation() const { return population_; }
+
+  // Gets the feasible individuals of the Pareto front, sorted by the first
+  // objective.
+  std::vector<Individual> GetFront() const;
+
+  // Gets the number of evaluations so far.
+  size_t GetEvaluationCount() const { return n_evaluations_; }
+
+  // Writes individuals as CSV with a header line.
+  // @param os                Output stream
+  // @param individuals       Individuals to write
+  // @param parameter_names   Names of parameters
+  // @param objective_names   Names of objectives
+  static void WriteCsv(std::ostream& os,
+                       const std::vector<Individual>& individuals,
+                       const std::vector<std::string>& parameter_names,
+                       const std::vector<std::string>& objective_names);
+
+  // Indicates the first individual dominates the second one by Deb's rules.
+  static bool Dominates(const Individual& a, const Individual& b);
+
+private:
+  // Search box radius in units of the parameter deltas
+  static constexpr double kSearchRadius = 10.;
+
+  // Population size
+  size_t population_size_;
+
+  // Objective function
+  Evaluate evaluate_;
+
+  // Number of threads evaluating individuals
+  unsigned int n_threads_;
+
+  // Random generator of variation operators
+  std::mt19937 rng_;
+
+  // Initial parameters, the deltas are kept
+  Tuner::ParameterSequence initial_parameters_;
+
+  // Lower and upper corners of the search box
+  std::vector<double> lower_;
+  std::vector<double> upper_;
+
+  // Current population
+  std::vector<Individual> population_;
+
+  // Number of evaluations so far
+  size_t n_evaluations_;
+
+  // Evaluates individuals in parallel.
+  void EvaluateAll(std::vector<Individual>& individuals);
+
+  // Sorts individuals into fronts, computes crowding distances, and keeps
+  // the best population_size_ ones in population_.
+  // @param individuals  Parents and offspring
+  void Select(std::vector<Individual>& individuals);
+
+  // Picks the better of two random individuals.
+  const Individual& Tournament();
+
+  // Creates two children by simulated binary crossover and polynomial
+  // mutation.
+  void Reproduce(const Individual& a, const Individual& b,
+                 Individual& c, Individual& d);
+
+  // Applies polynomial mutation to every parameter with probability 1/n.
+  void Mutate(Individual& individual);
+};
+
+#endif // NSGA2_H
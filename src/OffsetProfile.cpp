@@ -0,0 +1,82 @@
+#include "OffsetProfile.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Relative tolerance of the step between the distances of a loaded profile
+const auto kStepTolerance = 1e-3;
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+OffsetProfile::OffsetProfile()
+  : bucket_length_(),
+    inverse_bucket_length_() {
+  // Empty.
+}
+
+bool OffsetProfile::Load(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  std::vector<double> distances;
+  std::vector<double> offsets;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream iss(line);
+    double distance;
+    double offset;
+    if (iss >> distance >> offset) {
+      distances.push_back(distance);
+      offsets.push_back(offset);
+    }
+  }
+  if (distances.size() < 2) {
+    return false;
+  }
+  auto bucket_length = distances[1] - distances[0];
+  for (size_t i = 0; i < distances.size(); ++i) {
+    if (std::fabs(distances[i] - i * bucket_length)
+        > kStepTolerance * bucket_length) {
+      return false;
+    }
+  }
+  return SetOffsets(bucket_length, offsets);
+}
+
+bool OffsetProfile::Save(const std::string& path) const {
+  std::ofstream file(path);
+  file << "distance,offset" << std::endl << std::setprecision(9);
+  for (size_t i = 0; i < offsets_.size(); ++i) {
+    file << i * bucket_length_ << "," << offsets_[i] << std::endl;
+  }
+  return static_cast<bool>(file);
+}
+
+bool OffsetProfile::SetOffsets(double bucket_length,
+                               const std::vector<double>& offsets) {
+  if (!(bucket_length > 0.) || !std::isfinite(bucket_length)
+      || offsets.empty()) {
+    return false;
+  }
+  for (auto offset : offsets) {
+    if (!std::isfinite(offset)) {
+      return false;
+    }
+  }
+  bucket_length_ = bucket_length;
+  inverse_bucket_length_ = 1. / bucket_length;
+  offsets_ = offsets;
+  return true;
+}
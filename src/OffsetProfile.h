@@ -0,0 +1,66 @@
+#ifndef OFFSET_PROFILE_H
+#define OFFSET_PROFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Target lateral offset from the centerline over a lap, such as a racing
+// line, in buckets of equal distance. The controller drives toward the offset
+// of the bucket it's in instead of the centerline. A lookup is O(1) by the
+// distance driven, wrapping around the lap.
+class OffsetProfile {
+public:
+  // Constructor, of an empty profile.
+  OffsetProfile();
+
+  // Loads the profile from a CSV file, a line "distance,offset" in meters per
+  // bucket, starting at 0 with a constant step. Other lines, such as a header,
+  // are skipped.
+  // @param path  Path of the file
+  // @return      True on success
+  bool Load(const std::string& path);
+
+  // Saves the profile to a CSV file with a header.
+  // @param path  Path of the file
+  // @return      True on success
+  bool Save(const std::string& path) const;
+
+  // Sets the offsets.
+  // @param bucket_length  Distance covered by a bucket in meters
+  // @param offsets        Offset of every bucket in meters, positive to the
+  //                       left of the centerline like CTE
+  // @return               True on success
+  bool SetOffsets(double bucket_length, const std::vector<double>& offsets);
+
+  // Indicates whether the profile is set.
+  bool IsLoaded() const { return !offsets_.empty(); }
+
+  // Gets the distance covered by a bucket in meters.
+  double GetBucketLength() const { return bucket_length_; }
+
+  // Gets the length of the lap in meters.
+  double GetLength() const { return bucket_length_ * offsets_.size(); }
+
+  // Gets the offsets of all buckets.
+  const std::vector<double>& GetOffsets() const { return offsets_; }
+
+  // Gets the target offset at a distance.
+  // @param distance  Distance driven since the start in meters, wraps around
+  //                  the lap
+  // @return          Offset in meters
+  double GetOffset(double distance) const {
+    auto bucket = static_cast<size_t>(distance * inverse_bucket_length_);
+    return offsets_[bucket % offsets_.size()];
+  }
+
+private:
+  // Distance covered by a bucket and its inverse
+  double bucket_length_;
+  double inverse_bucket_length_;
+
+  // Offset of every bucket
+  std::vector<double> offsets_;
+};
+
+#endif // OFFSET_PROFILE_H
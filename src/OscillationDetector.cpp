@@ -0,0 +1,113 @@
+#include "OscillationDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Min growth of the amplitude from one window to the next when diverging
+const auto kMinGrowthPerWindow = 1.2;
+
+// Min amplitude w.r.t. the off track CTE when diverging, smaller oscillation
+// is noise rather than ringing
+const auto kMinAmplitudeMargin = 0.4;
+
+// Number of frames in a row the amplitude must grow to detect divergence
+const auto kConfirmFrames = OscillationDetector::kWindow / 4;
+
+// Range of the number of zero crossings within the window when oscillating in
+// the steering band: at least one cycle, at most a cycle above the top bin
+const auto kMinCrossings = 2;
+const auto kMaxCrossings = 2 * OscillationDetector::kBinCount + 2;
+
+// Hysteresis of zero crossings w.r.t. the amplitude, ignores the noise
+const auto kCrossingHysteresis = 0.25;
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+OscillationDetector::OscillationDetector(double off_track_cte)
+  : off_track_cte_(off_track_cte) {
+  for (auto k = 0; k < kBinCount; ++k) {
+    twiddles_[k] = std::polar(1., 2. * M_PI * (k + 1) / kWindow);
+  }
+  Reset();
+}
+
+void OscillationDetector::Reset() {
+  std::fill(bins_, bins_ + kBinCount, std::complex<double>());
+  std::fill(ctes_, ctes_ + kWindow, 0.);
+  std::fill(energies_, energies_ + kWindow, 0.);
+  std::fill(crossings_, crossings_ + kWindow, false);
+  n_frames_ = 0;
+  sum_cte_ = 0;
+  n_crossings_ = 0;
+  sign_ = 0;
+  growth_rate_ = 0;
+  n_growing_frames_ = 0;
+}
+
+bool OscillationDetector::Update(double cte) {
+  // The ring buffers hold zeros until the window fills, so the oldest value
+  // leaves the sliding DFT the same way in both cases
+  auto i = n_frames_ % kWindow;
+  auto oldest_cte = ctes_[i];
+  auto energy = 0.;
+  for (auto k = 0; k < kBinCount; ++k) {
+    bins_[k] = (bins_[k] + cte - oldest_cte) * twiddles_[k];
+    energy += std::norm(bins_[k]);
+  }
+  ctes_[i] = cte;
+  sum_cte_ += cte - oldest_cte;
+
+  // Count crossings of the window mean with hysteresis
+  auto deviation = cte - sum_cte_ / kWindow;
+  auto is_crossing = false;
+  if (std::fabs(deviation) > kCrossingHysteresis * GetAmplitude()) {
+    auto sign = deviation > 0 ? 1 : -1;
+    is_crossing = sign_ != 0 && sign != sign_;
+    sign_ = sign;
+  }
+  n_crossings_ += static_cast<int>(is_crossing) - crossings_[i];
+  crossings_[i] = is_crossing;
+
+  // Compare the energy with the one a window ago, both of full windows
+  auto previous_energy = energies_[i];
+  energies_[i] = energy;
+  if (++n_frames_ < 2 * kWindow || previous_energy <= 0) {
+    return false;
+  }
+  growth_rate_ = 0.5 * std::log(energy / previous_energy) / kWindow;
+  auto is_growing = growth_rate_ >= std::log(kMinGrowthPerWindow) / kWindow
+                    && GetAmplitude() >= kMinAmplitudeMargin * off_track_cte_
+                    && n_crossings_ >= kMinCrossings
+                    && n_crossings_ <= kMaxCrossings;
+  n_growing_frames_ = is_growing ? n_growing_frames_ + 1 : 0;
+  return n_growing_frames_ >= kConfirmFrames;
+}
+
+double OscillationDetector::GetAmplitude() const {
+  // A sinusoid of amplitude A at a bin has the DFT magnitude of A * N / 2
+  auto energy = 0.;
+  for (const auto& bin : bins_) {
+    energy += std::norm(bin);
+  }
+  return 2. * std::sqrt(energy) / kWindow;
+}
+
+double OscillationDetector::GetFramesToOffTrack() const {
+  auto headroom = off_track_cte_ - std::fabs(sum_cte_ / kWindow);
+  auto amplitude = GetAmplitude();
+  if (amplitude >= headroom) {
+    return 0.;
+  }
+  if (growth_rate_ <= 0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return std::log(headroom / amplitude) / growth_rate_;
+}
@@ -0,0 +1,79 @@
+#ifndef OSCILLATION_DETECTOR_H
+#define OSCILLATION_DETECTOR_H
+
+#include <complex>
+
+// Streaming detector of diverging oscillation of CTE, which is how candidate
+// coefficients with too much Kp and too little Kd behave long before they get
+// off track. Every frame costs O(1): a sliding DFT keeps the energy of a few
+// bins in the steering band over a window of frames, and the zero-crossing
+// rate around the window mean confirms the signal actually oscillates in the
+// band rather than drifting. The oscillation diverges when its amplitude grows
+// steadily from one window to the next.
+class OscillationDetector {
+public:
+  // Window length in frames, and the number of DFT bins in the steering band:
+  // periods of 64, 32, 21 and 16 frames, that is 0.4..1.6Hz at 25 frames per
+  // second
+  enum { kWindow = 64, kBinCount = 4 };
+
+  // Constructor.
+  // @param off_track_cte  CTE when the vehicle is considered off-track
+  explicit OscillationDetector(double off_track_cte);
+
+  // Forgets all frames.
+  void Reset();
+
+  // Updates the detector with the new value of CTE.
+  // @param cte  Cross-track error (CTE)
+  // @return     True if the oscillation diverges
+  bool Update(double cte);
+
+  // Gets the amplitude of the oscillation in the steering band.
+  double GetAmplitude() const;
+
+  // Gets the growth rate of the amplitude per frame, logarithmic.
+  double GetGrowthRate() const { return growth_rate_; }
+
+  // Gets the number of zero crossings within the window.
+  int GetCrossingCount() const { return n_crossings_; }
+
+  // Predicts the number of frames until the oscillation gets off track if it
+  // keeps growing at the current rate.
+  double GetFramesToOffTrack() const;
+
+private:
+  // CTE when the vehicle is considered off-track
+  double off_track_cte_;
+
+  // Rotation of every DFT bin per frame
+  std::complex<double> twiddles_[kBinCount];
+
+  // Sliding DFT of the window at every bin
+  std::complex<double> bins_[kBinCount];
+
+  // Ring buffers of CTE, band energy and zero crossings over the window
+  double ctes_[kWindow];
+  double energies_[kWindow];
+  bool crossings_[kWindow];
+
+  // Number of frames observed
+  unsigned long int n_frames_;
+
+  // Sum of CTE within the window
+  double sum_cte_;
+
+  // Number of zero crossings within the window
+  int n_crossings_;
+
+  // Sign of the last deviation from the window mean beyond the hysteresis
+  int sign_;
+
+  // Growth rate of the amplitude per frame, logarithmic
+  double growth_rate_;
+
+  // Number of frames in a row the amplitude is growing
+  int n_growing_frames_;
+};
+
+#endif // OSCILLATION_DETECTOR_H
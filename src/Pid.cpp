@@ -27,5 +27,5 @@ double Pid::GetError(double cte) {
   }
   d_error_ = cte - cte_prev_;
   cte_prev_ = cte;
-  return -kp_ * p_error_ - ki_ * i_error_ - kd_ * d_error_;
+  return Evaluate(p_error_, i_error_, d_error_);
 }
@@ -1,7 +1,9 @@
 #ifndef PID_H
 #define PID_H
 
-class Pid {
+#include "SteeringLaw.h"
+
+class Pid : public SteeringLaw<Pid> {
 public:
   // Constructor.
   // @param kp  Coefficient Kp of PID
@@ -14,6 +16,35 @@ public:
   // @param cte  Cross-track error (CTE)
   double GetError(double cte);
 
+  // Computes the total PID error for given errors without updating the state.
+  // @param p_error  Proportional error, that is the CTE
+  // @param i_error  Integral error, that is the sum of CTE
+  // @param d_error  Derivative error, that is the change of CTE
+  double Evaluate(double p_error, double i_error, double d_error) const {
+    return -kp_ * p_error - ki_ * i_error - kd_ * d_error;
+  }
+
+  // Gets the PID coefficients.
+  void GetCoefficients(double& kp, double& ki, double& kd) const {
+    kp = kp_;
+    ki = ki_;
+    kd = kd_;
+  }
+
+  // Gets the PID errors of the last update.
+  void GetErrors(double& p_error, double& i_error, double& d_error) const {
+    p_error = p_error_;
+    i_error = i_error_;
+    d_error = d_error_;
+  }
+
+  // Implements SteeringLaw, the steering value is the total PID error.
+  // @param cte    Cross-track error (CTE)
+  // @param speed  Speed in miles-per-hour, not used
+  double ComputeSteering(double cte, double /*speed*/) {
+    return GetError(cte);
+  }
+
 private:
   // PID coefficients Kp, Ki, Kd
   double kp_;
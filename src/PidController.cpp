@@ -1,8 +1,12 @@
 #include "PidController.h"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <iomanip>
-#include <iostream>
+#include <limits>
+#include <sstream>
+#include "AsyncLogger.h"
 
 namespace {
 
@@ -12,40 +16,28 @@ namespace {
 // Target CTE margin w.r.t. the off track CTE
 const auto kTargetCteMargin = 0.65;
 
+// Max number of stored evaluations reused in a row
+const auto kMaxReusedEvaluations = 100;
+
 // Max vehicle speed in miles-per-hour
 const auto kMaxSpeed = 100.0;
 
 // Safe CTE margin w.r.t. the off track CTE when driving normally
 const auto kSafeCteMargin = 0.6;
 
-// Initial part of track where off track detection is not applied
-const auto kSkipOffTrackPart = 0.00125;
-
-// Initial part of track where max CTE updates are skipped
-const auto kSkipMaxCtePart = 0.025;
-
-// Twiddler error penalty when going off track
-const auto kOffTrackPenalty = 1e+6;
-
-// Meters in mile per international agreement of 1959
-const auto kMetersInMile = 1609.344;
-
-// Default framerate
-const auto kFrameRate = 25.;
-
-// Time passed between frames
-const auto kSecondsPerFrame = 1. / kFrameRate;
-
-// Coefficient of conversion miles-per-hour to meters-per-second
-const auto kMphToMps = kMetersInMile / (60. * 60.);
-
-// Coefficient for computing distance passed since a previous frame, given the
-// instant speed
-const auto kSpeedToDistanceCoeff = kMphToMps / kFrameRate;
+// Distance in meters driven in a frame per mile-per-hour of speed, at the
+// simulator framerate of 25
+const auto kSpeedToDistanceCoeff = 1609.344 / (60. * 60.) / 25.;
 
 // Local Helper-Functions
 // -----------------------------------------------------------------------------
 
+// Gets the monotonic time in nanoseconds.
+uint64_t GetNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 // Normalizes input within -1..+1.
 // @param[in] value  Value to normalize
 // @return           Normalized value
@@ -72,22 +64,39 @@ PidController::PidController(double kp, double ki, double kd,
   : has_final_coefficients_(false),
     off_track_cte_(off_track_cte),
     track_length_(track_length),
-    distance_(),
-    no_max_cte_distance_(kSkipMaxCtePart * track_length),
-    no_off_track_distance_(kSkipOffTrackPart * track_length),
-    n_frames_(),
-    safe_cte_(kSafeCteMargin * off_track_cte),
-    max_cte_(),
-    sum_cte_(),
+    lap_statistics_(off_track_cte, track_length),
+    oscillation_detector_(off_track_cte),
+    n_aborted_(),
+    n_saved_frames_(),
     pid_(new Pid(kp, ki, kd)),
-    twiddler_(
-      new Twiddler({{.p=kp, .dp=dkp}, {.p=ki, .dp=dki}, {.p=kd, .dp=dkd}})) {
+    tuner_(
+      new Twiddler({{kp, dkp, Tuner::Transform::kLinear, 0., 0.},
+                    {ki, dki, Tuner::Transform::kLinear, 0., 0.},
+                    {kd, dkd, Tuner::Transform::kLinear, 0., 0.}})),
+    steering_backend_(SteeringBackend::kPid),
+    coefficients_{kp, ki, kd},
+    limits_(),
+    initial_deltas_{dkp, dki, dkd},
+    best_coefficients_{kp, ki, kd},
+    best_error_(std::numeric_limits<double>::infinity()),
+    is_best_full_lap_(),
+    n_evaluations_(),
+    n_stalled_evaluations_(),
+    best_cycle_(),
+    tuning_distance_(),
+    tuning_start_ns_(),
+    scenario_(),
+    distance_(),
+    n_laps_(),
+    lap_distance_() {
   assert(off_track_cte > 0);
   assert(track_length > 0);
-  std::cout << "Creating PID controller with initial coefficients Kp=" << kp
-            << ", Ki=" << ki << ", Kd=" << kd << ", dKp=" << dkp << ", dKi="
-            << dki << ", dKd=" << dkd << ", off-track CTE=" << off_track_cte
-            << ", target CTE=" << kTargetCteMargin * off_track_cte << std::endl;
+  std::ostringstream oss;
+  oss << "Creating PID controller with initial coefficients Kp=" << kp
+      << ", Ki=" << ki << ", Kd=" << kd << ", dKp=" << dkp << ", dKi=" << dki
+      << ", dKd=" << dkd << ", off-track CTE=" << off_track_cte
+      << ", target CTE=" << kTargetCteMargin * off_track_cte;
+  AsyncLogger::GetDefault().Log(oss.str());
 }
 
 PidController::PidController(double kp, double ki, double kd,
@@ -95,15 +104,32 @@ PidController::PidController(double kp, double ki, double kd,
   : has_final_coefficients_(true),
     off_track_cte_(off_track_cte),
     track_length_(),
+    lap_statistics_(off_track_cte, 0.),
+    oscillation_detector_(off_track_cte),
+    n_aborted_(),
+    n_saved_frames_(),
+    pid_(new Pid(kp, ki, kd)),
+    steering_backend_(SteeringBackend::kPid),
+    coefficients_{kp, ki, kd},
+    limits_(),
+    initial_deltas_(),
+    best_coefficients_{kp, ki, kd},
+    best_error_(),
+    is_best_full_lap_(),
+    n_evaluations_(),
+    n_stalled_evaluations_(),
+    best_cycle_(),
+    tuning_distance_(),
+    tuning_start_ns_(),
+    scenario_(),
     distance_(),
-    n_frames_(),
-    safe_cte_(kSafeCteMargin * off_track_cte),
-    max_cte_(),
-    sum_cte_(),
-    pid_(new Pid(kp, ki, kd)) {
+    n_laps_(),
+    lap_distance_() {
   assert(off_track_cte > 0);
-  std::cout << "Creating PID controller with final coefficients Kp="
-            << kp << ", Ki=" << ki << ", Kd=" << kd << std::endl;
+  std::ostringstream oss;
+  oss << "Creating PID controller with final coefficients Kp=" << kp
+      << ", Ki=" << ki << ", Kd=" << kd;
+  AsyncLogger::GetDefault().Log(oss.str());
 }
 
 void PidController::Update(
@@ -112,70 +138,437 @@ void PidController::Update(
   std::function<void(double steering, double throttle)> on_control,
   std::function<void()> on_reset) {
 
+  distance_ += kSpeedToDistanceCoeff * speed;
+  auto lap_length = track_length_ ? track_length_ :
+                    offset_profile_ ? offset_profile_->GetLength() : 0.;
+  if (has_final_coefficients_ && lap_length > 0
+      && distance_ - lap_distance_ >= lap_length) {
+    ++n_laps_;
+    lap_distance_ += lap_length;
+  }
   if (!has_final_coefficients_) {
-    ++n_frames_;
-    distance_ += kSpeedToDistanceCoeff * speed;
-    sum_cte_ += std::fabs(cte);
-    if (cte > max_cte_ && distance_ > no_max_cte_distance_) {
-      max_cte_ = cte;
+    if (!tuning_start_ns_) {
+      tuning_start_ns_ = GetNanoseconds();
     }
+    auto status = lap_statistics_.Update(cte, speed);
 
     // Detect getting off track
-    if (distance_ > no_off_track_distance_
-        && (std::fabs(cte) > off_track_cte_ || speed < 1.0)) {
-      auto error = kOffTrackPenalty / distance_;
-      std::cout << "Getting off track at distance " << std::fixed
-                << std::setprecision(0) << distance_ << "m, speed " << speed
-                << "mph! " << std::defaultfloat;
-      UpdateTwiddlerAndReset(error);
+    if (status == LapStatistics::Status::kOffTrack) {
+      std::ostringstream oss;
+      oss << "Getting off track at distance " << std::fixed
+          << std::setprecision(0) << lap_statistics_.GetDistance()
+          << "m, speed " << speed << "mph! ";
+      UpdateTunerAndReset(lap_statistics_.GetError(), oss.str());
+      distance_ = 0;
       on_reset();
       return;
     }
 
-    // Detect completing the track
-    if (distance_ > track_length_) {
-      auto time = kSecondsPerFrame * n_frames_;
-      auto average_speed = distance_ / (kMphToMps * time);
-      auto avg_cte = sum_cte_ / n_frames_;
-      auto error = max_cte_ * avg_cte;
-      std::cout << "Max CTE " << std::fixed << std::setprecision(3) << max_cte_
-                << ", average CTE " << avg_cte << " at distance "
-                << std::setprecision(0) << distance_ << "m, time " << time
-                << "s, average speed " << average_speed << "mph. "
-                << std::defaultfloat;
-      if (max_cte_ < kTargetCteMargin * off_track_cte_) {
-        std::cout << "Using the final coefficients." << std::endl;
-        has_final_coefficients_ = true;
+    // Detect diverging oscillation ahead of getting off track
+    if (status == LapStatistics::Status::kDriving
+        && oscillation_detector_.Update(cte)) {
+      auto n_frames = oscillation_detector_.GetFramesToOffTrack();
+      if (lap_statistics_.Abort(n_frames, speed)) {
+        ++n_aborted_;
+        n_saved_frames_ += n_frames;
+        std::ostringstream oss;
+        oss << "Oscillation diverging at distance " << std::fixed
+            << std::setprecision(0) << lap_statistics_.GetDistance()
+            << "m, amplitude " << std::setprecision(3)
+            << oscillation_detector_.GetAmplitude()
+            << ", off track predicted in " << std::setprecision(0)
+            << n_frames << " frames! ";
+        UpdateTunerAndReset(lap_statistics_.GetError(), oss.str());
+        distance_ = 0;
+        on_reset();
+        return;
+      }
+    }
+
+    // Detect completing the track or its part
+    if (status == LapStatistics::Status::kComplete) {
+      ++n_laps_;
+      auto max_cte = lap_statistics_.GetMaxCte();
+      std::ostringstream oss;
+      oss << "Max CTE " << std::fixed << std::setprecision(3) << max_cte
+          << ", average CTE " << lap_statistics_.GetAverageCte()
+          << " at distance " << std::setprecision(0)
+          << lap_statistics_.GetDistance() << "m, time "
+          << lap_statistics_.GetTime() << "s, average speed "
+          << lap_statistics_.GetAverageSpeed() << "mph, steering effort "
+          << std::setprecision(3) << lap_statistics_.GetSteeringEffort()
+          << ". ";
+      if (lap_statistics_.IsFullLap()
+          && max_cte < kTargetCteMargin * off_track_cte_) {
+        oss << "Using the final coefficients.";
+        lap_distance_ = distance_;
+        auto error = lap_statistics_.GetError();
+        RecordEvaluation(error);
+        UpdateTuningProgress(error);
+        CompleteTuning(TuningOutcome::kTarget, coefficients_, error,
+                       oss.str());
       } else {
-        UpdateTwiddlerAndReset(error);
+        UpdateTunerAndReset(lap_statistics_.GetError(), oss.str());
+        distance_ = 0;
         on_reset();
         return;
       }
     }
   }
 
-  auto steering = Normalize(pid_->GetError(cte), -1.0, 1.0);
-  // Throttle = 1 - 2 * (Speed / MaxSpeed) * (CTE / SafeCTE)
-  auto throttle = Normalize(1.0 - 2.0 * (speed / kMaxSpeed)
-                                      * (std::fabs(cte) / safe_cte_),
-                            -1.0, 1.0);
+  // Error from the target line, the centerline unless a profile is set
+  if (offset_profile_) {
+    cte -= offset_profile_->GetOffset(distance_);
+  }
+  auto steering = Normalize(GetSteering(cte, speed), -1.0, 1.0);
+  if (!has_final_coefficients_) {
+    lap_statistics_.AddSteering(steering);
+  }
+  auto throttle = steering_backend_ == SteeringBackend::kTable ?
+                  table_steering_->GetThrottle() :
+                  ComputeThrottle(cte, speed, off_track_cte_);
   on_control(steering, throttle);
 }
 
+void PidController::SetSteeringBackend(SteeringBackend backend,
+                                       uint64_t deadline_ns) {
+  assert(backend != SteeringBackend::kTable);
+  steering_backend_ = backend;
+  table_steering_.reset();
+  table_.reset();
+  mpc_.reset();
+  stanley_.reset();
+  if (backend == SteeringBackend::kMpc) {
+    mpc_.reset(new Mpc(deadline_ns));
+    std::ostringstream oss;
+    oss << "Using model-predictive steering with deadline " << deadline_ns
+        << "ns and PID fallback";
+    AsyncLogger::GetDefault().Log(oss.str());
+  } else if (backend == SteeringBackend::kStanley) {
+    stanley_.reset(new Stanley(coefficients_[0], coefficients_[1],
+                               coefficients_[2]));
+    std::ostringstream oss;
+    oss << "Using Stanley steering with k=" << coefficients_[0]
+        << ", k_soft=" << coefficients_[1] << ", k_heading="
+        << coefficients_[2];
+    AsyncLogger::GetDefault().Log(oss.str());
+  }
+}
+
+void PidController::SetControlTable(std::shared_ptr<const ControlTable> table) {
+  assert(table && table->IsLoaded());
+  steering_backend_ = SteeringBackend::kTable;
+  mpc_.reset();
+  stanley_.reset();
+  table_ = table;
+  table_steering_.reset(new TableSteering(*table_));
+  std::ostringstream oss;
+  oss << "Using explicit controller table of " << table_->GetSize()
+      << " bytes";
+  AsyncLogger::GetDefault().Log(oss.str());
+}
+
+void PidController::SetTuner(std::unique_ptr<Tuner> tuner) {
+  assert(tuner && !has_final_coefficients_
+         && lap_statistics_.GetDistance() == 0);
+  tuner_ = std::move(tuner);
+  lap_statistics_.Reset(tuner_->GetBudget() * track_length_);
+}
+
+void PidController::SetOffsetProfile(
+  std::shared_ptr<const OffsetProfile> profile) {
+  assert(profile && profile->IsLoaded());
+  offset_profile_ = profile;
+  std::ostringstream oss;
+  oss << "Using offset profile of " << profile->GetOffsets().size()
+      << " buckets over " << std::fixed << std::setprecision(0)
+      << profile->GetLength() << "m";
+  AsyncLogger::GetDefault().Log(oss.str());
+}
+
+void PidController::SetTuningLimits(const TuningLimits& limits) {
+  limits_ = limits;
+}
+
+void PidController::SetOnTuned(
+  std::function<void(const TuningSummary& summary)> on_tuned) {
+  on_tuned_ = on_tuned;
+}
+
+void PidController::SetOnEvaluated(
+  std::function<void(const Evaluation& evaluation)> on_evaluated) {
+  on_evaluated_ = on_evaluated;
+}
+
+void PidController::Restart() {
+  ResetSteering(coefficients_[0], coefficients_[1], coefficients_[2]);
+  distance_ = 0;
+  lap_distance_ = 0;
+  if (!has_final_coefficients_) {
+    oscillation_detector_.Reset();
+    lap_statistics_.Reset(lap_statistics_.GetBudget());
+  }
+}
+
+void PidController::Reset() {
+  assert(has_final_coefficients_);
+  Restart();
+  n_laps_ = 0;
+  if (mpc_) {
+    mpc_->ClearStatistics();
+  }
+}
+
+const char* PidController::GetOutcomeName(TuningOutcome outcome) {
+  switch (outcome) {
+    case TuningOutcome::kTarget:
+      return "target";
+    case TuningOutcome::kConverged:
+      return "converged";
+    case TuningOutcome::kStalled:
+      return "stalled";
+    case TuningOutcome::kTimeBudget:
+      return "time_budget";
+    case TuningOutcome::kLapBudget:
+    default:
+      return "lap_budget";
+  }
+}
+
+void PidController::SetExperimentStore(std::shared_ptr<ExperimentStore> store,
+                                       uint32_t scenario) {
+  assert(store && store->IsOpen());
+  store_ = store;
+  scenario_ = scenario;
+}
+
+void PidController::GetCoefficients(double& kp, double& ki, double& kd) const {
+  kp = coefficients_[0];
+  ki = coefficients_[1];
+  kd = coefficients_[2];
+}
+
+double PidController::ComputeThrottle(double cte, double speed,
+                                      double off_track_cte) {
+  // Throttle = 1 - 2 * (Speed / MaxSpeed) * (CTE / SafeCTE)
+  return Normalize(1.0 - 2.0 * (speed / kMaxSpeed)
+                               * (std::fabs(cte)
+                                  / (kSafeCteMargin * off_track_cte)),
+                   -1.0, 1.0);
+}
+
+void PidController::PrintStatistics(std::ostream& os) const {
+  if (!has_final_coefficients_) {
+    PrintTuningStatistics(os);
+  }
+  if (!mpc_) {
+    return;
+  }
+  const auto& solve_times = mpc_->GetSolveTimes();
+  solve_times.Print(os, "MPC solve time");
+  auto p99 = solve_times.GetPercentile(99);
+  os << "MPC deadline " << mpc_->GetDeadline() << "ns, p99 headroom "
+     << (p99 < mpc_->GetDeadline() ? mpc_->GetDeadline() - p99 : 0)
+     << "ns, PID fallbacks " << mpc_->GetDeadlineMisses() << std::endl;
+}
+
 // Private Members
 // -----------------------------------------------------------------------------
-void PidController::UpdateTwiddlerAndReset(double error) {
-  auto parameters = twiddler_->UpdateError(error);
+
+double PidController::GetSteering(double cte, double speed) {
+  switch (steering_backend_) {
+    case SteeringBackend::kMpc: {
+      auto pid_steering = pid_->GetSteering(cte, speed);
+      auto steering = mpc_->GetSteering(cte, speed);
+      if (std::isnan(steering)) {
+        mpc_->SetApplied(pid_steering);
+        return pid_steering;
+      }
+      return steering;
+    }
+    case SteeringBackend::kTable:
+      return table_steering_->GetSteering(cte, speed);
+    case SteeringBackend::kStanley:
+      return stanley_->GetSteering(cte, speed);
+    case SteeringBackend::kPid:
+    default:
+      return pid_->GetSteering(cte, speed);
+  }
+}
+
+void PidController::UpdateTunerAndReset(double error,
+                                        const std::string& event) {
+  RecordEvaluation(error);
+  UpdateTuningProgress(error);
+  auto parameters = tuner_->UpdateError(error);
   assert(parameters.size() == 3);
+  ExperimentStore::Record record;
+  for (auto i = 0; store_ && i < kMaxReusedEvaluations; ++i) {
+    double coefficients[] = {parameters[0].p, parameters[1].p,
+                             parameters[2].p};
+    if (!store_->Find(scenario_, coefficients, tuner_->GetBudget(), record)) {
+      break;
+    }
+    std::ostringstream oss;
+    oss << "Reusing stored error " << std::fixed << std::setprecision(3)
+        << record.error << std::defaultfloat << " of coefficients "
+        << coefficients[0] << ", " << coefficients[1] << ", "
+        << coefficients[2] << ".";
+    AsyncLogger::GetDefault().Log(oss.str());
+    // A stored error counts like a driven one, without the distance
+    UpdateBestCoefficients(record.coefficients, record.error,
+                           record.budget >= 1.);
+    parameters = tuner_->UpdateError(record.error);
+    assert(parameters.size() == 3);
+  }
+  TuningOutcome outcome;
+  std::ostringstream oss;
+  oss << event << "Error " << std::fixed << std::setprecision(3) << error
+      << std::defaultfloat << ". ";
+  if (IsTuningLimitReached(parameters, outcome)) {
+    CompleteTuning(outcome, best_coefficients_, best_error_, oss.str());
+    return;
+  }
   auto kp = parameters[0].p;
   auto ki = parameters[1].p;
   auto kd = parameters[2].p;
-  std::cout << "Error " << std::fixed << std::setprecision(3) << error
-            << std::defaultfloat << ". Trying PID coefficients " << kp << ", "
-            << ki << ", " << kd << "." << std::endl;
-  pid_.reset(new Pid(kp, ki, kd));
-  distance_ = 0;
-  n_frames_ = 0;
-  max_cte_ = 0;
-  sum_cte_ = 0;
+  ResetSteering(kp, ki, kd);
+  oscillation_detector_.Reset();
+  lap_statistics_.Reset(tuner_->GetBudget() * track_length_);
+  oss << "Trying coefficients " << kp << ", " << ki << ", " << kd;
+  if (!lap_statistics_.IsFullLap()) {
+    oss << " over " << std::fixed << std::setprecision(0)
+        << lap_statistics_.GetBudget() << "m" << std::defaultfloat;
+  }
+  oss << ".";
+  AsyncLogger::GetDefault().Log(oss.str());
+}
+
+void PidController::UpdateTuningProgress(double error) {
+  ++n_evaluations_;
+  tuning_distance_ += lap_statistics_.GetDistance();
+  // Whole-lap errors are preferred, partial laps may be lucky
+  auto is_full_lap = lap_statistics_.IsFullLap();
+  if (on_evaluated_) {
+    on_evaluated_({{coefficients_[0], coefficients_[1], coefficients_[2]},
+                   error, lap_statistics_.GetDistance(), is_full_lap});
+  }
+  UpdateBestCoefficients(coefficients_, error, is_full_lap);
+}
+
+void PidController::UpdateBestCoefficients(const double coefficients[3],
+                                           double error,
+                                           bool is_full_lap) {
+  if ((is_full_lap && !is_best_full_lap_)
+      || (is_full_lap == is_best_full_lap_ && error < best_error_)) {
+    std::copy(coefficients, coefficients + 3, best_coefficients_);
+    best_error_ = error;
+    is_best_full_lap_ = is_full_lap;
+    n_stalled_evaluations_ = 0;
+    best_cycle_ = tuner_->GetCycleCount();
+  } else {
+    ++n_stalled_evaluations_;
+  }
+}
+
+bool PidController::IsTuningLimitReached(
+  const Tuner::ParameterSequence& parameters,
+  TuningOutcome& outcome) const {
+  // Only coordinate descent adapts the deltas, the other tuners keep them
+  auto delta_sum = HUGE_VAL;
+  if (tuner_->IsCoordinateDescent()) {
+    delta_sum = 0.;
+    for (auto i = 0; i < 3; ++i) {
+      if (initial_deltas_[i] != 0) {
+        delta_sum += std::fabs(parameters[i].dp / initial_deltas_[i]);
+      }
+    }
+  }
+  // A cycle of coordinate descent takes one or two evaluations per
+  // coefficient, the other tuners move all coefficients at every evaluation
+  auto n_stalled_cycles = tuner_->IsCoordinateDescent() ?
+                          tuner_->GetCycleCount() - best_cycle_ :
+                          n_stalled_evaluations_ / parameters.size();
+  if (delta_sum < limits_.min_delta_sum) {
+    outcome = TuningOutcome::kConverged;
+  } else if (limits_.max_stalled_cycles
+             && n_stalled_cycles >= limits_.max_stalled_cycles) {
+    outcome = TuningOutcome::kStalled;
+  } else if (limits_.max_seconds
+             && GetNanoseconds() - tuning_start_ns_
+                >= 1e+9 * limits_.max_seconds) {
+    outcome = TuningOutcome::kTimeBudget;
+  } else if (limits_.max_laps
+             && tuning_distance_ >= limits_.max_laps * track_length_) {
+    outcome = TuningOutcome::kLapBudget;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void PidController::CompleteTuning(TuningOutcome outcome,
+                                   const double coefficients[3],
+                                   double error,
+                                   const std::string& event) {
+  TuningSummary summary;
+  summary.outcome = outcome;
+  std::copy(coefficients, coefficients + 3, summary.coefficients);
+  summary.error = error;
+  summary.n_evaluations = n_evaluations_;
+  summary.laps = tuning_distance_ / track_length_;
+  summary.seconds = (GetNanoseconds() - tuning_start_ns_) / 1e+9;
+  summary.n_aborted = n_aborted_;
+  if (outcome != TuningOutcome::kTarget) {
+    ResetSteering(coefficients[0], coefficients[1], coefficients[2]);
+  }
+  std::ostringstream oss;
+  oss << event;
+  if (outcome != TuningOutcome::kTarget) {
+    oss << "Tuning stopped, " << GetOutcomeName(outcome)
+        << ". Using the best coefficients " << coefficients[0] << ", "
+        << coefficients[1] << ", " << coefficients[2] << " with error "
+        << std::fixed << std::setprecision(3) << error
+        << std::defaultfloat << ".";
+  }
+  oss << std::endl << "Tuned in " << n_evaluations_ << " evaluations, "
+      << std::fixed << std::setprecision(1) << summary.laps << " laps, "
+      << summary.seconds << "s" << std::defaultfloat << std::endl;
+  PrintTuningStatistics(oss);
+  has_final_coefficients_ = true;
+  AsyncLogger::GetDefault().Log(oss.str());
+  if (on_tuned_) {
+    on_tuned_(summary);
+  }
+}
+
+void PidController::RecordEvaluation(double error) {
+  if (store_) {
+    store_->Append(scenario_, coefficients_, tuner_->GetBudget(), error);
+  }
+}
+
+void PidController::PrintTuningStatistics(std::ostream& os) const {
+  if (n_aborted_) {
+    os << "Oscillation detection aborted " << n_aborted_
+       << " candidates, saving " << std::fixed << std::setprecision(0)
+       << n_saved_frames_ << " frames" << std::defaultfloat << std::endl;
+  }
+}
+
+void PidController::ResetSteering(double kp, double ki, double kd) {
+  coefficients_[0] = kp;
+  coefficients_[1] = ki;
+  coefficients_[2] = kd;
+  // In place, so restarting doesn't allocate
+  *pid_ = Pid(kp, ki, kd);
+  if (mpc_) {
+    mpc_->Reset();
+  }
+  if (stanley_) {
+    *stanley_ = Stanley(kp, ki, kd);
+  }
+  if (table_steering_) {
+    table_steering_->Reset();
+  }
 }
@@ -1,14 +1,78 @@
 #ifndef PID_CONTROLLER_H
 #define PID_CONTROLLER_H
 
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <ostream>
 #include <vector>
+#include "ControlTable.h"
+#include "ExperimentStore.h"
+#include "LapStatistics.h"
+#include "Mpc.h"
+#include "OffsetProfile.h"
+#include "OscillationDetector.h"
 #include "Pid.h"
+#include "Stanley.h"
+#include "SteeringLaw.h"
+#include "Tuner.h"
 #include "Twiddler.h"
 
 class PidController {
 public:
+  // Defines why tuning stopped
+  enum class TuningOutcome {
+    // A whole lap was driven within the target CTE
+    kTarget,
+    // The deltas shrank below the threshold
+    kConverged,
+    // The best error did not improve for the max number of cycles
+    kStalled,
+    // The wall-clock budget is spent
+    kTimeBudget,
+    // The lap budget is spent
+    kLapBudget
+  };
+
+  // Limits of tuning, checked after every evaluation. Zero values disable
+  // them, and tuning continues until the target is reached.
+  struct TuningLimits {
+    // Min sum of the deltas relative to the initial ones, of coordinate
+    // descent only
+    double min_delta_sum;
+    // Max number of cycles over all coefficients without a better error
+    unsigned int max_stalled_cycles;
+    // Max wall-clock time in seconds
+    double max_seconds;
+    // Max distance in laps
+    double max_laps;
+  };
+
+  // Summary of a tuning session
+  struct TuningSummary {
+    TuningOutcome outcome;
+    // Final coefficients and their error
+    double coefficients[3];
+    double error;
+    // Number of evaluations driven, their distance in laps and the wall-clock
+    // time in seconds
+    unsigned long int n_evaluations;
+    double laps;
+    double seconds;
+    // Number of candidates aborted on diverging oscillation
+    unsigned long int n_aborted;
+  };
+
+  // Evaluation of coefficients while tuning
+  struct Evaluation {
+    // Evaluated coefficients and their error
+    double coefficients[3];
+    double error;
+    // Distance driven in meters, and whether it was a whole lap
+    double distance;
+    bool is_full_lap;
+  };
+
   // Contructor.
   // @param kp             Initial coefficient Kp of PID
   // @param ki             Initial coefficient Ki of PID
@@ -38,6 +102,107 @@ public:
               std::function<void(double steering, double throttle)> on_control,
               std::function<void()> on_reset);
 
+  // Selects the steering backend. With model-predictive control the PID keeps
+  // running on every frame, so it can take over when the solver overruns its
+  // deadline. With Stanley control the coefficients of this controller are
+  // the Stanley gains k, k_soft, k_heading, tuned the same way as PID ones.
+  // @param backend      Steering backend, except kTable
+  // @param deadline_ns  Per-frame compute deadline of model-predictive control
+  //                     in nanoseconds
+  void SetSteeringBackend(SteeringBackend backend, uint64_t deadline_ns);
+
+  // Selects the explicit controller backend, which provides both steering and
+  // throttle from a precomputed table.
+  // @param table  Loaded table, may be shared by many controllers
+  void SetControlTable(std::shared_ptr<const ControlTable> table);
+
+  // Replaces the Twiddler by another tuning algorithm. Must be called before
+  // the first update. The initial coefficients are driven over the budget of
+  // the tuner.
+  // @param tuner  Tuner starting with the initial coefficients of this
+  //               controller
+  void SetTuner(std::unique_ptr<Tuner> tuner);
+
+  // Records every evaluation of coefficients in an experiment store, and
+  // reuses stored errors of coefficients the tuner proposes again instead of
+  // driving them.
+  // @param store     Open experiment store, may be shared by many controllers
+  // @param scenario  Scenario identifier of this controller
+  void SetExperimentStore(std::shared_ptr<ExperimentStore> store,
+                          uint32_t scenario);
+
+  // Drives toward the target offsets of a profile, such as a racing line,
+  // instead of the centerline. The offset at the distance driven since the
+  // last reset is subtracted from CTE before steering and throttle, while
+  // tuning still scores CTE from the centerline.
+  // @param profile  Loaded profile, may be shared by many controllers
+  void SetOffsetProfile(std::shared_ptr<const OffsetProfile> profile);
+
+  // Sets the limits of tuning. When tuning stops short of the target, the
+  // controller uses the coefficients with the best error so far, preferring
+  // whole-lap evaluations.
+  // @param limits  Limits of tuning
+  void SetTuningLimits(const TuningLimits& limits);
+
+  // Sets the functional object called once tuning stops.
+  // @param on_tuned  Functional object getting the summary of tuning
+  void SetOnTuned(std::function<void(const TuningSummary& summary)> on_tuned);
+
+  // Sets the functional object called after every evaluation while tuning.
+  // @param on_evaluated  Functional object getting the evaluation
+  void SetOnEvaluated(
+    std::function<void(const Evaluation& evaluation)> on_evaluated);
+
+  // Restarts driving the current coefficients from the start of the track,
+  // e.g. after the simulator reconnected. The partial evaluation is dropped,
+  // the progress of tuning and the best coefficients are kept.
+  void Restart();
+
+  // Resets a controller with final coefficients in place for a new simulator
+  // connection, as if constructed: it restarts, and the lap count and the
+  // statistics of the steering backend start over.
+  void Reset();
+
+  // Gets the name of a tuning outcome.
+  // @param outcome  Tuning outcome
+  static const char* GetOutcomeName(TuningOutcome outcome);
+
+  // Indicates the controller has final coefficients, that is either they were
+  // provided, or tuning stopped.
+  bool HasFinalCoefficients() const { return has_final_coefficients_; }
+
+  // Gets the selected steering backend.
+  SteeringBackend GetSteeringBackend() const { return steering_backend_; }
+
+  // Gets the current coefficients of the steering law.
+  // @param[out] kp  Coefficient Kp of PID, or k of Stanley
+  // @param[out] ki  Coefficient Ki of PID, or k_soft of Stanley
+  // @param[out] kd  Coefficient Kd of PID, or k_heading of Stanley
+  void GetCoefficients(double& kp, double& ki, double& kd) const;
+
+  // Computes the throttle value given CTE and speed.
+  // @param cte            Cross-track error (CTE)
+  // @param speed          Speed in miles-per-hour
+  // @param off_track_cte  CTE when the vehicle is considered off-track
+  // @return               Throttle value within -1..1
+  static double ComputeThrottle(double cte, double speed, double off_track_cte);
+
+  // Gets the number of laps completed: distance budgets of tuning driven
+  // without a reset, then whole laps of the track length, or of the offset
+  // profile if the track length is unknown.
+  unsigned long int GetLapCount() const { return n_laps_; }
+
+  // Gets the number of candidates aborted on diverging oscillation.
+  unsigned long int GetAbortedCount() const { return n_aborted_; }
+
+  // Gets the number of frames saved by the aborts, that is predicted frames
+  // until the aborted candidates would get off track.
+  double GetSavedFrameCount() const { return n_saved_frames_; }
+
+  // Prints statistics of tuning and the steering backend.
+  // @param os  Output stream
+  void PrintStatistics(std::ostream& os) const;
+
 private:
   // Indicates the controller has final PID coefficients
   bool has_final_coefficients_;
@@ -48,35 +213,132 @@ private:
   // Track length in meters
   double track_length_;
 
-  // Travel distance in meters
+  // Statistics of driving with the current coefficients
+  LapStatistics lap_statistics_;
+
+  // Detector of diverging oscillation with the current coefficients
+  OscillationDetector oscillation_detector_;
+
+  // Number of aborted candidates and the frames saved by the aborts
+  unsigned long int n_aborted_;
+  double n_saved_frames_;
+
+  // Implementation of PID
+  std::unique_ptr<Pid> pid_;
+
+  // Implementation of the tuning algorithm, Twiddler by default
+  std::unique_ptr<Tuner> tuner_;
+
+  // Selected steering backend
+  SteeringBackend steering_backend_;
+
+  // Current coefficients of the steering law
+  double coefficients_[3];
+
+  // Implementation of model-predictive control, if selected
+  std::unique_ptr<Mpc> mpc_;
+
+  // Implementation of Stanley control, if selected
+  std::unique_ptr<Stanley> stanley_;
+
+  // Explicit controller table and its evaluation state, if selected
+  std::shared_ptr<const ControlTable> table_;
+  std::unique_ptr<TableSteering> table_steering_;
+
+  // Limits of tuning and the functional object called once it stops
+  TuningLimits limits_;
+  std::function<void(const TuningSummary& summary)> on_tuned_;
+
+  // Functional object called after every evaluation
+  std::function<void(const Evaluation& evaluation)> on_evaluated_;
+
+  // Initial deltas of the coefficients
+  double initial_deltas_[3];
+
+  // Coefficients with the best error so far and whether it is of a whole lap
+  double best_coefficients_[3];
+  double best_error_;
+  bool is_best_full_lap_;
+
+  // Number of evaluations driven, and of those without a better error in a
+  // row
+  unsigned long int n_evaluations_;
+  unsigned long int n_stalled_evaluations_;
+
+  // Cycle of coordinate descent of the best error
+  unsigned long int best_cycle_;
+
+  // Distance driven while tuning in meters
+  double tuning_distance_;
+
+  // Monotonic time of the first update while tuning in nanoseconds
+  uint64_t tuning_start_ns_;
+
+  // Experiment store and the scenario identifier, if set
+  std::shared_ptr<ExperimentStore> store_;
+  uint32_t scenario_;
+
+  // Profile of target offsets, if set
+  std::shared_ptr<const OffsetProfile> offset_profile_;
+
+  // Distance driven since the last reset in meters
   double distance_;
 
-  // Initial distance where max CTE tracking is not yet done
-  double no_max_cte_distance_;
+  // Number of laps completed, and the distance driven at the last one
+  unsigned long int n_laps_;
+  double lap_distance_;
 
-  // Initial distance where going off-track is not detected
-  double no_off_track_distance_;
+  // Gets the steering value of the selected backend.
+  // @param cte    Cross-track error (CTE)
+  // @param speed  Speed in miles-per-hour
+  double GetSteering(double cte, double speed);
 
-  // Number of frames observed
-  unsigned long int n_frames_;
+  // Updates the tuner with the new error value and resets related member
+  // @param error  Error of the evaluation
+  // @param event  Event ending the evaluation, starts the logged line
+  void UpdateTunerAndReset(double error, const std::string& event);
 
-  // Max safe CTE when driving normally
-  double safe_cte_;
+  // Updates the best coefficients and the progress of tuning with the error of
+  // the current coefficients.
+  // @param error  Error of the evaluation
+  void UpdateTuningProgress(double error);
 
-  // Maximum CTE registered so far
-  double max_cte_;
+  // Updates the best coefficients and the count of evaluations without a
+  // better error, with an evaluation driven or reused from the store.
+  // @param coefficients  Evaluated coefficients
+  // @param error         Error of the evaluation
+  // @param is_full_lap   Indicates the evaluation is of a whole lap
+  void UpdateBestCoefficients(const double coefficients[3], double error,
+                              bool is_full_lap);
 
-  // Sum of CTE
-  double sum_cte_;
+  // Checks the limits of tuning.
+  // @param[in]  parameters  Next parameters of the tuner
+  // @param[out] outcome     Outcome if tuning must stop
+  // @return                 True if tuning must stop
+  bool IsTuningLimitReached(const Tuner::ParameterSequence& parameters,
+                            TuningOutcome& outcome) const;
 
-  // Implementation of PID
-  std::unique_ptr<Pid> pid_;
+  // Stops tuning with the final coefficients, and reports the summary.
+  // @param outcome       Tuning outcome
+  // @param coefficients  Final coefficients
+  // @param error         Error of the final coefficients
+  // @param event         Event ending tuning, starts the logged lines
+  void CompleteTuning(TuningOutcome outcome, const double coefficients[3],
+                      double error, const std::string& event);
+
+  // Records the evaluation of the current coefficients in the store.
+  // @param error  Error of the evaluation
+  void RecordEvaluation(double error);
 
-  // Implementation of Twiddler algorithm
-  std::unique_ptr<Twiddler> twiddler_;
+  // Prints statistics of tuning.
+  // @param os  Output stream
+  void PrintTuningStatistics(std::ostream& os) const;
 
-  // Updates the Twiddler with the new error value and resets related member
-  void UpdateTwiddlerAndReset(double error);
+  // Recreates the steering backends with new coefficients.
+  // @param kp  Coefficient Kp of PID, or k of Stanley
+  // @param ki  Coefficient Ki of PID, or k_soft of Stanley
+  // @param kd  Coefficient Kd of PID, or k_heading of Stanley
+  void ResetSteering(double kp, double ki, double kd);
 };
 
 #endif // PID_CONTROLLER_H
@@ -0,0 +1,199 @@
+#include "PidCore.h"
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <new>
+#include "AsyncLogger.h"
+#include "PidController.h"
+#include "Session.h"
+#include "Twiddler.h"
+
+struct pidcore_twiddler {
+  explicit pidcore_twiddler(const Tuner::ParameterSequence& parameters)
+    : twiddler(parameters) {
+    // Empty.
+  }
+
+  Twiddler twiddler;
+};
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Silences the components at load, so an embedded controller neither writes
+// to the standard output of the host nor starts the logger thread, unless the
+// host enables logging
+const bool kIsQuietAtLoad = (AsyncLogger::GetDefault().SetQuiet(true), true);
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the pool of all sessions of the library, lock-free to share across
+// threads of the caller.
+SessionPool& GetSessions() {
+  static SessionPool sessions;
+  return sessions;
+}
+
+// Converts a session handle.
+Session* ToSession(pidcore_session* session) {
+  return reinterpret_cast<Session*>(session);
+}
+
+// Converts a session to its handle.
+pidcore_session* ToHandle(Session* session) {
+  return reinterpret_cast<pidcore_session*>(session);
+}
+
+// Updates a session with a frame, NaN steering and throttle on reset.
+// @return  True on reset
+bool UpdateSession(pidcore_session* session, double cte, double speed,
+                   double& steering, double& throttle) {
+  if (ToSession(session)->Update(cte, speed, steering, throttle)) {
+    return false;
+  }
+  steering = std::numeric_limits<double>::quiet_NaN();
+  throttle = std::numeric_limits<double>::quiet_NaN();
+  return true;
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+int pidcore_get_version(void) {
+  return PIDCORE_VERSION;
+}
+
+void pidcore_set_logging(int enabled) {
+  AsyncLogger::GetDefault().SetQuiet(!enabled);
+}
+
+pidcore_session* pidcore_session_create(double kp,
+                                        double ki,
+                                        double kd,
+                                        double off_track_cte) {
+  if (!(off_track_cte > 0)) {
+    return nullptr;
+  }
+  try {
+    return ToHandle(GetSessions().Acquire(kp, ki, kd, off_track_cte));
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+pidcore_session* pidcore_session_create_tuning(
+  double kp, double ki, double kd, double off_track_cte,
+  double dkp, double dki, double dkd, double track_length) {
+  if (!(off_track_cte > 0) || !(track_length > 0)) {
+    return nullptr;
+  }
+  try {
+    std::unique_ptr<PidController> controller(new PidController(
+      kp, ki, kd, off_track_cte, dkp, dki, dkd, track_length));
+    return ToHandle(GetSessions().Acquire(std::move(controller)));
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void pidcore_session_destroy(pidcore_session* session) {
+  GetSessions().Release(ToSession(session));
+}
+
+int pidcore_session_update(pidcore_session* session,
+                           double cte,
+                           double speed,
+                           double* steering,
+                           double* throttle) {
+  return UpdateSession(session, cte, speed, *steering, *throttle) ? 0 : 1;
+}
+
+size_t pidcore_session_update_batch(pidcore_session* session,
+                                    const double* ctes,
+                                    const double* speeds,
+                                    size_t n,
+                                    double* steering,
+                                    double* throttle) {
+  size_t n_resets = 0;
+  for (size_t i = 0; i < n; ++i) {
+    n_resets += UpdateSession(session, ctes[i], speeds[i],
+                              steering[i], throttle[i]);
+  }
+  return n_resets;
+}
+
+size_t pidcore_sessions_update(pidcore_session* const* sessions,
+                               const double* ctes,
+                               const double* speeds,
+                               size_t n,
+                               double* steering,
+                               double* throttle) {
+  size_t n_resets = 0;
+  for (size_t i = 0; i < n; ++i) {
+    n_resets += UpdateSession(sessions[i], ctes[i], speeds[i],
+                              steering[i], throttle[i]);
+  }
+  return n_resets;
+}
+
+void pidcore_session_get_coefficients(const pidcore_session* session,
+                                      double coefficients[3]) {
+  reinterpret_cast<const Session*>(session)->GetCoefficients(
+    coefficients[0], coefficients[1], coefficients[2]);
+}
+
+int pidcore_session_add_shadow(pidcore_session* session,
+                               double kp,
+                               double ki,
+                               double kd) {
+  return ToSession(session)->AddShadow(kp, ki, kd) ? 1 : 0;
+}
+
+int pidcore_session_get_shadow_statistics(const pidcore_session* session,
+                                          size_t i,
+                                          double statistics[3]) {
+  auto s = reinterpret_cast<const Session*>(session);
+  if (i >= s->GetShadowCount()) {
+    return 0;
+  }
+  auto shadow_statistics = s->GetShadowStatistics(i);
+  statistics[0] = shadow_statistics.mean_divergence;
+  statistics[1] = shadow_statistics.max_divergence;
+  statistics[2] = shadow_statistics.saturation_rate;
+  return 1;
+}
+
+pidcore_twiddler* pidcore_twiddler_create(const double* p,
+                                          const double* dp,
+                                          size_t n) {
+  if (n == 0) {
+    return nullptr;
+  }
+  try {
+    Tuner::ParameterSequence parameters;
+    for (size_t i = 0; i < n; ++i) {
+      parameters.push_back({p[i], dp[i], Tuner::Transform::kLinear, 0., 0.});
+    }
+    return new pidcore_twiddler(parameters);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void pidcore_twiddler_destroy(pidcore_twiddler* twiddler) {
+  delete twiddler;
+}
+
+void pidcore_twiddler_update(pidcore_twiddler* twiddler,
+                             double error,
+                             double* p) {
+  auto parameters = twiddler->twiddler.UpdateError(error);
+  for (size_t i = 0; i < parameters.size(); ++i) {
+    p[i] = parameters[i].p;
+  }
+}
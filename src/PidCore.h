@@ -0,0 +1,162 @@
+#ifndef PID_CORE_H
+#define PID_CORE_H
+
+// C ABI of the pidcore library: controller sessions and the Twiddle tuner,
+// usable from C and from foreign function interfaces such as Python ctypes.
+// All handles are opaque, no C++ exception crosses the ABI, and functions
+// only get added: a caller checks pidcore_get_version() against
+// PIDCORE_VERSION of the header it was built with.
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#define PIDCORE_API __declspec(dllexport)
+#else
+#define PIDCORE_API __attribute__((visibility("default")))
+#endif
+
+// Version of the ABI, increments when functions are added
+#define PIDCORE_VERSION 3
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Controller session, final or tuning PID coefficients
+typedef struct pidcore_session pidcore_session;
+
+// Twiddle tuner of PID coefficients
+typedef struct pidcore_twiddler pidcore_twiddler;
+
+// Gets the version of the ABI implemented by the library.
+PIDCORE_API int pidcore_get_version(void);
+
+// Sets whether the sessions log tuning progress to the standard output of the
+// host, from a background thread. The library is quiet by default. Since
+// version 3.
+// @param enabled  Nonzero to log
+PIDCORE_API void pidcore_set_logging(int enabled);
+
+// Creates a session with final PID coefficients.
+// @param kp             Coefficient Kp of PID
+// @param ki             Coefficient Ki of PID
+// @param kd             Coefficient Kd of PID
+// @param off_track_cte  CTE when the vehicle is considered off-track, positive
+// @return               Session, NULL on invalid arguments or out of memory
+PIDCORE_API pidcore_session* pidcore_session_create(double kp,
+                                                    double ki,
+                                                    double kd,
+                                                    double off_track_cte);
+
+// Creates a session tuning PID coefficients by Twiddle, resetting the
+// simulator for every evaluated set of coefficients.
+// @param kp, ki, kd     Initial coefficients of PID
+// @param off_track_cte  CTE when the vehicle is considered off-track, positive
+// @param dkp, dki, dkd  Initial deltas of the coefficients
+// @param track_length   Track length in meters, positive
+// @return               Session, NULL on invalid arguments or out of memory
+PIDCORE_API pidcore_session* pidcore_session_create_tuning(
+  double kp, double ki, double kd, double off_track_cte,
+  double dkp, double dki, double dkd, double track_length);
+
+// Destroys a session.
+// @param session  Session, may be NULL
+PIDCORE_API void pidcore_session_destroy(pidcore_session* session);
+
+// Updates a session with a frame.
+// @param[in]  session   Session
+// @param[in]  cte       Cross-track error (CTE)
+// @param[in]  speed     Speed in miles-per-hour
+// @param[out] steering  Steering value within -1..1, if controlling
+// @param[out] throttle  Throttle value within -1..1, if controlling
+// @return               1 to control the simulator, 0 to reset it
+PIDCORE_API int pidcore_session_update(pidcore_session* session,
+                                       double cte,
+                                       double speed,
+                                       double* steering,
+                                       double* throttle);
+
+// Updates a session with consecutive frames. The arrays are read and written
+// in place; frames resetting the simulator get NaN steering and throttle.
+// @param[in]  session   Session
+// @param[in]  ctes      CTE of every frame
+// @param[in]  speeds    Speed of every frame in miles-per-hour
+// @param[in]  n         Number of frames
+// @param[out] steering  Steering value of every frame
+// @param[out] throttle  Throttle value of every frame
+// @return               Number of frames resetting the simulator
+PIDCORE_API size_t pidcore_session_update_batch(pidcore_session* session,
+                                                const double* ctes,
+                                                const double* speeds,
+                                                size_t n,
+                                                double* steering,
+                                                double* throttle);
+
+// Updates many sessions with one frame each, e.g. a fleet in lockstep.
+// @param[in]  sessions  Sessions
+// @param[in]  ctes      CTE of every session
+// @param[in]  speeds    Speed of every session in miles-per-hour
+// @param[in]  n         Number of sessions
+// @param[out] steering  Steering value of every session
+// @param[out] throttle  Throttle value of every session
+// @return               Number of sessions resetting the simulator
+PIDCORE_API size_t pidcore_sessions_update(pidcore_session* const* sessions,
+                                           const double* ctes,
+                                           const double* speeds,
+                                           size_t n,
+                                           double* steering,
+                                           double* throttle);
+
+// Gets the current coefficients of a session.
+// @param[in]  session       Session
+// @param[out] coefficients  Kp, Ki and Kd
+PIDCORE_API void pidcore_session_get_coefficients(
+  const pidcore_session* session, double coefficients[3]);
+
+// Adds a shadow candidate to a session with final coefficients, evaluated on
+// the same CTE without actuating. Since version 2.
+// @param session  Session
+// @param kp       Coefficient Kp of the candidate
+// @param ki       Coefficient Ki of the candidate
+// @param kd       Coefficient Kd of the candidate
+// @return         1 on success, 0 for a tuning session or too many candidates
+PIDCORE_API int pidcore_session_add_shadow(pidcore_session* session,
+                                           double kp,
+                                           double ki,
+                                           double kd);
+
+// Gets the statistics of a shadow candidate. Since version 2.
+// @param[in]  session     Session
+// @param[in]  i           Index of the candidate in the order of adding
+// @param[out] statistics  Mean and max absolute steering divergence from the
+//                         production steering, and the saturation rate
+// @return                 1 on success, 0 if there's no such candidate
+PIDCORE_API int pidcore_session_get_shadow_statistics(
+  const pidcore_session* session, size_t i, double statistics[3]);
+
+// Creates a Twiddle tuner in the linear search space without bounds.
+// @param p   Initial parameters
+// @param dp  Initial deltas of the parameters
+// @param n   Number of parameters
+// @return    Tuner, NULL on invalid arguments or out of memory
+PIDCORE_API pidcore_twiddler* pidcore_twiddler_create(const double* p,
+                                                      const double* dp,
+                                                      size_t n);
+
+// Destroys a tuner.
+// @param twiddler  Tuner, may be NULL
+PIDCORE_API void pidcore_twiddler_destroy(pidcore_twiddler* twiddler);
+
+// Reports the error of the current parameters and gets the next ones.
+// @param[in]  twiddler  Tuner
+// @param[in]  error     Error of the current parameters
+// @param[out] p         Next parameters, as many as the tuner was created with
+PIDCORE_API void pidcore_twiddler_update(pidcore_twiddler* twiddler,
+                                         double error,
+                                         double* p);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PID_CORE_H
@@ -0,0 +1,209 @@
+#include "RacingLine.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Offset change in meters of the central differences
+const auto kGradientOffset = 1e-3;
+
+// Initial step w.r.t. the max offset, the min step in meters, and the growth
+// of the step after an accepted one
+const auto kInitialStep = 0.25;
+const auto kMinStep = 1e-4;
+const auto kStepGrowth = 1.5;
+
+// Distance between the control offsets in meters
+const auto kControlSpacing = 20.;
+
+// Min curvature in 1/m, keeps the speed limit of straight parts finite
+const auto kMinCurvature = 1e-9;
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+RacingLine::RacingLine(const Track& track, const Settings& settings)
+  : settings_(settings) {
+  assert(track.IsLoaded() && settings.bucket_length > 0);
+  auto n = std::max<size_t>(
+    3, std::lround(track.GetLength() / settings.bucket_length));
+  bucket_length_ = track.GetLength() / n;
+  for (size_t i = 0; i < n; ++i) {
+    double x, y, heading;
+    track.GetPose((i + 0.5) * bucket_length_, x, y, heading);
+    x_.push_back(x);
+    y_.push_back(y);
+    normal_x_.push_back(-std::sin(heading));
+    normal_y_.push_back(std::cos(heading));
+  }
+  // Uniform cubic B-spline weights of the 4 control offsets around every
+  // bucket
+  auto n_controls = std::max<size_t>(
+    4, std::lround(track.GetLength() / kControlSpacing));
+  for (size_t i = 0; i < n; ++i) {
+    auto u = (i + 0.5) * n_controls / n;
+    auto j = static_cast<size_t>(u);
+    auto t = u - j;
+    spline_indices_.push_back((j + n_controls - 1) % n_controls);
+    spline_weights_.push_back((1. - t) * (1. - t) * (1. - t) / 6.);
+    spline_weights_.push_back((3. * t * t * t - 6. * t * t + 4.) / 6.);
+    spline_weights_.push_back((-3. * t * t * t + 3. * t * t + 3. * t + 1.)
+                              / 6.);
+    spline_weights_.push_back(t * t * t / 6.);
+  }
+  controls_.assign(n_controls, 0.);
+  offsets_.assign(n, 0.);
+}
+
+unsigned int RacingLine::Optimize(unsigned int max_iterations,
+                                  unsigned int n_threads) {
+  if (!n_threads) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  auto n = controls_.size();
+  std::vector<double> gradient(n);
+  std::vector<double> candidate(n);
+  std::vector<double> offsets(offsets_.size());
+  auto time = GetLapTime();
+  auto step = kInitialStep * settings_.max_offset;
+  auto n_steps = 0u;
+  for (auto iteration = 0u; iteration < max_iterations && step >= kMinStep;
+       ++iteration) {
+    ComputeGradient(n_threads, gradient);
+    auto norm = 0.;
+    for (auto derivative : gradient) {
+      norm = std::max(norm, std::fabs(derivative));
+    }
+    if (norm == 0.) {
+      break;
+    }
+    // Backtrack until the lap time improves, the steepest control offset
+    // moves by the step
+    for (; step >= kMinStep; step *= 0.5) {
+      for (size_t j = 0; j < n; ++j) {
+        candidate[j] = std::max(-settings_.max_offset,
+                                std::min(settings_.max_offset,
+                                         controls_[j]
+                                         - step * gradient[j] / norm));
+      }
+      auto candidate_time = GetControlLapTime(candidate, offsets);
+      if (candidate_time < time) {
+        controls_.swap(candidate);
+        offsets_.swap(offsets);
+        time = candidate_time;
+        step *= kStepGrowth;
+        ++n_steps;
+        break;
+      }
+    }
+  }
+  return n_steps;
+}
+
+double RacingLine::GetLapTime(const std::vector<double>& offsets) const {
+  auto n = offsets.size();
+  assert(n == x_.size());
+  std::vector<double> x(n);
+  std::vector<double> y(n);
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = x_[i] + offsets[i] * normal_x_[i];
+    y[i] = y_[i] + offsets[i] * normal_y_[i];
+  }
+  // Length of the segment from every node to the next one
+  std::vector<double> ds(n);
+  for (size_t i = 0; i < n; ++i) {
+    auto next = i + 1 < n ? i + 1 : 0;
+    ds[i] = std::hypot(x[next] - x[i], y[next] - y[i]);
+  }
+  // Speed limit by the Menger curvature through every node and its neighbors
+  std::vector<double> v(n);
+  size_t slowest = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto prev = i ? i - 1 : n - 1;
+    auto next = i + 1 < n ? i + 1 : 0;
+    auto cross = (x[i] - x[prev]) * (y[next] - y[i])
+                 - (y[i] - y[prev]) * (x[next] - x[i]);
+    auto chord = std::hypot(x[next] - x[prev], y[next] - y[prev]);
+    auto curvature = std::max(kMinCurvature, 2. * std::fabs(cross)
+                                             / (ds[prev] * ds[i] * chord));
+    v[i] = std::min(settings_.max_speed,
+                    std::sqrt(settings_.max_lateral_acceleration / curvature));
+    if (v[i] < v[slowest]) {
+      slowest = i;
+    }
+  }
+  // Accelerate after, and decelerate before every node, around the lap from
+  // the slowest one
+  for (size_t k = 1; k < n; ++k) {
+    auto i = (slowest + k) % n;
+    auto prev = i ? i - 1 : n - 1;
+    v[i] = std::min(v[i], std::sqrt(v[prev] * v[prev] + 2.
+                                    * settings_.max_acceleration * ds[prev]));
+  }
+  for (size_t k = 1; k < n; ++k) {
+    auto i = (slowest + n - k) % n;
+    auto next = i + 1 < n ? i + 1 : 0;
+    v[i] = std::min(v[i], std::sqrt(v[next] * v[next] + 2.
+                                    * settings_.max_deceleration * ds[i]));
+  }
+  auto time = 0.;
+  for (size_t i = 0; i < n; ++i) {
+    auto next = i + 1 < n ? i + 1 : 0;
+    time += 2. * ds[i] / (v[i] + v[next]);
+  }
+  return time;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+double RacingLine::GetControlLapTime(const std::vector<double>& controls,
+                                     std::vector<double>& offsets) const {
+  auto n_controls = controls.size();
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    const auto* weights = &spline_weights_[4 * i];
+    auto j = spline_indices_[i];
+    auto offset = 0.;
+    for (auto k = 0; k < 4; ++k) {
+      offset += weights[k] * controls[j];
+      j = j + 1 < n_controls ? j + 1 : 0;
+    }
+    offsets[i] = offset;
+  }
+  return GetLapTime(offsets);
+}
+
+void RacingLine::ComputeGradient(unsigned int n_threads,
+                                 std::vector<double>& gradient) const {
+  auto n = controls_.size();
+  gradient.resize(n);
+  std::atomic<size_t> next(0);
+  auto work = [this, n, &gradient, &next]() {
+    auto controls = controls_;
+    std::vector<double> offsets(offsets_.size());
+    for (auto j = next++; j < n; j = next++) {
+      controls[j] = controls_[j] + kGradientOffset;
+      auto forward_time = GetControlLapTime(controls, offsets);
+      controls[j] = controls_[j] - kGradientOffset;
+      auto backward_time = GetControlLapTime(controls, offsets);
+      controls[j] = controls_[j];
+      gradient[j] = (forward_time - backward_time) / (2. * kGradientOffset);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned int t = 1; t < std::min<size_t>(n_threads, n); ++t) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
@@ -0,0 +1,99 @@
+#ifndef RACING_LINE_H
+#define RACING_LINE_H
+
+#include <cstddef>
+#include <vector>
+#include "Track.h"
+
+// Minimum-time racing line over a Track. The line is discretized into
+// buckets of equal centerline distance, each with a lateral offset within the
+// max one. The lap time of a line is that of a point mass: the speed at every
+// bucket is limited by the lateral acceleration in the curvature of the line,
+// then by the acceleration and the deceleration along the line. The offsets
+// follow a periodic cubic B-spline through control offsets a few buckets
+// apart, so the line is smooth and stays within the max offset whenever the
+// control offsets do. Those are optimized by projected gradient descent with
+// a backtracking step, the gradient is computed by central differences, its
+// components in parallel.
+class RacingLine {
+public:
+  // Limits of the line and of the vehicle
+  struct Settings {
+    // Centerline distance covered by a bucket in meters
+    double bucket_length;
+    // Max absolute offset from the centerline in meters
+    double max_offset;
+    // Max speed in meters-per-second
+    double max_speed;
+    // Max lateral acceleration, acceleration and deceleration in
+    // meters-per-second^2
+    double max_lateral_acceleration;
+    double max_acceleration;
+    double max_deceleration;
+  };
+
+  // Constructor, of the centerline.
+  // @param track     Loaded track, must outlive this object
+  // @param settings  Limits of the line and of the vehicle
+  RacingLine(const Track& track, const Settings& settings);
+
+  // Optimizes the offsets.
+  // @param max_iterations  Max number of gradient steps
+  // @param n_threads       Number of threads computing the gradient, 0 means
+  //                        the number of hardware threads
+  // @return                Number of gradient steps taken
+  unsigned int Optimize(unsigned int max_iterations,
+                        unsigned int n_threads = 0);
+
+  // Gets the lap time of a line.
+  // @param offsets  Offset of every bucket in meters
+  // @return         Lap time in seconds
+  double GetLapTime(const std::vector<double>& offsets) const;
+
+  // Gets the lap time of the current line in seconds.
+  double GetLapTime() const { return GetLapTime(offsets_); }
+
+  // Gets the offset of every bucket of the current line in meters, positive
+  // to the left of the centerline like CTE.
+  const std::vector<double>& GetOffsets() const { return offsets_; }
+
+  // Gets the centerline distance covered by a bucket in meters.
+  double GetBucketLength() const { return bucket_length_; }
+
+private:
+  // Gets the lap time of a line through control offsets.
+  // @param[in]  controls  Control offsets in meters
+  // @param[out] offsets   Offset of every bucket in meters
+  // @return               Lap time in seconds
+  double GetControlLapTime(const std::vector<double>& controls,
+                           std::vector<double>& offsets) const;
+
+  // Computes the gradient of the lap time by the current control offsets.
+  // @param[in]  n_threads  Number of threads
+  // @param[out] gradient   Derivative of the lap time by every control offset
+  void ComputeGradient(unsigned int n_threads,
+                       std::vector<double>& gradient) const;
+
+  // Limits of the line and of the vehicle
+  Settings settings_;
+
+  // Centerline distance covered by a bucket, the track length divided into a
+  // whole number of buckets
+  double bucket_length_;
+
+  // Centerline point at the middle of every bucket, and its left normal
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> normal_x_;
+  std::vector<double> normal_y_;
+
+  // First of the 4 control offsets of every bucket, and their weights
+  std::vector<size_t> spline_indices_;
+  std::vector<double> spline_weights_;
+
+  // Control offsets and the offset of every bucket
+  std::vector<double> controls_;
+  std::vector<double> offsets_;
+};
+
+#endif // RACING_LINE_H
@@ -14,7 +14,8 @@ public:
       length_(length),
       steering_noise_(),
       distance_noise_(),
-      steering_drift_() { }
+      steering_drift_(),
+      rng_(std::random_device()()) { }
 
   virtual ~Robot() { }
 
@@ -38,6 +39,11 @@ public:
     distance_noise_ = distance_noise;
   }
 
+  // Seeds the noise generator, so runs are reproducible.
+  void Seed(unsigned int seed) {
+    rng_.seed(seed);
+  }
+
   // Sets the systematical steering drift parameter.
   void SetSteeringDrift(double drift) {
     steering_drift_ = drift;
@@ -61,12 +67,10 @@ public:
     }
 
     // Apply noise
-    std::random_device random_device;
-    std::default_random_engine rng(random_device());
     std::normal_distribution<double> dist_steering(steering, steering_noise_);
     std::normal_distribution<double> dist_distance(distance, distance_noise_);
-    double steering2 = dist_steering(rng);
-    double distance2 = dist_distance(rng);
+    double steering2 = dist_steering(rng_);
+    double distance2 = dist_distance(rng_);
 
     // Apply steering drift
     steering2 += steering_drift_;
@@ -98,6 +102,7 @@ private:
   double steering_noise_;
   double distance_noise_;
   double steering_drift_;
+  std::default_random_engine rng_;
 };
 
 #endif // ROBOT_H
@@ -0,0 +1,784 @@
+#include "Server.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include "json.hpp"
+#include "AsyncLogger.h"
+#include "BayesOptimizer.h"
+#include "Session.h"
+#include "SocketIo.h"
+#include "StageProfiler.h"
+#include "TelemetryArchive.h"
+
+using namespace std::placeholders;
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Number of threads of Bayesian optimization searching the next coefficients.
+// The search runs on the loop thread at every reset, without spawning threads
+// which all sessions would wait for.
+const auto kBayesThreadCount = 1u;
+
+// Max number of laps modelled by Bayesian optimization. The search is
+// quadratic in them, the window keeps it within about a millisecond of the
+// loop thread per reset.
+const auto kBayesMaxObservations = 32u;
+
+// Max number of frames run at once, before the loop drains newly ready
+// sockets
+const auto kFrameSliceCount = 8u;
+
+// Response to HTTP requests of any other path than the dashboard page and the
+// metrics
+const char kNotFoundResponse[] =
+  "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// State of a simulator connection
+struct Connection {
+  uWS::WebSocket<uWS::SERVER> ws;
+  // Session and its identifier
+  Session* session;
+  uint32_t id;
+  SteerOutput output;
+  // Archive of the frames, if recording
+  std::unique_ptr<TelemetryWriter> recorder;
+  // Feed of the dashboard, if enabled
+  std::shared_ptr<Dashboard::Feed> feed;
+};
+
+// Controllers of closed simulator connections by steering backend, in the
+// order of closing. While tuning, the next connection with the same backend
+// resumes tuning of the first one. With final coefficients, it reuses the
+// first one reset in place, so churn of connections doesn't construct
+// controllers.
+typedef std::map<SteeringBackend,
+                 std::deque<std::unique_ptr<PidController>>>
+  ClosedControllers;
+
+// Viewer of the dashboard, deleted once closed and its sends are done
+struct Viewer {
+  uWS::WebSocket<uWS::SERVER> ws;
+  // Number of messages sent but not written yet
+  unsigned int n_pending;
+  // Indicates the viewer disconnected
+  bool is_closed;
+};
+
+// State of the event loop serving the simulator connections
+struct LoopState {
+  // Constructor.
+  // @param scheduling  Settings of the frame scheduler
+  // @param cork_ms     Corking interval, 0 writes messages at once
+  LoopState(const FrameScheduler::Settings& scheduling, unsigned int cork_ms)
+    : scheduler(scheduling),
+      run_timer(),
+      is_run_armed(false),
+      cork_ms(cork_ms) {
+    // Empty.
+  }
+
+  // Frames of all connections, and the timer running them once the loop
+  // drained the ready sockets
+  FrameScheduler scheduler;
+  uS::Timer* run_timer;
+  bool is_run_armed;
+  // Corking interval, and the connections with corked messages
+  unsigned int cork_ms;
+  std::vector<Connection*> corked;
+  // Live feed of the sessions, if enabled, its viewers and the last message
+  // sent to them
+  std::unique_ptr<Dashboard> dashboard;
+  std::set<Viewer*> viewers;
+  std::shared_ptr<const std::string> dashboard_message;
+  // Counters of the frame stages, if enabled
+  std::unique_ptr<StageProfiler> profiler;
+};
+
+// State of a server, shared by the handlers of its hub
+struct ServerState {
+  // Constructor.
+  // @param config  Settings of PID controllers
+  explicit ServerState(const ControllerConfig& config)
+    : config(config),
+      counters(),
+      loop(config.scheduling, config.cork_ms),
+      n_connections() {
+    // Empty.
+  }
+
+  // Settings of PID controllers
+  ControllerConfig config;
+  // Sessions of the connections, and controllers of closed ones
+  SessionPool sessions;
+  ClosedControllers closed_controllers;
+  // Counters of the output stages of all connections
+  SteerOutput::Counters counters;
+  // Frames and output of all connections, served by the loop thread
+  LoopState loop;
+  // Number of connections since the start
+  uint32_t n_connections;
+};
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets a value of the URL query parameter.
+// @param[in] url   URL
+// @param[in] name  Name of the parameter
+// @return          Value of the parameter, or empty string if there's none
+std::string GetQueryParameter(const std::string& url, const std::string& name) {
+  auto query = url.find('?');
+  while (query != std::string::npos) {
+    auto end = url.find('&', query + 1);
+    auto parameter = url.substr(query + 1, end == std::string::npos ?
+                                           end : end - query - 1);
+    if (parameter.compare(0, name.length() + 1, name + "=") == 0) {
+      return parameter.substr(name.length() + 1);
+    }
+    query = end;
+  }
+  return std::string();
+}
+
+// Gets the time of the steady clock.
+// @return  Time in seconds
+double GetSeconds() {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Writes a tuning summary as a JSON line.
+// @param[in] path     File to append, standard output if empty
+// @param[in] summary  Summary of tuning
+void WriteTuningSummary(const std::string& path,
+                        const PidController::TuningSummary& summary) {
+  nlohmann::json json_summary;
+  json_summary["event"] = "tuned";
+  json_summary["outcome"] = PidController::GetOutcomeName(summary.outcome);
+  json_summary["kp"] = summary.coefficients[0];
+  json_summary["ki"] = summary.coefficients[1];
+  json_summary["kd"] = summary.coefficients[2];
+  json_summary["error"] = summary.error;
+  json_summary["evaluations"] = summary.n_evaluations;
+  json_summary["laps"] = summary.laps;
+  json_summary["seconds"] = summary.seconds;
+  json_summary["aborted"] = summary.n_aborted;
+  if (path.empty()) {
+    AsyncLogger::GetDefault().Log(json_summary.dump());
+    return;
+  }
+  std::ofstream file(path, std::ios::app);
+  file << json_summary.dump() << std::endl;
+  if (!file) {
+    std::cerr << "Failed to write tuning summary to " << path << std::endl;
+  }
+}
+
+// Writes a tuning summary, and sends the end of tuning to the dashboard.
+// @param[in] path     File to append, standard output if empty
+// @param[in] feed     Dashboard feed of the session
+// @param[in] summary  Summary of tuning
+void WriteTuningEvent(const std::string& path,
+                      const std::shared_ptr<Dashboard::Feed>& feed,
+                      const PidController::TuningSummary& summary) {
+  WriteTuningSummary(path, summary);
+  feed->PushEvent({GetSeconds(),
+                   {summary.coefficients[0], summary.coefficients[1],
+                    summary.coefficients[2]},
+                   summary.error, true,
+                   PidController::GetOutcomeName(summary.outcome)});
+}
+
+// Sends an evaluation of tuning to the dashboard.
+// @param[in] feed        Dashboard feed of the session
+// @param[in] evaluation  Evaluation
+void PushEvaluation(const std::shared_ptr<Dashboard::Feed>& feed,
+                    const PidController::Evaluation& evaluation) {
+  feed->PushEvent({GetSeconds(),
+                   {evaluation.coefficients[0], evaluation.coefficients[1],
+                    evaluation.coefficients[2]},
+                   evaluation.error, evaluation.is_full_lap, nullptr});
+}
+
+// Selects the steering backend of a simulator connection.
+// @param[in] config    Settings of PID controllers
+// @param[in] steering  Name of the steering backend, the default one is used
+//                      if it's not available
+// @return              Steering backend
+SteeringBackend SelectSteeringBackend(const ControllerConfig& config,
+                                      const std::string& steering) {
+  auto backend = SteeringBackend::kPid;
+  if (!GetSteeringBackend(config, steering, &backend)) {
+    std::cerr << "Unavailable steering backend " << steering
+              << ", using " << config.steering << std::endl;
+    GetSteeringBackend(config, config.steering, &backend);
+  }
+  return backend;
+}
+
+// Reports the progress of tuning of a controller.
+// @param[in]     config          Settings of PID controllers
+// @param[in]     feed            Dashboard feed of the session, may be nullptr
+// @param[in,out] pid_controller  Tuning PID controller
+void SetTuningCallbacks(const ControllerConfig& config,
+                        const std::shared_ptr<Dashboard::Feed>& feed,
+                        PidController& pid_controller) {
+  if (feed) {
+    pid_controller.SetOnTuned(std::bind(WriteTuningEvent,
+                                        config.summary_path, feed, _1));
+    pid_controller.SetOnEvaluated(std::bind(PushEvaluation, feed, _1));
+  } else {
+    pid_controller.SetOnTuned(std::bind(WriteTuningSummary,
+                                        config.summary_path, _1));
+    pid_controller.SetOnEvaluated(nullptr);
+  }
+}
+
+// Creates a PID controller for a simulator connection.
+// @param[in] config   Settings of PID controllers
+// @param[in] backend  Steering backend
+// @param[in] feed     Dashboard feed of the session, may be nullptr
+// @return             PID controller object
+PidController* CreatePidController(
+  const ControllerConfig& config,
+  SteeringBackend backend,
+  const std::shared_ptr<Dashboard::Feed>& feed) {
+  // Tuning starts from the best stored results near the coefficients, also
+  // the ones recorded since the start, except successive halving, whose
+  // population is seeded once
+  auto parameters = GetTwiddleParameters(config);
+  if (config.is_tuning && config.store && !config.halving
+      && config.store->Seed(config.scenario, parameters)) {
+    std::ostringstream oss;
+    oss << "Seeded tuning from " << config.store->GetCount()
+        << " stored evaluations";
+    AsyncLogger::GetDefault().Log(oss.str());
+  }
+  // Every worker of successive halving starts on its own candidate
+  std::unique_ptr<SuccessiveHalving::Worker> worker;
+  if (config.halving) {
+    worker.reset(new SuccessiveHalving::Worker(config.halving));
+    parameters = worker->GetParameters();
+  }
+  PidController* pid_controller = config.is_tuning ?
+    new PidController(parameters[0].p, parameters[1].p, parameters[2].p,
+                      config.off_track_cte, parameters[0].dp,
+                      parameters[1].dp, parameters[2].dp,
+                      config.track_length) :
+    new PidController(config.kp, config.ki, config.kd, config.off_track_cte);
+  if (config.is_tuning && config.tuner == "bayes") {
+    pid_controller->SetTuner(std::unique_ptr<Tuner>(new BayesOptimizer(
+      parameters, kBayesThreadCount, 1, kBayesMaxObservations)));
+  } else if (worker) {
+    pid_controller->SetTuner(std::move(worker));
+  } else if (config.is_tuning) {
+    pid_controller->SetTuner(std::unique_ptr<Tuner>(
+      new Twiddler(parameters)));
+  }
+  if (config.is_tuning) {
+    pid_controller->SetTuningLimits(config.limits);
+    SetTuningCallbacks(config, feed, *pid_controller);
+  }
+  if (config.is_tuning && config.store) {
+    pid_controller->SetExperimentStore(config.store, config.scenario);
+  }
+  if (config.offset_profile) {
+    pid_controller->SetOffsetProfile(config.offset_profile);
+  }
+  if (backend == SteeringBackend::kTable) {
+    pid_controller->SetControlTable(config.table);
+  } else if (backend != SteeringBackend::kPid) {
+    pid_controller->SetSteeringBackend(backend, config.mpc_deadline_ns);
+  }
+  return pid_controller;
+}
+
+// Creates a session for a simulator connection, with inline PID if the
+// coefficients are final and there's no offset profile. Otherwise the
+// session takes the controller a closed connection left with the same
+// backend, if any: resuming tuning, or reset with final coefficients.
+// @param[in]     sessions     Pool of sessions
+// @param[in,out] controllers  Controllers of closed connections
+// @param[in]     config       Settings of PID controllers
+// @param[in]     steering     Name of the steering backend, the default one
+//                             is used if it's not available
+// @param[in]     feed         Dashboard feed of the session, may be nullptr
+// @return                     Session object
+Session* CreateSession(SessionPool& sessions,
+                       ClosedControllers& controllers,
+                       const ControllerConfig& config,
+                       const std::string& steering,
+                       const std::shared_ptr<Dashboard::Feed>& feed) {
+  auto backend = SelectSteeringBackend(config, steering);
+  auto it = controllers.find(backend);
+  if (it != controllers.end()) {
+    std::unique_ptr<PidController> pid_controller(
+      std::move(it->second.front()));
+    it->second.pop_front();
+    if (it->second.empty()) {
+      controllers.erase(it);
+    }
+    if (config.is_tuning) {
+      AsyncLogger::GetDefault().Log("Resuming tuning of a closed connection");
+      pid_controller->Restart();
+      SetTuningCallbacks(config, feed, *pid_controller);
+    } else {
+      AsyncLogger::GetDefault().Log("Reusing the controller of a closed"
+                                    " connection");
+      pid_controller->Reset();
+    }
+    return sessions.Acquire(std::move(pid_controller));
+  }
+  if (!config.is_tuning && backend == SteeringBackend::kPid
+      && !config.offset_profile) {
+    std::ostringstream oss;
+    oss << "Creating PID session with final coefficients Kp=" << config.kp
+        << ", Ki=" << config.ki << ", Kd=" << config.kd;
+    AsyncLogger::GetDefault().Log(oss.str());
+    auto session = sessions.Acquire(config.kp, config.ki, config.kd,
+                                    config.off_track_cte);
+    for (const auto& shadow : config.shadows) {
+      session->AddShadow(shadow[0], shadow[1], shadow[2]);
+    }
+    return session;
+  }
+  return sessions.Acquire(std::unique_ptr<PidController>(
+    CreatePidController(config, backend, feed)));
+}
+
+// Logs the statistics of the shadow candidates of a session.
+// @param[in] session  Session
+void LogShadowStatistics(const Session& session) {
+  for (size_t i = 0; i < session.GetShadowCount(); ++i) {
+    auto statistics = session.GetShadowStatistics(i);
+    std::ostringstream oss;
+    oss << "Shadow candidate " << i << ": mean steering divergence "
+        << std::fixed << std::setprecision(4) << statistics.mean_divergence
+        << ", max " << statistics.max_divergence << ", saturated "
+        << std::setprecision(1) << 100. * statistics.saturation_rate
+        << "% of frames";
+    AsyncLogger::GetDefault().Log(oss.str());
+  }
+}
+
+// Opens the telemetry archive of a connection, logging a failure.
+// @param[in,out] connection  Connection
+// @param[in]     directory   Directory of the archives
+// @param[in]     session     Session identifier, numbers the archive
+void OpenRecorder(Connection& connection, const std::string& directory,
+                  uint32_t session) {
+  std::ostringstream path;
+  path << directory << "/session-" << session << ".tlm";
+  std::unique_ptr<TelemetryWriter> recorder(new TelemetryWriter());
+  if (!recorder->Open(path.str(), session)) {
+    std::cerr << "Failed to record telemetry to " << path.str() << std::endl;
+    return;
+  }
+  AsyncLogger::GetDefault().Log("Recording telemetry to " + path.str());
+  connection.recorder = std::move(recorder);
+}
+
+// Writes messages to the simulator, several ones in one batch.
+// @param[in]     ws        WebSocket object
+// @param[in,out] messages  Messages, consumed
+void WriteMessages(uWS::WebSocket<uWS::SERVER> ws,
+                   std::vector<std::string>& messages) {
+  if (messages.size() == 1) {
+    ws.send(messages[0].data(), messages[0].length(), uWS::OpCode::TEXT);
+    return;
+  }
+  // Frames of all the messages in one buffer, written by one syscall
+  std::vector<int> excluded_messages;
+  auto batch = uWS::WebSocket<uWS::SERVER>::prepareMessageBatch(
+    messages, excluded_messages, uWS::OpCode::TEXT, false);
+  ws.sendPrepared(batch);
+  uWS::WebSocket<uWS::SERVER>::finalizeMessage(batch);
+}
+
+// Flushes the output of a connection to the simulator.
+// @param[in] connection  Connection
+void FlushOutput(Connection& connection) {
+  connection.output.Flush(std::bind(WriteMessages, connection.ws, _1));
+}
+
+// Logs the counters of the output stages.
+// @param[in] counters  Counters of all connections
+void LogOutputCounters(const SteerOutput::Counters& counters) {
+  std::ostringstream oss;
+  oss << "Output: " << counters.n_commands << " steering commands, "
+      << counters.n_suppressed << " suppressed, " << counters.n_refreshed
+      << " refreshed, " << counters.n_messages << " messages in "
+      << counters.n_writes << " writes of " << counters.n_bytes << " bytes";
+  AsyncLogger::GetDefault().Log(oss.str());
+}
+
+// Writes the queued messages of a connection at once, or corks them until the
+// cork timer.
+// @param[in,out] loop        State of the event loop
+// @param[in]     connection  Connection
+// @param[in]     is_corked   Indicates the connection was corked already
+void WriteOrCork(LoopState& loop, Connection& connection, bool is_corked) {
+  if (loop.cork_ms == 0) {
+    FlushOutput(connection);
+  } else if (!is_corked && connection.output.IsPending()) {
+    loop.corked.push_back(&connection);
+  }
+}
+
+// Runs a frame of a connection, steering the simulator or resetting it.
+// @param[in,out] loop   State of the event loop
+// @param[in]     frame  Frame
+void RunFrame(LoopState& loop, const FrameScheduler::Frame& frame) {
+  auto connection = static_cast<Connection*>(frame.context);
+  auto is_corked = connection->output.IsPending();
+  auto controller = connection->session->GetController();
+  auto n_laps = controller ? controller->GetLapCount() : 0;
+  auto steering = 0.;
+  auto throttle = 0.;
+  bool is_control;
+  {
+    StageProfiler::Scope scope(loop.profiler.get(), connection->id,
+                               StageProfiler::Stage::kUpdate);
+    is_control = connection->session->Update(frame.cte, frame.speed,
+                                             steering, throttle);
+  }
+  {
+    StageProfiler::Scope scope(loop.profiler.get(), connection->id,
+                               StageProfiler::Stage::kOutput);
+    if (is_control) {
+      connection->output.Control(steering, throttle);
+    } else {
+      connection->output.Reset();
+    }
+    WriteOrCork(loop, *connection, is_corked);
+  }
+  StageProfiler::Scope scope(loop.profiler.get(), connection->id,
+                             StageProfiler::Stage::kRecord);
+  if (connection->feed) {
+    connection->feed->Push({frame.arrival, frame.cte, steering, frame.speed});
+  }
+  if (connection->recorder) {
+    // A reset frame is recorded with zero steering and throttle, and ends
+    // the lap unless the controller completed it
+    connection->recorder->Append({static_cast<uint64_t>(1e6 * frame.arrival),
+                                  frame.cte, frame.speed, steering, throttle});
+    if (controller && controller->GetLapCount() != n_laps) {
+      connection->recorder->EndLap(LapEnd::kComplete);
+    } else if (!is_control) {
+      connection->recorder->EndLap(LapEnd::kReset);
+    }
+  }
+}
+
+// Runs a slice of the pending frames, and re-arms the timer while frames
+// remain.
+// @param[in] timer  Run timer of the event loop
+void RunFrames(uS::Timer* timer) {
+  auto loop = static_cast<LoopState*>(timer->getData());
+  loop->is_run_armed = false;
+  loop->scheduler.Run(std::bind(RunFrame, std::ref(*loop), _1),
+                      kFrameSliceCount);
+  if (loop->scheduler.GetPendingCount() > 0) {
+    timer->start(RunFrames, 0, 0);
+    loop->is_run_armed = true;
+  }
+}
+
+// Arms the run timer, it fires once the loop drained the ready sockets.
+// @param[in,out] loop  State of the event loop
+void ArmRunTimer(LoopState& loop) {
+  if (!loop.is_run_armed) {
+    loop.run_timer->start(RunFrames, 0, 0);
+    loop.is_run_armed = true;
+  }
+}
+
+// Counts a dashboard message of a viewer as written, and deletes the viewer
+// if it's closed and this was the last one.
+// @param[in] ws         WebSocket of the viewer
+// @param[in] data       Viewer
+// @param[in] cancelled  Indicates the message wasn't written
+// @param[in] reserved   Unused
+void OnDashboardSent(uWS::WebSocket<uWS::SERVER> ws, void* data,
+                     bool cancelled, void* reserved) {
+  auto viewer = static_cast<Viewer*>(data);
+  if (--viewer->n_pending == 0 && viewer->is_closed) {
+    delete viewer;
+  }
+}
+
+// Sends the last dashboard message, collected by the dashboard thread once for
+// all of them, to the viewers. A viewer which hasn't taken the previous
+// message yet skips this one, so a slow viewer never queues up messages.
+// @param[in] timer  Dashboard timer of the event loop
+void SendDashboard(uS::Timer* timer) {
+  auto loop = static_cast<LoopState*>(timer->getData());
+  auto message = loop->dashboard->GetMessage();
+  if (!message || message == loop->dashboard_message) {
+    return;
+  }
+  loop->dashboard_message = message;
+  for (auto viewer : loop->viewers) {
+    if (viewer->n_pending > 0) {
+      continue;
+    }
+    ++viewer->n_pending;
+    viewer->ws.send(message->data(), message->length(), uWS::OpCode::TEXT,
+                    OnDashboardSent, viewer);
+  }
+}
+
+// Gets the path of the URL without the query.
+// @param[in] url  URL
+// @return         Path
+std::string GetPath(const std::string& url) {
+  return url.substr(0, url.find('?'));
+}
+
+} // namespace
+
+const char kDashboardPath[] = "/dashboard";
+
+const char kMetricsPath[] = "/metrics";
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+bool GetSteeringBackend(const ControllerConfig& config,
+                        const std::string& name,
+                        SteeringBackend* backend) {
+  static const std::map<std::string, SteeringBackend> kBackends = {
+    {"pid", SteeringBackend::kPid},
+    {"mpc", SteeringBackend::kMpc},
+    {"table", SteeringBackend::kTable},
+    {"stanley", SteeringBackend::kStanley}};
+  auto it = kBackends.find(name);
+  if (it == kBackends.end()
+      || (it->second == SteeringBackend::kTable
+          && (!config.table || config.is_tuning))) {
+    return false;
+  }
+  if (backend) {
+    *backend = it->second;
+  }
+  return true;
+}
+
+Tuner::ParameterSequence GetTwiddleParameters(const ControllerConfig& config) {
+  const double coefficients[] = {config.kp, config.ki, config.kd};
+  const double deltas[] = {config.dkp, config.dki, config.dkd};
+  Tuner::ParameterSequence parameters;
+  for (auto i = 0; i < 3; ++i) {
+    auto is_linear = config.transform == Tuner::Transform::kLinear;
+    parameters.push_back({coefficients[i], deltas[i],
+                          config.transform,
+                          is_linear ? std::min(0., coefficients[i]) : 0.,
+                          is_linear ? HUGE_VAL : 0.});
+  }
+  return parameters;
+}
+
+bool Serve(uWS::Hub& hub, const ControllerConfig& config, int port) {
+  // The handlers of the hub share the state for the lifetime of the loop
+  auto server = new ServerState(config);
+  auto& loop = server->loop;
+  loop.run_timer = new uS::Timer(hub.getLoop());
+  loop.run_timer->setData(&loop);
+  if (config.dashboard_ms > 0) {
+    loop.dashboard.reset(new Dashboard(config.dashboard));
+  }
+  if (config.is_profiling) {
+    loop.profiler.reset(new StageProfiler());
+  }
+
+  hub.onConnection([server](uWS::WebSocket<uWS::SERVER> ws,
+                            uWS::HttpRequest request) {
+    const auto& config = server->config;
+    auto& loop = server->loop;
+    auto url = request.getUrl().toString();
+    if (GetPath(url) == kDashboardPath) {
+      // Viewers only get the dashboard messages
+      if (!loop.dashboard) {
+        ws.close();
+        return;
+      }
+      auto viewer = new Viewer{ws, 0, false};
+      loop.viewers.insert(viewer);
+      loop.dashboard->SetWatched(true);
+      ws.setUserData(viewer);
+      return;
+    }
+    // Every simulator connection gets its own session, the steering backend
+    // may be selected by the URL query
+    auto steering = GetQueryParameter(url, "steering");
+    auto feed = loop.dashboard ? loop.dashboard->AddFeed() :
+                                 std::shared_ptr<Dashboard::Feed>();
+    auto session = CreateSession(server->sessions, server->closed_controllers,
+                                 config,
+                                 steering.empty() ? config.steering : steering,
+                                 feed);
+    auto connection = new Connection{ws, session, server->n_connections,
+                                     SteerOutput(config.output,
+                                                 server->counters)};
+    connection->feed = feed;
+    if (!config.record_path.empty()) {
+      OpenRecorder(*connection, config.record_path, server->n_connections);
+    }
+    ++server->n_connections;
+    ws.setUserData(connection);
+  });
+
+  hub.onMessage([server](uWS::WebSocket<uWS::SERVER> ws,
+                         char* data,
+                         size_t length,
+                         uWS::OpCode opCode) {
+    auto& loop = server->loop;
+    if (loop.viewers.count(static_cast<Viewer*>(ws.getUserData()))) {
+      return;
+    }
+    auto connection = static_cast<Connection*>(ws.getUserData());
+    if (connection && SocketIo::IsEvent(data, length)) {
+      const char* json = nullptr;
+      size_t json_length = 0;
+      bool is_data;
+      {
+        StageProfiler::Scope scope(loop.profiler.get(), connection->id,
+                                   StageProfiler::Stage::kExtract);
+        is_data = SocketIo::FindJsonData(data, length, json, json_length);
+      }
+      if (is_data) {
+        StageProfiler::Scope scope(loop.profiler.get(), connection->id,
+                                   StageProfiler::Stage::kParse);
+        double cte;
+        double speed;
+        if (SocketIo::ParseTelemetry(json, json_length, cte, speed)) {
+          // The frame runs by its deadline after the loop drained all ready
+          // sockets
+          loop.scheduler.Push(connection, GetSeconds(), cte, speed);
+          ArmRunTimer(loop);
+        }
+      } else {
+        // Manual driving
+        auto is_corked = connection->output.IsPending();
+        connection->output.Queue("42[\"manual\",{}]");
+        WriteOrCork(loop, *connection, is_corked);
+      }
+    }
+  });
+
+  hub.onDisconnection([server](uWS::WebSocket<uWS::SERVER> ws,
+                               int code,
+                               char* message,
+                               size_t length) {
+    auto& loop = server->loop;
+    auto viewer = static_cast<Viewer*>(ws.getUserData());
+    if (loop.viewers.erase(viewer)) {
+      loop.dashboard->SetWatched(!loop.viewers.empty());
+      viewer->is_closed = true;
+      if (viewer->n_pending == 0) {
+        delete viewer;
+      }
+      ws.setUserData(nullptr);
+      return;
+    }
+    auto connection = static_cast<Connection*>(ws.getUserData());
+    if (connection) {
+      auto session = connection->session;
+      if (session->GetController()) {
+        std::ostringstream oss;
+        session->GetController()->PrintStatistics(oss);
+        if (oss.tellp() > 0) {
+          AsyncLogger::GetDefault().Log(oss.str());
+        }
+      }
+      LogShadowStatistics(*session);
+      if (connection->recorder && !connection->recorder->Close()) {
+        std::cerr << "Failed to write telemetry archive" << std::endl;
+      }
+      LogOutputCounters(server->counters);
+      // Tuning continues on the next connection with the same backend, or
+      // the controller is reused by it, the controllers of concurrent
+      // connections queue up
+      if (session->GetController()) {
+        auto backend = session->GetController()->GetSteeringBackend();
+        server->closed_controllers[backend].push_back(
+          session->ReleaseController());
+      }
+      server->sessions.Release(session);
+      loop.scheduler.Remove(connection);
+      if (connection->feed) {
+        loop.dashboard->RemoveFeed(connection->feed);
+      }
+      if (loop.profiler) {
+        loop.profiler->RemoveSession(connection->id);
+      }
+      loop.corked.erase(std::remove(loop.corked.begin(), loop.corked.end(),
+                                    connection),
+                        loop.corked.end());
+      delete connection;
+      ws.setUserData(nullptr);
+    }
+  });
+
+  // Corked messages are written by a timer
+  if (config.cork_ms > 0) {
+    auto timer = new uS::Timer(hub.getLoop());
+    timer->setData(&loop);
+    timer->start([](uS::Timer* timer) {
+      auto loop = static_cast<LoopState*>(timer->getData());
+      for (auto connection : loop->corked) {
+        FlushOutput(*connection);
+      }
+      loop->corked.clear();
+    }, config.cork_ms, config.cork_ms);
+  }
+
+  // Dashboard messages are collected by the dashboard thread and sent by a
+  // timer
+  if (loop.dashboard) {
+    loop.dashboard->Start(config.dashboard_ms);
+    auto timer = new uS::Timer(hub.getLoop());
+    timer->setData(&loop);
+    timer->start(SendDashboard, config.dashboard_ms, config.dashboard_ms);
+  }
+
+  // The dashboard page and the metrics are served over HTTP
+  if (loop.dashboard || loop.profiler) {
+    hub.onHttpRequest([server](uWS::HttpResponse* response,
+                               uWS::HttpRequest request,
+                               char* data,
+                               size_t length,
+                               size_t remaining) {
+      auto& loop = server->loop;
+      auto path = GetPath(request.getUrl().toString());
+      if (loop.dashboard && path == kDashboardPath) {
+        const auto& page = Dashboard::GetPage();
+        response->end(page.data(), page.length());
+      } else if (loop.profiler && path == kMetricsPath) {
+        std::ostringstream metrics;
+        loop.profiler->WriteMetrics(metrics);
+        auto text = metrics.str();
+        response->end(text.data(), text.length());
+      } else {
+        // Writing the head first keeps end from answering 200 OK
+        response->write(kNotFoundResponse, sizeof(kNotFoundResponse) - 1);
+        response->end(nullptr, 0);
+      }
+    });
+  }
+
+  return hub.listen(port);
+}
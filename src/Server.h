@@ -0,0 +1,101 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <uWS/uWS.h>
+#include "Dashboard.h"
+#include "ExperimentStore.h"
+#include "FrameScheduler.h"
+#include "PidController.h"
+#include "SteerOutput.h"
+#include "SuccessiveHalving.h"
+
+// Path of the dashboard page and its feed
+extern const char kDashboardPath[];
+
+// Path of the metrics
+extern const char kMetricsPath[];
+
+// Settings of the PID controllers created for simulator connections
+struct ControllerConfig {
+  // Initial or final PID coefficients and the off-track CTE
+  double kp;
+  double ki;
+  double kd;
+  double off_track_cte;
+  // Indicates the coefficients are tuned, and the tuning settings
+  bool is_tuning;
+  double dkp;
+  double dki;
+  double dkd;
+  double track_length;
+  std::string tuner;
+  // Search space of the coefficients when twiddling
+  Tuner::Transform transform;
+  // Successive halving shared by all connections, if selected
+  std::shared_ptr<SuccessiveHalving> halving;
+  // Experiment store shared by all connections, if any, and the scenario
+  std::shared_ptr<ExperimentStore> store;
+  uint32_t scenario;
+  // Limits of tuning, and the file appended with tuning summaries, standard
+  // output if empty
+  PidController::TuningLimits limits;
+  std::string summary_path;
+  // Output stage of the messages to the simulator, and the corking interval,
+  // 0 writes the messages of every event at once
+  SteerOutput::Settings output;
+  unsigned int cork_ms;
+  // Scheduling of the frames of all connections
+  FrameScheduler::Settings scheduling;
+  // Coefficients of shadow candidates run with final coefficients
+  std::vector<std::array<double, 3>> shadows;
+  // Default steering backend and its settings
+  std::string steering;
+  uint64_t mpc_deadline_ns;
+  std::shared_ptr<const ControlTable> table;
+  // Profile of target offsets from the centerline, if any
+  std::shared_ptr<const OffsetProfile> offset_profile;
+  // Directory of the telemetry archives of the connections, none if empty
+  std::string record_path;
+  // Interval of the dashboard messages in milliseconds, 0 disables the
+  // dashboard, and its settings
+  unsigned int dashboard_ms;
+  Dashboard::Settings dashboard;
+  // Indicates the frame stages are profiled for the metrics
+  bool is_profiling;
+};
+
+// Gets the steering backend by its name. The table backend is unavailable
+// while tuning, since its steering doesn't depend on the coefficients.
+// @param[in]  config   Settings of PID controllers
+// @param[in]  name     Name of the steering backend
+// @param[out] backend  Steering backend, may be nullptr
+// @return              True if the backend is known and available
+bool GetSteeringBackend(const ControllerConfig& config,
+                        const std::string& name,
+                        SteeringBackend* backend);
+
+// Gets the parameters of twiddling the coefficients, also the search space of
+// Bayesian optimization and successive halving. Linear ones are bounded below
+// by zero, or by the initial value if it's negative.
+// @param[in] config  Settings of PID controllers
+// @return            Parameters of Twiddler, BayesOptimizer or
+//                    SuccessiveHalving
+Tuner::ParameterSequence GetTwiddleParameters(const ControllerConfig& config);
+
+// Sets up the event loop of a hub to serve simulator connections, and the
+// dashboard and metrics if enabled, and listens on a port. The frames of all
+// connections run on the loop thread, which runs the hub. The state of the
+// server lives as long as the event loop, e.g. for the process of pid or a
+// load test in process.
+// @param hub     Hub, its event loop serves the connections
+// @param config  Settings of PID controllers
+// @param port    TCP port accepting connections
+// @return        True if listening
+bool Serve(uWS::Hub& hub, const ControllerConfig& config, int port);
+
+#endif // SERVER_H
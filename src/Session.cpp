@@ -0,0 +1,234 @@
+#include "Session.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+Session::Session()
+  : pid_(0., 0., 0.),
+    off_track_cte_(),
+    n_shadows_(),
+    index_(),
+    next_free_() {
+  // Empty.
+}
+
+Session::Session(double kp, double ki, double kd, double off_track_cte)
+  : pid_(kp, ki, kd),
+    off_track_cte_(off_track_cte),
+    n_shadows_(),
+    index_(),
+    next_free_() {
+  assert(off_track_cte > 0);
+}
+
+Session::Session(std::unique_ptr<PidController> controller)
+  : pid_(0., 0., 0.),
+    off_track_cte_(),
+    controller_(std::move(controller)),
+    n_shadows_(),
+    index_(),
+    next_free_() {
+  assert(controller_);
+}
+
+void Session::Reset(double kp, double ki, double kd, double off_track_cte) {
+  assert(off_track_cte > 0);
+  pid_ = Pid(kp, ki, kd);
+  off_track_cte_ = off_track_cte;
+  controller_.reset();
+  n_shadows_ = 0;
+}
+
+void Session::Reset(std::unique_ptr<PidController> controller) {
+  assert(controller);
+  controller_ = std::move(controller);
+  n_shadows_ = 0;
+}
+
+bool Session::Update(double cte, double speed,
+                     double& steering, double& throttle) {
+  if (!controller_) {
+    steering = std::max(-1., std::min(1., pid_.GetSteering(cte, speed)));
+    throttle = PidController::ComputeThrottle(cte, speed, off_track_cte_);
+    if (n_shadows_) {
+      UpdateShadows(steering);
+    }
+    return true;
+  }
+  // Two captures fit in the functional object, so a frame doesn't allocate
+  auto is_control = false;
+  double control[2];
+  controller_->Update(cte, speed,
+                      [&control, &is_control](double controlled_steering,
+                                              double controlled_throttle) {
+                        control[0] = controlled_steering;
+                        control[1] = controlled_throttle;
+                        is_control = true;
+                      },
+                      []() { });
+  if (is_control) {
+    steering = control[0];
+    throttle = control[1];
+  }
+  return is_control;
+}
+
+bool Session::AddShadow(double kp, double ki, double kd) {
+  if (controller_ || n_shadows_ == kMaxShadowCount) {
+    return false;
+  }
+  if (!shadows_) {
+    shadows_.reset(new Shadow[kMaxShadowCount]);
+  }
+  shadows_[n_shadows_++] = {kp, ki, kd, 0., 0., 0, 0};
+  return true;
+}
+
+Session::ShadowStatistics Session::GetShadowStatistics(size_t i) const {
+  assert(i < n_shadows_);
+  const auto& shadow = shadows_[i];
+  ShadowStatistics statistics = {};
+  if (shadow.n_frames > 0) {
+    statistics.mean_divergence = shadow.sum_divergence / shadow.n_frames;
+    statistics.max_divergence = shadow.max_divergence;
+    statistics.saturation_rate =
+      static_cast<double>(shadow.n_saturated) / shadow.n_frames;
+  }
+  return statistics;
+}
+
+void Session::GetCoefficients(double& kp, double& ki, double& kd) const {
+  if (controller_) {
+    controller_->GetCoefficients(kp, ki, kd);
+  } else {
+    pid_.GetCoefficients(kp, ki, kd);
+  }
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void Session::UpdateShadows(double steering) {
+  double p_error;
+  double i_error;
+  double d_error;
+  pid_.GetErrors(p_error, i_error, d_error);
+  for (uint32_t i = 0; i < n_shadows_; ++i) {
+    auto& shadow = shadows_[i];
+    // Same as Pid::Evaluate with the coefficients of the candidate
+    auto raw_steering = -shadow.kp * p_error - shadow.ki * i_error
+                        - shadow.kd * d_error;
+    auto divergence =
+      std::fabs(std::max(-1., std::min(1., raw_steering)) - steering);
+    shadow.sum_divergence += divergence;
+    shadow.max_divergence = std::max(shadow.max_divergence, divergence);
+    shadow.n_saturated += std::fabs(raw_steering) > 1.;
+    ++shadow.n_frames;
+  }
+}
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+SessionPool::SessionPool()
+  : n_slabs_(0),
+    free_top_(kNoIndex),
+    count_(0) {
+  for (auto& slab : slabs_) {
+    slab.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+SessionPool::~SessionPool() {
+  for (uint32_t i = 0; i < n_slabs_.load(); ++i) {
+    auto slab = slabs_[i].load();
+    for (auto j = 0; j < kSlabSessionCount; ++j) {
+      slab[j].~Session();
+    }
+    std::free(slab);
+  }
+}
+
+void SessionPool::Release(Session* session) {
+  if (!session) {
+    return;
+  }
+  session->controller_.reset();
+  count_.fetch_sub(1, std::memory_order_relaxed);
+  Push(session, session);
+}
+
+size_t SessionPool::GetReservedSize() const {
+  return n_slabs_.load(std::memory_order_relaxed) * kSlabSessionCount
+         * sizeof(Session);
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+Session* SessionPool::GetSession(uint32_t index) const {
+  auto slab = slabs_[index / kSlabSessionCount].load(std::memory_order_acquire);
+  return slab + index % kSlabSessionCount;
+}
+
+Session* SessionPool::Pop() {
+  auto top = free_top_.load(std::memory_order_acquire);
+  for (;;) {
+    auto index = static_cast<uint32_t>(top);
+    if (index != kNoIndex) {
+      // The next index may be stale if another thread pops the session first,
+      // then the version tag fails the exchange
+      auto next = GetSession(index)->next_free_.load(std::memory_order_relaxed);
+      auto new_top = (((top >> 32) + 1) << 32) | next;
+      if (free_top_.compare_exchange_weak(top, new_top,
+                                          std::memory_order_acquire,
+                                          std::memory_order_acquire)) {
+        return GetSession(index);
+      }
+      continue;
+    }
+
+    // Add a slab unless another thread has just added one
+    std::lock_guard<std::mutex> lock(slab_mutex_);
+    top = free_top_.load(std::memory_order_acquire);
+    if (static_cast<uint32_t>(top) != kNoIndex) {
+      continue;
+    }
+    auto n_slabs = n_slabs_.load(std::memory_order_relaxed);
+    void* memory = nullptr;
+    if (n_slabs == kMaxSlabCount
+        || posix_memalign(&memory, alignof(Session),
+                          kSlabSessionCount * sizeof(Session)) != 0) {
+      throw std::bad_alloc();
+    }
+    auto slab = static_cast<Session*>(memory);
+    for (auto i = 0; i < kSlabSessionCount; ++i) {
+      auto session = new (slab + i) Session();
+      session->index_ = n_slabs * kSlabSessionCount + i;
+      session->next_free_.store(session->index_ + 1,
+                                std::memory_order_relaxed);
+    }
+    slabs_[n_slabs].store(slab, std::memory_order_release);
+    n_slabs_.store(n_slabs + 1, std::memory_order_release);
+    // Keep the first session, the others are free in the order of addresses
+    Push(slab + 1, slab + kSlabSessionCount - 1);
+    return slab;
+  }
+}
+
+void SessionPool::Push(Session* first, Session* last) {
+  auto top = free_top_.load(std::memory_order_relaxed);
+  uint64_t new_top;
+  do {
+    last->next_free_.store(static_cast<uint32_t>(top),
+                           std::memory_order_relaxed);
+    new_top = (((top >> 32) + 1) << 32) | first->index_;
+  } while (!free_top_.compare_exchange_weak(top, new_top,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+}
@@ -0,0 +1,212 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "Pid.h"
+#include "PidController.h"
+
+// State of one simulator connection. With final PID coefficients, the whole
+// state is this object: the PID inline, in at most two cache lines, and no
+// other allocation. Tuning and the other steering backends keep their state
+// out of line in a PidController, which the session then delegates to.
+//
+// With final PID coefficients a session may also run shadow candidates:
+// coefficients evaluated on the same CTE but never actuated, to see how they
+// would have steered on real traffic. All candidates share the PID errors of
+// the production PID, which are the same for the same CTE, so a candidate
+// costs one dot product per frame. The candidates live in a block attached by
+// the first AddShadow, which the session keeps when reset, so sessions without
+// candidates stay compact and a reused session doesn't allocate it again.
+class alignas(64) Session {
+public:
+  // Max number of shadow candidates
+  enum { kMaxShadowCount = 2 };
+
+  // Statistics of a shadow candidate w.r.t. the production steering
+  struct ShadowStatistics {
+    // Mean and max absolute difference of steering values within -1..1
+    double mean_divergence;
+    double max_divergence;
+    // Part of the frames the candidate would have saturated steering
+    double saturation_rate;
+  };
+
+  // Constructor of an idle session, to be reset before use.
+  Session();
+
+  // Constructor of a session with final PID coefficients.
+  // @param kp             Coefficient Kp of PID
+  // @param ki             Coefficient Ki of PID
+  // @param kd             Coefficient Kd of PID
+  // @param off_track_cte  CTE when the vehicle is considered off-track
+  Session(double kp, double ki, double kd, double off_track_cte);
+
+  // Constructor of a session delegating to a controller.
+  // @param controller  Controller, e.g. tuning or with another backend
+  explicit Session(std::unique_ptr<PidController> controller);
+
+  // Resets the session in place to final PID coefficients.
+  // @param kp             Coefficient Kp of PID
+  // @param ki             Coefficient Ki of PID
+  // @param kd             Coefficient Kd of PID
+  // @param off_track_cte  CTE when the vehicle is considered off-track
+  void Reset(double kp, double ki, double kd, double off_track_cte);
+
+  // Resets the session in place to delegate to a controller.
+  // @param controller  Controller, e.g. tuning or with another backend
+  void Reset(std::unique_ptr<PidController> controller);
+
+  // Updates the session with the new values of CTE and speed.
+  // @param[in]  cte       Cross-track error (CTE)
+  // @param[in]  speed     Speed in miles-per-hour
+  // @param[out] steering  Steering value within -1..1, if controlling
+  // @param[out] throttle  Throttle value within -1..1, if controlling
+  // @return               True to control the simulator, false to reset it
+  bool Update(double cte, double speed, double& steering, double& throttle);
+
+  // Adds a shadow candidate, with final PID coefficients only.
+  // @param kp  Coefficient Kp of the candidate
+  // @param ki  Coefficient Ki of the candidate
+  // @param kd  Coefficient Kd of the candidate
+  // @return    False if delegating to a controller, or kMaxShadowCount
+  //            candidates are running already
+  bool AddShadow(double kp, double ki, double kd);
+
+  // Gets the number of shadow candidates.
+  size_t GetShadowCount() const { return n_shadows_; }
+
+  // Gets the statistics of a shadow candidate since it was added.
+  // @param i  Index of the candidate in the order of adding
+  ShadowStatistics GetShadowStatistics(size_t i) const;
+
+  // Gets the current PID coefficients, of the controller if any.
+  void GetCoefficients(double& kp, double& ki, double& kd) const;
+
+  // Takes the controller out of the session, e.g. to keep tuning across
+  // connections. The session must then be released.
+  // @return  Controller, nullptr with inline PID
+  std::unique_ptr<PidController> ReleaseController() {
+    return std::move(controller_);
+  }
+
+  // Gets the controller, nullptr with inline PID.
+  PidController* GetController() const { return controller_.get(); }
+
+private:
+  friend class SessionPool;
+
+  // PID with final coefficients, unused with a controller
+  Pid pid_;
+
+  // CTE when the vehicle is considered off-track
+  double off_track_cte_;
+
+  // Controller with out-of-line state, if any
+  std::unique_ptr<PidController> controller_;
+
+  // Shadow candidate, its coefficients and the running statistics
+  struct Shadow {
+    double kp;
+    double ki;
+    double kd;
+    double sum_divergence;
+    double max_divergence;
+    uint32_t n_frames;
+    uint32_t n_saturated;
+  };
+
+  // Shadow candidates, nullptr until the first one is added
+  std::unique_ptr<Shadow[]> shadows_;
+
+  // Number of shadow candidates
+  uint32_t n_shadows_;
+
+  // Index of the session within its pool, and of the next free session
+  uint32_t index_;
+  std::atomic<uint32_t> next_free_;
+
+  // Updates the shadow candidates with the PID errors of the last frame.
+  // @param steering  Production steering value within -1..1
+  void UpdateShadows(double steering);
+};
+
+static_assert(sizeof(Session) <= 128, "Session must fit two cache lines");
+
+// Pool of pre-constructed sessions. Sessions are constructed in
+// cache-line-aligned slabs of kSlabSessionCount, and released ones are reset
+// in place on reuse, so churn of connections neither allocates nor constructs
+// anything. Acquiring and releasing are lock-free: the free sessions form a
+// stack of indices with a version tag against ABA, and only adding a slab
+// takes a lock.
+class SessionPool {
+public:
+  // Number of sessions per slab, and max number of slabs
+  enum { kSlabSessionCount = 1024, kMaxSlabCount = 1024 };
+
+  // Constructor, reserves no memory.
+  SessionPool();
+
+  // Destructor, destroys all sessions and frees the slabs.
+  ~SessionPool();
+
+  SessionPool(const SessionPool&) = delete;
+  SessionPool& operator=(const SessionPool&) = delete;
+
+  // Acquires a session reset with the given arguments.
+  // @param args  Arguments of a Session::Reset
+  // @return      Acquired session
+  template<typename... Args>
+  Session* Acquire(Args&&... args) {
+    auto session = Pop();
+    session->Reset(std::forward<Args>(args)...);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    return session;
+  }
+
+  // Releases a session acquired from this pool, its controller if any is
+  // destroyed.
+  // @param session  Session, may be nullptr
+  void Release(Session* session);
+
+  // Gets the number of acquired sessions.
+  size_t GetCount() const { return count_.load(std::memory_order_relaxed); }
+
+  // Gets the number of bytes reserved by the slabs.
+  size_t GetReservedSize() const;
+
+private:
+  // Index meaning no session
+  static const uint32_t kNoIndex = 0xffffffff;
+
+  // Slabs of sessions
+  std::atomic<Session*> slabs_[kMaxSlabCount];
+
+  // Number of slabs, guarded by slab_mutex_ for writing
+  std::atomic<uint32_t> n_slabs_;
+  std::mutex slab_mutex_;
+
+  // Top of the stack of free sessions: version tag in the high half, index in
+  // the low half
+  std::atomic<uint64_t> free_top_;
+
+  // Number of acquired sessions
+  std::atomic<size_t> count_;
+
+  // Gets a session by index.
+  Session* GetSession(uint32_t index) const;
+
+  // Pops a free session, adding a slab if there is none.
+  Session* Pop();
+
+  // Pushes a chain of free sessions linked by next_free_.
+  // @param first  First session of the chain
+  // @param last   Last session of the chain
+  void Push(Session* first, Session* last);
+};
+
+#endif // SESSION_H
@@ -0,0 +1,155 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "DynamicBicycle.h"
+#include "Robot.h"
+#include "Track.h"
+
+// Offline stand-in for the simulator. Drives a vehicle along a straight track,
+// or along the centerline of a Track, at the simulator framerate, takes the
+// steering and throttle values like the steer message, and reports CTE and
+// speed like the telemetry message. The vehicle is a kinematic Robot, or a
+// DynamicBicycle understeering at speed.
+class Simulator {
+public:
+  // Framerate of the simulator
+  static constexpr double kFrameRate = 25.;
+
+  // Fixed steps of the dynamic model per frame
+  static constexpr int kDynamicStepCount = 4;
+
+  // Max steering angle in radians corresponding to the steering value of 1
+  static constexpr double kMaxSteeringAngle = 25. / 180. * M_PI;
+
+  // Acceleration in meters-per-second^2 at full throttle
+  static constexpr double kMaxAcceleration = 6.;
+
+  // Coefficient of conversion miles-per-hour to meters-per-second
+  static constexpr double kMphToMps = 1609.344 / (60. * 60.);
+
+  // Vehicle models
+  enum class Model {
+    kKinematic,
+    kDynamic
+  };
+
+  // Creates the simulator and resets the vehicle.
+  // @param max_speed       Max speed in miles-per-hour
+  // @param initial_cte     CTE after reset
+  // @param steering_drift  Systematical steering drift in radians
+  // @param steering_noise  Standard deviation of steering noise in radians
+  // @param seed            Seed of the noise generator
+  // @param track           Track, must outlive the simulator, nullptr for a
+  //                        straight track
+  // @param model           Vehicle model
+  Simulator(double max_speed,
+            double initial_cte = 1.,
+            double steering_drift = 0.,
+            double steering_noise = 0.,
+            unsigned int seed = 1,
+            const Track* track = nullptr,
+            Model model = Model::kKinematic)
+    : max_speed_(max_speed),
+      initial_cte_(initial_cte),
+      track_(track),
+      model_(model),
+      robot_(kWheelbase),
+      dynamics_(DynamicBicycle::GetSedan(), 1,
+                1. / (kFrameRate * kDynamicStepCount)),
+      steering_drift_(steering_drift),
+      steering_noise_(steering_noise),
+      rng_(seed),
+      speed_(),
+      distance_(),
+      n_frames_() {
+    robot_.SetSteeringDrift(steering_drift);
+    robot_.SetNoise(steering_noise, 0.);
+    robot_.Seed(seed);
+    Reset();
+  }
+
+  // Puts the vehicle at the start with zero speed.
+  void Reset() {
+    auto x = 0.;
+    auto y = initial_cte_;
+    auto heading = 0.;
+    if (track_) {
+      track_->GetPose(0., x, y, heading);
+      x -= initial_cte_ * std::sin(heading);
+      y += initial_cte_ * std::cos(heading);
+    }
+    robot_.Set(x, y, heading);
+    dynamics_.Reset(0, x, y, heading);
+    speed_ = 0.;
+    distance_ = 0.;
+    n_frames_ = 0;
+  }
+
+  // Gets CTE.
+  double GetCte() const {
+    double x, y, orientation;
+    if (model_ == Model::kDynamic) {
+      x = dynamics_.Get(DynamicBicycle::kX)[0];
+      y = dynamics_.Get(DynamicBicycle::kY)[0];
+    } else {
+      robot_.Get(x, y, orientation);
+    }
+    return track_ ? track_->GetCte(x, y) : y;
+  }
+
+  // Gets speed in miles-per-hour.
+  double GetSpeed() const { return speed_ / kMphToMps; }
+
+  // Gets the distance driven since reset in meters.
+  double GetDistance() const { return distance_; }
+
+  // Gets the number of frames since reset.
+  unsigned long int GetFrameCount() const { return n_frames_; }
+
+  // Applies the control values and advances by one frame.
+  // @param steering  Steering value within -1..1
+  // @param throttle  Throttle value within -1..1
+  void Control(double steering, double throttle) {
+    auto dt = 1. / kFrameRate;
+    if (model_ == Model::kDynamic) {
+      auto angle = kMaxSteeringAngle * steering + steering_drift_;
+      if (steering_noise_ > 0) {
+        angle += std::normal_distribution<double>(0., steering_noise_)(rng_);
+      }
+      auto acceleration = kMaxAcceleration * throttle;
+      for (auto step = 0; step < kDynamicStepCount; ++step) {
+        dynamics_.Step(&angle, &acceleration, kMphToMps * max_speed_);
+        speed_ = dynamics_.Get(DynamicBicycle::kVx)[0];
+        distance_ += speed_ * dynamics_.GetStep();
+      }
+    } else {
+      speed_ = std::max(0., std::min(kMphToMps * max_speed_,
+                                     speed_ + dt * kMaxAcceleration * throttle));
+      robot_.Move(kMaxSteeringAngle * steering, speed_ * dt);
+      distance_ += speed_ * dt;
+    }
+    ++n_frames_;
+  }
+
+private:
+  // Vehicle wheelbase in meters
+  static constexpr double kWheelbase = 2.67;
+
+  double max_speed_;
+  double initial_cte_;
+  const Track* track_;
+  Model model_;
+  Robot robot_;
+  DynamicBicycle dynamics_;
+  double steering_drift_;
+  double steering_noise_;
+  std::default_random_engine rng_;
+  double speed_;
+  double distance_;
+  unsigned long int n_frames_;
+};
+
+#endif // SIMULATOR_H
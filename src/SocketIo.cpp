@@ -0,0 +1,115 @@
+#include "SocketIo.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Name of the telemetry event, quoted
+const char kTelemetry[] = "\"telemetry\"";
+
+// Keys of CTE and speed, quoted
+const char kCteKey[] = "\"cte\"";
+const char kSpeedKey[] = "\"speed\"";
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Skips JSON whitespace.
+// @param begin  Start of the range
+// @param end    End of the range
+// @return       First other character, or the end
+const char* SkipSpace(const char* begin, const char* end) {
+  while (begin != end && (*begin == ' ' || *begin == '\t' || *begin == '\n'
+                          || *begin == '\r')) {
+    ++begin;
+  }
+  return begin;
+}
+
+// Parses the number of a key, quoted or not. Base64 images have no quotes, so
+// the first quoted key is the key.
+// @param begin  Start of the range
+// @param end    End of the range, its last character is not a number
+// @param key    Quoted key
+// @return       Value of the key
+double ParseNumber(const char* begin, const char* end, const char* key) {
+  auto key_length = std::strlen(key);
+  auto p = std::search(begin, end, key, key + key_length);
+  if (p == end) {
+    throw std::invalid_argument(std::string("missing ") + key);
+  }
+  p = SkipSpace(p + key_length, end);
+  if (p == end || *p != ':') {
+    throw std::invalid_argument(std::string("malformed ") + key);
+  }
+  p = SkipSpace(p + 1, end);
+  auto is_quoted = p != end && *p == '"';
+  p += is_quoted;
+  if (p == end) {
+    throw std::invalid_argument(std::string("malformed ") + key);
+  }
+  char* number_end = nullptr;
+  auto value = std::strtod(p, &number_end);
+  if (number_end == p || number_end >= end
+      || (is_quoted && *number_end != '"')) {
+    throw std::invalid_argument(std::string("malformed ") + key);
+  }
+  return value;
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+bool SocketIo::FindJsonData(const char* data, size_t length,
+                            const char*& json, size_t& json_length) {
+  const char null[] = "null";
+  auto end = data + length;
+  auto b1 = std::find(data, end, '[');
+  auto b2 = std::find(std::reverse_iterator<const char*>(end),
+                      std::reverse_iterator<const char*>(data), ']');
+  if (std::search(data, end, null, null + 4) != end || b1 == end
+      || b2.base() == data || b2.base() <= b1) {
+    return false;
+  }
+  json = b1;
+  json_length = b2.base() - b1;
+  return true;
+}
+
+std::string SocketIo::GetJsonData(const std::string& s) {
+  const char* json = nullptr;
+  size_t json_length = 0;
+  return FindJsonData(s.data(), s.length(), json, json_length) ?
+    std::string(json, json_length) : std::string();
+}
+
+bool SocketIo::ParseTelemetry(const char* json, size_t length, double& cte,
+                              double& speed) {
+  auto end = json + length;
+  auto p = SkipSpace(json, end);
+  if (p == end || *p != '[') {
+    throw std::invalid_argument("malformed event");
+  }
+  p = SkipSpace(p + 1, end);
+  if (p == end || *p != '"') {
+    throw std::invalid_argument("malformed event name");
+  }
+  auto name_length = sizeof(kTelemetry) - 1;
+  if (static_cast<size_t>(end - p) < name_length
+      || std::memcmp(p, kTelemetry, name_length) != 0) {
+    return false;
+  }
+  // The data object follows the name
+  p += name_length;
+  cte = ParseNumber(p, end, kCteKey);
+  speed = ParseNumber(p, end, kSpeedKey);
+  return true;
+}
@@ -0,0 +1,56 @@
+#ifndef SOCKET_IO_H
+#define SOCKET_IO_H
+
+#include <cstddef>
+#include <string>
+
+// Decoding of the SocketIO events of the simulator, shared by the event loop
+// and the offline benchmarks driving it. The event loop decodes in place, so
+// a frame allocates nothing before it's scheduled.
+class SocketIo {
+public:
+  // Indicates a message is an event: "42" at the start of the message, the 4
+  // signifies a websocket message, the 2 signifies a websocket event.
+  // @param data    Message
+  // @param length  Length of the message
+  static bool IsEvent(const char* data, size_t length) {
+    return length > 2 && data[0] == '4' && data[1] == '2';
+  }
+
+  // Finds the JSON data of the SocketIO event within the message.
+  // @param[in]  data         Raw event
+  // @param[in]  length       Length of the event
+  // @param[out] json         JSON data within the event, if any
+  // @param[out] json_length  Length of the JSON data, if any
+  // @return                  True if there is data
+  static bool FindJsonData(const char* data, size_t length, const char*& json,
+                           size_t& json_length);
+
+  // Checks if the SocketIO event has JSON data.
+  // @param[in] s  Raw event string
+  // @return       If there is data the JSON object in string format will be
+  //               returned, else the empty string will be returned.
+  static std::string GetJsonData(const std::string& s);
+
+  // Parses the JSON data of an event in place, without building a document,
+  // throws if the event name, CTE or speed is malformed.
+  // @param[in]  json    JSON data of the event
+  // @param[in]  length  Length of the JSON data, which ends with "]"
+  // @param[out] cte     Cross-track error (CTE), if telemetry
+  // @param[out] speed   Speed in miles-per-hour, if telemetry
+  // @return             True if the event is telemetry
+  static bool ParseTelemetry(const char* json, size_t length, double& cte,
+                             double& speed);
+
+  // Parses the JSON data of an event, throws if it's malformed.
+  // @param[in]  json   JSON data of the event
+  // @param[out] cte    Cross-track error (CTE), if telemetry
+  // @param[out] speed  Speed in miles-per-hour, if telemetry
+  // @return            True if the event is telemetry
+  static bool ParseTelemetry(const std::string& json, double& cte,
+                             double& speed) {
+    return ParseTelemetry(json.data(), json.length(), cte, speed);
+  }
+};
+
+#endif // SOCKET_IO_H
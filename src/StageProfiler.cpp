@@ -0,0 +1,191 @@
+#include "StageProfiler.h"
+#include <ctime>
+#include <iomanip>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Names of the stages
+const char* kStageNames[] = {"extract", "parse", "update", "output", "record"};
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Metric of the counters
+struct Metric {
+  // Name and help
+  const char* name;
+  const char* help;
+  // Indicates nanoseconds written as seconds
+  bool is_seconds;
+  // Member of the counters
+  uint64_t StageProfiler::Counters::* member;
+};
+
+const Metric kMetrics[] = {
+  {"pid_stage_runs_total", "Runs of the stage.", false,
+   &StageProfiler::Counters::n_runs},
+  {"pid_stage_allocations_total", "Allocations of the stage.", false,
+   &StageProfiler::Counters::n_allocations},
+  {"pid_stage_allocated_bytes_total", "Bytes allocated by the stage.", false,
+   &StageProfiler::Counters::n_bytes},
+  {"pid_stage_cpu_seconds_total", "CPU time of the stage.", true,
+   &StageProfiler::Counters::cpu_ns}
+};
+
+// Local Variables
+// -----------------------------------------------------------------------------
+
+// Allocation counters of the thread, trivial so the allocator may count
+// before anything is constructed
+thread_local uint64_t thread_n_allocations;
+thread_local uint64_t thread_n_bytes;
+
+// Indicates the counting global allocator is linked
+bool is_counting_allocations;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Adds the counters of a run.
+// @param[in,out] counters  Counters
+// @param[in]     run       Counters of the run
+void Add(StageProfiler::Counters& counters,
+         const StageProfiler::Counters& run) {
+  ++counters.n_runs;
+  counters.n_allocations += run.n_allocations;
+  counters.n_bytes += run.n_bytes;
+  counters.cpu_ns += run.cpu_ns;
+}
+
+// Writes a sample of a metric, exactly.
+// @param[in] os        Output stream
+// @param[in] metric    Metric
+// @param[in] counters  Counters
+void WriteValue(std::ostream& os, const Metric& metric,
+                const StageProfiler::Counters& counters) {
+  auto value = counters.*metric.member;
+  if (metric.is_seconds) {
+    os << value / 1000000000 << '.' << std::setfill('0') << std::setw(9)
+       << value % 1000000000 << std::setfill(' ');
+  } else {
+    os << value;
+  }
+  os << '\n';
+}
+
+} // namespace
+
+constexpr size_t StageProfiler::kStageCount;
+
+// Scope Public Members
+// -----------------------------------------------------------------------------
+
+StageProfiler::Scope::Scope(StageProfiler* profiler, uint32_t session,
+                            Stage stage)
+  : profiler_(profiler),
+    session_(session),
+    stage_(stage),
+    n_allocations_(),
+    n_bytes_(),
+    cpu_ns_() {
+  if (profiler_) {
+    GetThreadAllocations(n_allocations_, n_bytes_);
+    cpu_ns_ = GetThreadCpuTime();
+  }
+}
+
+StageProfiler::Scope::~Scope() {
+  if (profiler_) {
+    auto cpu_ns = GetThreadCpuTime();
+    uint64_t n_allocations;
+    uint64_t n_bytes;
+    GetThreadAllocations(n_allocations, n_bytes);
+    profiler_->Record(session_, stage_, {0, n_allocations - n_allocations_,
+                                         n_bytes - n_bytes_,
+                                         cpu_ns - cpu_ns_});
+  }
+}
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+StageProfiler::StageProfiler()
+  : totals_() {
+  // Empty.
+}
+
+void StageProfiler::Record(uint32_t session, Stage stage,
+                           const Counters& run) {
+  auto i = static_cast<size_t>(stage);
+  Add(totals_[i], run);
+  // A new session allocates its counters once, outside of the measured run
+  Add(sessions_[session].stages[i], run);
+}
+
+void StageProfiler::RemoveSession(uint32_t session) {
+  sessions_.erase(session);
+}
+
+bool StageProfiler::GetSessionCounters(uint32_t session, Stage stage,
+                                       Counters& counters) const {
+  auto it = sessions_.find(session);
+  if (it == sessions_.end()) {
+    return false;
+  }
+  counters = it->second.stages[static_cast<size_t>(stage)];
+  return true;
+}
+
+void StageProfiler::WriteMetrics(std::ostream& os) const {
+  os << "# HELP pid_allocation_counting Whether allocations are counted.\n"
+     << "# TYPE pid_allocation_counting gauge\n"
+     << "pid_allocation_counting " << (IsCountingAllocations() ? 1 : 0)
+     << '\n';
+  for (const auto& metric : kMetrics) {
+    os << "# HELP " << metric.name << ' ' << metric.help << '\n'
+       << "# TYPE " << metric.name << " counter\n";
+    for (size_t i = 0; i < kStageCount; ++i) {
+      os << metric.name << "{stage=\"" << kStageNames[i] << "\"} ";
+      WriteValue(os, metric, totals_[i]);
+    }
+    for (const auto& session : sessions_) {
+      for (size_t i = 0; i < kStageCount; ++i) {
+        os << metric.name << "{session=\"" << session.first << "\",stage=\""
+           << kStageNames[i] << "\"} ";
+        WriteValue(os, metric, session.second.stages[i]);
+      }
+    }
+  }
+}
+
+const char* StageProfiler::GetStageName(Stage stage) {
+  return kStageNames[static_cast<size_t>(stage)];
+}
+
+uint64_t StageProfiler::GetThreadCpuTime() {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return 1000000000ull * time.tv_sec + time.tv_nsec;
+}
+
+void StageProfiler::GetThreadAllocations(uint64_t& n_allocations,
+                                         uint64_t& n_bytes) {
+  n_allocations = thread_n_allocations;
+  n_bytes = thread_n_bytes;
+}
+
+bool StageProfiler::IsCountingAllocations() {
+  return is_counting_allocations;
+}
+
+void StageProfiler::CountAllocation(size_t size) {
+  ++thread_n_allocations;
+  thread_n_bytes += size;
+}
+
+void StageProfiler::EnableAllocationCounting() {
+  is_counting_allocations = true;
+}
@@ -0,0 +1,138 @@
+#ifndef STAGE_PROFILER_H
+#define STAGE_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+
+// Attribution of allocations and CPU time to the stages of the frame pipeline
+// and to the sessions, for the metrics endpoint. A Scope samples the CPU
+// clock of its thread, CLOCK_THREAD_CPUTIME_ID, and the allocation counters of
+// its thread around a stage. Allocations are counted by the counting global
+// allocator of src/CountingAllocator.cpp, linked into instrumentation builds
+// only; without it they stay zero. Not thread-safe, one profiler serves the
+// event-loop thread.
+class StageProfiler {
+public:
+  // Stages of a frame
+  enum class Stage {
+    // Extracting the JSON data of the SocketIO event, FindJsonData
+    kExtract,
+    // Parsing the telemetry and scheduling the frame
+    kParse,
+    // Updating the session
+    kUpdate,
+    // Queuing and writing the messages to the simulator
+    kOutput,
+    // Recording the telemetry and feeding the dashboard
+    kRecord
+  };
+
+  // Number of stages
+  static constexpr size_t kStageCount = 5;
+
+  // Counters of a stage
+  struct Counters {
+    // Number of runs of the stage
+    uint64_t n_runs;
+    // Allocations and their bytes
+    uint64_t n_allocations;
+    uint64_t n_bytes;
+    // CPU time of the thread in nanoseconds
+    uint64_t cpu_ns;
+  };
+
+  // Measures a stage of a session from construction to destruction, does
+  // nothing without a profiler.
+  class Scope {
+  public:
+    // Constructor.
+    // @param profiler  Profiler, may be nullptr
+    // @param session   Session identifier
+    // @param stage     Stage
+    Scope(StageProfiler* profiler, uint32_t session, Stage stage);
+
+    // Destructor, records the stage.
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    StageProfiler* profiler_;
+    uint32_t session_;
+    Stage stage_;
+    // Counters of the thread at construction
+    uint64_t n_allocations_;
+    uint64_t n_bytes_;
+    uint64_t cpu_ns_;
+  };
+
+  // Constructor.
+  StageProfiler();
+
+  // Records a run of a stage.
+  // @param session  Session identifier
+  // @param stage    Stage
+  // @param run      Counters of the run, n_runs is ignored
+  void Record(uint32_t session, Stage stage, const Counters& run);
+
+  // Removes the counters of a closed session, the totals keep them.
+  // @param session  Session identifier
+  void RemoveSession(uint32_t session);
+
+  // Gets the counters of a stage over all sessions.
+  const Counters& GetCounters(Stage stage) const {
+    return totals_[static_cast<size_t>(stage)];
+  }
+
+  // Gets the counters of a stage of an open session.
+  // @param[in]  session   Session identifier
+  // @param[in]  stage     Stage
+  // @param[out] counters  Counters
+  // @return               False if the session has no counters
+  bool GetSessionCounters(uint32_t session, Stage stage,
+                          Counters& counters) const;
+
+  // Writes the counters in the Prometheus text format: the totals of every
+  // stage, and of every stage of every open session.
+  // @param[in] os  Output stream
+  void WriteMetrics(std::ostream& os) const;
+
+  // Gets the name of a stage.
+  static const char* GetStageName(Stage stage);
+
+  // Gets the CPU time of the calling thread.
+  // @return  CPU time in nanoseconds
+  static uint64_t GetThreadCpuTime();
+
+  // Gets the allocation counters of the calling thread.
+  // @param[out] n_allocations  Number of allocations
+  // @param[out] n_bytes        Number of bytes allocated
+  static void GetThreadAllocations(uint64_t& n_allocations, uint64_t& n_bytes);
+
+  // Indicates the counting global allocator is linked.
+  static bool IsCountingAllocations();
+
+  // Counts an allocation of the calling thread, called by the counting
+  // global allocator.
+  // @param size  Size in bytes
+  static void CountAllocation(size_t size);
+
+  // Marks the counting global allocator as linked, called by it at static
+  // initialization.
+  static void EnableAllocationCounting();
+
+private:
+  // Counters of all stages
+  struct StageCounters {
+    Counters stages[kStageCount];
+  };
+
+  // Totals of every stage, and counters of the open sessions
+  Counters totals_[kStageCount];
+  std::map<uint32_t, StageCounters> sessions_;
+};
+
+#endif // STAGE_PROFILER_H
@@ -0,0 +1,53 @@
+#include "Stanley.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Time passed between frames
+const auto kSecondsPerFrame = 1. / 25.;
+
+// Coefficient of conversion miles-per-hour to meters-per-second
+const auto kMphToMps = 1609.344 / (60. * 60.);
+
+// Max steering angle in radians corresponding to the steering value of 1
+const auto kMaxSteeringAngle = 25. / 180. * M_PI;
+
+// Minimum distance per frame used for estimating the heading
+const auto kMinFrameDistance = 0.02;
+
+// Minimum denominator of the CTE term in meters-per-second
+const auto kMinSoftening = 0.1;
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+Stanley::Stanley(double k, double k_soft, double k_heading)
+  : k_(k),
+    k_soft_(k_soft),
+    k_heading_(k_heading),
+    cte_prev_(),
+    is_cte_prev_initialized_() {
+  // Empty.
+}
+
+double Stanley::ComputeSteering(double cte, double speed) {
+  if (!is_cte_prev_initialized_) {
+    cte_prev_ = cte;
+    is_cte_prev_initialized_ = true;
+  }
+  auto speed_mps = kMphToMps * speed;
+  auto frame_distance = std::max(speed_mps * kSecondsPerFrame,
+                                 kMinFrameDistance);
+  auto heading = std::atan((cte - cte_prev_) / frame_distance);
+  cte_prev_ = cte;
+  auto angle = k_heading_ * heading
+    + std::atan(k_ * cte / std::max(std::fabs(k_soft_) + speed_mps,
+                                    kMinSoftening));
+  return -angle / kMaxSteeringAngle;
+}
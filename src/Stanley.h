@@ -0,0 +1,36 @@
+#ifndef STANLEY_H
+#define STANLEY_H
+
+#include "SteeringLaw.h"
+
+// Stanley-style geometric steering. The steering angle is the heading error
+// plus atan(k * CTE / (k_soft + speed)), where the heading error w.r.t. the
+// track is estimated from the change of CTE and the distance driven within a
+// frame, as there's no heading in the telemetry.
+class Stanley : public SteeringLaw<Stanley> {
+public:
+  // Constructor.
+  // @param k          Gain of the CTE term
+  // @param k_soft     Softening speed in meters-per-second, keeps the CTE term
+  //                   bounded at low speed
+  // @param k_heading  Gain of the heading term
+  Stanley(double k, double k_soft, double k_heading);
+
+  // Implements SteeringLaw.
+  // @param cte    Cross-track error (CTE)
+  // @param speed  Speed in miles-per-hour
+  // @return       Steering value, 1 corresponds to the max steering angle
+  double ComputeSteering(double cte, double speed);
+
+private:
+  // Gains
+  double k_;
+  double k_soft_;
+  double k_heading_;
+
+  // Previous CTE and indication whether it's initialized
+  double cte_prev_;
+  bool is_cte_prev_initialized_;
+};
+
+#endif // STANLEY_H
@@ -0,0 +1,120 @@
+#include "SteerOutput.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Max length of a number and of a steering command
+const size_t kMaxNumberLength = 32;
+const size_t kMaxCommandLength = 128;
+
+// Reply to a telemetry event without a steering command
+const char kManualMessage[] = "42[\"manual\",{}]";
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Writes a number the way the JSON library does, without allocating: 15
+// significant digits, ".0" appended if it looks like an integer, and null if
+// it isn't finite.
+// @param[in]  value   Number
+// @param[out] buffer  Text, of kMaxNumberLength
+void WriteNumber(double value, char* buffer) {
+  if (!std::isfinite(value)) {
+    std::strcpy(buffer, "null");
+    return;
+  }
+  auto length = std::snprintf(buffer, kMaxNumberLength, "%.15g", value);
+  if (!std::strpbrk(buffer, ".eE")) {
+    std::strcpy(buffer + length, ".0");
+  }
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+SteerOutput::SteerOutput(const Settings& settings, Counters& counters)
+  : settings_(settings),
+    counters_(counters),
+    steering_(),
+    throttle_(),
+    age_(),
+    is_sent_(false) {
+  // Empty.
+}
+
+bool SteerOutput::Control(double steering, double throttle) {
+  ++counters_.n_commands;
+  auto is_changed = !is_sent_
+                    || std::fabs(steering - steering_) >= settings_.epsilon
+                    || std::fabs(throttle - throttle_) >= settings_.epsilon;
+  if (!is_changed && age_ < settings_.max_age) {
+    ++age_;
+    ++counters_.n_suppressed;
+    Queue(kManualMessage, sizeof(kManualMessage) - 1);
+    return false;
+  }
+  if (!is_changed) {
+    ++counters_.n_refreshed;
+  }
+  steering_ = steering;
+  throttle_ = throttle;
+  age_ = 0;
+  is_sent_ = true;
+  char steering_text[kMaxNumberLength];
+  char throttle_text[kMaxNumberLength];
+  WriteNumber(steering, steering_text);
+  WriteNumber(throttle, throttle_text);
+  char message[kMaxCommandLength];
+  auto length = std::snprintf(
+    message, sizeof(message),
+    "42[\"steer\",{\"steering_angle\":%s,\"throttle\":%s}]",
+    steering_text, throttle_text);
+  Queue(message, length);
+  return true;
+}
+
+void SteerOutput::Reset() {
+  is_sent_ = false;
+  Queue("42[\"reset\", {}]");
+}
+
+void SteerOutput::Queue(std::string message) {
+  ++counters_.n_messages;
+  messages_.push_back(std::move(message));
+}
+
+void SteerOutput::Queue(const char* message, size_t length) {
+  ++counters_.n_messages;
+  if (spare_.empty()) {
+    messages_.emplace_back(message, length);
+    return;
+  }
+  messages_.push_back(std::move(spare_.back()));
+  spare_.pop_back();
+  messages_.back().assign(message, length);
+}
+
+void SteerOutput::Flush(const Writer& write) {
+  if (messages_.empty()) {
+    return;
+  }
+  ++counters_.n_writes;
+  for (const auto& message : messages_) {
+    counters_.n_bytes += message.length();
+  }
+  write(messages_);
+  // Messages keep their buffers for the next ones, unless the writer
+  // consumed them
+  for (auto& message : messages_) {
+    spare_.push_back(std::move(message));
+  }
+  messages_.clear();
+}
@@ -0,0 +1,92 @@
+#ifndef STEER_OUTPUT_H
+#define STEER_OUTPUT_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Output stage of the messages to one simulator connection. A steering
+// command that changes steering and throttle by less than an epsilon is
+// suppressed, unless the last sent command is older than the max age. The
+// simulator waits for a reply to every telemetry event, so a suppressed
+// command is replaced by the short manual message, and the simulator keeps
+// applying the last command. Queued messages are corked until
+// flushed, and then written in one batch, that is one syscall. Written
+// messages keep their buffers for the next ones, so steady steering commands
+// don't allocate.
+class SteerOutput {
+public:
+  // Settings of the output stage
+  struct Settings {
+    // Min change of steering or throttle to send a command, 0 sends all
+    double epsilon;
+    // Max number of commands suppressed in a row
+    unsigned int max_age;
+  };
+
+  // Counters of output stages, usually shared by all connections
+  struct Counters {
+    // Steering commands, suppressed ones, and ones sent by max age only
+    uint64_t n_commands;
+    uint64_t n_suppressed;
+    uint64_t n_refreshed;
+    // Messages queued, batches written and their bytes
+    uint64_t n_messages;
+    uint64_t n_writes;
+    uint64_t n_bytes;
+  };
+
+  // Writes a batch of messages at once, may consume the messages.
+  typedef std::function<void(std::vector<std::string>& messages)> Writer;
+
+  // Constructor.
+  // @param settings  Settings of the output stage
+  // @param counters  Counters to update, must outlive the output stage
+  SteerOutput(const Settings& settings, Counters& counters);
+
+  // Queues a steering command, or the manual message if suppressed.
+  // @param steering  Steering value
+  // @param throttle  Throttle value
+  // @return          True if the steering command is queued
+  bool Control(double steering, double throttle);
+
+  // Queues a reset message, the next command after it is never suppressed.
+  void Reset();
+
+  // Queues a message as is.
+  // @param message  Message
+  void Queue(std::string message);
+
+  // Indicates there are queued messages.
+  bool IsPending() const { return !messages_.empty(); }
+
+  // Writes the queued messages, if any, in one batch.
+  // @param write  Writer of the batch
+  void Flush(const Writer& write);
+
+private:
+  // Settings of the output stage
+  Settings settings_;
+
+  // Counters to update
+  Counters& counters_;
+
+  // Last sent steering and throttle, and the number of commands suppressed
+  // since
+  double steering_;
+  double throttle_;
+  unsigned int age_;
+  bool is_sent_;
+
+  // Queued messages, and written ones kept for their buffers
+  std::vector<std::string> messages_;
+  std::vector<std::string> spare_;
+
+  // Queues a copy of a message, in the buffer of a written one if any.
+  // @param message  Message
+  // @param length   Length of the message
+  void Queue(const char* message, size_t length);
+};
+
+#endif // STEER_OUTPUT_H
@@ -0,0 +1,36 @@
+#ifndef STEERING_LAW_H
+#define STEERING_LAW_H
+
+// Identifies the available steering backends
+enum class SteeringBackend {
+  // Proportional-integral-derivative control, see Pid
+  kPid,
+  // Model-predictive control with PID fallback, see Mpc
+  kMpc,
+  // Precomputed lookup table of steering and throttle, see ControlTable
+  kTable,
+  // Stanley-style geometric control, see Stanley
+  kStanley
+};
+
+// Statically dispatched interface of a lateral control law. A backend derives
+// from SteeringLaw<Backend> and implements
+//   double ComputeSteering(double cte, double speed);
+// which returns the raw steering value, negative values steering left.
+template<typename Backend>
+class SteeringLaw {
+public:
+  // Computes the steering value given cross-track error (CTE) and speed.
+  // @param cte    Cross-track error (CTE)
+  // @param speed  Speed in miles-per-hour
+  // @return       Raw steering value, not yet normalized within -1..1
+  double GetSteering(double cte, double speed) {
+    return static_cast<Backend*>(this)->ComputeSteering(cte, speed);
+  }
+
+protected:
+  // Backends are never owned through the interface.
+  ~SteeringLaw() { }
+};
+
+#endif // STEERING_LAW_H
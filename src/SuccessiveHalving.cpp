@@ -0,0 +1,222 @@
+#include "SuccessiveHalving.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include "AsyncLogger.h"
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Shrinking of the search box radius per round
+const auto kRadiusShrink = 0.5;
+
+// Max number of infeasible samples of a parameter rejected in a row
+const auto kMaxRejections = 1000;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Indicates the value is within the feasible range of the parameter, where
+// the log scale excludes zero and the logit scale its bounds.
+// @param[in] parameter  Parameter
+// @param[in] value      Value
+bool IsFeasibleValue(const Tuner::Parameter& parameter, double value) {
+  switch (parameter.transform) {
+    case Tuner::Transform::kLog:
+      if (value <= 0) {
+        return false;
+      }
+      break;
+    case Tuner::Transform::kLogit:
+      return value > parameter.lower && value < parameter.upper;
+    case Tuner::Transform::kLinear:
+    default:
+      break;
+  }
+  return parameter.lower == parameter.upper
+    || (value >= parameter.lower && value <= parameter.upper);
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+SuccessiveHalving::SuccessiveHalving(const Tuner::ParameterSequence& parameters,
+                                     size_t population,
+                                     size_t eta,
+                                     size_t n_rungs,
+                                     unsigned int seed)
+  : population_size_(std::max<size_t>(1, population)),
+    eta_(std::max<size_t>(2, eta)),
+    rng_(seed),
+    round_(),
+    rung_(),
+    best_parameters_(parameters),
+    best_error_(std::numeric_limits<double>::infinity()) {
+  assert(n_rungs > 0);
+  for (size_t k = 0; k < n_rungs; ++k) {
+    budgets_.push_back(std::pow(static_cast<double>(eta_),
+                                static_cast<double>(k) - (n_rungs - 1)));
+  }
+  StartRound();
+}
+
+SuccessiveHalving::Trial SuccessiveHalving::Ask() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Prefer candidates assigned the least, that is unassigned ones first, then
+  // duplicates of pending ones
+  size_t position = 0;
+  auto min_assigned = std::numeric_limits<unsigned int>::max();
+  for (size_t i = 0; i < current_.candidates.size(); ++i) {
+    if (std::isnan(current_.errors[i])
+        && current_.n_assigned[i] < min_assigned) {
+      min_assigned = current_.n_assigned[i];
+      position = i;
+    }
+  }
+  ++current_.n_assigned[position];
+  return MakeTrial(position);
+}
+
+void SuccessiveHalving::Tell(const Trial& trial, double error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (trial.round != round_ || trial.rung != rung_) {
+    return;
+  }
+  auto it = std::find(current_.candidates.begin(), current_.candidates.end(),
+                      trial.candidate);
+  if (it == current_.candidates.end()) {
+    return;
+  }
+  auto& reported = current_.errors[it - current_.candidates.begin()];
+  if (!std::isnan(reported)) {
+    return;
+  }
+  reported = error;
+  if (++current_.n_reported == current_.candidates.size()) {
+    CompleteRung();
+  }
+}
+
+Tuner::ParameterSequence SuccessiveHalving::GetBestParameters() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return best_parameters_;
+}
+
+double SuccessiveHalving::GetBestError() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return best_error_;
+}
+
+size_t SuccessiveHalving::GetRound() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return round_;
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void SuccessiveHalving::StartRound() {
+  const auto& center = best_parameters_;
+  auto radius = kSearchRadius * std::pow(kRadiusShrink, round_);
+  std::uniform_real_distribution<double> uniform(-1., 1.);
+  population_.assign(1, center);
+  while (population_.size() < population_size_) {
+    auto candidate = center;
+    for (auto& parameter : candidate) {
+      // Infeasible samples are rejected before any lap is driven, so the
+      // candidate is uniform within the feasible part of the box
+      for (auto i = 0; i < kMaxRejections; ++i) {
+        auto p = parameter.p + radius * std::fabs(parameter.dp) * uniform(rng_);
+        if (IsFeasibleValue(parameter, p)) {
+          parameter.p = p;
+          break;
+        }
+      }
+    }
+    population_.push_back(candidate);
+  }
+  std::vector<size_t> candidates(population_size_);
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    candidates[i] = i;
+  }
+  rung_ = 0;
+  StartRung(candidates);
+}
+
+void SuccessiveHalving::StartRung(const std::vector<size_t>& candidates) {
+  current_.candidates = candidates;
+  current_.errors.assign(candidates.size(),
+                         std::numeric_limits<double>::quiet_NaN());
+  current_.n_assigned.assign(candidates.size(), 0);
+  current_.n_reported = 0;
+}
+
+void SuccessiveHalving::CompleteRung() {
+  std::vector<size_t> order(current_.candidates.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return current_.errors[a] < current_.errors[b];
+  });
+  std::ostringstream oss;
+  oss << "Round " << round_ << ", rung " << rung_ << " over " << std::fixed
+      << std::setprecision(0) << 100. * budgets_[rung_]
+      << "% of the lap: best error " << std::setprecision(3)
+      << current_.errors[order[0]] << std::defaultfloat;
+
+  if (rung_ + 1 == budgets_.size()) {
+    if (current_.errors[order[0]] < best_error_) {
+      best_error_ = current_.errors[order[0]];
+      best_parameters_ = population_[current_.candidates[order[0]]];
+    }
+    oss << ", starting round " << round_ + 1 << ".";
+    AsyncLogger::GetDefault().Log(oss.str());
+    ++round_;
+    StartRound();
+    return;
+  }
+
+  auto n_promoted = (order.size() + eta_ - 1) / eta_;
+  oss << ", promoting " << n_promoted << " of " << order.size()
+      << " candidates.";
+  AsyncLogger::GetDefault().Log(oss.str());
+  std::vector<size_t> promoted;
+  for (size_t i = 0; i < n_promoted; ++i) {
+    promoted.push_back(current_.candidates[order[i]]);
+  }
+  ++rung_;
+  StartRung(promoted);
+}
+
+SuccessiveHalving::Trial SuccessiveHalving::MakeTrial(size_t position) const {
+  Trial trial;
+  trial.round = round_;
+  trial.rung = rung_;
+  trial.candidate = current_.candidates[position];
+  trial.parameters = population_[trial.candidate];
+  trial.budget = budgets_[rung_];
+  return trial;
+}
+
+// Worker Public Members
+// -----------------------------------------------------------------------------
+
+SuccessiveHalving::Worker::Worker(std::shared_ptr<SuccessiveHalving> scheduler)
+  : scheduler_(scheduler),
+    trial_(scheduler->Ask()) {
+  // Empty.
+}
+
+Tuner::ParameterSequence SuccessiveHalving::Worker::UpdateError(double error) {
+  scheduler_->Tell(trial_, error);
+  trial_ = scheduler_->Ask();
+  return trial_.parameters;
+}
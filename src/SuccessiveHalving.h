@@ -0,0 +1,159 @@
+#ifndef SUCCESSIVE_HALVING_H
+#define SUCCESSIVE_HALVING_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "Tuner.h"
+
+// Successive halving over a population of coefficients. Every round samples
+// the population within a search box, drives all candidates over the shortest
+// part of the lap, promotes the best 1/eta of them to a part eta times longer,
+// and so on, so only the finalists drive whole laps. The next round samples a
+// smaller box around the best coefficients so far.
+//
+// Evaluations are requested and reported by any number of workers, such as
+// simulator connections or offline threads, each using its own Worker. When
+// every candidate of the current rung is already assigned, workers get a
+// duplicate of a pending one, the first reported error counts, so stalled or
+// disconnected workers never block a rung.
+class SuccessiveHalving {
+public:
+  // Describes one evaluation
+  struct Trial {
+    // Round, rung within the round, and candidate within the population
+    size_t round;
+    size_t rung;
+    size_t candidate;
+    // Parameters of the candidate
+    Tuner::ParameterSequence parameters;
+    // Fraction of the track length to drive
+    double budget;
+  };
+
+  // Tuner adapter of one worker. Its initial trial is asked like the next
+  // ones, so workers start on distinct candidates, and the controller using
+  // it must start with its parameters.
+  class Worker : public Tuner {
+  public:
+    // Constructor, asks the initial trial.
+    // @param scheduler  Shared scheduler
+    explicit Worker(std::shared_ptr<SuccessiveHalving> scheduler);
+
+    // Gets the parameters of the current trial.
+    const ParameterSequence& GetParameters() const {
+      return trial_.parameters;
+    }
+
+    // Implements Tuner, reports the error of the current trial.
+    ParameterSequence UpdateError(double error) override;
+
+    // Implements Tuner, gets the budget of the current trial.
+    double GetBudget() const override { return trial_.budget; }
+
+  private:
+    // Shared scheduler
+    std::shared_ptr<SuccessiveHalving> scheduler_;
+
+    // Trial being evaluated
+    Trial trial_;
+  };
+
+  // Constructor.
+  // @param parameters  Initial parameters, within their feasible ranges. The
+  //                    search box of every parameter of the first round is
+  //                    p +/- kSearchRadius * dp, where infeasible samples are
+  //                    rejected.
+  // @param population  Number of candidates per round
+  // @param eta         Ratio of budgets of consecutive rungs, also the ratio of
+  //                    their candidate counts
+  // @param n_rungs     Number of rungs, the first one has the budget of
+  //                    eta^(1-n_rungs) of the lap
+  // @param seed        Seed of the random generator
+  SuccessiveHalving(const Tuner::ParameterSequence& parameters,
+                    size_t population = 27,
+                    size_t eta = 3,
+                    size_t n_rungs = 3,
+                    unsigned int seed = 1);
+
+  // Gets the next trial to evaluate.
+  Trial Ask();
+
+  // Reports the error of a trial, ignored if the trial is already reported.
+  // @param trial  Evaluated trial
+  // @param error  Its error
+  void Tell(const Trial& trial, double error);
+
+  // Gets the best parameters driven over the whole lap so far, or the initial
+  // ones.
+  Tuner::ParameterSequence GetBestParameters() const;
+
+  // Gets the best error over the whole lap so far, infinity if none.
+  double GetBestError() const;
+
+  // Gets the current round.
+  size_t GetRound() const;
+
+private:
+  // Search box radius in units of the parameter deltas in the first round
+  static constexpr double kSearchRadius = 10.;
+
+  // Candidates of one rung
+  struct Rung {
+    // Indices within the population
+    std::vector<size_t> candidates;
+    // Errors, NaN while not reported
+    std::vector<double> errors;
+    // Number of times every candidate was assigned
+    std::vector<unsigned int> n_assigned;
+    // Number of reported errors
+    size_t n_reported;
+  };
+
+  // Guards all members below
+  mutable std::mutex mutex_;
+
+  // Number of candidates per round
+  size_t population_size_;
+
+  // Ratio of budgets of consecutive rungs
+  size_t eta_;
+
+  // Budgets of rungs as fractions of the lap
+  std::vector<double> budgets_;
+
+  // Random generator of candidates
+  std::mt19937 rng_;
+
+  // Current round and rung
+  size_t round_;
+  size_t rung_;
+
+  // Candidates of the current round
+  std::vector<Tuner::ParameterSequence> population_;
+
+  // Current rung
+  Rung current_;
+
+  // Best parameters over the whole lap and their error
+  Tuner::ParameterSequence best_parameters_;
+  double best_error_;
+
+  // Starts a new round around the best parameters.
+  void StartRound();
+
+  // Starts a rung with the given candidates.
+  // @param candidates  Indices within the population
+  void StartRung(const std::vector<size_t>& candidates);
+
+  // Promotes the best candidates of the completed rung, or starts the next
+  // round after the last rung.
+  void CompleteRung();
+
+  // Makes a trial of the candidate at the given position of the current rung.
+  Trial MakeTrial(size_t position) const;
+};
+
+#endif // SUCCESSIVE_HALVING_H
@@ -0,0 +1,508 @@
+#include "TelemetryArchive.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Header of the archive file, occupies exactly one cache line
+struct Header {
+  char magic[8];
+  uint32_t session;
+  uint32_t block_frame_count;
+  char reserved[48];
+};
+static_assert(sizeof(Header) == 64, "Archive header must be one cache line");
+
+// Trailer of the archive file, locates the indices
+struct Trailer {
+  uint64_t index_offset;
+  uint64_t n_frames;
+  uint32_t n_blocks;
+  uint32_t n_laps;
+  char magic[8];
+};
+static_assert(sizeof(Trailer) == 32, "Archive trailer must be 32 bytes");
+
+// Writes bit fields most significant bit first.
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<uint8_t>& bytes)
+    : bytes_(bytes), buffer_(), n_bits_() { }
+
+  // Writes the low bits of a value.
+  // @param value   Value
+  // @param n_bits  Number of bits, up to 64
+  void Write(uint64_t value, int n_bits) {
+    if (n_bits > 32) {
+      Write(value >> 32, n_bits - 32);
+      n_bits = 32;
+    }
+    buffer_ = buffer_ << n_bits | (value & ((1ull << n_bits) - 1));
+    n_bits_ += n_bits;
+    while (n_bits_ >= 8) {
+      n_bits_ -= 8;
+      bytes_.push_back(static_cast<uint8_t>(buffer_ >> n_bits_));
+    }
+  }
+
+  // Writes the last partial byte, padded with zeros.
+  void Finish() {
+    if (n_bits_) {
+      bytes_.push_back(static_cast<uint8_t>(buffer_ << (8 - n_bits_)));
+      n_bits_ = 0;
+    }
+  }
+
+private:
+  std::vector<uint8_t>& bytes_;
+  uint64_t buffer_;
+  int n_bits_;
+};
+
+// Reads bit fields written by BitWriter, zeros past the end.
+class BitReader {
+public:
+  BitReader(const uint8_t* data, size_t size)
+    : data_(data), size_(size), position_(), buffer_(), n_bits_() { }
+
+  // Reads bits.
+  // @param n_bits  Number of bits, up to 64
+  // @return        Value of the bits
+  uint64_t Read(int n_bits) {
+    if (n_bits > 32) {
+      auto high = Read(n_bits - 32);
+      return high << 32 | Read(32);
+    }
+    while (n_bits_ < n_bits) {
+      buffer_ = buffer_ << 8 | (position_ < size_ ? data_[position_] : 0);
+      ++position_;
+      n_bits_ += 8;
+    }
+    n_bits_ -= n_bits;
+    return buffer_ >> n_bits_ & ((1ull << n_bits) - 1);
+  }
+
+  // Counts leading one bits, up to a max.
+  // @param max_count  Max number of ones read
+  // @return           Number of ones
+  int ReadOnes(int max_count) {
+    auto count = 0;
+    while (count < max_count && Read(1)) {
+      ++count;
+    }
+    return count;
+  }
+
+private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_;
+  uint64_t buffer_;
+  int n_bits_;
+};
+
+// XOR coding state of a channel: the previous value, and the window of its
+// meaningful bits, leading < 0 if there's none yet
+struct XorState {
+  uint64_t previous;
+  int leading;
+  int trailing;
+};
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Magic bytes identifying the archive format and its version
+const char kMagic[8] = {'P', 'I', 'D', 'T', 'L', 'M', '0', '1'};
+
+// Number of channels of a frame besides the timestamp
+const auto kChannelCount = 4;
+
+// Bit widths of the zigzag delta-of-delta of timestamps by the number of
+// leading ones of its prefix, 0 is the '0' bit alone
+const int kDeltaBits[] = {0, 7, 9, 12, 20, 64};
+const auto kDeltaBucketCount = 6;
+
+// Bit widths of the leading zeros and of the meaningful bits of XOR values
+const auto kLeadingBits = 5;
+const auto kLengthBits = 6;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the bits of a double.
+uint64_t ToBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// Gets a double from its bits.
+double FromBits(uint64_t bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Gets the channels of a frame.
+void GetChannels(const TelemetryFrame& frame, double channels[]) {
+  channels[0] = frame.cte;
+  channels[1] = frame.speed;
+  channels[2] = frame.steering;
+  channels[3] = frame.throttle;
+}
+
+// Writes a value XOR-ed with the previous one of its channel: '0' if they're
+// equal, '10' and the meaningful bits within the previous window, or '11',
+// the leading zeros, the length and the meaningful bits of a new window.
+void EncodeXor(BitWriter& writer, XorState& state, uint64_t value) {
+  auto x = value ^ state.previous;
+  state.previous = value;
+  if (x == 0) {
+    writer.Write(0, 1);
+    return;
+  }
+  auto leading = std::min(__builtin_clzll(x), (1 << kLeadingBits) - 1);
+  auto trailing = __builtin_ctzll(x);
+  if (state.leading >= 0 && leading >= state.leading
+      && trailing >= state.trailing) {
+    writer.Write(2, 2);
+    writer.Write(x >> state.trailing, 64 - state.leading - state.trailing);
+    return;
+  }
+  auto length = 64 - leading - trailing;
+  writer.Write(3, 2);
+  writer.Write(leading, kLeadingBits);
+  writer.Write(length - 1, kLengthBits);
+  writer.Write(x >> trailing, length);
+  state.leading = leading;
+  state.trailing = trailing;
+}
+
+// Reads a value written by EncodeXor.
+uint64_t DecodeXor(BitReader& reader, XorState& state) {
+  if (reader.Read(1)) {
+    if (reader.Read(1)) {
+      state.leading = static_cast<int>(reader.Read(kLeadingBits));
+      auto length = static_cast<int>(reader.Read(kLengthBits)) + 1;
+      state.trailing = 64 - state.leading - length;
+    }
+    auto length = 64 - state.leading - state.trailing;
+    state.previous ^= reader.Read(length) << state.trailing;
+  }
+  return state.previous;
+}
+
+// Writes the delta-of-delta of a timestamp in the smallest bucket.
+void EncodeDelta(BitWriter& writer, int64_t delta_of_delta) {
+  auto zigzag = static_cast<uint64_t>(delta_of_delta) << 1
+                ^ static_cast<uint64_t>(delta_of_delta >> 63);
+  auto bucket = 0;
+  while (bucket < kDeltaBucketCount - 1
+         && zigzag >> kDeltaBits[bucket] != 0) {
+    ++bucket;
+  }
+  // Prefix of 'bucket' ones, terminated by zero except for the last one
+  if (bucket < kDeltaBucketCount - 1) {
+    writer.Write(((1ull << bucket) - 1) << 1, bucket + 1);
+  } else {
+    writer.Write((1ull << bucket) - 1, bucket);
+  }
+  writer.Write(zigzag, kDeltaBits[bucket]);
+}
+
+// Reads a delta-of-delta written by EncodeDelta.
+int64_t DecodeDelta(BitReader& reader) {
+  auto bucket = reader.ReadOnes(kDeltaBucketCount - 1);
+  auto zigzag = reader.Read(kDeltaBits[bucket]);
+  return static_cast<int64_t>(zigzag >> 1 ^ (~(zigzag & 1) + 1));
+}
+
+// Encodes a block of frames: the first one raw, every next one by the
+// delta-of-delta of its timestamp and the XOR of its channels.
+// @param[in]  frames  Frames, not empty
+// @param[out] bytes   Encoded bytes
+void EncodeBlock(const std::vector<TelemetryFrame>& frames,
+                 std::vector<uint8_t>& bytes) {
+  bytes.clear();
+  BitWriter writer(bytes);
+  double channels[kChannelCount];
+  XorState states[kChannelCount];
+  GetChannels(frames[0], channels);
+  writer.Write(frames[0].timestamp, 64);
+  for (auto c = 0; c < kChannelCount; ++c) {
+    states[c] = {ToBits(channels[c]), -1, 0};
+    writer.Write(states[c].previous, 64);
+  }
+  int64_t delta = 0;
+  for (size_t i = 1; i < frames.size(); ++i) {
+    auto next_delta = static_cast<int64_t>(frames[i].timestamp
+                                           - frames[i - 1].timestamp);
+    EncodeDelta(writer, next_delta - delta);
+    delta = next_delta;
+    GetChannels(frames[i], channels);
+    for (auto c = 0; c < kChannelCount; ++c) {
+      EncodeXor(writer, states[c], ToBits(channels[c]));
+    }
+  }
+  writer.Finish();
+}
+
+// Decodes a block of frames written by EncodeBlock.
+// @param[in]  data      Encoded bytes
+// @param[in]  size      Number of encoded bytes
+// @param[in]  n_frames  Number of frames
+// @param[out] frames    Frames, appended
+void DecodeBlock(const uint8_t* data, size_t size, uint32_t n_frames,
+                 std::vector<TelemetryFrame>& frames) {
+  BitReader reader(data, size);
+  XorState states[kChannelCount];
+  auto timestamp = reader.Read(64);
+  for (auto c = 0; c < kChannelCount; ++c) {
+    states[c] = {reader.Read(64), -1, 0};
+  }
+  int64_t delta = 0;
+  for (uint32_t i = 0; i < n_frames; ++i) {
+    if (i > 0) {
+      delta += DecodeDelta(reader);
+      timestamp += delta;
+      for (auto c = 0; c < kChannelCount; ++c) {
+        DecodeXor(reader, states[c]);
+      }
+    }
+    frames.push_back({timestamp,
+                      FromBits(states[0].previous),
+                      FromBits(states[1].previous),
+                      FromBits(states[2].previous),
+                      FromBits(states[3].previous)});
+  }
+}
+
+} // namespace
+
+constexpr size_t TelemetryWriter::kBlockFrameCount;
+
+// TelemetryWriter Public Members
+// -----------------------------------------------------------------------------
+
+TelemetryWriter::TelemetryWriter()
+  : offset_(),
+    n_frames_() {
+  // Empty.
+}
+
+TelemetryWriter::~TelemetryWriter() {
+  Close();
+}
+
+bool TelemetryWriter::Open(const std::string& path, uint32_t session) {
+  Close();
+  file_.open(path, std::ios::binary | std::ios::trunc);
+  Header header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.session = session;
+  header.block_frame_count = kBlockFrameCount;
+  file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!file_) {
+    file_.close();
+    return false;
+  }
+  offset_ = sizeof(header);
+  block_.reserve(kBlockFrameCount);
+  return true;
+}
+
+void TelemetryWriter::Append(const TelemetryFrame& frame) {
+  if (laps_.empty()
+      || laps_.back().end != static_cast<uint32_t>(LapEnd::kOpen)) {
+    laps_.push_back({n_frames_, frame.timestamp, frame.timestamp,
+                     static_cast<uint32_t>(blocks_.size()), 0, 0,
+                     static_cast<uint32_t>(LapEnd::kOpen)});
+  }
+  block_.push_back(frame);
+  auto& lap = laps_.back();
+  lap.last_timestamp = frame.timestamp;
+  ++lap.n_frames;
+  ++n_frames_;
+  if (block_.size() == kBlockFrameCount) {
+    FlushBlock();
+  }
+}
+
+void TelemetryWriter::EndLap(LapEnd end) {
+  if (laps_.empty()
+      || laps_.back().end != static_cast<uint32_t>(LapEnd::kOpen)) {
+    return;
+  }
+  FlushBlock();
+  laps_.back().end = static_cast<uint32_t>(end);
+}
+
+bool TelemetryWriter::Close() {
+  if (!file_.is_open()) {
+    return false;
+  }
+  FlushBlock();
+  // Indices aligned to be read in place
+  const char kPadding[sizeof(uint64_t)] = {};
+  auto padding = -offset_ % sizeof(uint64_t);
+  file_.write(kPadding, padding);
+  offset_ += padding;
+  Trailer trailer = {};
+  trailer.index_offset = offset_;
+  trailer.n_frames = n_frames_;
+  trailer.n_blocks = static_cast<uint32_t>(blocks_.size());
+  trailer.n_laps = static_cast<uint32_t>(laps_.size());
+  std::memcpy(trailer.magic, kMagic, sizeof(kMagic));
+  file_.write(reinterpret_cast<const char*>(blocks_.data()),
+              blocks_.size() * sizeof(BlockEntry));
+  file_.write(reinterpret_cast<const char*>(laps_.data()),
+              laps_.size() * sizeof(LapEntry));
+  file_.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+  file_.close();
+  auto is_written = !file_.fail();
+  block_.clear();
+  blocks_.clear();
+  laps_.clear();
+  offset_ = 0;
+  n_frames_ = 0;
+  return is_written;
+}
+
+// TelemetryWriter Private Members
+// -----------------------------------------------------------------------------
+
+void TelemetryWriter::FlushBlock() {
+  if (block_.empty()) {
+    return;
+  }
+  EncodeBlock(block_, bytes_);
+  file_.write(reinterpret_cast<const char*>(bytes_.data()), bytes_.size());
+  blocks_.push_back({offset_, block_[0].timestamp,
+                     static_cast<uint32_t>(bytes_.size()),
+                     static_cast<uint32_t>(block_.size())});
+  ++laps_.back().n_blocks;
+  offset_ += bytes_.size();
+  block_.clear();
+}
+
+// TelemetryReader Public Members
+// -----------------------------------------------------------------------------
+
+TelemetryReader::TelemetryReader()
+  : mapped_(),
+    mapped_size_(),
+    blocks_(),
+    laps_(),
+    n_blocks_(),
+    n_laps_(),
+    n_frames_() {
+  // Empty.
+}
+
+TelemetryReader::~TelemetryReader() {
+  Unload();
+}
+
+bool TelemetryReader::Load(const std::string& path) {
+  Unload();
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  auto is_mapped = fstat(fd, &st) == 0
+    && static_cast<size_t>(st.st_size) >= sizeof(Header) + sizeof(Trailer);
+  if (is_mapped) {
+    mapped_ = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    is_mapped = mapped_ != MAP_FAILED;
+  }
+  close(fd);
+  if (!is_mapped) {
+    mapped_ = nullptr;
+    return false;
+  }
+  mapped_size_ = st.st_size;
+
+  const auto* bytes = static_cast<const uint8_t*>(mapped_);
+  const auto& header = *static_cast<const Header*>(mapped_);
+  Trailer trailer;
+  std::memcpy(&trailer, bytes + mapped_size_ - sizeof(trailer),
+              sizeof(trailer));
+  auto index_size = trailer.n_blocks * sizeof(TelemetryWriter::BlockEntry)
+                    + trailer.n_laps * sizeof(TelemetryWriter::LapEntry);
+  auto is_valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+    && std::memcmp(trailer.magic, kMagic, sizeof(kMagic)) == 0
+    && trailer.index_offset >= sizeof(Header)
+    && trailer.index_offset % sizeof(uint64_t) == 0
+    && trailer.index_offset + index_size + sizeof(trailer) == mapped_size_;
+  if (!is_valid) {
+    Unload();
+    return false;
+  }
+  blocks_ = reinterpret_cast<const TelemetryWriter::BlockEntry*>(
+    bytes + trailer.index_offset);
+  laps_ = reinterpret_cast<const TelemetryWriter::LapEntry*>(
+    blocks_ + trailer.n_blocks);
+  n_blocks_ = trailer.n_blocks;
+  n_laps_ = trailer.n_laps;
+  n_frames_ = trailer.n_frames;
+
+  // Blocks within the data, laps within the blocks
+  for (uint32_t i = 0; i < n_blocks_ && is_valid; ++i) {
+    is_valid = blocks_[i].offset >= sizeof(Header)
+      && blocks_[i].offset + blocks_[i].size <= trailer.index_offset
+      && blocks_[i].n_frames > 0;
+  }
+  for (uint32_t i = 0; i < n_laps_ && is_valid; ++i) {
+    is_valid = laps_[i].first_block + laps_[i].n_blocks <= n_blocks_
+      && laps_[i].end <= static_cast<uint32_t>(LapEnd::kOpen);
+  }
+  if (!is_valid) {
+    Unload();
+  }
+  return is_valid;
+}
+
+uint32_t TelemetryReader::GetSession() const {
+  return static_cast<const Header*>(mapped_)->session;
+}
+
+TelemetryReader::Lap TelemetryReader::GetLap(size_t i) const {
+  const auto& lap = laps_[i];
+  return {lap.first_frame, lap.n_frames, lap.first_timestamp,
+          lap.last_timestamp, static_cast<LapEnd>(lap.end)};
+}
+
+void TelemetryReader::ReadLap(size_t i,
+                              std::vector<TelemetryFrame>& frames) const {
+  const auto& lap = laps_[i];
+  const auto* bytes = static_cast<const uint8_t*>(mapped_);
+  for (auto b = lap.first_block; b < lap.first_block + lap.n_blocks; ++b) {
+    const auto& block = blocks_[b];
+    DecodeBlock(bytes + block.offset, block.size, block.n_frames, frames);
+  }
+}
+
+// TelemetryReader Private Members
+// -----------------------------------------------------------------------------
+
+void TelemetryReader::Unload() {
+  if (mapped_) {
+    munmap(mapped_, mapped_size_);
+  }
+  mapped_ = nullptr;
+  mapped_size_ = 0;
+  blocks_ = nullptr;
+  laps_ = nullptr;
+  n_blocks_ = 0;
+  n_laps_ = 0;
+  n_frames_ = 0;
+}
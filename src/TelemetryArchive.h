@@ -0,0 +1,181 @@
+#ifndef TELEMETRY_ARCHIVE_H
+#define TELEMETRY_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Recorded frame of a simulator session
+struct TelemetryFrame {
+  // Arrival time in microseconds
+  uint64_t timestamp;
+  // Cross-track error (CTE) and speed in miles-per-hour
+  double cte;
+  double speed;
+  // Steering and throttle values sent in response
+  double steering;
+  double throttle;
+};
+
+// Defines how a lap of an archive ends
+enum class LapEnd {
+  // The controller completed the lap or its distance budget
+  kComplete,
+  // The vehicle was reset, e.g. getting off track
+  kReset,
+  // The recording ended
+  kOpen
+};
+
+// Writes the frames of a session to a compressed archive. Frames are encoded
+// in blocks of up to kBlockFrameCount: timestamps by their delta-of-delta, and
+// every other channel by the XOR with its previous value, so steady frames
+// take a few bits. Blocks never span lap boundaries, and the footer indexes
+// every block and lap, so a reader decodes any lap without a scan.
+//
+// File layout: a 64-byte header, the blocks, the block index, the lap index
+// and a 32-byte trailer locating the indices.
+class TelemetryWriter {
+public:
+  // Max number of frames of a block
+  static constexpr size_t kBlockFrameCount = 1024;
+
+  TelemetryWriter();
+
+  ~TelemetryWriter();
+
+  // Creates the archive, truncating an existing file.
+  // @param[in] path     Archive file
+  // @param[in] session  Session identifier stored in the header
+  // @return             True if created
+  bool Open(const std::string& path, uint32_t session);
+
+  // Appends a frame to the current lap, timestamps must not decrease.
+  // @param[in] frame  Frame
+  void Append(const TelemetryFrame& frame);
+
+  // Ends the current lap after its last appended frame, nothing happens if
+  // it has no frames.
+  // @param[in] end  Cause of the lap end
+  void EndLap(LapEnd end);
+
+  // Ends the last lap as kOpen, writes the indices and closes the file.
+  // @return  True if the whole archive was written
+  bool Close();
+
+  // Checks if the archive is open.
+  bool IsOpen() const { return file_.is_open(); }
+
+private:
+  // Index entry of a block
+  struct BlockEntry {
+    uint64_t offset;
+    uint64_t first_timestamp;
+    uint32_t size;
+    uint32_t n_frames;
+  };
+
+  // Index entry of a lap
+  struct LapEntry {
+    uint64_t first_frame;
+    uint64_t first_timestamp;
+    uint64_t last_timestamp;
+    uint32_t first_block;
+    uint32_t n_blocks;
+    uint32_t n_frames;
+    uint32_t end;
+  };
+
+  friend class TelemetryReader;
+
+  // Writes the current block, if it has frames.
+  void FlushBlock();
+
+  // Archive file and the offset of its end
+  std::ofstream file_;
+  uint64_t offset_;
+
+  // Frames of the current block
+  std::vector<TelemetryFrame> block_;
+
+  // Encoded bytes of a block, reused
+  std::vector<uint8_t> bytes_;
+
+  // Indices written so far, the last lap is the current one
+  std::vector<BlockEntry> blocks_;
+  std::vector<LapEntry> laps_;
+
+  // Number of frames appended
+  uint64_t n_frames_;
+};
+
+// Reads an archive written by TelemetryWriter. The file is mapped for
+// reading, so seeking to a lap decodes only the blocks of the lap.
+class TelemetryReader {
+public:
+  // Lap of an archive
+  struct Lap {
+    // Index of the first frame within the archive, and the number of frames
+    uint64_t first_frame;
+    uint32_t n_frames;
+    // Timestamps of the first and the last frames in microseconds
+    uint64_t first_timestamp;
+    uint64_t last_timestamp;
+    // Cause of the lap end
+    LapEnd end;
+  };
+
+  TelemetryReader();
+
+  ~TelemetryReader();
+
+  // Maps an archive, validating its indices.
+  // @param[in] path  Archive file
+  // @return          True if loaded
+  bool Load(const std::string& path);
+
+  // Checks if an archive is loaded.
+  bool IsLoaded() const { return mapped_ != nullptr; }
+
+  // Gets the session identifier.
+  uint32_t GetSession() const;
+
+  // Gets the number of frames.
+  uint64_t GetFrameCount() const { return n_frames_; }
+
+  // Gets the number of laps.
+  size_t GetLapCount() const { return n_laps_; }
+
+  // Gets a lap.
+  // @param[in] i  Index of the lap
+  Lap GetLap(size_t i) const;
+
+  // Decodes the frames of a lap.
+  // @param[in]  i       Index of the lap
+  // @param[out] frames  Frames of the lap, appended
+  void ReadLap(size_t i, std::vector<TelemetryFrame>& frames) const;
+
+  // Gets the size of the mapped archive in bytes.
+  size_t GetSize() const { return mapped_size_; }
+
+private:
+  // Unmaps the archive.
+  void Unload();
+
+  // Mapped archive and its size
+  void* mapped_;
+  size_t mapped_size_;
+
+  // Indices within the mapped archive
+  const TelemetryWriter::BlockEntry* blocks_;
+  const TelemetryWriter::LapEntry* laps_;
+  uint32_t n_blocks_;
+  uint32_t n_laps_;
+
+  // Number of frames
+  uint64_t n_frames_;
+};
+
+#endif // TELEMETRY_ARCHIVE_H
@@ -0,0 +1,88 @@
+#ifndef TELEMETRY_RING_H
+#define TELEMETRY_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lock-free ring of values with one writer, overwriting the oldest ones. The
+// writer pays a store and a release of the sequence number, readers never
+// block it: they copy the values and drop the ones the writer overwrote
+// meanwhile. One slot is spare, as the writer overwrites it before publishing
+// the next value. A value is any trivially copyable type.
+template<typename T>
+class TelemetryRing {
+public:
+  // Constructor.
+  // @param capacity  Min number of values kept, rounded up to a power of two
+  //                  less the spare slot
+  explicit TelemetryRing(size_t capacity)
+    : values_(RoundUp(capacity + 1)),
+      mask_(values_.size() - 1),
+      count_(0) {
+    // Empty.
+  }
+
+  // Writes a value, must be called by one writer at a time.
+  // @param value  Value
+  void Push(const T& value) {
+    auto count = count_.load(std::memory_order_relaxed);
+    values_[count & mask_] = value;
+    count_.store(count + 1, std::memory_order_release);
+  }
+
+  // Copies the values written since a sequence number, as many of them as the
+  // ring still keeps.
+  // @param[in]  from    Sequence number of the first value
+  // @param[out] values  Values in the order of writing, appended
+  // @return             Sequence number of the next value
+  uint64_t Read(uint64_t from, std::vector<T>& values) const {
+    auto count = count_.load(std::memory_order_acquire);
+    auto begin = std::max(from, count > GetCapacity() ?
+                                count - GetCapacity() : 0);
+    auto size = values.size();
+    for (auto sequence = begin; sequence < count; ++sequence) {
+      values.push_back(values_[sequence & mask_]);
+    }
+    // Values overwritten while copying are dropped, along with the one the
+    // writer may be overwriting before it publishes the next count
+    std::atomic_thread_fence(std::memory_order_acquire);
+    auto last_count = count_.load(std::memory_order_relaxed) + 1;
+    if (last_count > begin + values_.size()) {
+      auto n_overwritten = std::min<uint64_t>(
+        last_count - values_.size() - begin, count - begin);
+      values.erase(values.begin() + size, values.begin() + size
+                                          + n_overwritten);
+    }
+    return count;
+  }
+
+  // Gets the number of values written.
+  uint64_t GetCount() const {
+    return count_.load(std::memory_order_acquire);
+  }
+
+  // Gets the number of values kept.
+  size_t GetCapacity() const { return values_.size() - 1; }
+
+private:
+  // Rounds up to a power of two.
+  static size_t RoundUp(size_t n) {
+    size_t capacity = 1;
+    while (capacity < n) {
+      capacity <<= 1;
+    }
+    return capacity;
+  }
+
+  // Values and the mask of their indices
+  std::vector<T> values_;
+  size_t mask_;
+
+  // Number of values written
+  std::atomic<uint64_t> count_;
+};
+
+#endif // TELEMETRY_RING_H
@@ -0,0 +1,394 @@
+#include "Track.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Number of steps per span of the spline when measuring its arc length
+const auto kStepsPerSpan = 32;
+
+// Number of candidates whose distances are computed at once
+enum { kChunkSize = 16 };
+
+// Half of the diagonal of a cell, max distance of a point in a cell from its
+// center
+const auto kHalfCellDiagonal = Track::kCellSize * std::sqrt(0.5);
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the squared distance of a point from a segment.
+// @param x, y        Point
+// @param ax, ay      Start of the segment
+// @param dx, dy      Direction of the segment, from start to end
+// @param inverse_l2  Inverse squared length of the segment
+// @return            Squared distance
+inline double GetDistance2(double x, double y,
+                           double ax, double ay,
+                           double dx, double dy,
+                           double inverse_l2) {
+  auto t = ((x - ax) * dx + (y - ay) * dy) * inverse_l2;
+  t = t < 0. ? 0. : t;
+  t = t > 1. ? 1. : t;
+  auto ex = x - ax - t * dx;
+  auto ey = y - ay - t * dy;
+  return ex * ex + ey * ey;
+}
+
+// Gets a point of a span of the centripetal Catmull-Rom spline.
+// @param[in]  px, py  Control points before, at the start, at the end and
+//                     after the span
+// @param[in]  u       Position within the span, 0..1
+// @param[out] x, y    Point
+void GetSplinePoint(const double px[4], const double py[4], double u,
+                    double& x, double& y) {
+  // Knots by the square root of the distances between control points
+  double t[4] = {0.};
+  for (auto i = 1; i < 4; ++i) {
+    auto d = std::hypot(px[i] - px[i - 1], py[i] - py[i - 1]);
+    t[i] = t[i - 1] + std::max(1e-9, std::sqrt(d));
+  }
+  // Barry-Goldman pyramid
+  auto tu = t[1] + u * (t[2] - t[1]);
+  auto lerp = [tu](double a, double b, double ta, double tb) {
+    return ((tb - tu) * a + (tu - ta) * b) / (tb - ta);
+  };
+  auto a1x = lerp(px[0], px[1], t[0], t[1]);
+  auto a1y = lerp(py[0], py[1], t[0], t[1]);
+  auto a2x = lerp(px[1], px[2], t[1], t[2]);
+  auto a2y = lerp(py[1], py[2], t[1], t[2]);
+  auto a3x = lerp(px[2], px[3], t[2], t[3]);
+  auto a3y = lerp(py[2], py[3], t[2], t[3]);
+  auto b1x = lerp(a1x, a2x, t[0], t[2]);
+  auto b1y = lerp(a1y, a2y, t[0], t[2]);
+  auto b2x = lerp(a2x, a3x, t[1], t[3]);
+  auto b2y = lerp(a2y, a3y, t[1], t[3]);
+  x = lerp(b1x, b2x, t[1], t[2]);
+  y = lerp(b1y, b2y, t[1], t[2]);
+}
+
+} // namespace
+
+// Public Members
+// -----------------------------------------------------------------------------
+
+constexpr double Track::kSampleSpacing;
+constexpr double Track::kCellSize;
+constexpr double Track::kIndexedDistance;
+
+Track::Track()
+  : spacing_(),
+    grid_x_(),
+    grid_y_(),
+    n_columns_(),
+    n_rows_() {
+  // Empty.
+}
+
+bool Track::Load(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  std::vector<double> x;
+  std::vector<double> y;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream iss(line);
+    double point_x;
+    double point_y;
+    if (iss >> point_x >> point_y) {
+      x.push_back(point_x);
+      y.push_back(point_y);
+    }
+  }
+  return SetCenterline(x, y);
+}
+
+bool Track::SetCenterline(const std::vector<double>& x,
+                          const std::vector<double>& y) {
+  if (x.size() != y.size()) {
+    return false;
+  }
+  // Consecutive duplicates, and the first point repeated at the end, are
+  // dropped
+  std::vector<double> control_x;
+  std::vector<double> control_y;
+  for (size_t i = 0; i < x.size(); ++i) {
+    if (!std::isfinite(x[i]) || !std::isfinite(y[i])) {
+      return false;
+    }
+    if (control_x.empty() || x[i] != control_x.back()
+        || y[i] != control_y.back()) {
+      control_x.push_back(x[i]);
+      control_y.push_back(y[i]);
+    }
+  }
+  while (control_x.size() > 1 && control_x.back() == control_x.front()
+         && control_y.back() == control_y.front()) {
+    control_x.pop_back();
+    control_y.pop_back();
+  }
+  if (control_x.size() < 3) {
+    return false;
+  }
+  Sample(control_x, control_y);
+  BuildIndex();
+  return true;
+}
+
+void Track::GetPose(double s, double& x, double& y, double& heading) const {
+  auto n = x_.size();
+  auto position = std::fmod(s / spacing_, static_cast<double>(n));
+  if (position < 0) {
+    position += n;
+  }
+  auto i = std::min(n - 1, static_cast<size_t>(position));
+  auto t = position - i;
+  x = x_[i] + t * dx_[i];
+  y = y_[i] + t * dy_[i];
+  heading = std::atan2(dy_[i], dx_[i]);
+}
+
+double Track::GetCte(double x, double y, double* s) const {
+  double cte;
+  GetCtes(&x, &y, 1, &cte, s);
+  return cte;
+}
+
+void Track::GetCtes(const double* x,
+                    const double* y,
+                    size_t n,
+                    double* ctes,
+                    double* s) const {
+  const auto* candidate_x = candidate_x_.data();
+  const auto* candidate_y = candidate_y_.data();
+  const auto* candidate_dx = candidate_dx_.data();
+  const auto* candidate_dy = candidate_dy_.data();
+  const auto* candidate_inverse_l2 = candidate_inverse_length2_.data();
+  for (size_t k = 0; k < n; ++k) {
+    auto column = std::floor((x[k] - grid_x_) / kCellSize);
+    auto row = std::floor((y[k] - grid_y_) / kCellSize);
+    auto segment = x_.size();
+    if (column >= 0 && row >= 0 && column < n_columns_ && row < n_rows_) {
+      auto cell = static_cast<size_t>(row) * n_columns_
+                  + static_cast<size_t>(column);
+      auto begin = cell_offsets_[cell];
+      auto end = cell_offsets_[cell + 1];
+      // Distances of a chunk of candidates in a loop without branches, then
+      // the nearest one of them
+      auto point_x = x[k];
+      auto point_y = y[k];
+      auto min_d2 = std::numeric_limits<double>::infinity();
+      auto nearest = begin;
+      for (auto chunk = begin; chunk < end; chunk += kChunkSize) {
+        auto count = std::min<uint32_t>(kChunkSize, end - chunk);
+        double d2[kChunkSize];
+        const auto* chunk_x = candidate_x + chunk;
+        const auto* chunk_y = candidate_y + chunk;
+        const auto* chunk_dx = candidate_dx + chunk;
+        const auto* chunk_dy = candidate_dy + chunk;
+        const auto* chunk_inverse_l2 = candidate_inverse_l2 + chunk;
+        for (uint32_t c = 0; c < count; ++c) {
+          d2[c] = GetDistance2(point_x, point_y, chunk_x[c], chunk_y[c],
+                               chunk_dx[c], chunk_dy[c], chunk_inverse_l2[c]);
+        }
+        for (uint32_t c = 0; c < count; ++c) {
+          auto is_nearer = d2[c] < min_d2;
+          min_d2 = is_nearer ? d2[c] : min_d2;
+          nearest = is_nearer ? chunk + c : nearest;
+        }
+      }
+      if (min_d2 <= kIndexedDistance * kIndexedDistance) {
+        segment = candidates_[nearest];
+      }
+    }
+    if (segment == x_.size()) {
+      // Beyond the indexed distance
+      segment = FindNearestSegment(x[k], y[k]);
+    }
+    ctes[k] = GetSegmentCte(segment, x[k], y[k], s ? s + k : nullptr);
+  }
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void Track::Sample(const std::vector<double>& x,
+                   const std::vector<double>& y) {
+  // Dense polyline of the spline and its cumulative arc length
+  auto n_control = x.size();
+  std::vector<double> dense_x;
+  std::vector<double> dense_y;
+  std::vector<double> dense_s;
+  dense_x.reserve(n_control * kStepsPerSpan + 1);
+  dense_y.reserve(n_control * kStepsPerSpan + 1);
+  dense_s.reserve(n_control * kStepsPerSpan + 1);
+  for (size_t i = 0; i < n_control; ++i) {
+    double px[4];
+    double py[4];
+    for (size_t j = 0; j < 4; ++j) {
+      auto control = (i + n_control + j - 1) % n_control;
+      px[j] = x[control];
+      py[j] = y[control];
+    }
+    for (auto step = 0; step < kStepsPerSpan; ++step) {
+      double point_x;
+      double point_y;
+      GetSplinePoint(px, py, static_cast<double>(step) / kStepsPerSpan,
+                     point_x, point_y);
+      dense_s.push_back(dense_x.empty() ?
+                        0. :
+                        dense_s.back() + std::hypot(point_x - dense_x.back(),
+                                                    point_y - dense_y.back()));
+      dense_x.push_back(point_x);
+      dense_y.push_back(point_y);
+    }
+  }
+  dense_s.push_back(dense_s.back() + std::hypot(dense_x.front() - dense_x.back(),
+                                                dense_y.front() - dense_y.back()));
+  dense_x.push_back(dense_x.front());
+  dense_y.push_back(dense_y.front());
+
+  // Samples at uniform arc length
+  auto length = dense_s.back();
+  auto n = std::max<size_t>(3, static_cast<size_t>(
+    std::round(length / kSampleSpacing)));
+  spacing_ = length / n;
+  x_.resize(n);
+  y_.resize(n);
+  size_t j = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto s = i * spacing_;
+    while (dense_s[j + 1] < s) {
+      ++j;
+    }
+    auto t = (s - dense_s[j]) / std::max(1e-12, dense_s[j + 1] - dense_s[j]);
+    x_[i] = dense_x[j] + t * (dense_x[j + 1] - dense_x[j]);
+    y_[i] = dense_y[j] + t * (dense_y[j + 1] - dense_y[j]);
+  }
+  dx_.resize(n);
+  dy_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    dx_[i] = x_[(i + 1) % n] - x_[i];
+    dy_[i] = y_[(i + 1) % n] - y_[i];
+  }
+}
+
+void Track::BuildIndex() {
+  // Grid covering the samples and the indexed distance around them
+  auto margin = kIndexedDistance + kCellSize;
+  grid_x_ = *std::min_element(x_.begin(), x_.end()) - margin;
+  grid_y_ = *std::min_element(y_.begin(), y_.end()) - margin;
+  n_columns_ = static_cast<size_t>(std::ceil(
+    (*std::max_element(x_.begin(), x_.end()) + margin - grid_x_) / kCellSize));
+  n_rows_ = static_cast<size_t>(std::ceil(
+    (*std::max_element(y_.begin(), y_.end()) + margin - grid_y_) / kCellSize));
+
+  // Segments within the indexed distance of any point of every cell
+  struct Candidate {
+    size_t cell;
+    uint32_t segment;
+    double distance;
+  };
+  std::vector<Candidate> collected;
+  auto reach = kIndexedDistance + kHalfCellDiagonal;
+  for (size_t i = 0; i < x_.size(); ++i) {
+    auto inverse_l2 = 1. / (dx_[i] * dx_[i] + dy_[i] * dy_[i]);
+    auto min_column = static_cast<size_t>(std::max(0., std::floor(
+      (std::min(x_[i], x_[i] + dx_[i]) - reach - grid_x_) / kCellSize)));
+    auto max_column = std::min(n_columns_ - 1, static_cast<size_t>(std::floor(
+      (std::max(x_[i], x_[i] + dx_[i]) + reach - grid_x_) / kCellSize)));
+    auto min_row = static_cast<size_t>(std::max(0., std::floor(
+      (std::min(y_[i], y_[i] + dy_[i]) - reach - grid_y_) / kCellSize)));
+    auto max_row = std::min(n_rows_ - 1, static_cast<size_t>(std::floor(
+      (std::max(y_[i], y_[i] + dy_[i]) + reach - grid_y_) / kCellSize)));
+    for (auto row = min_row; row <= max_row; ++row) {
+      for (auto column = min_column; column <= max_column; ++column) {
+        auto center_x = grid_x_ + (column + 0.5) * kCellSize;
+        auto center_y = grid_y_ + (row + 0.5) * kCellSize;
+        auto distance = std::sqrt(GetDistance2(center_x, center_y, x_[i],
+                                               y_[i], dx_[i], dy_[i],
+                                               inverse_l2));
+        if (distance <= reach) {
+          collected.push_back({row * n_columns_ + column,
+                               static_cast<uint32_t>(i), distance});
+        }
+      }
+    }
+  }
+  std::sort(collected.begin(), collected.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return a.cell < b.cell
+                     || (a.cell == b.cell && a.distance < b.distance);
+            });
+
+  // Any point of a cell is nearest to a segment within the diagonal of the
+  // cell beyond the nearest segment of its center
+  cell_offsets_.assign(n_columns_ * n_rows_ + 1, 0);
+  candidates_.clear();
+  for (size_t begin = 0; begin < collected.size();) {
+    auto cell = collected[begin].cell;
+    auto max_distance = collected[begin].distance + 2. * kHalfCellDiagonal;
+    auto end = begin;
+    for (; end < collected.size() && collected[end].cell == cell; ++end) {
+      if (collected[end].distance <= max_distance) {
+        candidates_.push_back(collected[end].segment);
+        ++cell_offsets_[cell + 1];
+      }
+    }
+    begin = end;
+  }
+  for (size_t i = 1; i < cell_offsets_.size(); ++i) {
+    cell_offsets_[i] += cell_offsets_[i - 1];
+  }
+  auto n_candidates = candidates_.size();
+  candidate_x_.resize(n_candidates);
+  candidate_y_.resize(n_candidates);
+  candidate_dx_.resize(n_candidates);
+  candidate_dy_.resize(n_candidates);
+  candidate_inverse_length2_.resize(n_candidates);
+  for (size_t c = 0; c < n_candidates; ++c) {
+    auto i = candidates_[c];
+    candidate_x_[c] = x_[i];
+    candidate_y_[c] = y_[i];
+    candidate_dx_[c] = dx_[i];
+    candidate_dy_[c] = dy_[i];
+    candidate_inverse_length2_[c] = 1. / (dx_[i] * dx_[i] + dy_[i] * dy_[i]);
+  }
+}
+
+double Track::GetSegmentCte(size_t i, double x, double y, double* s) const {
+  auto inverse_l2 = 1. / (dx_[i] * dx_[i] + dy_[i] * dy_[i]);
+  auto t = std::min(1., std::max(0., ((x - x_[i]) * dx_[i]
+                                      + (y - y_[i]) * dy_[i]) * inverse_l2));
+  if (s) {
+    *s = (i + t) * spacing_;
+  }
+  auto distance = std::sqrt(GetDistance2(x, y, x_[i], y_[i], dx_[i], dy_[i],
+                                         inverse_l2));
+  // Left of the direction of the segment is positive
+  auto cross = dx_[i] * (y - y_[i]) - dy_[i] * (x - x_[i]);
+  return cross < 0 ? -distance : distance;
+}
+
+size_t Track::FindNearestSegment(double x, double y) const {
+  size_t nearest = 0;
+  auto min_d2 = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < x_.size(); ++i) {
+    auto d2 = GetDistance2(x, y, x_[i], y_[i], dx_[i], dy_[i],
+                           1. / (dx_[i] * dx_[i] + dy_[i] * dy_[i]));
+    if (d2 < min_d2) {
+      min_d2 = d2;
+      nearest = i;
+    }
+  }
+  return nearest;
+}
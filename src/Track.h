@@ -0,0 +1,128 @@
+#ifndef TRACK_H
+#define TRACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Geometry of a closed track: a centripetal Catmull-Rom spline through the
+// control points of the centerline, sampled at uniform arc length, so the
+// samples are the lookup table from arc length to position. A grid index
+// keeps the candidate nearest segments of every cell near the centerline, so
+// the CTE of a point takes O(1), and the candidates of a cell are stored
+// contiguously as structure of arrays, so the distance loop is vectorizable.
+class Track {
+public:
+  // Arc length between samples of the centerline in meters
+  static constexpr double kSampleSpacing = 1.;
+
+  // Size of the cells of the grid index in meters
+  static constexpr double kCellSize = 2.;
+
+  // Distance from the centerline covered by the grid index in meters, CTE of
+  // points further away is found by a linear search
+  static constexpr double kIndexedDistance = 16.;
+
+  // Constructor, of an empty track.
+  Track();
+
+  // Loads the control points of the centerline from a text file, a point
+  // "x y" or "x,y" per line in meters. Other lines, such as a header, are
+  // skipped.
+  // @param path  Path of the file
+  // @return      True on success
+  bool Load(const std::string& path);
+
+  // Sets the control points of the centerline, the last one connects to the
+  // first one.
+  // @param x  X coordinates in meters
+  // @param y  Y coordinates in meters
+  // @return   True on success, at least 3 distinct points are required
+  bool SetCenterline(const std::vector<double>& x,
+                     const std::vector<double>& y);
+
+  // Indicates whether the centerline is set.
+  bool IsLoaded() const { return !x_.empty(); }
+
+  // Gets the length of the centerline in meters.
+  double GetLength() const { return spacing_ * x_.size(); }
+
+  // Gets the number of segments of the sampled centerline.
+  size_t GetSegmentCount() const { return x_.size(); }
+
+  // Gets the pose on the centerline at an arc length.
+  // @param[in]  s        Arc length in meters, wraps around the track
+  // @param[out] x        X coordinate in meters
+  // @param[out] y        Y coordinate in meters
+  // @param[out] heading  Direction of the centerline in radians
+  void GetPose(double s, double& x, double& y, double& heading) const;
+
+  // Gets CTE of a point.
+  // @param[in]  x  X coordinate in meters
+  // @param[in]  y  Y coordinate in meters
+  // @param[out] s  Arc length of the nearest point on the centerline, if not
+  //                nullptr
+  // @return        CTE in meters, positive to the left of the centerline
+  double GetCte(double x, double y, double* s = nullptr) const;
+
+  // Gets CTE of many points, e.g. of all vehicles of a batch simulator.
+  // @param[in]  x     X coordinates in meters
+  // @param[in]  y     Y coordinates in meters
+  // @param[in]  n     Number of points
+  // @param[out] ctes  CTE of every point
+  // @param[out] s     Arc length of every point, if not nullptr
+  void GetCtes(const double* x,
+               const double* y,
+               size_t n,
+               double* ctes,
+               double* s = nullptr) const;
+
+private:
+  // Samples the spline through the control points at uniform arc length.
+  void Sample(const std::vector<double>& x, const std::vector<double>& y);
+
+  // Builds the grid index of the sampled centerline.
+  void BuildIndex();
+
+  // Gets CTE of a point relative to a segment.
+  // @param[in]  i  Index of the segment
+  // @param[in]  x  X coordinate in meters
+  // @param[in]  y  Y coordinate in meters
+  // @param[out] s  Arc length of the nearest point of the segment, if not
+  //                nullptr
+  // @return        CTE in meters
+  double GetSegmentCte(size_t i, double x, double y, double* s) const;
+
+  // Finds the nearest segment by a linear search.
+  // @param x  X coordinate in meters
+  // @param y  Y coordinate in meters
+  // @return   Index of the segment
+  size_t FindNearestSegment(double x, double y) const;
+
+  // Samples of the centerline, segment i connects sample i to sample i + 1,
+  // the last one to the first one
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> dx_;
+  std::vector<double> dy_;
+  // Arc length between samples in meters
+  double spacing_;
+
+  // Origin of the grid in meters, and its size in cells
+  double grid_x_;
+  double grid_y_;
+  size_t n_columns_;
+  size_t n_rows_;
+  // Candidates of cell i are [cell_offsets_[i], cell_offsets_[i + 1]), their
+  // segments and the start, direction and inverse squared length of those
+  std::vector<uint32_t> cell_offsets_;
+  std::vector<uint32_t> candidates_;
+  std::vector<double> candidate_x_;
+  std::vector<double> candidate_y_;
+  std::vector<double> candidate_dx_;
+  std::vector<double> candidate_dy_;
+  std::vector<double> candidate_inverse_length2_;
+};
+
+#endif // TRACK_H
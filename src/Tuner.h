@@ -0,0 +1,60 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <vector>
+
+// Interface of tuning algorithms with the ask/tell protocol of Twiddler: the
+// caller evaluates the current parameters, reports the error, and gets the
+// next parameters to evaluate.
+class Tuner {
+public:
+  // Defines the search space of a parameter, where its steps are taken
+  enum class Transform {
+    // Steps add to the value
+    kLinear,
+    // Steps multiply the value, which stays positive
+    kLog,
+    // Steps are in the log-odds of the value within its bounds, which it
+    // approaches but never reaches
+    kLogit
+  };
+
+  // Contains a parameter value and its delta, the search space and the
+  // feasible range of the value. Fields left zero mean the linear search space
+  // without bounds. The delta is in units of the value at the current value.
+  struct Parameter {
+    double p;
+    double dp;
+    Transform transform;
+    // Feasible range of the value, unbounded if both are equal
+    double lower;
+    double upper;
+    bool operator==(const Parameter& rhs) const {
+      return rhs.p == p && rhs.dp == dp && rhs.transform == transform
+        && rhs.lower == lower && rhs.upper == upper;
+    }
+  };
+  typedef std::vector<Parameter> ParameterSequence;
+
+  virtual ~Tuner() { }
+
+  // Updates the error, generates a new set of parameters to try.
+  // @param[in] error  The error value for the current parameters
+  // @return           New parameters to try
+  virtual ParameterSequence UpdateError(double error) = 0;
+
+  // Gets the part of the lap to drive with the parameters returned by the last
+  // update, or with the initial parameters before the first update.
+  // @return  Fraction of the track length within 0..1
+  virtual double GetBudget() const { return 1.; }
+
+  // Indicates the tuner descends along one parameter at a time in cycles over
+  // all of them, adapting the deltas, so tuning converges as they shrink.
+  virtual bool IsCoordinateDescent() const { return false; }
+
+  // Gets the number of completed cycles over all parameters of coordinate
+  // descent.
+  virtual unsigned long int GetCycleCount() const { return 0; }
+};
+
+#endif // TUNER_H
@@ -1,4 +1,87 @@
 #include "Twiddler.h"
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Max number of infeasible candidates rejected in a row
+const auto kMaxRejections = 1000;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Indicates the parameter has bounds.
+// @param[in] parameter  Parameter
+bool HasBounds(const Tuner::Parameter& parameter) {
+  return parameter.lower != parameter.upper;
+}
+
+// Maps a value to the search space of the parameter.
+// @param[in] parameter  Parameter defining the search space
+// @param[in] value      Value
+// @return               Value in the search space
+double ToSearchSpace(const Tuner::Parameter& parameter, double value) {
+  switch (parameter.transform) {
+    case Tuner::Transform::kLog:
+      return std::log(value);
+    case Tuner::Transform::kLogit:
+      return std::log((value - parameter.lower) / (parameter.upper - value));
+    case Tuner::Transform::kLinear:
+    default:
+      return value;
+  }
+}
+
+// Maps a value from the search space of the parameter.
+// @param[in] parameter  Parameter defining the search space
+// @param[in] x          Value in the search space
+// @return               Value
+double FromSearchSpace(const Tuner::Parameter& parameter, double x) {
+  switch (parameter.transform) {
+    case Tuner::Transform::kLog:
+      return std::exp(x);
+    case Tuner::Transform::kLogit:
+      return parameter.lower
+        + (parameter.upper - parameter.lower) / (1. + std::exp(-x));
+    case Tuner::Transform::kLinear:
+    default:
+      return x;
+  }
+}
+
+// Indicates the value is within the domain of the search space, where the
+// logit space excludes its bounds.
+// @param[in] parameter  Parameter defining the search space
+// @param[in] value      Value
+bool IsInSearchSpace(const Tuner::Parameter& parameter, double value) {
+  switch (parameter.transform) {
+    case Tuner::Transform::kLog:
+      return value > 0;
+    case Tuner::Transform::kLogit:
+      return value > parameter.lower && value < parameter.upper;
+    case Tuner::Transform::kLinear:
+    default:
+      return true;
+  }
+}
+
+// Indicates the value is within the feasible range of the parameter.
+// @param[in] parameter  Parameter
+// @param[in] value      Value
+bool IsFeasibleValue(const Tuner::Parameter& parameter, double value) {
+  if (std::isnan(value)
+      || (parameter.transform == Tuner::Transform::kLog && value <= 0)) {
+    return false;
+  }
+  return !HasBounds(parameter)
+    || (value >= parameter.lower && value <= parameter.upper);
+}
+
+} // namespace
 
 // Public Members
 // -----------------------------------------------------------------------------
@@ -7,14 +90,41 @@ Twiddler::Twiddler(const ParameterSequence& parameters)
   : parameters_(parameters),
     state_(State::kUninitialized),
     parameter_id_(),
-    best_error_() {
-  // Empty.
+    best_error_(),
+    n_rejected_(),
+    n_cycles_() {
+  for (auto& parameter : parameters_) {
+    assert(IsFeasibleValue(parameter, parameter.p)
+           && IsInSearchSpace(parameter, parameter.p));
+    // The delta is the step from the initial value in both spaces, taken in
+    // the direction where it stays in the search space
+    auto x = ToSearchSpace(parameter, parameter.p);
+    auto step = std::fabs(parameter.dp);
+    auto dx = IsInSearchSpace(parameter, parameter.p + step) ?
+              ToSearchSpace(parameter, parameter.p + step) - x :
+              x - ToSearchSpace(parameter, parameter.p - step);
+    parameter.dp = std::copysign(dx, parameter.dp);
+    parameter.p = x;
+  }
 }
 
 Twiddler::ParameterSequence Twiddler::UpdateError(double error) {
   if (parameters_.empty()) {
     return parameters_;
   }
+  Update(error);
+  // Infeasible candidates are worse than any evaluated one
+  for (auto i = 0; i < kMaxRejections && !IsFeasible(); ++i) {
+    ++n_rejected_;
+    Update(std::numeric_limits<double>::infinity());
+  }
+  return GetParameters();
+}
+
+// Private Members
+// -----------------------------------------------------------------------------
+
+void Twiddler::Update(double error) {
   switch (state_) {
     case State::kUninitialized:
       // Initialize
@@ -46,15 +156,35 @@ Twiddler::ParameterSequence Twiddler::UpdateError(double error) {
       CompletePositiveChange();
     }
   }
-  return parameters_;
 }
 
-// Private Members
-// -----------------------------------------------------------------------------
-
 void Twiddler::CompletePositiveChange() {
-  parameter_id_ = parameter_id_ + 1 < parameters_.size() ?
-                  parameter_id_ + 1 : 0;
+  if (parameter_id_ + 1 < parameters_.size()) {
+    ++parameter_id_;
+  } else {
+    parameter_id_ = 0;
+    ++n_cycles_;
+  }
   parameters_.at(parameter_id_).p += parameters_.at(parameter_id_).dp;
   state_ = State::kPositiveChange;
 }
+
+bool Twiddler::IsFeasible() const {
+  for (const auto& parameter : parameters_) {
+    if (!IsFeasibleValue(parameter, FromSearchSpace(parameter, parameter.p))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Twiddler::ParameterSequence Twiddler::GetParameters() const {
+  auto parameters = parameters_;
+  for (auto& parameter : parameters) {
+    auto value = FromSearchSpace(parameter, parameter.p);
+    parameter.dp = FromSearchSpace(parameter, parameter.p + parameter.dp)
+      - value;
+    parameter.p = value;
+  }
+  return parameters;
+}
@@ -1,28 +1,34 @@
 #ifndef TWIDDLER_H
 #define TWIDDLER_H
 
+#include <cstddef>
 #include <vector>
+#include "Tuner.h"
 
-class Twiddler {
+// Twiddle, coordinate descent with adaptive deltas. Every parameter is stepped
+// in its own search space, so a log-space parameter around 1e-5 moves by the
+// same factors as one around 4. Candidates outside the feasible range of a
+// parameter count as failures without being returned for evaluation.
+class Twiddler : public Tuner {
 public:
-  // Contains a parameter value and its delta
-  struct Parameter {
-    double p;
-    double dp;
-    bool operator==(const Parameter& rhs) const {
-      return rhs.p == p && rhs.dp == dp;
-    }
-  };
-  typedef std::vector<Parameter> ParameterSequence;
-
   // Constructor.
-  // @param parameters  Initial sequence of parameters
+  // @param parameters  Initial sequence of parameters, within their feasible
+  //                    ranges
   Twiddler(const ParameterSequence& parameters);
 
   // Updates the error, generates a new set of parameters to try.
   // @param[in] error  The error value for the current parameters
   // @return           New parameters to try
-  ParameterSequence UpdateError(double error);
+  ParameterSequence UpdateError(double error) override;
+
+  // Twiddle is coordinate descent.
+  bool IsCoordinateDescent() const override { return true; }
+
+  // Gets the number of completed cycles over all parameters.
+  unsigned long int GetCycleCount() const override { return n_cycles_; }
+
+  // Gets the number of candidates rejected as infeasible.
+  size_t GetRejectedCount() const { return n_rejected_; }
 
 private:
   // Defines Twiddler states
@@ -36,7 +42,7 @@ private:
     kNegativeChange
   };
 
-  // Parameters
+  // Parameters, values and deltas are in the search space
   ParameterSequence parameters_;
 
   // State
@@ -48,8 +54,24 @@ private:
   // Best error value so far
   double best_error_;
 
+  // Number of candidates rejected as infeasible
+  size_t n_rejected_;
+
+  // Number of completed cycles over all parameters
+  unsigned long int n_cycles_;
+
+  // Updates the state with the error of the current parameters.
+  // @param error  The error value
+  void Update(double error);
+
   // Completes the positive change of a parameter
   void CompletePositiveChange();
+
+  // Indicates the current parameters are within their feasible ranges.
+  bool IsFeasible() const;
+
+  // Gets the current parameters with values and deltas in units of values.
+  ParameterSequence GetParameters() const;
 };
 
 #endif // TWIDDLER_H
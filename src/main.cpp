@@ -1,10 +1,14 @@
+#include <array>
+#include <cassert>
 #include <cmath>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <uWS/uWS.h>
-#include "json.hpp"
-#include "PidController.h"
-
-using namespace std::placeholders;
+#include "ExperimentStore.h"
+#include "Server.h"
+#include "Session.h"
+#include "SuccessiveHalving.h"
 
 // Local Constants
 // -----------------------------------------------------------------------------
@@ -26,20 +30,54 @@ const auto kMinOffTrackCte = 0.1;
 // Minimum allowed track length in meters
 const auto kMinTrackLength = 50.0;
 
+// Default per-frame compute deadline of model-predictive steering
+const auto kMpcDeadlineUs = 200;
+
+// Default number of candidates per round of successive halving
+const auto kHalvingPopulation = 27;
+
+// Default sum of the deltas relative to the initial ones, tuning converges
+// below it
+const auto kMinDeltaSum = 0.01;
+
+// Default number of cycles over all coefficients without a better error,
+// tuning stalls after it
+const auto kMaxStalledCycles = 20;
+
+// Default max number of steering commands not sent in a row
+const auto kMaxSteerAge = 10u;
+
+// Default budget of a frame with zero CTE, one frame of the simulator
+const auto kFrameBudgetMs = 40.;
+
+// Number of last frames of a session on the dashboard, about 40s
+const auto kDashboardWindow = 1024u;
+
+// Default max number of points per channel of a dashboard message
+const auto kDashboardPoints = 300u;
+
 // Local Helper-Functions
 // -----------------------------------------------------------------------------
 
-// Checks if the SocketIO event has JSON data.
-// @param[in] s  Raw event string
-// @return       If there is data the JSON object in string format will be
-//               returned, else the empty string will be returned.
-std::string GetJsonData(const std::string& s) {
-  auto found_null = s.find("null");
-  auto b1 = s.find_first_of("[");
-  auto b2 = s.find_last_of("]");
-  return found_null == std::string::npos
-    && b1 != std::string::npos
-    && b2 != std::string::npos ? s.substr(b1, b2 - b1 + 1) : std::string();
+// Extracts options of the form --name=value from command line arguments.
+// @param[in,out] argc  Number of arguments, options are removed
+// @param[in,out] argv  Array of arguments, options are removed
+// @return              Map of option names to values
+std::map<std::string, std::string> ExtractOptions(int& argc, char* argv[]) {
+  std::map<std::string, std::string> options;
+  auto n_args = 1;
+  for (auto i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg.compare(0, 2, "--") == 0) {
+      auto equals = arg.find('=');
+      options[arg.substr(2, equals == std::string::npos ? equals : equals - 2)]
+        = equals == std::string::npos ? std::string() : arg.substr(equals + 1);
+    } else {
+      argv[n_args++] = argv[i];
+    }
+  }
+  argc = n_args;
+  return options;
 }
 
 // Processes first four command line parameters.
@@ -72,11 +110,13 @@ void ProcessBaseParameters(int argc, char* argv[],
 // Checks arguments of the program and exits, if the check fails.
 // @param[in] argc  Number of arguments
 // @param[in] argv  Array of arguments
-// @return          A smart pointer to the PID controller object
-std::shared_ptr<PidController> CreatePidController(int argc, char* argv[]) {
+// @return          Settings of PID controllers
+ControllerConfig ProcessArguments(int argc, char* argv[]) {
+  auto options = ExtractOptions(argc, argv);
   std::stringstream oss;
     oss << "Usage instructions: " << argv[0]
-        << " [Kp Ki Kd offTrackCte] [dKp dKi dKd trackLength]" << std::endl
+        << " [options] [Kp Ki Kd offTrackCte] [dKp dKi dKd trackLength]"
+        << std::endl
         << "  Kp          Proportional coefficient" << std::endl
         << "  Ki          Integral coefficient" << std::endl
         << "  Kd          Derivativf coefficient" << std::endl
@@ -92,55 +132,159 @@ std::shared_ptr<PidController> CreatePidController(int argc, char* argv[]) {
         << " those values." << std::endl
         << "If [dKp dKi dKd trackLength] are also provided, the PID"
         << " controller finds best coefficients using the Twiddle algorithm,"
-        << " and uses them." << std::endl;
+        << " and uses them. A reconnected simulator resumes tuning where a"
+        << " closed connection with the same steering backend left it, the"
+        << " earliest closed first." << std::endl
+        << "Options:" << std::endl
+        << "  --steering=NAME           Steering backend: pid, mpc, table,"
+        << " or stanley, default is pid. With stanley the coefficients are"
+        << " the gains k, k_soft, k_heading. A simulator connection may"
+        << " override it with the URL query ?steering=NAME" << std::endl
+        << "  --mpc-deadline-us=N       Per-frame compute deadline of mpc,"
+        << " default is " << kMpcDeadlineUs << std::endl
+        << "  --table=path              Table made by compile_table, used by"
+        << " the table backend for steering and throttle, with final"
+        << " coefficients only" << std::endl
+        << "  --offset-profile=path     Profile made by optimize_line, the"
+        << " vehicle drives toward its target offset from the centerline at"
+        << " the distance driven, such as a racing line" << std::endl
+        << "  --tuner=NAME              Tuning algorithm: twiddle, bayes, or"
+        << " halving, default is twiddle. With bayes and halving the search"
+        << " box is 10 deltas around the initial coefficients, within the"
+        << " feasible range of the scale. With halving candidates first"
+        << " drive 1/9 of the lap, the best third of them 1/3, and the best"
+        << " of those the whole lap, evaluations are shared by all simulator"
+        << " connections" << std::endl
+        << "  --population=N            Candidates per round of halving,"
+        << " default is " << kHalvingPopulation << std::endl
+        << "  --scale=NAME              Search space of twiddle: linear or log,"
+        << " default is linear. With linear the deltas add to coefficients,"
+        << " which never get negative. With log the deltas multiply positive"
+        << " coefficients, so Ki around 1e-5 and Kd around 4 take steps of"
+        << " the same relative size" << std::endl
+        << "  --store=path              Experiment store recording every"
+        << " evaluation. Tuning starts from the best prior results of the"
+        << " scenario near the initial coefficients, and reuses stored"
+        << " errors instead of driving the same coefficients again"
+        << std::endl
+        << "  --scenario=N              Scenario identifier within the store,"
+        << " such as a track or a speed, default is 0" << std::endl
+        << "  --min-delta-sum=X         Twiddle converges when the sum of the"
+        << " deltas relative to the initial ones gets below X, default is "
+        << kMinDeltaSum << std::endl
+        << "  --stall-cycles=N          Tuning stalls after N cycles over all"
+        << " coefficients without a better error, default is "
+        << kMaxStalledCycles << std::endl
+        << "  --max-laps=N              Tuning stops after driving N laps"
+        << std::endl
+        << "  --max-minutes=N           Tuning stops after N minutes"
+        << std::endl
+        << "  --summary=path            File appended with a JSON line"
+        << " summarizing every tuning session, default is standard output."
+        << " Stopping short of the target, tuning uses the coefficients with"
+        << " the best error" << std::endl
+        << "  --steer-epsilon=X         Steering commands changing steering"
+        << " and throttle by less than X are not sent, default is 0"
+        << std::endl
+        << "  --steer-max-age=N         Max number of steering commands not"
+        << " sent in a row, default is " << kMaxSteerAge << std::endl
+        << "  --cork-ms=N               Messages to a simulator are corked for"
+        << " N milliseconds and written at once, default is 0. The simulator"
+        << " waits for the reply, so keep N well below the 40ms frame"
+        << " interval" << std::endl
+        << "  --frame-budget-ms=X       Frames of all simulators run earliest"
+        << " deadline first: the arrival plus X milliseconds, shrinking to 0"
+        << " as CTE gets to offTrackCte, default is " << kFrameBudgetMs
+        << ". With 0 frames run in the order of arrival" << std::endl
+        << "  --shadow=Kp,Ki,Kd[/...]   Shadow candidates, up to "
+        << Session::kMaxShadowCount << ", run on the same CTE as the final"
+        << " coefficients without actuating. Their divergence from the"
+        << " production steering and saturation rate are logged when the"
+        << " simulator disconnects" << std::endl
+        << "  --record=dir              Frames of every simulator connection"
+        << " are archived to dir/session-N.tlm, compressed and indexed by laps"
+        << " and resets, overwriting archives of a previous run. Read them with"
+        << " bench_telemetry" << std::endl
+        << "  --dashboard-ms=N          Every N milliseconds viewers of the"
+        << " page http://host:" << kTcpPort << kDashboardPath << " get the"
+        << " last " << kDashboardWindow << " frames of CTE, steering and"
+        << " speed of every session, downsampled, and the tuning events,"
+        << " default is 0, no dashboard" << std::endl
+        << "  --dashboard-points=N      Max points per channel of a dashboard"
+        << " message, shared by all sessions, default is " << kDashboardPoints
+        << std::endl
+        << "  --metrics                 CPU time of the frame stages per"
+        << " session, and their allocations in builds with"
+        << " -Dinstrumentation=ON, are served at http://host:" << kTcpPort
+        << kMetricsPath << std::endl;
 
   if (argc != 1 && argc != 5 && argc != 9) {
     std::cerr << oss.str();
     std::exit(EXIT_FAILURE);
   }
 
-  std::shared_ptr<PidController> pid_controller;
+  ControllerConfig config = {kKp, kKi, kKd, kOffTrackCte, false};
   try {
     switch (argc) {
       case 1:
-        pid_controller.reset(new PidController(kKp, kKi, kKd, kOffTrackCte));
         break;
-      case 5: {
-        auto kp = 0.;
-        auto ki = 0.;
-        auto kd = 0.;
-        auto off_track_cte = 0.;
-        ProcessBaseParameters(argc, argv, oss.str(), kp, ki, kd, off_track_cte);
-        pid_controller.reset(new PidController(kp, ki, kd, off_track_cte));
+      case 5:
+        ProcessBaseParameters(argc, argv, oss.str(), config.kp, config.ki,
+                              config.kd, config.off_track_cte);
         break;
-      }
       case 9: {
-        auto kp = 0.;
-        auto ki = 0.;
-        auto kd = 0.;
-        auto off_track_cte = 0.;
-        ProcessBaseParameters(argc, argv, oss.str(), kp, ki, kd, off_track_cte);
-        auto dkp = std::stod(argv[5]);
-        auto dki = std::stod(argv[6]);
-        auto dkd = std::stod(argv[7]);
-        auto track_length = std::stod(argv[8]);
-        if (track_length < 0) {
+        ProcessBaseParameters(argc, argv, oss.str(), config.kp, config.ki,
+                              config.kd, config.off_track_cte);
+        config.is_tuning = true;
+        config.dkp = std::stod(argv[5]);
+        config.dki = std::stod(argv[6]);
+        config.dkd = std::stod(argv[7]);
+        config.track_length = std::stod(argv[8]);
+        if (config.track_length < 0) {
           std::cerr << "Error: trackLength may not be negative" << std::endl
                     << oss.str();
           std::exit(EXIT_FAILURE);
-        } else if (track_length < kMinTrackLength) {
+        } else if (config.track_length < kMinTrackLength) {
           std::cerr << "Error: trackLength must be greater than "
                     << kMinTrackLength << std::endl << oss.str();
           std::exit(EXIT_FAILURE);
         }
-        pid_controller.reset(new PidController(kp, ki, kd, off_track_cte,
-                                               dkp, dki, dkd, track_length));
         break;
       }
       default:
         std::cerr << "Error: invalid number of arguments" << std::endl << oss.str();
         std::exit(EXIT_FAILURE);
     }
+    config.mpc_deadline_ns = 1000 * (options.count("mpc-deadline-us") ?
+                                     std::stoul(options["mpc-deadline-us"]) :
+                                     kMpcDeadlineUs);
+    config.limits.min_delta_sum = options.count("min-delta-sum") ?
+                                  std::stod(options["min-delta-sum"]) :
+                                  kMinDeltaSum;
+    config.limits.max_stalled_cycles = options.count("stall-cycles") ?
+                                       std::stoul(options["stall-cycles"]) :
+                                       kMaxStalledCycles;
+    config.limits.max_laps = options.count("max-laps") ?
+                             std::stod(options["max-laps"]) : 0.;
+    config.limits.max_seconds = options.count("max-minutes") ?
+                                60. * std::stod(options["max-minutes"]) : 0.;
+    config.output.epsilon = options.count("steer-epsilon") ?
+                            std::stod(options["steer-epsilon"]) : 0.;
+    config.output.max_age = options.count("steer-max-age") ?
+                            std::stoul(options["steer-max-age"]) :
+                            kMaxSteerAge;
+    config.cork_ms = options.count("cork-ms") ?
+                     std::stoul(options["cork-ms"]) : 0;
+    config.scheduling.budget = 1e-3 * (options.count("frame-budget-ms") ?
+                                       std::stod(options["frame-budget-ms"]) :
+                                       kFrameBudgetMs);
+    config.scheduling.off_track_cte = config.off_track_cte;
+    config.dashboard_ms = options.count("dashboard-ms") ?
+                          std::stoul(options["dashboard-ms"]) : 0;
+    config.dashboard.window = kDashboardWindow;
+    config.dashboard.n_points = options.count("dashboard-points") ?
+                                std::stoul(options["dashboard-points"]) :
+                                kDashboardPoints;
   }
   catch (const std::exception& e) {
     std::cerr << "Error: invalid data format: " << e.what() << std::endl
@@ -148,28 +292,122 @@ std::shared_ptr<PidController> CreatePidController(int argc, char* argv[]) {
     std::exit(EXIT_FAILURE);
   }
 
-  return pid_controller;
-}
+  if (config.scheduling.budget < 0) {
+    std::cerr << "Error: frame budget must not be negative" << std::endl
+              << oss.str();
+    std::exit(EXIT_FAILURE);
+  }
 
-// Sends a control message to the simulator.
-// @param[in] ws        WebSocket object
-// @param[in] steering  Steering value
-// @param[in] throttle  Throttle value
-void ControlSimulator(uWS::WebSocket<uWS::SERVER>& ws,
-                      double steering,
-                      double throttle) {
-  nlohmann::json json_msg;
-  json_msg["steering_angle"] = steering;
-  json_msg["throttle"] = throttle;
-  auto msg = "42[\"steer\"," + json_msg.dump() + "]";
-  ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-}
+  config.summary_path = options.count("summary") ? options["summary"] : "";
+  config.record_path = options.count("record") ? options["record"] : "";
+  config.is_profiling = options.count("metrics") > 0;
+
+  if (options.count("shadow")) {
+    std::istringstream candidates(options["shadow"]);
+    std::string candidate;
+    while (std::getline(candidates, candidate, '/')) {
+      std::array<double, 3> coefficients;
+      char comma1 = 0;
+      char comma2 = 0;
+      std::istringstream iss(candidate);
+      if (!(iss >> coefficients[0] >> comma1 >> coefficients[1] >> comma2
+                >> coefficients[2]) || comma1 != ',' || comma2 != ',') {
+        std::cerr << "Error: invalid shadow candidate " << candidate
+                  << std::endl << oss.str();
+        std::exit(EXIT_FAILURE);
+      }
+      config.shadows.push_back(coefficients);
+    }
+    if (config.shadows.size() > Session::kMaxShadowCount) {
+      std::cerr << "Error: too many shadow candidates" << std::endl
+                << oss.str();
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  config.tuner = options.count("tuner") ? options["tuner"] : "twiddle";
+  if (config.tuner != "twiddle" && config.tuner != "bayes"
+      && config.tuner != "halving") {
+    std::cerr << "Error: unknown tuner " << config.tuner << std::endl
+              << oss.str();
+    std::exit(EXIT_FAILURE);
+  }
+  auto scale = options.count("scale") ? options["scale"] : "linear";
+  if (scale != "linear" && scale != "log") {
+    std::cerr << "Error: unknown scale " << scale << std::endl << oss.str();
+    std::exit(EXIT_FAILURE);
+  }
+  config.transform = scale == "log" ? Tuner::Transform::kLog :
+                                      Tuner::Transform::kLinear;
+  if (config.is_tuning && config.transform == Tuner::Transform::kLog
+      && (config.kp <= 0 || config.ki <= 0 || config.kd <= 0)) {
+    std::cerr << "Error: log scale requires positive coefficients"
+              << std::endl << oss.str();
+    std::exit(EXIT_FAILURE);
+  }
+  if (options.count("store")) {
+    config.store = std::make_shared<ExperimentStore>();
+    if (!config.store->Open(options["store"])) {
+      std::cerr << "Error: failed to open store " << options["store"]
+                << std::endl << oss.str();
+      std::exit(EXIT_FAILURE);
+    }
+    config.scenario = options.count("scenario") ?
+                      std::strtoul(options["scenario"].c_str(), nullptr, 10) :
+                      0;
+  }
+
+  if (config.is_tuning && config.tuner == "halving") {
+    auto population = options.count("population") ?
+                      std::atoi(options["population"].c_str()) :
+                      kHalvingPopulation;
+    if (population < 1) {
+      std::cerr << "Error: population must be positive" << std::endl
+                << oss.str();
+      std::exit(EXIT_FAILURE);
+    }
+    // The population is shared by all connections, so it's seeded once, the
+    // controllers of the other tuners are seeded as they are created
+    auto parameters = GetTwiddleParameters(config);
+    if (config.store && config.store->Seed(config.scenario, parameters)) {
+      std::cout << "Seeded tuning from " << config.store->GetCount()
+                << " stored evaluations" << std::endl;
+    }
+    config.halving = std::make_shared<SuccessiveHalving>(parameters,
+                                                         population);
+  }
 
-// Sends a reset message to the simulator.
-// @param[in] ws        WebSocket object
-void ResetSimulator(uWS::WebSocket<uWS::SERVER>& ws) {
-  std::string msg("42[\"reset\", {}]");
-  ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+  config.steering = options.count("steering") ? options["steering"] : "pid";
+  if (options.count("table")) {
+    std::shared_ptr<ControlTable> table(new ControlTable());
+    if (!table->Load(options["table"])) {
+      std::cerr << "Error: failed to load table " << options["table"]
+                << std::endl << oss.str();
+      std::exit(EXIT_FAILURE);
+    }
+    config.table = table;
+  }
+  if (options.count("offset-profile")) {
+    std::shared_ptr<OffsetProfile> profile(new OffsetProfile());
+    if (!profile->Load(options["offset-profile"])) {
+      std::cerr << "Error: failed to load offset profile "
+                << options["offset-profile"] << std::endl << oss.str();
+      std::exit(EXIT_FAILURE);
+    }
+    config.offset_profile = profile;
+  }
+  if (config.steering == "table" && config.is_tuning) {
+    std::cerr << "Error: the table backend can't be tuned, its steering"
+              << " doesn't depend on the coefficients" << std::endl
+              << oss.str();
+    std::exit(EXIT_FAILURE);
+  }
+  if (!GetSteeringBackend(config, config.steering, nullptr)) {
+    std::cerr << "Error: unavailable steering backend " << config.steering
+              << std::endl << oss.str();
+    std::exit(EXIT_FAILURE);
+  }
+  return config;
 }
 
 // main
@@ -178,39 +416,8 @@ void ResetSimulator(uWS::WebSocket<uWS::SERVER>& ws) {
 int main(int argc, char* argv[])
 {
   uWS::Hub hub;
-  auto pid_controller = CreatePidController(argc, argv);
-  hub.onMessage([pid_controller](uWS::WebSocket<uWS::SERVER> ws,
-                                 char* data,
-                                 size_t length,
-                                 uWS::OpCode opCode) {
-    // "42" at the start of the message means there's a websocket message event.
-    // The 4 signifies a websocket message
-    // The 2 signifies a websocket event
-    if (length && length > 2 && data[0] == '4' && data[1] == '2') {
-      auto s = GetJsonData(std::string(data).substr(0, length));
-      if (!s.empty()) {
-        auto j = nlohmann::json::parse(s);
-        auto event = j[0].get<std::string>();
-        if (event == "telemetry") {
-          // j[1] is the data JSON object
-          auto cte = std::stod(j[1]["cte"].get<std::string>());
-          auto speed = std::stod(j[1]["speed"].get<std::string>());
-          auto angle = std::stod(j[1]["steering_angle"].get<std::string>());
-          pid_controller->Update(
-            cte,
-            speed,
-            std::bind(ControlSimulator, ws, _1, _2),
-            std::bind(ResetSimulator, ws));
-        }
-      } else {
-        // Manual driving
-        std::string msg = "42[\"manual\",{}]";
-        ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-      }
-    }
-  });
-
-  if (hub.listen(kTcpPort)) {
+  auto config = ProcessArguments(argc, argv);
+  if (Serve(hub, config, kTcpPort)) {
     std::cout << "Listening on port " << kTcpPort << std::endl;
   } else {
     std::cerr << "Failed to listen on port " << kTcpPort << std::endl;
@@ -0,0 +1,76 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/AsyncLogger.h"
+
+TEST(AsyncLogger, FlushWritesLinesInOrder) {
+  std::ostringstream oss;
+  AsyncLogger logger(oss);
+  std::string expected;
+  for (auto i = 0; i < 1000; ++i) {
+    logger.Log("line " + std::to_string(i));
+    expected += "line " + std::to_string(i) + "\n";
+  }
+  logger.Flush();
+  EXPECT_EQ(expected, oss.str());
+}
+
+TEST(AsyncLogger, DestructorWritesQueuedLines) {
+  std::ostringstream oss;
+  {
+    AsyncLogger logger(oss);
+    logger.Log("first");
+    logger.Log("second");
+  }
+  EXPECT_EQ("first\nsecond\n", oss.str());
+}
+
+TEST(AsyncLogger, LogsSeveralLinesAtOnce) {
+  std::ostringstream oss;
+  AsyncLogger logger(oss);
+  logger.Log("first\nsecond\n");
+  logger.Log("third");
+  logger.Flush();
+  EXPECT_EQ("first\nsecond\nthird\n", oss.str());
+}
+
+TEST(AsyncLogger, QuietLoggerDropsLines) {
+  std::ostringstream oss;
+  AsyncLogger logger(oss);
+  logger.SetQuiet(true);
+  logger.Log("dropped");
+  logger.Flush();
+  logger.SetQuiet(false);
+  logger.Log("written");
+  logger.Flush();
+  EXPECT_EQ("written\n", oss.str());
+}
+
+TEST(AsyncLogger, ConcurrentCallersLoseNoLines) {
+  const auto kThreadCount = 4;
+  const auto kLineCount = 10000;
+  std::ostringstream oss;
+  AsyncLogger logger(oss);
+  std::vector<std::thread> threads;
+  for (auto t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([&logger, kLineCount]() {
+      for (auto i = 0; i < kLineCount; ++i) {
+        logger.Log("x");
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  logger.Flush();
+  EXPECT_EQ(2u * kThreadCount * kLineCount, oss.str().size());
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
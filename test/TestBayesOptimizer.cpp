@@ -0,0 +1,81 @@
+#include <cmath>
+#include "gtest/gtest.h"
+#include "../src/BayesOptimizer.h"
+
+// Objective with the minimum 0.01 at (1, -0.5)
+double Objective(const Tuner::ParameterSequence& p) {
+  return (p[0].p - 1) * (p[0].p - 1) + (p[1].p + 0.5) * (p[1].p + 0.5) + 0.01;
+}
+
+double Optimize(unsigned int n_threads, size_t n_evaluations) {
+  Tuner::ParameterSequence p = {{0, 0.25}, {0, 0.25}};
+  BayesOptimizer optimizer(p, n_threads);
+  for (size_t i = 0; i < n_evaluations; ++i) {
+    auto next = optimizer.UpdateError(Objective(p));
+    // Stays within the search box, deltas are kept
+    EXPECT_LE(std::fabs(next[0].p), 2.5 + 1e-9);
+    EXPECT_LE(std::fabs(next[1].p), 2.5 + 1e-9);
+    EXPECT_EQ(0.25, next[0].dp);
+    p = next;
+  }
+  EXPECT_EQ(n_evaluations, optimizer.GetObservationCount());
+  EXPECT_NEAR(Objective(optimizer.GetBestParameters()),
+              optimizer.GetBestError(), 1e-12);
+  return optimizer.GetBestError();
+}
+
+TEST(BayesOptimizer, SingleThread) {
+  EXPECT_LT(Optimize(1, 30), 0.05);
+}
+
+TEST(BayesOptimizer, MultipleThreads) {
+  EXPECT_LT(Optimize(4, 30), 0.05);
+}
+
+TEST(BayesOptimizer, ObservationWindow) {
+  Tuner::ParameterSequence p = {{0, 0.25}, {0, 0.25}};
+  BayesOptimizer optimizer(p, 1, 1, 8);
+  for (auto i = 0; i < 30; ++i) {
+    p = optimizer.UpdateError(Objective(p));
+    EXPECT_LE(optimizer.GetObservationCount(), 8u);
+  }
+  EXPECT_EQ(8u, optimizer.GetObservationCount());
+  EXPECT_LT(optimizer.GetBestError(), 0.05);
+}
+
+TEST(BayesOptimizer, Empty) {
+  BayesOptimizer optimizer({});
+  EXPECT_TRUE(optimizer.UpdateError(1).empty());
+}
+
+TEST(BayesOptimizer, ZeroErrorAndFixedParameter) {
+  BayesOptimizer optimizer({{1, 0}, {0, 1}}, 2);
+  for (auto i = 0; i < 10; ++i) {
+    auto p = optimizer.UpdateError(i % 2 ? 0. : 1e+6);
+    EXPECT_EQ(1, p[0].p);
+    EXPECT_FALSE(std::isnan(p[1].p));
+  }
+  EXPECT_EQ(0, optimizer.GetBestError());
+}
+
+TEST(BayesOptimizer, StaysWithinBounds) {
+  // The optimum at (1, -0.5) is infeasible, the second parameter is bounded
+  // below by zero like Ki and Kd
+  Tuner::ParameterSequence p = {
+    {0.5, 0.25},
+    {0.5, 0.25, Tuner::Transform::kLinear, 0., HUGE_VAL}};
+  BayesOptimizer optimizer(p, 2);
+  for (auto i = 0; i < 30; ++i) {
+    p = optimizer.UpdateError(Objective(p));
+    EXPECT_GE(p[1].p, 0.);
+    EXPECT_LE(p[1].p, 3.);
+  }
+  EXPECT_NEAR(0., optimizer.GetBestParameters()[1].p, 0.1);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
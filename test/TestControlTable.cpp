@@ -0,0 +1,86 @@
+#include <cstdio>
+#include <fstream>
+#include "gtest/gtest.h"
+#include "../src/ControlTable.h"
+#include "../src/Pid.h"
+
+const auto kKp = 0.1;
+const auto kKi = 1e-4;
+const auto kKd = 4.0;
+const auto kPath = "test_control_table.tbl";
+
+// Source which is linear in every dimension, so it's interpolated exactly
+void LinearSource(const double point[], double& steering, double& throttle) {
+  steering = -kKp * point[0] - kKd * point[1] - kKi * point[2];
+  throttle = 1. - 0.01 * point[3] + 0.1 * point[0];
+}
+
+const ControlTable::Grid kGrid = {{-5, -1, -100, 0},
+                                  {5, 1, 100, 100},
+                                  {11, 5, 3, 6}};
+
+TEST(ControlTable, LinearSourceIsExact) {
+  ASSERT_TRUE(ControlTable::Compile(kPath, kGrid, LinearSource));
+  ControlTable table;
+  ASSERT_TRUE(table.Load(kPath));
+  EXPECT_EQ(64 + 2 * sizeof(float) * 11 * 5 * 3 * 6, table.GetSize());
+  const double points[][4] = {{0, 0, 0, 0}, {1.3, -0.2, 17, 33},
+                              {-4.9, 0.95, -99, 99.5}, {5, 1, 100, 100}};
+  for (const auto& p : points) {
+    double steering, throttle, expected_steering, expected_throttle;
+    table.Evaluate(p[0], p[1], p[2], p[3], steering, throttle);
+    LinearSource(p, expected_steering, expected_throttle);
+    EXPECT_NEAR(expected_steering, steering, 1e-5);
+    EXPECT_NEAR(expected_throttle, throttle, 1e-5);
+  }
+  std::remove(kPath);
+}
+
+TEST(ControlTable, ClampsOutsideGrid) {
+  ASSERT_TRUE(ControlTable::Compile(kPath, kGrid, LinearSource));
+  ControlTable table;
+  ASSERT_TRUE(table.Load(kPath));
+  double steering, throttle, edge_steering, edge_throttle;
+  table.Evaluate(50, 0, 0, 500, steering, throttle);
+  table.Evaluate(5, 0, 0, 100, edge_steering, edge_throttle);
+  EXPECT_NEAR(edge_steering, steering, 1e-6);
+  EXPECT_NEAR(edge_throttle, throttle, 1e-6);
+  std::remove(kPath);
+}
+
+TEST(ControlTable, RejectsInvalidFile) {
+  ControlTable::Grid grid = kGrid;
+  grid.size[2] = 1;
+  EXPECT_FALSE(ControlTable::Compile(kPath, grid, LinearSource));
+  {
+    std::ofstream file(kPath);
+    file << "not a table";
+  }
+  ControlTable table;
+  EXPECT_FALSE(table.Load(kPath));
+  EXPECT_FALSE(table.IsLoaded());
+  EXPECT_FALSE(table.Load("no_such_file.tbl"));
+  std::remove(kPath);
+}
+
+TEST(ControlTable, TableSteeringFollowsPid) {
+  ASSERT_TRUE(ControlTable::Compile(kPath, kGrid, LinearSource));
+  ControlTable table;
+  ASSERT_TRUE(table.Load(kPath));
+  TableSteering table_steering(table);
+  Pid pid(kKp, kKi, kKd);
+  const double ctes[] = {1, 1.2, 0.9, 0.5, 0, -0.4, -0.6};
+  for (auto cte : ctes) {
+    EXPECT_NEAR(pid.GetSteering(cte, 50), table_steering.GetSteering(cte, 50),
+                1e-5);
+    EXPECT_NEAR(1. - 0.5 + 0.1 * cte, table_steering.GetThrottle(), 1e-5);
+  }
+  std::remove(kPath);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
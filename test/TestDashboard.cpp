@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/Dashboard.h"
+#include "../src/TelemetryRing.h"
+
+// Counts the occurrences of a string.
+size_t Count(const std::string& s, const std::string& pattern) {
+  size_t n = 0;
+  for (auto i = s.find(pattern); i != std::string::npos;
+       i = s.find(pattern, i + 1)) {
+    ++n;
+  }
+  return n;
+}
+
+TEST(TelemetryRing, KeepsTheLastValues) {
+  TelemetryRing<int> ring(5);
+  EXPECT_EQ(7u, ring.GetCapacity());
+  std::vector<int> values;
+  EXPECT_EQ(0u, ring.Read(0, values));
+  EXPECT_TRUE(values.empty());
+  for (auto i = 0; i < 20; ++i) {
+    ring.Push(i);
+  }
+  EXPECT_EQ(20u, ring.GetCount());
+  // Overwritten values are skipped
+  EXPECT_EQ(20u, ring.Read(3, values));
+  ASSERT_EQ(7u, values.size());
+  for (auto i = 0; i < 7; ++i) {
+    EXPECT_EQ(13 + i, values[i]);
+  }
+  values.clear();
+  EXPECT_EQ(20u, ring.Read(17, values));
+  EXPECT_EQ((std::vector<int>{17, 18, 19}), values);
+}
+
+TEST(TelemetryRing, ReadsWhileWriting) {
+  // Values are the sequence numbers, a reader only gets consistent ones
+  TelemetryRing<uint64_t> ring(64);
+  std::thread writer([&ring]() {
+    for (uint64_t i = 0; i < 1000000; ++i) {
+      ring.Push(i);
+    }
+  });
+  uint64_t next = 0;
+  std::vector<uint64_t> values;
+  while (next < 1000000) {
+    values.clear();
+    auto count = ring.Read(next, values);
+    for (size_t i = 0; i < values.size(); ++i) {
+      ASSERT_EQ(count - values.size() + i, values[i]);
+    }
+    next = count;
+  }
+  writer.join();
+}
+
+TEST(Dashboard, DownsampleKeepsPeaks) {
+  std::vector<double> x;
+  std::vector<double> y;
+  for (auto i = 0; i < 1000; ++i) {
+    x.push_back(0.04 * i);
+    y.push_back(std::sin(0.01 * i));
+  }
+  y[333] = 10.;
+  y[777] = -10.;
+  std::vector<size_t> indices;
+  Dashboard::Downsample(x.data(), y.data(), x.size(), 50, indices);
+  ASSERT_EQ(50u, indices.size());
+  EXPECT_EQ(0u, indices.front());
+  EXPECT_EQ(999u, indices.back());
+  for (size_t i = 1; i < indices.size(); ++i) {
+    EXPECT_LT(indices[i - 1], indices[i]);
+  }
+  EXPECT_EQ(1u, std::count(indices.begin(), indices.end(), 333u));
+  EXPECT_EQ(1u, std::count(indices.begin(), indices.end(), 777u));
+
+  // Short series are kept, and too few points are the ends
+  Dashboard::Downsample(x.data(), y.data(), 10, 50, indices);
+  EXPECT_EQ(10u, indices.size());
+  Dashboard::Downsample(x.data(), y.data(), x.size(), 2, indices);
+  EXPECT_EQ((std::vector<size_t>{0, 999}), indices);
+  Dashboard::Downsample(x.data(), y.data(), x.size(), 3, indices);
+  EXPECT_EQ(3u, indices.size());
+}
+
+TEST(Dashboard, MessagesAreBounded) {
+  Dashboard dashboard({100, 60});
+  std::string message;
+  dashboard.Collect(message);
+  EXPECT_EQ("{\"sessions\":[]}", message);
+
+  auto first = dashboard.AddFeed();
+  auto second = dashboard.AddFeed();
+  EXPECT_NE(first->GetId(), second->GetId());
+  for (auto i = 0; i < 10000; ++i) {
+    first->Push({0.04 * i, std::sin(0.01 * i), 0.1, 30.});
+    second->Push({0.04 * i, 1., 0.2, 40.});
+  }
+  first->PushEvent({1., {0.1, 1e-4, 3.}, 0.5, true, nullptr});
+  first->PushEvent({2., {0.2, 1e-4, 3.}, 0.4, false, "target"});
+  dashboard.Collect(message);
+  EXPECT_EQ(2u, Count(message, "\"id\":"));
+  // Every session gets 60 / 2 points per channel, pairs are separated by "],["
+  EXPECT_EQ(2u * 3 * 29, Count(message, "],["));
+  EXPECT_EQ(1u, Count(message, "\"event\":\"evaluated\""));
+  EXPECT_EQ(1u, Count(message, "\"event\":\"target\""));
+  EXPECT_EQ(1u, Count(message, "\"full_lap\":false"));
+  EXPECT_LT(message.size(), 8000u);
+
+  // Events are sent once, closed sessions are gone
+  dashboard.RemoveFeed(second);
+  dashboard.Collect(message);
+  EXPECT_EQ(1u, Count(message, "\"id\":"));
+  EXPECT_EQ(0u, Count(message, "\"event\""));
+  EXPECT_EQ(3u * 59, Count(message, "],["));
+}
+
+TEST(Dashboard, CollectsOnItsOwnThread) {
+  Dashboard dashboard({100, 60});
+  auto feed = dashboard.AddFeed();
+  dashboard.Start(1);
+  // Nothing is collected without viewers
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(nullptr, dashboard.GetMessage());
+
+  // The feed keeps being written while collecting
+  dashboard.SetWatched(true);
+  std::shared_ptr<const std::string> message;
+  for (auto i = 0; !message || Count(*message, "],[") == 0; ++i) {
+    feed->Push({0.04 * i, 1., 0.1, 30.});
+    message = dashboard.GetMessage();
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(1u, Count(*message, "\"id\":"));
+  dashboard.RemoveFeed(feed);
+}
+
+TEST(Dashboard, ServesThePage) {
+  const auto& page = Dashboard::GetPage();
+  EXPECT_NE(std::string::npos, page.find("<html>"));
+  EXPECT_NE(std::string::npos, page.find("/dashboard"));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
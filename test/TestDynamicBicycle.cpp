@@ -0,0 +1,164 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/Simulator.h"
+#include "../src/DynamicBicycle.h"
+#include "../src/Pid.h"
+
+const auto kDt = 0.01;
+
+// Drives a vehicle with constant commands until the steady state.
+// @param speed     Longitudinal velocity in meters-per-second
+// @param steering  Front wheel angle in radians
+// @return          Steady yaw rate in radians-per-second
+double GetSteadyYawRate(double speed, double steering) {
+  DynamicBicycle vehicle(DynamicBicycle::GetSedan(), 1, kDt);
+  vehicle.Reset(0, 0., 0., 0., speed);
+  for (auto i = 0; i < 1000; ++i) {
+    // Thrust keeps the speed against the drag of the lateral slip
+    auto acceleration = -vehicle.Get(DynamicBicycle::kVy)[0]
+                        * vehicle.Get(DynamicBicycle::kYawRate)[0];
+    vehicle.Step(&steering, &acceleration, speed);
+  }
+  return vehicle.Get(DynamicBicycle::kYawRate)[0];
+}
+
+TEST(DynamicBicycle, AcceleratesStraight) {
+  DynamicBicycle vehicle(DynamicBicycle::GetSedan(), 1, kDt);
+  vehicle.Reset(0, 0., 2., 0.);
+  auto steering = 0.;
+  auto acceleration = 3.;
+  for (auto i = 0; i < 200; ++i) {
+    vehicle.Step(&steering, &acceleration, 100.);
+  }
+  EXPECT_NEAR(6., vehicle.Get(DynamicBicycle::kVx)[0], 1e-9);
+  EXPECT_NEAR(6., vehicle.Get(DynamicBicycle::kX)[0], 1e-9);
+  EXPECT_EQ(2., vehicle.Get(DynamicBicycle::kY)[0]);
+  EXPECT_EQ(0., vehicle.Get(DynamicBicycle::kVy)[0]);
+  // Max speed caps the longitudinal velocity
+  for (auto i = 0; i < 200; ++i) {
+    vehicle.Step(&steering, &acceleration, 8.);
+  }
+  EXPECT_EQ(8., vehicle.Get(DynamicBicycle::kVx)[0]);
+}
+
+TEST(DynamicBicycle, StepsActiveVehiclesOnly) {
+  DynamicBicycle vehicles(DynamicBicycle::GetSedan(), 3, kDt);
+  for (auto i = 0; i < 3; ++i) {
+    vehicles.Reset(i, 0., i, 0.);
+  }
+  // The last vehicle takes the place of the first one, and stays at rest
+  vehicles.Move(2, 0);
+  vehicles.SetActiveCount(2);
+  EXPECT_EQ(2u, vehicles.GetActiveCount());
+  double steering[] = {0., 0.};
+  double acceleration[] = {3., 3.};
+  for (auto i = 0; i < 100; ++i) {
+    vehicles.Step(steering, acceleration, 100.);
+  }
+  const auto* x = vehicles.Get(DynamicBicycle::kX);
+  const auto* y = vehicles.Get(DynamicBicycle::kY);
+  EXPECT_NEAR(1.5, x[0], 1e-9);
+  EXPECT_EQ(2., y[0]);
+  EXPECT_NEAR(1.5, x[1], 1e-9);
+  EXPECT_EQ(0., x[2]);
+  EXPECT_EQ(2., y[2]);
+}
+
+TEST(DynamicBicycle, UndersteersWithSpeed) {
+  auto sedan = DynamicBicycle::GetSedan();
+  auto wheelbase = sedan.front_distance + sedan.rear_distance;
+  auto gradient = sedan.mass / wheelbase
+                  * (sedan.rear_distance / sedan.front_stiffness
+                     - sedan.front_distance / sedan.rear_stiffness);
+  ASSERT_GT(gradient, 0.);
+  const auto kSteering = 0.02;
+  for (auto speed : {5., 15., 30., 45.}) {
+    // Linear single-track theory, kinematic at low speed
+    auto expected = speed * kSteering / (wheelbase + gradient * speed * speed);
+    EXPECT_NEAR(expected, GetSteadyYawRate(speed, kSteering), 1e-3 * expected);
+  }
+  EXPECT_NEAR(5. * kSteering / wheelbase, GetSteadyYawRate(5., kSteering),
+              0.05 * 5. * kSteering / wheelbase);
+  EXPECT_LT(GetSteadyYawRate(45., kSteering),
+            0.5 * 45. * kSteering / wheelbase);
+}
+
+TEST(DynamicBicycle, SteeringLags) {
+  auto sedan = DynamicBicycle::GetSedan();
+  DynamicBicycle vehicle(sedan, 1, kDt);
+  vehicle.Reset(0, 0., 0., 0., 20.);
+  auto steering = 0.1;
+  auto acceleration = 0.;
+  for (auto i = 0; i < std::lround(sedan.steering_lag / kDt); ++i) {
+    vehicle.Step(&steering, &acceleration, 20.);
+  }
+  EXPECT_NEAR(0.1 * (1. - std::exp(-1.)),
+              vehicle.Get(DynamicBicycle::kSteering)[0], 1e-6);
+}
+
+TEST(DynamicBicycle, BatchMatchesSingleVehicles) {
+  const auto kCount = 37;
+  DynamicBicycle batch(DynamicBicycle::GetSedan(), kCount, kDt);
+  std::vector<double> steering(kCount);
+  std::vector<double> acceleration(kCount);
+  for (auto i = 0; i < kCount; ++i) {
+    batch.Reset(i, i, -i, 0.01 * i, 0.5 * i);
+    steering[i] = 0.01 * (i % 7) - 0.03;
+    acceleration[i] = 0.1 * (i % 5);
+  }
+  for (auto step = 0; step < 300; ++step) {
+    batch.Step(steering.data(), acceleration.data(), 40.);
+  }
+  for (auto i = 0; i < kCount; ++i) {
+    DynamicBicycle single(DynamicBicycle::GetSedan(), 1, kDt);
+    single.Reset(0, i, -i, 0.01 * i, 0.5 * i);
+    for (auto step = 0; step < 300; ++step) {
+      single.Step(&steering[i], &acceleration[i], 40.);
+    }
+    for (auto c = 0; c < DynamicBicycle::kComponentCount; ++c) {
+      auto component = static_cast<DynamicBicycle::Component>(c);
+      ASSERT_DOUBLE_EQ(single.Get(component)[0], batch.Get(component)[i]);
+    }
+  }
+}
+
+TEST(DynamicBicycle, SimulatorNeedsMoreSteeringAtSpeed) {
+  // On a circle, PID holds the kinematic vehicle closer to the centerline
+  // than the understeering one at high speed
+  std::vector<double> x;
+  std::vector<double> y;
+  for (auto i = 0; i < 24; ++i) {
+    x.push_back(150. * std::cos(2. * M_PI * i / 24));
+    y.push_back(150. * std::sin(2. * M_PI * i / 24));
+  }
+  Track track;
+  ASSERT_TRUE(track.SetCenterline(x, y));
+  double mean_ctes[2];
+  for (auto model : {Simulator::Model::kKinematic, Simulator::Model::kDynamic}) {
+    Simulator simulator(70., 0., 0., 0., 1, &track, model);
+    Pid pid(0.12, 0., 4.);
+    auto sum_cte = 0.;
+    auto n_frames = 0;
+    while (simulator.GetDistance() < track.GetLength()) {
+      auto cte = simulator.GetCte();
+      if (simulator.GetSpeed() > 65.) {
+        sum_cte += std::fabs(cte);
+        ++n_frames;
+      }
+      auto steering = std::max(-1., std::min(1., pid.GetSteering(
+        cte, simulator.GetSpeed())));
+      simulator.Control(steering, 1.);
+    }
+    ASSERT_GT(n_frames, 0);
+    mean_ctes[model == Simulator::Model::kDynamic] = sum_cte / n_frames;
+  }
+  EXPECT_GT(mean_ctes[1], 1.5 * mean_ctes[0]);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
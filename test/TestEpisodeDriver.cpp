@@ -0,0 +1,204 @@
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/EpisodeDriver.h"
+
+const EpisodeDriver::Settings kSettings = {
+  7,         // batch_size
+  3,         // n_threads
+  50.,       // max_speed
+  1.,        // initial_cte
+  0,         // max_ticks
+  nullptr};  // track
+
+// Episode driving at full throttle for a number of ticks, then resetting
+// once, recording the telemetry of every tick.
+class ThrottleEpisode : public Episode {
+public:
+  explicit ThrottleEpisode(unsigned long int n_ticks) : n_ticks_(n_ticks) {
+    Start(Drive());
+  }
+
+  std::vector<Tick> ticks;
+
+private:
+  Coroutine Drive() {
+    for (;;) {
+      auto& step = co_await NextTick();
+      ticks.push_back(step.tick);
+      if (ticks.size() > 2 * n_ticks_) {
+        co_return;
+      }
+      step.command.throttle = 1.;
+      step.command.is_reset = ticks.size() == n_ticks_;
+    }
+  }
+
+  unsigned long int n_ticks_;
+};
+
+// Episode accelerating to a speed, then completing.
+// @param[in]  speed    Speed in miles-per-hour
+// @param[out] n_ticks  Number of ticks driven
+Episode::Coroutine Accelerate(double speed, unsigned long int& n_ticks) {
+  for (;;) {
+    auto& step = co_await Episode::NextTick();
+    if (step.tick.speed >= speed) {
+      n_ticks = step.tick.n_ticks;
+      co_return;
+    }
+    step.command.throttle = 1.;
+  }
+}
+
+// Episode throwing at a tick.
+// @param n_ticks  Number of ticks before throwing
+Episode::Coroutine Throw(unsigned long int n_ticks) {
+  for (;;) {
+    auto& step = co_await Episode::NextTick();
+    if (step.tick.n_ticks == n_ticks) {
+      throw std::runtime_error("episode failed");
+    }
+  }
+}
+
+TEST(EpisodeDriver, RunsAllEpisodesInBatches) {
+  EpisodeDriver driver(kSettings);
+  std::vector<std::unique_ptr<ThrottleEpisode>> episodes;
+  unsigned long int n_ticks = 0;
+  for (auto i = 0; i < 20; ++i) {
+    episodes.emplace_back(new ThrottleEpisode(10 + i));
+    driver.Add(episodes.back().get());
+    n_ticks += 2 * (10 + i);
+  }
+  EXPECT_EQ(n_ticks, driver.Run());
+  for (auto i = 0; i < 20; ++i) {
+    // The last resume completes the episode
+    const auto& ticks = episodes[i]->ticks;
+    ASSERT_EQ(2u * (10 + i) + 1, ticks.size());
+    for (size_t j = 0; j < ticks.size(); ++j) {
+      EXPECT_EQ(j, ticks[j].n_ticks);
+    }
+  }
+  // Nothing is left to run
+  EXPECT_EQ(0u, driver.Run());
+}
+
+TEST(EpisodeDriver, RunsCoroutines) {
+  EpisodeDriver driver(kSettings);
+  unsigned long int n_ticks = 0;
+  // 20mph at 6m/s^2 after 37.25 frames of 1/25s
+  Episode episode(Accelerate(20., n_ticks));
+  driver.Add(&episode);
+  EXPECT_EQ(38u, driver.Run());
+  EXPECT_EQ(38u, n_ticks);
+  // A complete episode stays complete
+  Episode::Command command = {};
+  EXPECT_FALSE(episode.Resume({0., 0., 0., 0}, command));
+}
+
+TEST(EpisodeDriver, RethrowsFromCoroutines) {
+  Episode episode(Throw(2));
+  Episode::Command command = {};
+  EXPECT_TRUE(episode.Resume({0., 0., 0., 0}, command));
+  EXPECT_TRUE(episode.Resume({0., 0., 0., 1}, command));
+  EXPECT_THROW(episode.Resume({0., 0., 0., 2}, command), std::runtime_error);
+  EXPECT_FALSE(episode.Resume({0., 0., 0., 3}, command));
+}
+
+TEST(EpisodeDriver, ResetPutsTheVehicleBack) {
+  EpisodeDriver driver(kSettings);
+  ThrottleEpisode episode(50);
+  driver.Add(&episode);
+  driver.Run();
+  const auto& ticks = episode.ticks;
+  EXPECT_EQ(1., ticks[0].cte);
+  EXPECT_EQ(0., ticks[0].speed);
+  EXPECT_EQ(0., ticks[0].distance);
+  // Full throttle for 49 frames of 1/25s at 6m/s^2, within max speed
+  EXPECT_NEAR(49. / 25. * 6. / 0.44704, ticks[49].speed, 1e-6);
+  EXPECT_NEAR(0.5 * 6. * (49. / 25.) * (49. / 25.), ticks[49].distance, 0.2);
+  EXPECT_NEAR(1., ticks[49].cte, 1e-9);
+  EXPECT_EQ(1., ticks[50].cte);
+  EXPECT_EQ(0., ticks[50].speed);
+  EXPECT_EQ(0., ticks[50].distance);
+}
+
+TEST(EpisodeDriver, StopsAtMaxTicks) {
+  auto settings = kSettings;
+  settings.max_ticks = 30;
+  EpisodeDriver driver(settings);
+  ThrottleEpisode short_episode(10);
+  ThrottleEpisode long_episode(100);
+  driver.Add(&short_episode);
+  driver.Add(&long_episode);
+  EXPECT_EQ(20u + 30u, driver.Run());
+  EXPECT_EQ(30u, long_episode.ticks.size());
+}
+
+TEST(EpisodeDriver, BatchesMatchSingleEpisodes) {
+  // Tuning controllers from different initial coefficients, driven in one
+  // batch and one by one
+  const auto kCount = 9;
+  std::vector<std::unique_ptr<ControllerEpisode>> batch;
+  std::vector<std::unique_ptr<ControllerEpisode>> singles;
+  auto settings = kSettings;
+  settings.batch_size = kCount;
+  EpisodeDriver batch_driver(settings);
+  settings.batch_size = 1;
+  EpisodeDriver single_driver(settings);
+  for (auto i = 0; i < kCount; ++i) {
+    for (auto* episodes : {&batch, &singles}) {
+      std::unique_ptr<PidController> controller(new PidController(
+        0.1 + 0.01 * i, 0., 3., 5., 0.01, 0., 0.5, 300.));
+      // Min delta sum, max stalled cycles, max seconds and max laps
+      controller->SetTuningLimits({0., 0, 0., 4.});
+      episodes->emplace_back(new ControllerEpisode(std::move(controller),
+                                                   1e4));
+    }
+    batch_driver.Add(batch.back().get());
+    single_driver.Add(singles.back().get());
+  }
+  EXPECT_EQ(single_driver.Run(), batch_driver.Run());
+  for (auto i = 0; i < kCount; ++i) {
+    EXPECT_TRUE(batch[i]->GetController().HasFinalCoefficients());
+    double batch_kp, batch_ki, batch_kd;
+    double single_kp, single_ki, single_kd;
+    batch[i]->GetController().GetCoefficients(batch_kp, batch_ki, batch_kd);
+    singles[i]->GetController().GetCoefficients(single_kp, single_ki,
+                                                single_kd);
+    EXPECT_EQ(single_kp, batch_kp);
+    EXPECT_EQ(single_kd, batch_kd);
+    EXPECT_EQ(singles[i]->GetDistance(), batch[i]->GetDistance());
+  }
+}
+
+TEST(EpisodeDriver, DrivesAlongTrack) {
+  std::vector<double> x;
+  std::vector<double> y;
+  for (auto i = 0; i < 24; ++i) {
+    x.push_back(100. * std::cos(2. * M_PI * i / 24));
+    y.push_back(100. * std::sin(2. * M_PI * i / 24));
+  }
+  Track track;
+  ASSERT_TRUE(track.SetCenterline(x, y));
+  auto settings = kSettings;
+  settings.track = &track;
+  EpisodeDriver driver(settings);
+  ControllerEpisode episode(
+    std::unique_ptr<PidController>(new PidController(0.12, 0., 4., 5.)),
+    track.GetLength());
+  driver.Add(&episode);
+  EXPECT_GT(driver.Run(), 0u);
+  EXPECT_GE(episode.GetDistance(), track.GetLength());
+  EXPECT_LT(episode.GetDistance(), track.GetLength() + 5.);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
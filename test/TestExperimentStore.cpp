@@ -0,0 +1,157 @@
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <sys/resource.h>
+#include "gtest/gtest.h"
+#include "../src/ExperimentStore.h"
+
+const auto kPath = "test_experiment_store.exp";
+
+TEST(ExperimentStore, AppendGrowAndReopen) {
+  std::remove(kPath);
+  {
+    ExperimentStore store;
+    ASSERT_TRUE(store.Open(kPath));
+    // More records than the initial capacity
+    for (auto i = 0; i < 3000; ++i) {
+      double c[] = {0.1 + 1e-4 * i, 0., 4.};
+      ASSERT_TRUE(store.Append(i % 2, c, i % 3 ? 1. : 1. / 3, 3000. - i));
+    }
+    EXPECT_EQ(3000, store.GetCount());
+  }
+  ExperimentStore store;
+  ASSERT_TRUE(store.Open(kPath));
+  EXPECT_EQ(3000, store.GetCount());
+  double c[] = {0.1 + 1e-4 * 2999, 0., 4.};
+  ExperimentStore::Record record;
+  ASSERT_TRUE(store.Find(1, c, 1., record));
+  EXPECT_EQ(1., record.error);
+  EXPECT_EQ(1u, record.scenario);
+  EXPECT_GT(record.timestamp_ns, 0u);
+  // Scenario and budget are parts of the key
+  EXPECT_FALSE(store.Find(0, c, 1., record));
+  EXPECT_FALSE(store.Find(1, c, 1. / 3, record));
+  std::remove(kPath);
+}
+
+TEST(ExperimentStore, FailedGrowthKeepsRecords) {
+  std::remove(kPath);
+  ExperimentStore store;
+  ASSERT_TRUE(store.Open(kPath));
+  // The file size limit fails growing beyond the initial capacity
+  rlimit limit;
+  ASSERT_EQ(0, getrlimit(RLIMIT_FSIZE, &limit));
+  auto handler = std::signal(SIGXFSZ, SIG_IGN);
+  auto limited = limit;
+  limited.rlim_cur = 64 + 1024 * sizeof(ExperimentStore::Record);
+  ASSERT_EQ(0, setrlimit(RLIMIT_FSIZE, &limited));
+  auto i = 0;
+  for (; i < 2048; ++i) {
+    double c[] = {0.1 + 1e-4 * i, 0., 4.};
+    if (!store.Append(0, c, 1., 2048. - i)) {
+      break;
+    }
+  }
+  setrlimit(RLIMIT_FSIZE, &limit);
+  std::signal(SIGXFSZ, handler);
+  EXPECT_EQ(1024, i);
+  EXPECT_EQ(1024, store.GetCount());
+  double c[] = {0.1, 0., 4.};
+  ExperimentStore::Record record;
+  ASSERT_TRUE(store.Find(0, c, 1., record));
+  EXPECT_EQ(2048., record.error);
+  double center[] = {0.1, 0., 4.};
+  double radius[] = {1., 1., 1.};
+  auto best = store.FindBest(0, center, radius, 1);
+  ASSERT_EQ(1, best.size());
+  EXPECT_EQ(1025., best[0].error);
+  // Growing succeeds again without the limit
+  double next[] = {0.1 + 1e-4 * i, 0., 4.};
+  EXPECT_TRUE(store.Append(0, next, 1., 0.));
+  EXPECT_EQ(1025, store.GetCount());
+  std::remove(kPath);
+}
+
+TEST(ExperimentStore, FindBestWithinBox) {
+  std::remove(kPath);
+  ExperimentStore store;
+  ASSERT_TRUE(store.Open(kPath));
+  double c1[] = {1., 0., 1.};
+  double c2[] = {1.1, 0., 1.};
+  double c3[] = {3., 0., 1.};
+  double c4[] = {1.05, 0., 1.};
+  store.Append(0, c1, 1., 0.5);
+  store.Append(0, c2, 1., 0.3);
+  store.Append(0, c3, 1., 0.1);
+  store.Append(0, c4, 0.5, 0.01);
+  store.Append(1, c1, 1., 0.01);
+  double center[] = {1., 0., 1.};
+  double radius[] = {0.5, 0.5, 0.5};
+  auto best = store.FindBest(0, center, radius, 5);
+  // Out of the box, partial laps and other scenarios are skipped
+  ASSERT_EQ(2, best.size());
+  EXPECT_EQ(0.3, best[0].error);
+  EXPECT_EQ(0.5, best[1].error);
+  EXPECT_EQ(1, store.FindBest(0, center, radius, 1).size());
+  EXPECT_TRUE(store.FindBest(2, center, radius, 5).empty());
+  std::remove(kPath);
+}
+
+TEST(ExperimentStore, Seed) {
+  std::remove(kPath);
+  ExperimentStore store;
+  ASSERT_TRUE(store.Open(kPath));
+  Tuner::ParameterSequence parameters = {{1, 0.1}, {0, 0.01},
+                                         {2, 0.5}};
+  auto seeded = parameters;
+  EXPECT_FALSE(store.Seed(0, seeded));
+  EXPECT_EQ(parameters, seeded);
+
+  double c1[] = {1.2, 0.01, 2.};
+  double c2[] = {1.25, 0.01, 2.5};
+  store.Append(0, c1, 1., 0.1);
+  store.Append(0, c2, 1., 0.2);
+  ASSERT_TRUE(store.Seed(0, seeded));
+  EXPECT_EQ(1.2, seeded[0].p);
+  EXPECT_EQ(0.01, seeded[1].p);
+  EXPECT_EQ(2., seeded[2].p);
+  // Deltas narrow to the spread of the best results, but not below 1/10
+  EXPECT_NEAR(0.05, seeded[0].dp, 1e-12);
+  EXPECT_NEAR(0.001, seeded[1].dp, 1e-12);
+  EXPECT_NEAR(0.5, seeded[2].dp, 1e-12);
+
+  // Seeded values stay within the feasible ranges
+  Tuner::ParameterSequence bounded = {
+    {1, 0.1, Tuner::Transform::kLog, 0., 1.1},
+    {0, 0.01, Tuner::Transform::kLinear, 0., HUGE_VAL},
+    {2, 0.5, Tuner::Transform::kLinear, 0., HUGE_VAL}};
+  ASSERT_TRUE(store.Seed(0, bounded));
+  EXPECT_EQ(1.1, bounded[0].p);
+  EXPECT_EQ(Tuner::Transform::kLog, bounded[0].transform);
+  EXPECT_EQ(1.1, bounded[0].upper);
+  EXPECT_EQ(2., bounded[2].p);
+  std::remove(kPath);
+}
+
+TEST(ExperimentStore, InvalidAndLockedFiles) {
+  {
+    std::ofstream file(kPath);
+    file << "not a store";
+  }
+  ExperimentStore store;
+  EXPECT_FALSE(store.Open(kPath));
+  EXPECT_FALSE(store.IsOpen());
+  std::remove(kPath);
+  ASSERT_TRUE(store.Open(kPath));
+  ExperimentStore other;
+  EXPECT_FALSE(other.Open(kPath));
+  std::remove(kPath);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
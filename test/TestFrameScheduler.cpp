@@ -0,0 +1,99 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/FrameScheduler.h"
+
+const auto kBudget = 0.04;
+const auto kOffTrackCte = 5.;
+
+// Sessions are told apart by their addresses only
+int g_sessions[4];
+
+// Collects the frames in the order of running.
+struct Ran {
+  std::vector<FrameScheduler::Frame> frames;
+  FrameScheduler::Handler GetHandler() {
+    return [this](const FrameScheduler::Frame& frame) {
+      frames.push_back(frame);
+    };
+  }
+};
+
+TEST(FrameScheduler, UrgentFramesRunFirst) {
+  FrameScheduler scheduler({kBudget, kOffTrackCte});
+  // Comfortable frames arrive first, the urgent ones later
+  EXPECT_DOUBLE_EQ(1. + kBudget, scheduler.Push(&g_sessions[0], 1., 0., 30.));
+  EXPECT_DOUBLE_EQ(1.001 + 0.5 * kBudget,
+                   scheduler.Push(&g_sessions[1], 1.001, -2.5, 30.));
+  EXPECT_DOUBLE_EQ(1.002, scheduler.Push(&g_sessions[2], 1.002, 6., 30.));
+  EXPECT_DOUBLE_EQ(1.003 + 0.8 * kBudget,
+                   scheduler.Push(&g_sessions[3], 1.003, 1., 30.));
+  EXPECT_EQ(4u, scheduler.GetPendingCount());
+  Ran ran;
+  EXPECT_EQ(4u, scheduler.Run(ran.GetHandler()));
+  ASSERT_EQ(4u, ran.frames.size());
+  EXPECT_EQ(&g_sessions[2], ran.frames[0].context);
+  EXPECT_EQ(&g_sessions[1], ran.frames[1].context);
+  EXPECT_EQ(&g_sessions[3], ran.frames[2].context);
+  EXPECT_EQ(&g_sessions[0], ran.frames[3].context);
+  EXPECT_EQ(-2.5, ran.frames[1].cte);
+  EXPECT_EQ(0u, scheduler.GetPendingCount());
+}
+
+TEST(FrameScheduler, ZeroBudgetRunsInOrderOfArrival) {
+  FrameScheduler scheduler({0., kOffTrackCte});
+  const double ctes[] = {0., 4., -1., 4.9};
+  for (auto i = 0; i < 4; ++i) {
+    scheduler.Push(&g_sessions[i], 1. + 0.001 * i, ctes[i], 30.);
+  }
+  Ran ran;
+  scheduler.Run(ran.GetHandler());
+  for (auto i = 0; i < 4; ++i) {
+    EXPECT_EQ(&g_sessions[i], ran.frames[i].context);
+  }
+}
+
+TEST(FrameScheduler, FramesOfSessionKeepOrder) {
+  FrameScheduler scheduler({kBudget, kOffTrackCte});
+  scheduler.Push(&g_sessions[0], 1., 0., 30.);
+  scheduler.Push(&g_sessions[1], 1.01, 2., 30.);
+  // More urgent, but not ahead of the earlier frame of its session
+  EXPECT_DOUBLE_EQ(1. + kBudget,
+                   scheduler.Push(&g_sessions[0], 1.02, 4., 30.));
+  Ran ran;
+  EXPECT_EQ(1u, scheduler.Run(ran.GetHandler(), 1));
+  EXPECT_EQ(2u, scheduler.GetPendingCount());
+  scheduler.Run(ran.GetHandler());
+  ASSERT_EQ(3u, ran.frames.size());
+  EXPECT_EQ(&g_sessions[1], ran.frames[0].context);
+  EXPECT_EQ(&g_sessions[0], ran.frames[1].context);
+  EXPECT_EQ(0., ran.frames[1].cte);
+  EXPECT_EQ(4., ran.frames[2].cte);
+
+  // Once run, the next frame of the session is urgent again
+  EXPECT_DOUBLE_EQ(1.1, scheduler.Push(&g_sessions[0], 1.1, 5., 30.));
+}
+
+TEST(FrameScheduler, RemovedSessionsDropTheirFrames) {
+  FrameScheduler scheduler({kBudget, kOffTrackCte});
+  for (auto i = 0; i < 3; ++i) {
+    scheduler.Push(&g_sessions[0], 1. + 0.01 * i, 1., 30.);
+    scheduler.Push(&g_sessions[1], 1. + 0.01 * i, 2., 30.);
+  }
+  scheduler.Remove(&g_sessions[1]);
+  scheduler.Remove(&g_sessions[2]);
+  EXPECT_EQ(3u, scheduler.GetPendingCount());
+  Ran ran;
+  scheduler.Run(ran.GetHandler());
+  ASSERT_EQ(3u, ran.frames.size());
+  for (size_t i = 0; i < ran.frames.size(); ++i) {
+    EXPECT_EQ(&g_sessions[0], ran.frames[i].context);
+    EXPECT_DOUBLE_EQ(1. + 0.01 * i, ran.frames[i].arrival);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,44 @@
+#include "gtest/gtest.h"
+#include "../src/Histogram.h"
+
+TEST(Histogram, Empty) {
+  Histogram histogram;
+  EXPECT_EQ(0, histogram.GetCount());
+  EXPECT_EQ(0, histogram.GetPercentile(99));
+  EXPECT_EQ(0, histogram.GetMean());
+}
+
+TEST(Histogram, Percentiles) {
+  Histogram histogram;
+  for (auto i = 0; i < 99; ++i) {
+    histogram.Add(100);
+  }
+  histogram.Add(100000);
+  EXPECT_EQ(100, histogram.GetCount());
+  EXPECT_EQ(100000, histogram.GetMax());
+  EXPECT_NEAR(1099, histogram.GetMean(), 1e-9);
+  // 100ns falls into the bucket [64, 128)
+  EXPECT_EQ(127, histogram.GetPercentile(50));
+  EXPECT_EQ(127, histogram.GetPercentile(99));
+  EXPECT_EQ(100000, histogram.GetPercentile(100));
+}
+
+TEST(Histogram, Merge) {
+  Histogram h1;
+  Histogram h2;
+  h1.Add(10);
+  h2.Add(1000);
+  h2.Add(2000);
+  h1.Merge(h2);
+  EXPECT_EQ(3, h1.GetCount());
+  EXPECT_EQ(2000, h1.GetMax());
+  h1.Clear();
+  EXPECT_EQ(0, h1.GetCount());
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "../src/LapStatistics.h"
+
+const auto kOffTrackCte = 1.0;
+const auto kTrackLength = 1000.0;
+
+// Drives at constant CTE and speed until the budget is complete or the
+// vehicle gets off track at the given distance.
+LapStatistics::Status Drive(LapStatistics& statistics,
+                            double cte,
+                            double off_track_distance = 1e+9) {
+  auto status = LapStatistics::Status::kDriving;
+  while (status == LapStatistics::Status::kDriving) {
+    auto is_off_track = statistics.GetDistance() > off_track_distance;
+    status = statistics.Update(is_off_track ? 2 * kOffTrackCte : cte, 50);
+  }
+  return status;
+}
+
+TEST(LapStatistics, FullLap) {
+  LapStatistics statistics(kOffTrackCte, kTrackLength);
+  EXPECT_TRUE(statistics.IsFullLap());
+  EXPECT_EQ(LapStatistics::Status::kComplete, Drive(statistics, 0.5));
+  EXPECT_GT(statistics.GetDistance(), kTrackLength);
+  EXPECT_NEAR(0.5, statistics.GetMaxCte(), 1e-12);
+  EXPECT_NEAR(0.5, statistics.GetAverageCte(), 1e-12);
+  EXPECT_NEAR(0.25, statistics.GetError(), 1e-12);
+  EXPECT_NEAR(50, statistics.GetAverageSpeed(), 1e-9);
+}
+
+TEST(LapStatistics, PartialBudgetsAreComparable) {
+  LapStatistics statistics(kOffTrackCte, kTrackLength);
+  statistics.Reset(kTrackLength / 9);
+  EXPECT_FALSE(statistics.IsFullLap());
+  EXPECT_EQ(LapStatistics::Status::kComplete, Drive(statistics, -0.5));
+  EXPECT_LT(statistics.GetDistance(), kTrackLength / 8);
+  EXPECT_NEAR(0, statistics.GetError(), 1e-12);
+  statistics.Reset(kTrackLength / 9);
+  Drive(statistics, 0.5);
+  EXPECT_NEAR(0.25, statistics.GetError(), 1e-12);
+
+  // Getting off track halfway has the same penalty for every budget
+  statistics.Reset(kTrackLength);
+  EXPECT_EQ(LapStatistics::Status::kOffTrack,
+            Drive(statistics, 0.5, kTrackLength / 2));
+  auto full_lap_penalty = statistics.GetError();
+  EXPECT_NEAR(1e+6 / statistics.GetDistance(), full_lap_penalty, 1e-9);
+  statistics.Reset(kTrackLength / 3);
+  EXPECT_EQ(LapStatistics::Status::kOffTrack,
+            Drive(statistics, 0.5, kTrackLength / 6));
+  EXPECT_NEAR(full_lap_penalty, statistics.GetError(),
+              0.02 * full_lap_penalty);
+  EXPECT_GT(statistics.GetError(), 0.25);
+}
+
+TEST(LapStatistics, AbortIsGradedByPredictedDistance) {
+  LapStatistics statistics(kOffTrackCte, kTrackLength);
+  Drive(statistics, 0.5, kTrackLength / 4);
+  auto off_track_penalty = statistics.GetError();
+
+  // Aborting a quarter lap ahead of the same distance has the same penalty
+  statistics.Reset(kTrackLength);
+  while (statistics.GetDistance() < kTrackLength / 8) {
+    statistics.Update(0.5, 50);
+  }
+  auto distance = statistics.GetDistance();
+  // Frames at 50mph to drive the rest of a quarter lap
+  auto n_frames = (kTrackLength / 4 - distance) / (50 * 1609.344 / 3600 / 25);
+  EXPECT_FALSE(statistics.Abort(100 * n_frames, 50));
+  EXPECT_TRUE(statistics.Abort(n_frames, 50));
+  EXPECT_EQ(distance, statistics.GetDistance());
+  EXPECT_NEAR(off_track_penalty, statistics.GetError(),
+              0.01 * off_track_penalty);
+}
+
+TEST(LapStatistics, BudgetIsAtMostLap) {
+  LapStatistics statistics(kOffTrackCte, kTrackLength);
+  statistics.Reset(2 * kTrackLength);
+  EXPECT_EQ(kTrackLength, statistics.GetBudget());
+  EXPECT_TRUE(statistics.IsFullLap());
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
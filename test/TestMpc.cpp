@@ -0,0 +1,73 @@
+#include <cmath>
+#include "gtest/gtest.h"
+#include "../src/Robot.h"
+#include "../src/Mpc.h"
+
+const auto kLf = 2.67;
+const auto kMaxSteeringAngle = 25. / 180. * M_PI;
+const auto kMphToMps = 1609.344 / (60. * 60.);
+const auto kSecondsPerFrame = 1. / 25.;
+
+// Drives the robot with MPC steering, returns the final CTE.
+double RunRobot(Robot& robot, Mpc& mpc, double speed, size_t n_iterations) {
+  double x = 0;
+  double y = 0;
+  double orientation = 0;
+  for (size_t i = 0; i < n_iterations; ++i) {
+    robot.Get(x, y, orientation);
+    auto steering = mpc.GetSteering(y, speed);
+    EXPECT_FALSE(std::isnan(steering));
+    EXPECT_LE(std::fabs(steering), 1.);
+    robot.Move(kMaxSteeringAngle * steering,
+               kMphToMps * speed * kSecondsPerFrame);
+  }
+  robot.Get(x, y, orientation);
+  return y;
+}
+
+TEST(Mpc, ConvergesAtLowSpeed) {
+  Mpc mpc(1000000000);
+  Robot robot(kLf);
+  robot.Set(0, 1, 0);
+  EXPECT_NEAR(RunRobot(robot, mpc, 20, 500), 0, 0.05);
+  EXPECT_EQ(500, mpc.GetSolveTimes().GetCount());
+  EXPECT_EQ(0, mpc.GetDeadlineMisses());
+}
+
+TEST(Mpc, ConvergesAtHighSpeed) {
+  Mpc mpc(1000000000);
+  Robot robot(kLf);
+  robot.Set(0, -2, 0.1);
+  EXPECT_NEAR(RunRobot(robot, mpc, 80, 500), 0, 0.05);
+}
+
+TEST(Mpc, SteersTowardsCenter) {
+  Mpc mpc(1000000000);
+  EXPECT_LT(mpc.GetSteering(1, 30), 0);
+  Mpc mpc2(1000000000);
+  EXPECT_GT(mpc2.GetSteering(-1, 30), 0);
+}
+
+TEST(Mpc, DeadlineOverrun) {
+  Mpc mpc(0);
+  EXPECT_TRUE(std::isnan(mpc.GetSteering(1, 30)));
+  EXPECT_EQ(1, mpc.GetDeadlineMisses());
+  EXPECT_EQ(1, mpc.GetSolveTimes().GetCount());
+}
+
+TEST(Mpc, PenalizesChangesAgainstAppliedSteering) {
+  Mpc mpc(1000000000);
+  Mpc mpc2(1000000000);
+  mpc.GetSteering(0.5, 30);
+  mpc2.GetSteering(0.5, 30);
+  // The fallback steered fully positive instead of following the solution
+  mpc2.SetApplied(2.);
+  EXPECT_GT(mpc2.GetSteering(0.5, 30), mpc.GetSteering(0.5, 30));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/NetworkImpairment.h"
+
+// Gets settings without impairment but the latency.
+NetworkImpairment::Settings GetSettings(double latency) {
+  return {latency, 0., NetworkImpairment::Distribution::kConstant, 0., 0.};
+}
+
+TEST(NetworkImpairment, DelaysByLatency) {
+  NetworkImpairment impairment(GetSettings(0.05), 1);
+  double delivery = 0.;
+  ASSERT_TRUE(impairment.Send(1., delivery));
+  EXPECT_DOUBLE_EQ(1.05, delivery);
+  ASSERT_TRUE(impairment.Send(1.02, delivery));
+  EXPECT_DOUBLE_EQ(1.07, delivery);
+}
+
+TEST(NetworkImpairment, DrawsJitterWithMean) {
+  for (const auto* name : {"uniform", "normal", "exponential", "pareto"}) {
+    auto settings = GetSettings(0.);
+    settings.jitter = 0.01;
+    ASSERT_TRUE(NetworkImpairment::GetDistribution(name,
+                                                   settings.distribution));
+    // Far apart, so the order does not hold the messages back
+    NetworkImpairment impairment(settings, 2);
+    const auto n_messages = 100000;
+    auto sum = 0.;
+    for (auto i = 0; i < n_messages; ++i) {
+      double delivery;
+      ASSERT_TRUE(impairment.Send(i, delivery));
+      ASSERT_GE(delivery, i);
+      sum += delivery - i;
+    }
+    EXPECT_NEAR(0.01, sum / n_messages, 0.001) << name;
+  }
+  NetworkImpairment::Distribution distribution;
+  EXPECT_FALSE(NetworkImpairment::GetDistribution("gamma", distribution));
+}
+
+TEST(NetworkImpairment, KeepsOrderUnlessReordered) {
+  auto settings = GetSettings(0.01);
+  settings.jitter = 0.05;
+  settings.distribution = NetworkImpairment::Distribution::kExponential;
+  ImpairedChannel<int> in_order(settings, 3);
+  settings.reorder_rate = 0.5;
+  ImpairedChannel<int> reordered(settings, 3);
+  for (auto i = 0; i < 1000; ++i) {
+    in_order.Send(0.001 * i, i);
+    reordered.Send(0.001 * i, i);
+  }
+  EXPECT_EQ(1000u, in_order.GetPendingCount());
+
+  std::vector<int> messages;
+  std::vector<double> deliveries;
+  EXPECT_EQ(0u, in_order.Receive(0.005, messages));
+  EXPECT_GE(in_order.GetNextDelivery(), 0.01);
+  EXPECT_EQ(1000u, in_order.Receive(100., messages, &deliveries));
+  for (auto i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i, messages[i]);
+    EXPECT_GE(deliveries[i], 0.001 * i + 0.01);
+  }
+  EXPECT_TRUE(std::is_sorted(deliveries.begin(), deliveries.end()));
+  EXPECT_EQ(0u, in_order.GetPendingCount());
+
+  messages.clear();
+  EXPECT_EQ(1000u, reordered.Receive(100., messages));
+  auto n_overtaking = 0;
+  for (auto i = 1; i < 1000; ++i) {
+    n_overtaking += messages[i] < messages[i - 1];
+  }
+  EXPECT_GT(n_overtaking, 0);
+}
+
+TEST(NetworkImpairment, DropsMessages) {
+  auto settings = GetSettings(0.);
+  settings.drop_rate = 0.25;
+  ImpairedChannel<std::string> channel(settings, 4);
+  for (auto i = 0; i < 10000; ++i) {
+    channel.Send(0.001 * i, "42[\"steer\",{}]");
+  }
+  EXPECT_NEAR(2500., channel.GetDroppedCount(), 200.);
+  EXPECT_EQ(10000u, channel.GetDroppedCount() + channel.GetPendingCount());
+}
+
+TEST(NetworkImpairment, OnlyDelaysUnimpairedMessages) {
+  auto settings = GetSettings(0.01);
+  settings.jitter = 0.05;
+  settings.reorder_rate = 0.5;
+  settings.drop_rate = 0.5;
+  ImpairedChannel<int> channel(settings, 5);
+  for (auto i = 0; i < 1000; ++i) {
+    channel.Send(0.001 * i, i, i % 2 == 0);
+  }
+  std::vector<int> messages;
+  channel.Receive(100., messages);
+  // Unimpaired messages all arrive, in the order of sending
+  std::vector<int> unimpaired;
+  for (auto message : messages) {
+    if (message % 2) {
+      unimpaired.push_back(message);
+    }
+  }
+  EXPECT_EQ(500u, unimpaired.size());
+  EXPECT_TRUE(std::is_sorted(unimpaired.begin(), unimpaired.end()));
+  EXPECT_GT(channel.GetDroppedCount(), 0u);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
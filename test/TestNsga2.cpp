@@ -0,0 +1,73 @@
+#include <cmath>
+#include <sstream>
+#include "gtest/gtest.h"
+#include "../src/Nsga2.h"
+
+// Schaffer's problem: the Pareto front is 0 <= x <= 2, infeasible if y > 1
+void Schaffer(const Tuner::ParameterSequence& p,
+              std::vector<double>& objectives,
+              double& violation) {
+  auto x = p[0].p;
+  objectives = {x * x, (x - 2) * (x - 2)};
+  violation = std::max(0., p[1].p - 1);
+}
+
+Nsga2::Individual MakeIndividual(double f1, double f2, double violation) {
+  Nsga2::Individual individual;
+  individual.objectives = {f1, f2};
+  individual.violation = violation;
+  return individual;
+}
+
+TEST(Nsga2, Dominates) {
+  EXPECT_TRUE(Nsga2::Dominates(MakeIndividual(1, 1, 0),
+                               MakeIndividual(1, 2, 0)));
+  EXPECT_FALSE(Nsga2::Dominates(MakeIndividual(1, 2, 0),
+                                MakeIndividual(2, 1, 0)));
+  EXPECT_FALSE(Nsga2::Dominates(MakeIndividual(1, 1, 0),
+                                MakeIndividual(1, 1, 0)));
+  // Feasible dominates infeasible, the smaller violation dominates
+  EXPECT_TRUE(Nsga2::Dominates(MakeIndividual(9, 9, 0),
+                               MakeIndividual(1, 1, 0.1)));
+  EXPECT_TRUE(Nsga2::Dominates(MakeIndividual(9, 9, 0.1),
+                               MakeIndividual(1, 1, 0.2)));
+}
+
+TEST(Nsga2, ConvergesToFront) {
+  Nsga2 nsga2({{5, 1}, {5, 1}}, 40, Schaffer, 4);
+  nsga2.Initialize();
+  for (auto generation = 0; generation < 30; ++generation) {
+    nsga2.Evolve();
+  }
+  EXPECT_EQ(31 * 40, nsga2.GetEvaluationCount());
+  auto front = nsga2.GetFront();
+  ASSERT_GE(front.size(), 20);
+  for (size_t i = 0; i < front.size(); ++i) {
+    EXPECT_GE(front[i].parameters[0].p, -0.05);
+    EXPECT_LE(front[i].parameters[0].p, 2.05);
+    EXPECT_LE(front[i].parameters[1].p, 1.);
+    EXPECT_EQ(0, front[i].rank);
+    if (i > 0) {
+      EXPECT_LE(front[i - 1].objectives[0], front[i].objectives[0]);
+      EXPECT_FALSE(Nsga2::Dominates(front[i - 1], front[i]));
+    }
+  }
+  // Spread along the whole front
+  EXPECT_LT(front.front().objectives[0], 0.05);
+  EXPECT_LT(front.back().objectives[1], 0.05);
+}
+
+TEST(Nsga2, WriteCsv) {
+  auto individual = MakeIndividual(1, 2, 0);
+  individual.parameters = {{0.5, 1}};
+  std::ostringstream oss;
+  Nsga2::WriteCsv(oss, {individual}, {"x"}, {"f1", "f2"});
+  EXPECT_EQ("x,f1,f2\n0.5,1,2\n", oss.str());
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <fstream>
+#include "gtest/gtest.h"
+#include "../src/OffsetProfile.h"
+
+const auto kPath = "test_offset_profile.csv";
+
+TEST(OffsetProfile, LooksUpBucketsAroundTheLap) {
+  OffsetProfile profile;
+  EXPECT_FALSE(profile.IsLoaded());
+  EXPECT_FALSE(profile.SetOffsets(0., {1.}));
+  EXPECT_FALSE(profile.SetOffsets(5., {}));
+  ASSERT_TRUE(profile.SetOffsets(5., {0., 1., -2.}));
+  EXPECT_TRUE(profile.IsLoaded());
+  EXPECT_EQ(15., profile.GetLength());
+  EXPECT_EQ(0., profile.GetOffset(0.));
+  EXPECT_EQ(0., profile.GetOffset(4.99));
+  EXPECT_EQ(1., profile.GetOffset(5.));
+  EXPECT_EQ(-2., profile.GetOffset(14.99));
+  EXPECT_EQ(0., profile.GetOffset(15.));
+  EXPECT_EQ(1., profile.GetOffset(3. * 15. + 7.));
+}
+
+TEST(OffsetProfile, SavesAndLoads) {
+  OffsetProfile profile;
+  ASSERT_TRUE(profile.SetOffsets(4.7, {0.25, -1.5, 0.75, 1.125}));
+  ASSERT_TRUE(profile.Save(kPath));
+  OffsetProfile loaded;
+  ASSERT_TRUE(loaded.Load(kPath));
+  EXPECT_DOUBLE_EQ(4.7, loaded.GetBucketLength());
+  EXPECT_EQ(profile.GetOffsets(), loaded.GetOffsets());
+  std::remove(kPath);
+}
+
+TEST(OffsetProfile, RejectsUnevenBuckets) {
+  OffsetProfile profile;
+  EXPECT_FALSE(profile.Load(kPath));
+  {
+    std::ofstream file(kPath);
+    file << "distance,offset" << std::endl << "0,1" << std::endl << "5,0"
+         << std::endl << "11,-1" << std::endl;
+  }
+  EXPECT_FALSE(profile.Load(kPath));
+  {
+    std::ofstream file(kPath);
+    file << "0 1" << std::endl << "5 0" << std::endl << "10 -1" << std::endl;
+  }
+  EXPECT_TRUE(profile.Load(kPath));
+  EXPECT_EQ(-1., profile.GetOffset(12.));
+  std::remove(kPath);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
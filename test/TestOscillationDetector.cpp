@@ -0,0 +1,95 @@
+#include <cmath>
+#include "gtest/gtest.h"
+#include "../src/Simulator.h"
+#include "../src/OscillationDetector.h"
+#include "../src/Pid.h"
+#include "../src/PidController.h"
+
+const auto kOffTrackCte = 2.0;
+const auto kPeriod = 32.;
+
+// Feeds a sinusoid with the given growth per frame until the detector reports
+// divergence, the amplitude exceeds the off-track CTE or 1000 frames pass.
+// @return  Frame of detection, or -1
+int Detect(OscillationDetector& detector, double amplitude, double growth) {
+  for (auto i = 0;
+       i < 1000 && amplitude * std::exp(growth * i) < kOffTrackCte; ++i) {
+    auto cte = 0.3 + amplitude * std::exp(growth * i)
+                     * std::sin(2. * M_PI * i / kPeriod);
+    if (detector.Update(cte)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Drives the offline simulator with PID coefficients.
+// @param[out] detection  Frame of detecting divergence, or -1
+// @return                Frame of getting off track, or -1
+int Drive(double kp, double kd, int& detection) {
+  Pid pid(kp, 0., kd);
+  Simulator simulator(100., 1., 1. / 180. * M_PI, 0.5 / 180. * M_PI);
+  OscillationDetector detector(kOffTrackCte);
+  detection = -1;
+  for (auto i = 0; i < 3000; ++i) {
+    auto cte = simulator.GetCte();
+    auto speed = simulator.GetSpeed();
+    if (std::fabs(cte) > kOffTrackCte) {
+      return i;
+    }
+    if (detector.Update(cte) && detection < 0) {
+      detection = i;
+    }
+    auto steering = std::max(-1., std::min(1., pid.GetSteering(cte, speed)));
+    simulator.Control(steering, PidController::ComputeThrottle(
+      cte, speed, kOffTrackCte));
+  }
+  return -1;
+}
+
+TEST(OscillationDetector, GrowingSinusoid) {
+  OscillationDetector detector(kOffTrackCte);
+  auto growth = std::log(1.5) / OscillationDetector::kWindow;
+  auto detection = Detect(detector, 0.1, growth);
+  ASSERT_GT(detection, 0);
+  EXPECT_NEAR(growth, detector.GetGrowthRate(), 0.1 * growth);
+  EXPECT_GE(detector.GetCrossingCount(), 3);
+  EXPECT_LE(detector.GetCrossingCount(), 5);
+
+  // The prediction is within a window of the actual frame getting off track
+  auto off_track = std::log((kOffTrackCte - 0.3) / 0.1) / growth;
+  EXPECT_NEAR(off_track, detection + detector.GetFramesToOffTrack(),
+              OscillationDetector::kWindow);
+}
+
+TEST(OscillationDetector, SteadyOrDecayingSinusoid) {
+  OscillationDetector detector(kOffTrackCte);
+  for (auto i = 0; i < 1000; ++i) {
+    EXPECT_FALSE(detector.Update(1.5 * std::sin(2. * M_PI * i / kPeriod)));
+  }
+  EXPECT_NEAR(1.5, detector.GetAmplitude(), 0.1);
+  EXPECT_GT(detector.GetFramesToOffTrack(), 1e+6);
+  detector.Reset();
+  EXPECT_EQ(0, detector.GetAmplitude());
+  EXPECT_EQ(-1, Detect(detector, 1.5, -0.01));
+}
+
+TEST(OscillationDetector, Simulator) {
+  // Too much Kp and too little Kd diverge, detected ahead of getting off track
+  int detection;
+  auto off_track = Drive(0.3, 0.05, detection);
+  ASSERT_GT(off_track, 0);
+  EXPECT_GT(detection, 0);
+  EXPECT_LT(detection, off_track);
+
+  // Tuned coefficients never trigger the detector
+  EXPECT_EQ(-1, Drive(0.12, 4., detection));
+  EXPECT_EQ(-1, detection);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
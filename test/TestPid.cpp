@@ -1,5 +1,5 @@
 #include "gtest/gtest.h"
-#include "Robot.h"
+#include "../src/Robot.h"
 #include "../src/Pid.h"
 
 void RunRobot(Robot& robot,
@@ -1,6 +1,10 @@
+#include <cmath>
+#include <cstdio>
+#include <vector>
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
-#include "Robot.h"
+#include "../src/Robot.h"
+#include "../src/Simulator.h"
 #include "../src/PidController.h"
 
 const auto kKp = 0.1;
@@ -21,6 +25,17 @@ public:
   MOCK_METHOD0(OnReset, void());
 };
 
+// Tuner trying the same parameters with the same deltas, like one sampling
+// the whole space
+class FixedTuner : public Tuner {
+public:
+  FixedTuner(const ParameterSequence& parameters) : parameters_(parameters) {}
+  ParameterSequence UpdateError(double) override { return parameters_; }
+
+private:
+  ParameterSequence parameters_;
+};
+
 TEST(PidController, FinalCoefficients) {
   User user;
   PidController pid_controller(kKp, kKi, kKd, kOffTrackCte);
@@ -100,10 +115,313 @@ TEST(PidController, InitialCoefficientsTrackComplete) {
                           std::bind(&User::OnControl, &user, _1, _2),
                           std::bind(&User::OnReset, &user)); 
   }
+  EXPECT_EQ(0u, pid_controller.GetLapCount());
   EXPECT_CALL(user, OnReset()).Times(1);
   pid_controller.Update(4.99, 100,
                         std::bind(&User::OnControl, &user, _1, _2),
                         std::bind(&User::OnReset, &user)); 
+  EXPECT_EQ(1u, pid_controller.GetLapCount());
+}
+
+TEST(PidController, RestartDropsPartialEvaluation) {
+  User user;
+  PidController pid_controller(kKp, kKi, kKd, kOffTrackCte,
+                               kdKp, kdKi, kdKd, 10);
+  EXPECT_CALL(user, OnControl(_, _)).Times(8);
+  for (auto i = 0; i < 3; ++i) {
+    pid_controller.Update(4.99, 100,
+                          std::bind(&User::OnControl, &user, _1, _2),
+                          std::bind(&User::OnReset, &user));
+  }
+  // The track is driven from the start again
+  pid_controller.Restart();
+  for (auto i = 0; i < 5; ++i) {
+    pid_controller.Update(4.99, 100,
+                          std::bind(&User::OnControl, &user, _1, _2),
+                          std::bind(&User::OnReset, &user));
+  }
+  EXPECT_CALL(user, OnReset()).Times(1);
+  pid_controller.Update(4.99, 100,
+                        std::bind(&User::OnControl, &user, _1, _2),
+                        std::bind(&User::OnReset, &user));
+  EXPECT_EQ(1u, pid_controller.GetLapCount());
+}
+
+TEST(PidController, StanleyOffTrack) {
+  User user;
+  PidController pid_controller(2, 1, 0.8, kOffTrackCte, 0.1, 0.1, 0.1, 10);
+  pid_controller.SetSteeringBackend(SteeringBackend::kStanley, 0);
+  double steering;
+  double throttle;
+  for (auto i = 0; i < 5; ++i) {
+    EXPECT_CALL(user, OnControl(_, _))
+      .Times(1)
+      .WillOnce(DoAll(SaveArg<0>(&steering), SaveArg<1>(&throttle)));
+    pid_controller.Update(1, 100,
+                          std::bind(&User::OnControl, &user, _1, _2),
+                          std::bind(&User::OnReset, &user));
+  }
+  EXPECT_LT(steering, 0);
+  EXPECT_CALL(user, OnReset()).Times(1);
+  pid_controller.Update(5.01, 100,
+                        std::bind(&User::OnControl, &user, _1, _2),
+                        std::bind(&User::OnReset, &user));
+}
+
+TEST(PidController, StoredErrorsAreReused) {
+  const auto path = "test_pid_controller.exp";
+  std::remove(path);
+  auto store = std::make_shared<ExperimentStore>();
+  ASSERT_TRUE(store->Open(path));
+  User user;
+  EXPECT_CALL(user, OnControl(_, _)).Times(::testing::AnyNumber());
+  EXPECT_CALL(user, OnReset()).Times(3);
+  double kp, ki, kd;
+  for (auto session = 0; session < 2; ++session) {
+    PidController pid_controller(kKp, kKi, kKd, kOffTrackCte,
+                                 kdKp, kdKi, kdKd, 10);
+    pid_controller.SetExperimentStore(store, 0);
+    // The first session drives the initial coefficients and Kp + dKp off
+    // track, the second one only the initial coefficients
+    for (auto lap = 0; lap < 2 - session; ++lap) {
+      pid_controller.Update(4.99, 100,
+                            std::bind(&User::OnControl, &user, _1, _2),
+                            std::bind(&User::OnReset, &user));
+      pid_controller.Update(5.01, 100,
+                            std::bind(&User::OnControl, &user, _1, _2),
+                            std::bind(&User::OnReset, &user));
+    }
+    pid_controller.GetCoefficients(kp, ki, kd);
+  }
+  // The second session skips Kp + dKp evaluated by the first one
+  EXPECT_NEAR(kKp - kdKp, kp, 1e-12);
+  EXPECT_EQ(3, store->GetCount());
+  std::remove(path);
+}
+
+// Drives at constant CTE until the controller resets the simulator or gets the
+// final coefficients.
+void DriveLap(PidController& pid_controller, double cte) {
+  auto is_reset = false;
+  while (!is_reset && !pid_controller.HasFinalCoefficients()) {
+    pid_controller.Update(cte, 100, [](double, double) { },
+                          [&is_reset]() { is_reset = true; });
+  }
+}
+
+TEST(PidController, LapBudgetLocksInBestCoefficients) {
+  PidController pid_controller(kKp, kKi, kKd, kOffTrackCte,
+                               kdKp, kdKi, kdKd, 10);
+  PidController::TuningLimits limits = {};
+  limits.max_laps = 2.2;
+  pid_controller.SetTuningLimits(limits);
+  PidController::TuningSummary summary = {};
+  pid_controller.SetOnTuned(
+    [&summary](const PidController::TuningSummary& s) { summary = s; });
+  std::vector<PidController::Evaluation> evaluations;
+  pid_controller.SetOnEvaluated(
+    [&evaluations](const PidController::Evaluation& e) {
+      evaluations.push_back(e);
+    });
+  // Above the target CTE, off track, and worse than the first lap
+  DriveLap(pid_controller, 4);
+  DriveLap(pid_controller, 5.01);
+  EXPECT_FALSE(pid_controller.HasFinalCoefficients());
+  DriveLap(pid_controller, 4.5);
+  ASSERT_TRUE(pid_controller.HasFinalCoefficients());
+  ASSERT_EQ(3u, evaluations.size());
+  EXPECT_EQ(kKp, evaluations[0].coefficients[0]);
+  EXPECT_NEAR(16, evaluations[0].error, 1e-9);
+  EXPECT_TRUE(evaluations[0].is_full_lap);
+  EXPECT_GT(evaluations[1].error, evaluations[0].error);
+  EXPECT_EQ(PidController::TuningOutcome::kLapBudget, summary.outcome);
+  EXPECT_EQ(3, summary.n_evaluations);
+  EXPECT_NEAR(16, summary.error, 1e-9);
+  EXPECT_GE(summary.laps, 2.2);
+  double kp, ki, kd;
+  pid_controller.GetCoefficients(kp, ki, kd);
+  EXPECT_EQ(kKp, kp);
+  EXPECT_EQ(kKi, ki);
+  EXPECT_EQ(kKd, kd);
+  EXPECT_EQ(kKp, summary.coefficients[0]);
+}
+
+TEST(PidController, ReusedErrorsAreBestCoefficients) {
+  const auto path = "test_pid_controller_best.exp";
+  std::remove(path);
+  auto store = std::make_shared<ExperimentStore>();
+  ASSERT_TRUE(store->Open(path));
+  const double kStored[] = {kKp + kdKp, kKi, kKd};
+  ASSERT_TRUE(store->Append(0, kStored, 1., 1.));
+  PidController pid_controller(kKp, kKi, kKd, kOffTrackCte,
+                               kdKp, kdKi, kdKd, 10);
+  pid_controller.SetExperimentStore(store, 0);
+  PidController::TuningLimits limits = {};
+  limits.max_laps = 1.5;
+  pid_controller.SetTuningLimits(limits);
+  PidController::TuningSummary summary = {};
+  pid_controller.SetOnTuned(
+    [&summary](const PidController::TuningSummary& s) { summary = s; });
+  // Kp + dKp is reused with a better error than both driven laps
+  DriveLap(pid_controller, 4);
+  DriveLap(pid_controller, 4);
+  ASSERT_TRUE(pid_controller.HasFinalCoefficients());
+  EXPECT_EQ(2, summary.n_evaluations);
+  EXPECT_EQ(1., summary.error);
+  EXPECT_EQ(kKp + kdKp, summary.coefficients[0]);
+  double kp, ki, kd;
+  pid_controller.GetCoefficients(kp, ki, kd);
+  EXPECT_EQ(kKp + kdKp, kp);
+  std::remove(path);
+}
+
+TEST(PidController, ConvergedAndStalledTuningStops) {
+  PidController::TuningLimits limits = {};
+  limits.min_delta_sum = 10;
+  PidController converged(kKp, kKi, kKd, kOffTrackCte, kdKp, kdKi, kdKd, 10);
+  converged.SetTuningLimits(limits);
+  auto outcome = PidController::TuningOutcome::kTarget;
+  converged.SetOnTuned([&outcome](const PidController::TuningSummary& s) {
+    outcome = s.outcome;
+  });
+  // The sum of relative deltas is 3
+  DriveLap(converged, 4);
+  EXPECT_TRUE(converged.HasFinalCoefficients());
+  EXPECT_EQ(PidController::TuningOutcome::kConverged, outcome);
+
+  // Tuners keeping their deltas don't converge by them, and stall after an
+  // evaluation per coefficient
+  limits.max_stalled_cycles = 1;
+  PidController fixed(kKp, kKi, kKd, kOffTrackCte, kdKp, kdKi, kdKd, 10);
+  fixed.SetTuner(std::unique_ptr<Tuner>(new FixedTuner(
+    {{kKp, kdKp, Tuner::Transform::kLinear, 0., 0.},
+     {kKi, kdKi, Tuner::Transform::kLinear, 0., 0.},
+     {kKd, kdKd, Tuner::Transform::kLinear, 0., 0.}})));
+  fixed.SetTuningLimits(limits);
+  fixed.SetOnTuned([&outcome](const PidController::TuningSummary& s) {
+    outcome = s.outcome;
+  });
+  DriveLap(fixed, 4);
+  for (auto i = 0; i < 2; ++i) {
+    DriveLap(fixed, 5.01);
+    EXPECT_FALSE(fixed.HasFinalCoefficients());
+  }
+  DriveLap(fixed, 5.01);
+  EXPECT_TRUE(fixed.HasFinalCoefficients());
+  EXPECT_EQ(PidController::TuningOutcome::kStalled, outcome);
+
+  limits = {};
+  limits.max_stalled_cycles = 1;
+  PidController stalled(kKp, kKi, kKd, kOffTrackCte, kdKp, kdKi, kdKd, 10);
+  stalled.SetTuningLimits(limits);
+  stalled.SetOnTuned([&outcome](const PidController::TuningSummary& s) {
+    outcome = s.outcome;
+  });
+  DriveLap(stalled, 4);
+  // A cycle of twiddle without a better error tries both directions of
+  // every coefficient
+  for (auto i = 0; i < 5; ++i) {
+    DriveLap(stalled, 5.01);
+    EXPECT_FALSE(stalled.HasFinalCoefficients());
+  }
+  DriveLap(stalled, 5.01);
+  EXPECT_TRUE(stalled.HasFinalCoefficients());
+  EXPECT_EQ(PidController::TuningOutcome::kStalled, outcome);
+}
+
+TEST(PidController, DivergingOscillationIsAborted) {
+  // Too much Kp and too little Kd ring, and the first deltas make it worse
+  PidController pid_controller(0.3, 0., 0.05, 2., -0.1, 0., 0.05, 1000);
+  Simulator simulator(100., 1., 1. / 180. * M_PI, 0.5 / 180. * M_PI);
+  for (auto i = 0; i < 3000 && !pid_controller.HasFinalCoefficients(); ++i) {
+    pid_controller.Update(simulator.GetCte(), simulator.GetSpeed(),
+                          std::bind(&Simulator::Control, &simulator, _1, _2),
+                          std::bind(&Simulator::Reset, &simulator));
+  }
+  EXPECT_GT(pid_controller.GetAbortedCount(), 0);
+  EXPECT_GT(pid_controller.GetSavedFrameCount(), 0);
+}
+
+TEST(PidController, OffsetProfileShiftsTheLine) {
+  // The line is 1m left of the centerline for the first 100m, 1m right of it
+  // after
+  std::shared_ptr<OffsetProfile> profile(new OffsetProfile());
+  ASSERT_TRUE(profile->SetOffsets(100., {1., -1.}));
+  PidController pid_controller(kKp, kKi, kKd, kOffTrackCte);
+  pid_controller.SetOffsetProfile(profile);
+  Simulator simulator(30., 0.);
+  auto is_left = false;
+  auto is_right = false;
+  while (simulator.GetDistance() < 190.) {
+    auto cte = simulator.GetCte();
+    if (simulator.GetDistance() > 70. && simulator.GetDistance() < 95.) {
+      is_left = true;
+      EXPECT_NEAR(1., cte, 0.1);
+    }
+    if (simulator.GetDistance() > 170.) {
+      is_right = true;
+      EXPECT_NEAR(-1., cte, 0.1);
+    }
+    pid_controller.Update(cte, simulator.GetSpeed(),
+                          std::bind(&Simulator::Control, &simulator, _1, _2),
+                          std::bind(&Simulator::Reset, &simulator));
+  }
+  EXPECT_TRUE(is_left && is_right);
+}
+
+TEST(PidController, CountsLapsOfTheProfile) {
+  // Without a track length, laps of final coefficients are the profile length
+  std::shared_ptr<OffsetProfile> profile(new OffsetProfile());
+  ASSERT_TRUE(profile->SetOffsets(50., {0., 0.}));
+  PidController pid_controller(kKp, kKi, kKd, kOffTrackCte);
+  pid_controller.SetOffsetProfile(profile);
+  Simulator simulator(30., 0.);
+  while (simulator.GetDistance() < 250.) {
+    // Away from the lap boundaries, the distance of the controller is within
+    // a few meters of the driven one
+    auto distance = simulator.GetDistance();
+    if (std::fmod(distance, 100.) > 5. && std::fmod(distance, 100.) < 95.) {
+      EXPECT_EQ(static_cast<unsigned long int>(distance / 100.),
+                pid_controller.GetLapCount());
+    }
+    pid_controller.Update(simulator.GetCte(), simulator.GetSpeed(),
+                          std::bind(&Simulator::Control, &simulator, _1, _2),
+                          std::bind(&Simulator::Reset, &simulator));
+  }
+  EXPECT_EQ(2u, pid_controller.GetLapCount());
+}
+
+TEST(PidController, ResetMatchesNewController) {
+  // A reused Stanley controller with the offset profile steers as a new one
+  std::shared_ptr<OffsetProfile> profile(new OffsetProfile());
+  ASSERT_TRUE(profile->SetOffsets(50., {0., 0.5}));
+  PidController reused(2, 1, 0.8, kOffTrackCte);
+  reused.SetOffsetProfile(profile);
+  reused.SetSteeringBackend(SteeringBackend::kStanley, 0);
+  Simulator simulator(30., 1.);
+  while (simulator.GetDistance() < 150.) {
+    reused.Update(simulator.GetCte(), simulator.GetSpeed(),
+                  std::bind(&Simulator::Control, &simulator, _1, _2),
+                  std::bind(&Simulator::Reset, &simulator));
+  }
+  EXPECT_EQ(1u, reused.GetLapCount());
+  reused.Reset();
+  EXPECT_EQ(0u, reused.GetLapCount());
+
+  PidController created(2, 1, 0.8, kOffTrackCte);
+  created.SetOffsetProfile(profile);
+  created.SetSteeringBackend(SteeringBackend::kStanley, 0);
+  Simulator reused_simulator(30., 1.);
+  Simulator created_simulator(30., 1.);
+  for (auto i = 0; i < 100; ++i) {
+    reused.Update(reused_simulator.GetCte(), reused_simulator.GetSpeed(),
+                  std::bind(&Simulator::Control, &reused_simulator, _1, _2),
+                  std::bind(&Simulator::Reset, &reused_simulator));
+    created.Update(created_simulator.GetCte(), created_simulator.GetSpeed(),
+                   std::bind(&Simulator::Control, &created_simulator, _1, _2),
+                   std::bind(&Simulator::Reset, &created_simulator));
+    ASSERT_EQ(created_simulator.GetCte(), reused_simulator.GetCte());
+  }
 }
 
 int main(int argc, char **argv)
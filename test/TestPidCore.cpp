@@ -0,0 +1,134 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/PidCore.h"
+#include "../src/PidController.h"
+
+const auto kKp = 0.12;
+const auto kKi = 1e-5;
+const auto kKd = 4.0;
+const auto kOffTrackCte = 5.0;
+
+TEST(PidCore, InvalidArgumentsGiveNoSession) {
+  EXPECT_EQ(PIDCORE_VERSION, pidcore_get_version());
+  EXPECT_EQ(nullptr, pidcore_session_create(kKp, kKi, kKd, 0.));
+  EXPECT_EQ(nullptr, pidcore_session_create_tuning(kKp, kKi, kKd, kOffTrackCte,
+                                                   0.01, 1e-5, 0.1, -1.));
+  EXPECT_EQ(nullptr, pidcore_twiddler_create(nullptr, nullptr, 0));
+}
+
+TEST(PidCore, BatchMatchesController) {
+  const size_t kFrameCount = 500;
+  std::vector<double> ctes(kFrameCount);
+  std::vector<double> speeds(kFrameCount, 40.);
+  for (size_t i = 0; i < kFrameCount; ++i) {
+    ctes[i] = 2. * std::sin(0.03 * i);
+  }
+  std::vector<double> steering(kFrameCount);
+  std::vector<double> throttle(kFrameCount);
+  auto session = pidcore_session_create(kKp, kKi, kKd, kOffTrackCte);
+  ASSERT_NE(nullptr, session);
+  EXPECT_EQ(0u, pidcore_session_update_batch(session, ctes.data(),
+                                             speeds.data(), kFrameCount,
+                                             steering.data(),
+                                             throttle.data()));
+  double coefficients[3];
+  pidcore_session_get_coefficients(session, coefficients);
+  EXPECT_EQ(kKp, coefficients[0]);
+  EXPECT_EQ(kKi, coefficients[1]);
+  EXPECT_EQ(kKd, coefficients[2]);
+  pidcore_session_destroy(session);
+
+  PidController controller(kKp, kKi, kKd, kOffTrackCte);
+  for (size_t i = 0; i < kFrameCount; ++i) {
+    controller.Update(ctes[i], speeds[i],
+                      [&](double expected_steering, double expected_throttle) {
+                        EXPECT_DOUBLE_EQ(expected_steering, steering[i]);
+                        EXPECT_DOUBLE_EQ(expected_throttle, throttle[i]);
+                      },
+                      []() { FAIL(); });
+  }
+}
+
+TEST(PidCore, TuningResetsAreNaN) {
+  auto session = pidcore_session_create_tuning(kKp, kKi, kKd, kOffTrackCte,
+                                               0.01, 1e-5, 0.1, 10.);
+  ASSERT_NE(nullptr, session);
+  const double ctes[] = {0.5, 2. * kOffTrackCte, 0.5};
+  const double speeds[] = {30., 30., 30.};
+  double steering[3];
+  double throttle[3];
+  EXPECT_EQ(1u, pidcore_session_update_batch(session, ctes, speeds, 3,
+                                             steering, throttle));
+  EXPECT_FALSE(std::isnan(steering[0]));
+  EXPECT_TRUE(std::isnan(steering[1]));
+  EXPECT_TRUE(std::isnan(throttle[1]));
+
+  // The next coefficients of Twiddle are evaluated after the reset
+  double coefficients[3];
+  pidcore_session_get_coefficients(session, coefficients);
+  EXPECT_NE(kKp, coefficients[0]);
+  pidcore_session_destroy(session);
+}
+
+TEST(PidCore, SessionsInLockstep) {
+  const size_t kSessionCount = 100;
+  std::vector<pidcore_session*> sessions;
+  std::vector<double> ctes;
+  for (size_t i = 0; i < kSessionCount; ++i) {
+    sessions.push_back(pidcore_session_create(kKp, kKi, kKd, kOffTrackCte));
+    ctes.push_back(0.01 * i);
+  }
+  std::vector<double> speeds(kSessionCount, 30.);
+  std::vector<double> steering(kSessionCount);
+  std::vector<double> throttle(kSessionCount);
+  EXPECT_EQ(0u, pidcore_sessions_update(sessions.data(), ctes.data(),
+                                        speeds.data(), kSessionCount,
+                                        steering.data(), throttle.data()));
+  for (size_t i = 0; i < kSessionCount; ++i) {
+    double expected_steering;
+    double expected_throttle;
+    auto session = pidcore_session_create(kKp, kKi, kKd, kOffTrackCte);
+    EXPECT_EQ(1, pidcore_session_update(session, ctes[i], speeds[i],
+                                        &expected_steering,
+                                        &expected_throttle));
+    EXPECT_EQ(expected_steering, steering[i]);
+    EXPECT_EQ(expected_throttle, throttle[i]);
+    pidcore_session_destroy(session);
+    pidcore_session_destroy(sessions[i]);
+  }
+}
+
+TEST(PidCore, ShadowCandidates) {
+  auto session = pidcore_session_create(kKp, kKi, kKd, kOffTrackCte);
+  EXPECT_EQ(1, pidcore_session_add_shadow(session, 2. * kKp, kKi, kKd));
+  double steering;
+  double throttle;
+  pidcore_session_update(session, 1., 30., &steering, &throttle);
+  pidcore_session_update(session, 1.5, 30., &steering, &throttle);
+  double statistics[3];
+  EXPECT_EQ(0, pidcore_session_get_shadow_statistics(session, 1, statistics));
+  ASSERT_EQ(1, pidcore_session_get_shadow_statistics(session, 0, statistics));
+  EXPECT_GT(statistics[0], 0.);
+  EXPECT_GE(statistics[1], statistics[0]);
+  pidcore_session_destroy(session);
+}
+
+TEST(PidCore, TwiddlerSteps) {
+  const double p[] = {1., 2.};
+  const double dp[] = {0.5, 0.25};
+  auto twiddler = pidcore_twiddler_create(p, dp, 2);
+  ASSERT_NE(nullptr, twiddler);
+  double next[2];
+  pidcore_twiddler_update(twiddler, 1., next);
+  EXPECT_DOUBLE_EQ(1.5, next[0]);
+  EXPECT_DOUBLE_EQ(2., next[1]);
+  pidcore_twiddler_destroy(twiddler);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/RacingLine.h"
+#include "../src/Track.h"
+
+const RacingLine::Settings kSettings = {
+  5.,   // bucket_length
+  2.,   // max_offset
+  44.,  // max_speed
+  8.,   // max_lateral_acceleration
+  6.,   // max_acceleration
+  8.};  // max_deceleration
+
+// Sets a counterclockwise stadium of two straights and two half circles.
+// @param track     Track
+// @param straight  Length of the straights in meters
+// @param radius    Radius of the half circles in meters
+void SetStadium(Track& track, double straight, double radius) {
+  std::vector<double> x;
+  std::vector<double> y;
+  for (auto side = 0; side < 2; ++side) {
+    auto sign = side ? -1. : 1.;
+    for (auto s = 0.; s < straight; s += 20.) {
+      x.push_back(sign * (s - 0.5 * straight));
+      y.push_back(-sign * radius);
+    }
+    for (auto i = 0; i < 12; ++i) {
+      auto angle = -0.5 * M_PI + M_PI * i / 12;
+      x.push_back(sign * (0.5 * straight + radius * std::cos(angle)));
+      y.push_back(sign * radius * std::sin(angle));
+    }
+  }
+  ASSERT_TRUE(track.SetCenterline(x, y));
+}
+
+TEST(RacingLine, CircleHugsTheInside) {
+  std::vector<double> x;
+  std::vector<double> y;
+  for (auto i = 0; i < 24; ++i) {
+    x.push_back(50. * std::cos(2. * M_PI * i / 24));
+    y.push_back(50. * std::sin(2. * M_PI * i / 24));
+  }
+  Track track;
+  ASSERT_TRUE(track.SetCenterline(x, y));
+  RacingLine line(track, kSettings);
+  EXPECT_EQ(63u, line.GetOffsets().size());
+  EXPECT_NEAR(track.GetLength() / 63, line.GetBucketLength(), 1e-9);
+  auto center_time = line.GetLapTime();
+  // Lateral acceleration limits the speed, the lap time is 2 pi sqrt(R / a)
+  EXPECT_NEAR(2. * M_PI * std::sqrt(50. / 8.), center_time,
+              0.01 * center_time);
+  EXPECT_GT(line.Optimize(100, 2), 0u);
+  for (auto offset : line.GetOffsets()) {
+    // Inside the counterclockwise circle is left of the centerline
+    EXPECT_NEAR(kSettings.max_offset, offset, 0.05);
+  }
+  EXPECT_NEAR(2. * M_PI * std::sqrt(48. / 8.), line.GetLapTime(),
+              0.01 * center_time);
+}
+
+TEST(RacingLine, StadiumTurnsInFromOutside) {
+  Track track;
+  SetStadium(track, 200., 40.);
+  RacingLine line(track, kSettings);
+  auto center_time = line.GetLapTime();
+  EXPECT_GT(line.Optimize(300, 4), 0u);
+  EXPECT_LT(line.GetLapTime(), 0.97 * center_time);
+  const auto& offsets = line.GetOffsets();
+  for (auto offset : offsets) {
+    EXPECT_LE(std::fabs(offset), kSettings.max_offset);
+  }
+  // The lap starts at the start of a straight, the line approaches both
+  // turns from outside, and keeps inside through them
+  auto turn_length = M_PI * 40.;
+  for (auto turn : {200., 400. + turn_length}) {
+    auto begin = static_cast<size_t>(turn / line.GetBucketLength());
+    auto end = static_cast<size_t>((turn + turn_length)
+                                   / line.GetBucketLength());
+    EXPECT_LT(offsets[begin - 3], -0.2 * kSettings.max_offset);
+    auto sum_offset = 0.;
+    for (auto i = begin; i < end; ++i) {
+      sum_offset += offsets[i];
+    }
+    EXPECT_GT(sum_offset / (end - begin), 0.1 * kSettings.max_offset);
+  }
+}
+
+TEST(RacingLine, ThreadsFindTheSameLine) {
+  Track track;
+  SetStadium(track, 100., 30.);
+  RacingLine single(track, kSettings);
+  RacingLine multiple(track, kSettings);
+  EXPECT_EQ(single.Optimize(50, 1), multiple.Optimize(50, 8));
+  EXPECT_EQ(single.GetOffsets(), multiple.GetOffsets());
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/Simulator.h"
+#include "../src/PidController.h"
+#include "../src/Session.h"
+
+const auto kKp = 0.12;
+const auto kKi = 1e-5;
+const auto kKd = 4.0;
+const auto kOffTrackCte = 5.0;
+
+TEST(Session, FitsTwoCacheLines) {
+  EXPECT_LE(sizeof(Session), 128u);
+  EXPECT_EQ(0u, alignof(Session) % 64);
+}
+
+TEST(Session, InlinePidMatchesController) {
+  SessionPool sessions;
+  auto session = sessions.Acquire(kKp, kKi, kKd, kOffTrackCte);
+  EXPECT_EQ(nullptr, session->GetController());
+  PidController controller(kKp, kKi, kKd, kOffTrackCte);
+  Simulator simulator(50., 2., 1. / 180. * M_PI, 0.5 / 180. * M_PI);
+  for (auto i = 0; i < 1000; ++i) {
+    auto cte = simulator.GetCte();
+    auto speed = simulator.GetSpeed();
+    double expected_steering = 0;
+    double expected_throttle = 0;
+    controller.Update(cte, speed,
+                      [&](double steering, double throttle) {
+                        expected_steering = steering;
+                        expected_throttle = throttle;
+                      },
+                      []() { });
+    double steering;
+    double throttle;
+    ASSERT_TRUE(session->Update(cte, speed, steering, throttle));
+    ASSERT_DOUBLE_EQ(expected_steering, steering);
+    ASSERT_DOUBLE_EQ(expected_throttle, throttle);
+    simulator.Control(steering, throttle);
+  }
+  sessions.Release(session);
+  EXPECT_EQ(0u, sessions.GetCount());
+}
+
+TEST(Session, ControllerResetIsReported) {
+  SessionPool sessions;
+  auto session = sessions.Acquire(std::unique_ptr<PidController>(
+    new PidController(kKp, kKi, kKd, kOffTrackCte, 0.01, 1e-5, 0.1, 10)));
+  ASSERT_NE(nullptr, session->GetController());
+  double steering;
+  double throttle;
+  EXPECT_TRUE(session->Update(0.5, 30., steering, throttle));
+  EXPECT_FALSE(session->Update(2. * kOffTrackCte, 30., steering, throttle));
+  sessions.Release(session);
+}
+
+TEST(SessionPool, SlotsAreDenseAndReused) {
+  SessionPool sessions;
+  std::vector<Session*> created;
+  for (auto i = 0; i < SessionPool::kSlabSessionCount; ++i) {
+    created.push_back(sessions.Acquire(kKp, kKi, kKd, kOffTrackCte));
+  }
+  EXPECT_EQ(SessionPool::kSlabSessionCount * sizeof(Session),
+            sessions.GetReservedSize());
+  for (size_t i = 0; i < created.size(); ++i) {
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(created[i]) % alignof(Session));
+    EXPECT_EQ(created[0] + i, created[i]);
+  }
+
+  // Released sessions are reset in place before a new slab is allocated
+  auto released = created[10];
+  sessions.Release(released);
+  EXPECT_EQ(released, sessions.Acquire(kKp, kKi, kKd, kOffTrackCte));
+  EXPECT_EQ(SessionPool::kSlabSessionCount * sizeof(Session),
+            sessions.GetReservedSize());
+
+  auto extra = sessions.Acquire(kKp, kKi, kKd, kOffTrackCte);
+  EXPECT_EQ(0u, std::set<Session*>(created.begin(), created.end()).count(extra));
+  EXPECT_EQ(2 * SessionPool::kSlabSessionCount * sizeof(Session),
+            sessions.GetReservedSize());
+  EXPECT_EQ(SessionPool::kSlabSessionCount + 1u, sessions.GetCount());
+  for (auto session : created) {
+    sessions.Release(session);
+  }
+  sessions.Release(extra);
+  EXPECT_EQ(0u, sessions.GetCount());
+}
+
+TEST(SessionPool, ControllerIsDroppedOnRelease) {
+  SessionPool sessions;
+  auto session = sessions.Acquire(std::unique_ptr<PidController>(
+    new PidController(kKp, kKi, kKd, kOffTrackCte)));
+  ASSERT_NE(nullptr, session->GetController());
+  sessions.Release(session);
+  EXPECT_EQ(session, sessions.Acquire(kKp, kKi, kKd, kOffTrackCte));
+  EXPECT_EQ(nullptr, session->GetController());
+  double steering;
+  double throttle;
+  EXPECT_TRUE(session->Update(1., 30., steering, throttle));
+  EXPECT_LT(steering, 0.);
+  sessions.Release(session);
+}
+
+TEST(SessionPool, ReleasedControllerOutlivesSession) {
+  SessionPool sessions;
+  auto session = sessions.Acquire(std::unique_ptr<PidController>(
+    new PidController(kKp, kKi, kKd, kOffTrackCte, 0.01, 1e-5, 0.1, 10)));
+  auto controller = session->GetController();
+  auto released = session->ReleaseController();
+  EXPECT_EQ(controller, released.get());
+  EXPECT_EQ(nullptr, session->GetController());
+  sessions.Release(session);
+  // A new session continues with the same controller
+  session = sessions.Acquire(std::move(released));
+  EXPECT_EQ(controller, session->GetController());
+  sessions.Release(session);
+}
+
+TEST(SessionPool, ConcurrentChurnHandsOutUniqueSessions) {
+  const auto kThreadCount = 4;
+  const auto kHeldCount = 700;
+  SessionPool sessions;
+  std::vector<std::vector<Session*>> held(kThreadCount);
+  for (auto round = 0; round < 20; ++round) {
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < kThreadCount; ++t) {
+      threads.emplace_back([&sessions, &held, t, kHeldCount]() {
+        // Release the sessions of another thread, then acquire new ones
+        for (auto session : held[t]) {
+          sessions.Release(session);
+        }
+        held[t].clear();
+        for (auto i = 0; i < kHeldCount; ++i) {
+          held[t].push_back(sessions.Acquire(kKp, kKi, kKd, kOffTrackCte));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    std::set<Session*> unique;
+    for (const auto& thread_held : held) {
+      unique.insert(thread_held.begin(), thread_held.end());
+    }
+    ASSERT_EQ(size_t(kThreadCount * kHeldCount), unique.size());
+    ASSERT_EQ(unique.size(), sessions.GetCount());
+    std::rotate(held.begin(), held.begin() + 1, held.end());
+  }
+  // At most the sessions of one round and of the next are acquired at once
+  EXPECT_LE(sessions.GetReservedSize(),
+            (2 * kThreadCount * kHeldCount / SessionPool::kSlabSessionCount + 1)
+            * SessionPool::kSlabSessionCount * sizeof(Session));
+}
+
+TEST(Session, ShadowCandidatesNeverActuate) {
+  SessionPool sessions;
+  auto session = sessions.Acquire(kKp, kKi, kKd, kOffTrackCte);
+  auto reference = sessions.Acquire(kKp, kKi, kKd, kOffTrackCte);
+  auto candidate = sessions.Acquire(2. * kKp, kKi, kKd, kOffTrackCte);
+  // The same coefficients never diverge, the doubled Kp saturates more
+  ASSERT_TRUE(session->AddShadow(kKp, kKi, kKd));
+  ASSERT_TRUE(session->AddShadow(2. * kKp, kKi, kKd));
+  EXPECT_FALSE(session->AddShadow(kKp, kKi, kKd));
+  EXPECT_EQ(2u, session->GetShadowCount());
+
+  auto sum_divergence = 0.;
+  auto max_divergence = 0.;
+  auto n_saturated = 0;
+  const auto kFrameCount = 400;
+  for (auto i = 0; i < kFrameCount; ++i) {
+    auto cte = 4. * std::sin(0.05 * i);
+    double steering;
+    double throttle;
+    double reference_steering;
+    double candidate_steering;
+    ASSERT_TRUE(session->Update(cte, 50., steering, throttle));
+    reference->Update(cte, 50., reference_steering, throttle);
+    candidate->Update(cte, 50., candidate_steering, throttle);
+    ASSERT_EQ(reference_steering, steering);
+    auto divergence = std::fabs(candidate_steering - steering);
+    sum_divergence += divergence;
+    max_divergence = std::max(max_divergence, divergence);
+    n_saturated += std::fabs(candidate_steering) == 1.;
+  }
+  auto same = session->GetShadowStatistics(0);
+  EXPECT_EQ(0., same.mean_divergence);
+  EXPECT_EQ(0., same.max_divergence);
+  auto doubled = session->GetShadowStatistics(1);
+  EXPECT_NEAR(sum_divergence / kFrameCount, doubled.mean_divergence, 1e-12);
+  EXPECT_NEAR(max_divergence, doubled.max_divergence, 1e-12);
+  EXPECT_NEAR(static_cast<double>(n_saturated) / kFrameCount,
+              doubled.saturation_rate, 1e-12);
+  EXPECT_GT(doubled.saturation_rate, same.saturation_rate);
+
+  // Candidates are dropped on reset, and never added to a controller
+  sessions.Release(session);
+  session = sessions.Acquire(std::unique_ptr<PidController>(
+    new PidController(kKp, kKi, kKd, kOffTrackCte)));
+  EXPECT_EQ(0u, session->GetShadowCount());
+  EXPECT_FALSE(session->AddShadow(kKp, kKi, kKd));
+  sessions.Release(session);
+
+  // A reused session starts without candidates
+  session = sessions.Acquire(kKp, kKi, kKd, kOffTrackCte);
+  EXPECT_EQ(0u, session->GetShadowCount());
+  ASSERT_TRUE(session->AddShadow(2. * kKp, kKi, kKd));
+  EXPECT_EQ(0., session->GetShadowStatistics(0).max_divergence);
+  sessions.Release(session);
+  sessions.Release(reference);
+  sessions.Release(candidate);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,63 @@
+#include <stdexcept>
+#include <string>
+#include "gtest/gtest.h"
+#include "../src/SocketIo.h"
+
+const std::string kTelemetry = "42[\"telemetry\",{\"cte\":\"0.7598\","
+                               "\"speed\":\"12.4380\","
+                               "\"steering_angle\":\"0.0000\"}]";
+
+TEST(SocketIo, DetectsEvents) {
+  EXPECT_TRUE(SocketIo::IsEvent(kTelemetry.data(), kTelemetry.length()));
+  EXPECT_FALSE(SocketIo::IsEvent("42", 2));
+  EXPECT_FALSE(SocketIo::IsEvent("2probe", 6));
+}
+
+TEST(SocketIo, ParsesTelemetry) {
+  auto json = SocketIo::GetJsonData(kTelemetry);
+  EXPECT_EQ(kTelemetry.substr(2), json);
+  double cte = 0.;
+  double speed = 0.;
+  ASSERT_TRUE(SocketIo::ParseTelemetry(json, cte, speed));
+  EXPECT_DOUBLE_EQ(0.7598, cte);
+  EXPECT_DOUBLE_EQ(12.438, speed);
+
+  // Other events are not telemetry, and manual driving has no data
+  EXPECT_FALSE(SocketIo::ParseTelemetry(
+    SocketIo::GetJsonData("42[\"other\",{}]"), cte, speed));
+  EXPECT_EQ("", SocketIo::GetJsonData("42[\"telemetry\",null]"));
+  EXPECT_THROW(SocketIo::ParseTelemetry("[\"telemetry\",{\"cte\":\"x\"}]",
+                                        cte, speed),
+               std::exception);
+  EXPECT_THROW(SocketIo::ParseTelemetry("[\"telemetry\",{\"cte\":1}]",
+                                        cte, speed),
+               std::exception);
+  EXPECT_THROW(SocketIo::ParseTelemetry("[telemetry]", cte, speed),
+               std::exception);
+}
+
+TEST(SocketIo, ParsesInPlace) {
+  // Whitespace, unquoted numbers and an image after the data
+  const std::string kEvent = "42[ \"telemetry\" , { \"speed\" : 3.5 ,"
+                             "\"cte\":\"-1.25\",\"image\":\"bnVsbA+/\"}]";
+  const char* json = nullptr;
+  size_t json_length = 0;
+  ASSERT_TRUE(SocketIo::FindJsonData(kEvent.data(), kEvent.length(), json,
+                                     json_length));
+  EXPECT_EQ(kEvent.data() + 2, json);
+  EXPECT_EQ(kEvent.length() - 2, json_length);
+  double cte = 0.;
+  double speed = 0.;
+  ASSERT_TRUE(SocketIo::ParseTelemetry(json, json_length, cte, speed));
+  EXPECT_DOUBLE_EQ(-1.25, cte);
+  EXPECT_DOUBLE_EQ(3.5, speed);
+  EXPECT_FALSE(SocketIo::FindJsonData("42[\"manual\"", 12, json,
+                                      json_length));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
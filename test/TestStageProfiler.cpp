@@ -0,0 +1,184 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/Simulator.h"
+#include "../src/FrameScheduler.h"
+#include "../src/PidController.h"
+#include "../src/Session.h"
+#include "../src/SocketIo.h"
+#include "../src/StageProfiler.h"
+#include "../src/SteerOutput.h"
+
+// This test links the counting global allocator, src/CountingAllocator.cpp
+
+typedef StageProfiler::Stage Stage;
+
+// Steady state of frames: the frames of warming up may allocate, none after
+const auto kWarmUpFrameCount = 200;
+const auto kFrameCount = 5000;
+
+// Drives a session on the simulator through the stages of the frame pipeline
+// but the socket, from the telemetry message, and checks steady frames don't
+// allocate.
+// @param session  Session
+void ExpectSteadyFramesDontAllocate(Session& session) {
+  StageProfiler profiler;
+  FrameScheduler scheduler({0.04, 5.});
+  SteerOutput::Counters counters = {};
+  SteerOutput output({0., 10}, counters);
+  Simulator simulator(50., 1., 0., 0.5 / 180. * M_PI);
+  auto n_bytes = 0ul;
+  auto write = [&n_bytes](std::vector<std::string>& messages) {
+    n_bytes += messages.size();
+  };
+  auto run = [&](const FrameScheduler::Frame& frame) {
+    auto steering = 0.;
+    auto throttle = 0.;
+    bool is_control;
+    {
+      StageProfiler::Scope scope(&profiler, 0, Stage::kUpdate);
+      is_control = session.Update(frame.cte, frame.speed, steering, throttle);
+    }
+    StageProfiler::Scope scope(&profiler, 0, Stage::kOutput);
+    if (is_control) {
+      output.Control(steering, throttle);
+      simulator.Control(steering, throttle);
+    } else {
+      output.Reset();
+      simulator.Reset();
+    }
+    output.Flush(write);
+  };
+  char telemetry[256];
+  for (auto i = 0; i < kWarmUpFrameCount + kFrameCount; ++i) {
+    if (i == kWarmUpFrameCount) {
+      profiler = StageProfiler();
+    }
+    auto length = std::snprintf(
+      telemetry, sizeof(telemetry),
+      "42[\"telemetry\",{\"cte\":\"%.4f\",\"speed\":\"%.4f\","
+      "\"steering_angle\":\"0.0000\"}]", simulator.GetCte(),
+      simulator.GetSpeed());
+    const char* json = nullptr;
+    size_t json_length = 0;
+    bool is_data;
+    {
+      StageProfiler::Scope scope(&profiler, 0, Stage::kExtract);
+      is_data = SocketIo::FindJsonData(telemetry, length, json, json_length);
+    }
+    ASSERT_TRUE(is_data);
+    {
+      StageProfiler::Scope scope(&profiler, 0, Stage::kParse);
+      double cte;
+      double speed;
+      ASSERT_TRUE(SocketIo::ParseTelemetry(json, json_length, cte, speed));
+      scheduler.Push(&session, 0.04 * i, cte, speed);
+    }
+    scheduler.Run(run);
+  }
+  for (auto stage : {Stage::kExtract, Stage::kParse, Stage::kUpdate,
+                     Stage::kOutput}) {
+    EXPECT_EQ(kFrameCount, profiler.GetCounters(stage).n_runs);
+    EXPECT_EQ(0u, profiler.GetCounters(stage).n_allocations)
+      << StageProfiler::GetStageName(stage) << " allocates "
+      << profiler.GetCounters(stage).n_bytes << " bytes";
+  }
+  EXPECT_EQ(kWarmUpFrameCount + kFrameCount, counters.n_commands);
+  EXPECT_GT(n_bytes, 0u);
+}
+
+TEST(StageProfiler, CountsAllocationsOfStages) {
+  ASSERT_TRUE(StageProfiler::IsCountingAllocations());
+  StageProfiler profiler;
+  {
+    StageProfiler::Scope scope(&profiler, 3, Stage::kParse);
+    std::unique_ptr<std::vector<int>> values(new std::vector<int>(100));
+  }
+  {
+    StageProfiler::Scope scope(&profiler, 4, Stage::kParse);
+  }
+  {
+    // Nothing is recorded without a profiler
+    StageProfiler::Scope scope(nullptr, 3, Stage::kParse);
+    std::vector<int> values(100);
+  }
+  auto totals = profiler.GetCounters(Stage::kParse);
+  EXPECT_EQ(2u, totals.n_runs);
+  EXPECT_EQ(2u, totals.n_allocations);
+  EXPECT_EQ(sizeof(std::vector<int>) + 100 * sizeof(int), totals.n_bytes);
+  StageProfiler::Counters counters;
+  ASSERT_TRUE(profiler.GetSessionCounters(4, Stage::kParse, counters));
+  EXPECT_EQ(1u, counters.n_runs);
+  EXPECT_EQ(0u, counters.n_allocations);
+  ASSERT_TRUE(profiler.GetSessionCounters(3, Stage::kUpdate, counters));
+  EXPECT_EQ(0u, counters.n_runs);
+
+  // Totals keep closed sessions
+  profiler.RemoveSession(3);
+  EXPECT_FALSE(profiler.GetSessionCounters(3, Stage::kParse, counters));
+  EXPECT_EQ(2u, profiler.GetCounters(Stage::kParse).n_allocations);
+}
+
+TEST(StageProfiler, MeasuresThreadCpuTime) {
+  StageProfiler profiler;
+  {
+    // Spinning for 20ms of CPU time, however loaded the machine is
+    StageProfiler::Scope scope(&profiler, 0, Stage::kUpdate);
+    auto start = StageProfiler::GetThreadCpuTime();
+    volatile auto sum = 0.;
+    while (StageProfiler::GetThreadCpuTime() - start < 20000000) {
+      sum = sum + 1.;
+    }
+  }
+  {
+    // Waiting takes no CPU time
+    StageProfiler::Scope scope(&profiler, 0, Stage::kOutput);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_GE(profiler.GetCounters(Stage::kUpdate).cpu_ns, 20000000u);
+  EXPECT_LT(profiler.GetCounters(Stage::kOutput).cpu_ns, 5000000u);
+}
+
+TEST(StageProfiler, SteadyFramesDontAllocate) {
+  // Inline PID
+  Session session(0.1, 1e-4, 4., 5.);
+  ExpectSteadyFramesDontAllocate(session);
+}
+
+TEST(StageProfiler, SteadyFramesOfControllerDontAllocate) {
+  // Final coefficients of a controller
+  Session session(std::unique_ptr<PidController>(
+    new PidController(0.1, 1e-4, 4., 5.)));
+  ExpectSteadyFramesDontAllocate(session);
+}
+
+TEST(StageProfiler, WritesMetrics) {
+  StageProfiler profiler;
+  profiler.Record(7, Stage::kUpdate, {0, 2, 64, 1500000001});
+  std::ostringstream oss;
+  profiler.WriteMetrics(oss);
+  auto metrics = oss.str();
+  EXPECT_NE(std::string::npos, metrics.find("pid_allocation_counting 1\n"));
+  EXPECT_NE(std::string::npos, metrics.find(
+    "pid_stage_runs_total{stage=\"update\"} 1\n"));
+  EXPECT_NE(std::string::npos, metrics.find(
+    "pid_stage_allocations_total{session=\"7\",stage=\"update\"} 2\n"));
+  EXPECT_NE(std::string::npos, metrics.find(
+    "pid_stage_allocated_bytes_total{stage=\"update\"} 64\n"));
+  EXPECT_NE(std::string::npos, metrics.find(
+    "pid_stage_cpu_seconds_total{stage=\"update\"} 1.500000001\n"));
+  EXPECT_NE(std::string::npos, metrics.find(
+    "pid_stage_cpu_seconds_total{stage=\"parse\"} 0.000000000\n"));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,49 @@
+#include <cmath>
+#include "gtest/gtest.h"
+#include "../src/Simulator.h"
+#include "../src/Stanley.h"
+
+const auto kK = 2.0;
+const auto kKSoft = 1.0;
+const auto kKHeading = 0.8;
+
+TEST(Stanley, SteersTowardsCenter) {
+  Stanley stanley(kK, kKSoft, kKHeading);
+  EXPECT_LT(stanley.GetSteering(1, 30), 0);
+  Stanley stanley2(kK, kKSoft, kKHeading);
+  EXPECT_GT(stanley2.GetSteering(-1, 30), 0);
+}
+
+TEST(Stanley, CteTermIsBounded) {
+  Stanley stanley(kK, 0, 0);
+  // atan() saturates at pi/2, which is 3.6 of the 25 degree max angle
+  EXPECT_NEAR(-90. / 25., stanley.GetSteering(1e+6, 0), 1e-3);
+  Stanley stanley2(kK, 0, 0);
+  EXPECT_EQ(0, stanley2.GetSteering(0, 0));
+}
+
+TEST(Stanley, HeadingTerm) {
+  Stanley stanley(0, kKSoft, 1);
+  EXPECT_EQ(0, stanley.GetSteering(1, 30));
+  // Moving away from the center steers back
+  EXPECT_LT(stanley.GetSteering(1.1, 30), 0);
+  EXPECT_GT(stanley.GetSteering(1.0, 30), 0);
+}
+
+TEST(Stanley, ConvergesOnSimulator) {
+  Stanley stanley(kK, kKSoft, kKHeading);
+  Simulator simulator(50);
+  for (auto i = 0; i < 1000; ++i) {
+    auto steering = stanley.GetSteering(simulator.GetCte(),
+                                        simulator.GetSpeed());
+    simulator.Control(std::max(-1., std::min(1., steering)), 1.);
+  }
+  EXPECT_NEAR(0, simulator.GetCte(), 0.05);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
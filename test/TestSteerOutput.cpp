@@ -0,0 +1,91 @@
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/SteerOutput.h"
+
+// Collects written batches.
+struct Written {
+  std::vector<std::vector<std::string>> batches;
+  SteerOutput::Writer GetWriter() {
+    return [this](std::vector<std::string>& messages) {
+      batches.push_back(messages);
+    };
+  }
+};
+
+TEST(SteerOutput, ZeroEpsilonSendsEveryCommand) {
+  SteerOutput::Counters counters = {};
+  SteerOutput output({0., 10}, counters);
+  Written written;
+  for (auto i = 0; i < 5; ++i) {
+    EXPECT_TRUE(output.Control(0.1, 0.5));
+    output.Flush(written.GetWriter());
+  }
+  ASSERT_EQ(5u, written.batches.size());
+  EXPECT_EQ("42[\"steer\",{\"steering_angle\":0.1,\"throttle\":0.5}]",
+            written.batches[0][0]);
+  EXPECT_EQ(5u, counters.n_commands);
+  EXPECT_EQ(0u, counters.n_suppressed);
+  EXPECT_EQ(5u, counters.n_writes);
+  EXPECT_EQ(5 * written.batches[0][0].length(), counters.n_bytes);
+}
+
+TEST(SteerOutput, SmallChangesAreSuppressedUntilMaxAge) {
+  SteerOutput::Counters counters = {};
+  SteerOutput output({0.01, 3}, counters);
+  EXPECT_TRUE(output.Control(0.1, 0.5));
+  EXPECT_FALSE(output.Control(0.105, 0.5));
+  EXPECT_FALSE(output.Control(0.1, 0.495));
+  EXPECT_FALSE(output.Control(0.1, 0.5));
+  // Refreshed after 3 suppressed commands
+  EXPECT_TRUE(output.Control(0.1, 0.5));
+  EXPECT_FALSE(output.Control(0.1, 0.5));
+  // A large enough change is sent at once
+  EXPECT_TRUE(output.Control(0.12, 0.5));
+  EXPECT_EQ(7u, counters.n_commands);
+  EXPECT_EQ(4u, counters.n_suppressed);
+  EXPECT_EQ(1u, counters.n_refreshed);
+  // Every command gets a reply
+  EXPECT_EQ(7u, counters.n_messages);
+}
+
+TEST(SteerOutput, SuppressedCommandIsRepliedByManual) {
+  SteerOutput::Counters counters = {};
+  SteerOutput output({0.01, 3}, counters);
+  Written written;
+  output.Control(0.1, 0.5);
+  output.Flush(written.GetWriter());
+  EXPECT_FALSE(output.Control(0.1, 0.5));
+  EXPECT_TRUE(output.IsPending());
+  output.Flush(written.GetWriter());
+  ASSERT_EQ(2u, written.batches.size());
+  ASSERT_EQ(1u, written.batches[1].size());
+  EXPECT_EQ("42[\"manual\",{}]", written.batches[1][0]);
+}
+
+TEST(SteerOutput, ResetIsCorkedWithNextCommand) {
+  SteerOutput::Counters counters = {};
+  SteerOutput output({0.01, 10}, counters);
+  Written written;
+  output.Control(0.1, 0.5);
+  output.Flush(written.GetWriter());
+  EXPECT_FALSE(output.IsPending());
+  output.Reset();
+  // The same command is sent again after the reset
+  EXPECT_TRUE(output.Control(0.1, 0.5));
+  EXPECT_TRUE(output.IsPending());
+  output.Flush(written.GetWriter());
+  output.Flush(written.GetWriter());
+  ASSERT_EQ(2u, written.batches.size());
+  ASSERT_EQ(2u, written.batches[1].size());
+  EXPECT_EQ("42[\"reset\", {}]", written.batches[1][0]);
+  EXPECT_EQ(3u, counters.n_messages);
+  EXPECT_EQ(2u, counters.n_writes);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
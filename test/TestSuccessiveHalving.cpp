@@ -0,0 +1,106 @@
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/SuccessiveHalving.h"
+
+// Objective with the minimum 0.01 at (1, -0.5), shorter budgets are noisier
+double Objective(const Tuner::ParameterSequence& p, double budget) {
+  return (p[0].p - 1) * (p[0].p - 1) + (p[1].p + 0.5) * (p[1].p + 0.5) + 0.01
+    + 0.01 * (1 - budget) * std::sin(1000 * p[0].p);
+}
+
+const Tuner::ParameterSequence kInitial = {{0, 0.25}, {0, 0.25}};
+
+TEST(SuccessiveHalving, RungsAndBudgets) {
+  auto scheduler = std::make_shared<SuccessiveHalving>(kInitial, 9, 3, 3);
+  SuccessiveHalving::Worker worker(scheduler);
+  EXPECT_NEAR(1. / 9, worker.GetBudget(), 1e-12);
+  // 9 candidates over 1/9 of the lap, 3 over 1/3, 1 over the whole lap
+  auto p = kInitial;
+  double budgets[] = {1. / 9, 1. / 3, 1.};
+  size_t counts[] = {9, 3, 1};
+  for (auto rung = 0; rung < 3; ++rung) {
+    for (size_t i = 0; i < counts[rung]; ++i) {
+      EXPECT_NEAR(budgets[rung], worker.GetBudget(), 1e-12);
+      EXPECT_EQ(0, scheduler->GetRound());
+      p = worker.UpdateError(Objective(p, worker.GetBudget()));
+    }
+  }
+  EXPECT_EQ(1, scheduler->GetRound());
+  EXPECT_NEAR(1. / 9, worker.GetBudget(), 1e-12);
+  EXPECT_LE(scheduler->GetBestError(), Objective(kInitial, 1.));
+  EXPECT_NEAR(Objective(scheduler->GetBestParameters(), 1.),
+              scheduler->GetBestError(), 1e-12);
+}
+
+TEST(SuccessiveHalving, StalledWorkerDoesNotBlock) {
+  auto scheduler = std::make_shared<SuccessiveHalving>(kInitial, 3, 3, 2);
+  auto trial = scheduler->Ask();
+  auto stalled = scheduler->Ask();
+  EXPECT_NE(trial.candidate, stalled.candidate);
+  scheduler->Tell(trial, 1.);
+  // The unassigned candidate comes first, then a duplicate of the pending one
+  auto next = scheduler->Ask();
+  EXPECT_NE(stalled.candidate, next.candidate);
+  scheduler->Tell(next, 2.);
+  auto pending = scheduler->Ask();
+  EXPECT_EQ(stalled.candidate, pending.candidate);
+  scheduler->Tell(pending, 3.);
+  // Reports of completed rungs are ignored
+  scheduler->Tell(stalled, 0.);
+  auto last = scheduler->Ask();
+  EXPECT_EQ(1, last.rung);
+  EXPECT_EQ(1., last.budget);
+  scheduler->Tell(last, 0.5);
+  EXPECT_EQ(0.5, scheduler->GetBestError());
+  EXPECT_EQ(1, scheduler->GetRound());
+}
+
+TEST(SuccessiveHalving, WorkersStartOnDistinctCandidates) {
+  auto scheduler = std::make_shared<SuccessiveHalving>(kInitial, 3, 3, 2);
+  SuccessiveHalving::Worker first(scheduler);
+  SuccessiveHalving::Worker second(scheduler);
+  EXPECT_EQ(kInitial, first.GetParameters());
+  EXPECT_NE(first.GetParameters(), second.GetParameters());
+  EXPECT_EQ(2u, scheduler->Ask().candidate);
+}
+
+TEST(SuccessiveHalving, InfeasibleSamplesAreRejected) {
+  const Tuner::ParameterSequence kBounded = {
+    {0.1, 0.25, Tuner::Transform::kLinear, 0., 1.},
+    {1e-3, 1e-3, Tuner::Transform::kLog, 0., 0.}};
+  auto scheduler = std::make_shared<SuccessiveHalving>(kBounded, 27);
+  for (auto i = 0; i < 27; ++i) {
+    auto trial = scheduler->Ask();
+    EXPECT_GE(trial.parameters[0].p, 0.);
+    EXPECT_LE(trial.parameters[0].p, 1.);
+    EXPECT_GT(trial.parameters[1].p, 0.);
+    scheduler->Tell(trial, 1.);
+  }
+}
+
+TEST(SuccessiveHalving, ParallelWorkers) {
+  auto scheduler = std::make_shared<SuccessiveHalving>(kInitial);
+  std::vector<std::thread> threads;
+  for (auto t = 0; t < 4; ++t) {
+    threads.emplace_back([scheduler]() {
+      SuccessiveHalving::Worker worker(scheduler);
+      auto p = kInitial;
+      while (scheduler->GetRound() < 4) {
+        p = worker.UpdateError(Objective(p, worker.GetBudget()));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LT(scheduler->GetBestError(), 0.05);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,201 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/Simulator.h"
+#include "../src/PidController.h"
+#include "../src/TelemetryArchive.h"
+
+const auto kPath = "test_telemetry_archive.tlm";
+
+// Checks two frames are the same bit for bit.
+void ExpectSameFrame(const TelemetryFrame& expected,
+                     const TelemetryFrame& actual) {
+  EXPECT_EQ(expected.timestamp, actual.timestamp);
+  EXPECT_EQ(0, std::memcmp(&expected.cte, &actual.cte, sizeof(double)));
+  EXPECT_EQ(0, std::memcmp(&expected.speed, &actual.speed, sizeof(double)));
+  EXPECT_EQ(0, std::memcmp(&expected.steering, &actual.steering,
+                           sizeof(double)));
+  EXPECT_EQ(0, std::memcmp(&expected.throttle, &actual.throttle,
+                           sizeof(double)));
+}
+
+TEST(TelemetryArchive, RoundTripsFramesExactly) {
+  // Jittered frames with repeated values, gaps of every size and special
+  // values, over several blocks
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise;
+  std::vector<TelemetryFrame> frames;
+  uint64_t timestamp = 1234567;
+  for (auto i = 0; i < 3000; ++i) {
+    timestamp += 40000 + static_cast<int>(2000 * noise(rng));
+    if (i % 500 == 0) {
+      timestamp += 1ull << (i / 60);
+    }
+    frames.push_back({timestamp, noise(rng), i % 7 ? 30. : 30. + noise(rng),
+                      i % 3 ? frames.back().steering : noise(rng),
+                      1.});
+  }
+  frames[10].cte = -0.;
+  frames[11].cte = NAN;
+  frames[12].cte = HUGE_VAL;
+  frames[13].cte = 1e-310;
+  TelemetryWriter writer;
+  ASSERT_TRUE(writer.Open(kPath, 42));
+  for (const auto& frame : frames) {
+    writer.Append(frame);
+  }
+  ASSERT_TRUE(writer.Close());
+
+  TelemetryReader reader;
+  ASSERT_TRUE(reader.Load(kPath));
+  EXPECT_EQ(42u, reader.GetSession());
+  EXPECT_EQ(frames.size(), reader.GetFrameCount());
+  ASSERT_EQ(1u, reader.GetLapCount());
+  auto lap = reader.GetLap(0);
+  EXPECT_EQ(0u, lap.first_frame);
+  EXPECT_EQ(frames.size(), lap.n_frames);
+  EXPECT_EQ(frames.front().timestamp, lap.first_timestamp);
+  EXPECT_EQ(frames.back().timestamp, lap.last_timestamp);
+  EXPECT_EQ(LapEnd::kOpen, lap.end);
+  std::vector<TelemetryFrame> decoded;
+  reader.ReadLap(0, decoded);
+  ASSERT_EQ(frames.size(), decoded.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    ExpectSameFrame(frames[i], decoded[i]);
+  }
+  std::remove(kPath);
+}
+
+TEST(TelemetryArchive, SeeksToLaps) {
+  TelemetryWriter writer;
+  ASSERT_TRUE(writer.Open(kPath, 7));
+  // The last lap ends with the recording
+  const LapEnd kEnds[] = {LapEnd::kComplete, LapEnd::kReset,
+                          LapEnd::kComplete, LapEnd::kOpen};
+  const uint32_t kFrameCounts[] = {1500, 3, 1024, 10};
+  uint64_t timestamp = 0;
+  for (auto lap = 0; lap < 4; ++lap) {
+    for (uint32_t i = 0; i < kFrameCounts[lap]; ++i) {
+      timestamp += 40000;
+      writer.Append({timestamp, static_cast<double>(lap), 1. * i, 0., 0.});
+    }
+    if (kEnds[lap] != LapEnd::kOpen) {
+      writer.EndLap(kEnds[lap]);
+      // A lap without frames is not recorded
+      writer.EndLap(LapEnd::kReset);
+    }
+  }
+  ASSERT_TRUE(writer.Close());
+
+  TelemetryReader reader;
+  ASSERT_TRUE(reader.Load(kPath));
+  EXPECT_EQ(7u, reader.GetSession());
+  ASSERT_EQ(4u, reader.GetLapCount());
+  uint64_t first_frame = 0;
+  for (auto lap = 0; lap < 4; ++lap) {
+    auto info = reader.GetLap(lap);
+    EXPECT_EQ(first_frame, info.first_frame);
+    EXPECT_EQ(kFrameCounts[lap], info.n_frames);
+    EXPECT_EQ(kEnds[lap], info.end);
+    EXPECT_EQ(40000 * (first_frame + 1), info.first_timestamp);
+    EXPECT_EQ(40000 * (first_frame + info.n_frames), info.last_timestamp);
+    first_frame += info.n_frames;
+  }
+  // Laps are read in any order
+  for (auto lap : {2, 0, 3, 1}) {
+    std::vector<TelemetryFrame> frames;
+    reader.ReadLap(lap, frames);
+    ASSERT_EQ(kFrameCounts[lap], frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+      EXPECT_EQ(lap, frames[i].cte);
+      EXPECT_EQ(i, frames[i].speed);
+    }
+  }
+  std::remove(kPath);
+}
+
+TEST(TelemetryArchive, CompressesDrivingTelemetry) {
+  // Tuning on the simulator: resets on getting off track, and laps
+  TelemetryWriter writer;
+  ASSERT_TRUE(writer.Open(kPath, 0));
+  PidController pid_controller(0.1, 1e-4, 4., 5., 0.05, 1e-5, 1., 200.);
+  Simulator simulator(50., 1., 0., 0.5 / 180. * M_PI);
+  std::vector<TelemetryFrame> frames;
+  std::vector<unsigned long int> laps;
+  for (uint64_t i = 0; i < 20000; ++i) {
+    frames.push_back({40000 * i, simulator.GetCte(), simulator.GetSpeed(), 0.,
+                      0.});
+    auto n_laps = pid_controller.GetLapCount();
+    auto is_reset = false;
+    pid_controller.Update(frames.back().cte, frames.back().speed,
+                          [&](double steering, double throttle) {
+                            frames.back().steering = steering;
+                            frames.back().throttle = throttle;
+                            simulator.Control(steering, throttle);
+                          },
+                          [&]() {
+                            is_reset = true;
+                            simulator.Reset();
+                          });
+    writer.Append(frames.back());
+    if (pid_controller.GetLapCount() != n_laps) {
+      writer.EndLap(LapEnd::kComplete);
+      laps.push_back(i);
+    } else if (is_reset) {
+      writer.EndLap(LapEnd::kReset);
+      laps.push_back(i);
+    }
+  }
+  ASSERT_TRUE(writer.Close());
+
+  TelemetryReader reader;
+  ASSERT_TRUE(reader.Load(kPath));
+  ASSERT_EQ(laps.size() + 1, reader.GetLapCount());
+  EXPECT_GT(laps.size(), 3u);
+  for (size_t lap = 0; lap < reader.GetLapCount(); ++lap) {
+    auto info = reader.GetLap(lap);
+    std::vector<TelemetryFrame> decoded;
+    reader.ReadLap(lap, decoded);
+    ASSERT_EQ(info.n_frames, decoded.size());
+    for (size_t i = 0; i < decoded.size(); ++i) {
+      ExpectSameFrame(frames[info.first_frame + i], decoded[i]);
+    }
+    if (lap < laps.size()) {
+      EXPECT_EQ(laps[lap] + 1, info.first_frame + info.n_frames);
+    }
+  }
+  // Steady timestamps and speed take a bit per frame, noisy CTE and steering
+  // most of their mantissas
+  EXPECT_LT(reader.GetSize(), frames.size() * 5 * sizeof(double) * 3 / 5);
+  std::remove(kPath);
+}
+
+TEST(TelemetryArchive, RejectsInvalidFiles) {
+  TelemetryReader reader;
+  EXPECT_FALSE(reader.Load(kPath));
+  TelemetryWriter writer;
+  ASSERT_TRUE(writer.Open(kPath, 0));
+  writer.Append({1, 2., 3., 4., 5.});
+  // Not closed yet, there's no index
+  EXPECT_FALSE(reader.Load(kPath));
+  ASSERT_TRUE(writer.Close());
+  EXPECT_TRUE(reader.Load(kPath));
+  {
+    std::ofstream file(kPath, std::ios::binary | std::ios::app);
+    file << "garbage";
+  }
+  EXPECT_FALSE(reader.Load(kPath));
+  EXPECT_FALSE(reader.IsLoaded());
+  std::remove(kPath);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,143 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/Simulator.h"
+#include "../src/Pid.h"
+#include "../src/Track.h"
+
+const auto kRadius = 50.;
+
+// Sets a circle of control points, counterclockwise.
+// @param track  Track
+// @param n      Number of control points
+void SetCircle(Track& track, int n) {
+  std::vector<double> x;
+  std::vector<double> y;
+  for (auto i = 0; i < n; ++i) {
+    x.push_back(kRadius * std::cos(2. * M_PI * i / n));
+    y.push_back(kRadius * std::sin(2. * M_PI * i / n));
+  }
+  ASSERT_TRUE(track.SetCenterline(x, y));
+}
+
+// Gets the distance to the nearest segment by a linear search.
+double GetNearestDistance(const Track& track, double x, double y) {
+  auto spacing = track.GetLength() / track.GetSegmentCount();
+  auto min_distance = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < track.GetSegmentCount(); ++i) {
+    double ax, ay, bx, by, heading;
+    track.GetPose(i * spacing, ax, ay, heading);
+    track.GetPose((i + 1) * spacing, bx, by, heading);
+    auto dx = bx - ax;
+    auto dy = by - ay;
+    auto t = std::max(0., std::min(1., ((x - ax) * dx + (y - ay) * dy)
+                                       / (dx * dx + dy * dy)));
+    min_distance = std::min(min_distance,
+                            std::hypot(x - ax - t * dx, y - ay - t * dy));
+  }
+  return min_distance;
+}
+
+TEST(Track, CircleHasArcLengthAndCte) {
+  Track track;
+  EXPECT_FALSE(track.IsLoaded());
+  SetCircle(track, 24);
+  EXPECT_TRUE(track.IsLoaded());
+  EXPECT_NEAR(2. * M_PI * kRadius, track.GetLength(), 1e-3 * track.GetLength());
+  for (auto angle = 0.1; angle < 2. * M_PI; angle += 0.7) {
+    // Inside the counterclockwise circle is left of the centerline
+    for (auto offset : {-3., 0., 2.5}) {
+      double s;
+      auto cte = track.GetCte((kRadius - offset) * std::cos(angle),
+                              (kRadius - offset) * std::sin(angle), &s);
+      EXPECT_NEAR(offset, cte, 0.02);
+      EXPECT_NEAR(angle * kRadius, s, 0.01 * track.GetLength());
+    }
+    double x, y, heading;
+    track.GetPose(angle * kRadius, x, y, heading);
+    EXPECT_NEAR(kRadius, std::hypot(x, y), 0.02);
+    EXPECT_NEAR(0., std::remainder(heading - angle - M_PI / 2., 2. * M_PI),
+                0.03);
+  }
+}
+
+TEST(Track, IndexMatchesLinearSearch) {
+  // Irregular track with a hairpin
+  Track track;
+  ASSERT_TRUE(track.SetCenterline({0., 60., 90., 70., 40., 45., 10., -20.},
+                                  {0., -5., 30., 60., 35., 70., 80., 40.}));
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> offset(-20., 20.);
+  std::uniform_real_distribution<double> position(0., track.GetLength());
+  std::vector<double> x;
+  std::vector<double> y;
+  for (auto i = 0; i < 2000; ++i) {
+    double point_x, point_y, heading;
+    track.GetPose(position(generator), point_x, point_y, heading);
+    auto d = offset(generator);
+    x.push_back(point_x - d * std::sin(heading));
+    y.push_back(point_y + d * std::cos(heading));
+  }
+  std::vector<double> ctes(x.size());
+  std::vector<double> s(x.size());
+  track.GetCtes(x.data(), y.data(), x.size(), ctes.data(), s.data());
+  for (size_t i = 0; i < x.size(); ++i) {
+    ASSERT_NEAR(GetNearestDistance(track, x[i], y[i]), std::fabs(ctes[i]),
+                1e-9);
+    double scalar_s;
+    ASSERT_EQ(ctes[i], track.GetCte(x[i], y[i], &scalar_s));
+    ASSERT_EQ(s[i], scalar_s);
+  }
+}
+
+TEST(Track, LoadsControlPoints) {
+  auto path = "test_track.csv";
+  {
+    std::ofstream file(path);
+    file << "x,y" << std::endl;
+    for (auto i = 0; i <= 8; ++i) {
+      file << kRadius * std::cos(2. * M_PI * i / 8) << ","
+           << kRadius * std::sin(2. * M_PI * i / 8) << std::endl;
+    }
+  }
+  Track track;
+  ASSERT_TRUE(track.Load(path));
+  EXPECT_NEAR(2. * M_PI * kRadius, track.GetLength(), 0.01 * track.GetLength());
+  {
+    std::ofstream file(path);
+    file << "0 0" << std::endl << "10 0" << std::endl << "10 0" << std::endl;
+  }
+  EXPECT_FALSE(Track().Load(path));
+  std::remove(path);
+  EXPECT_FALSE(Track().Load(path));
+}
+
+TEST(Track, SimulatorDrivesAlongCurves) {
+  Track track;
+  SetCircle(track, 24);
+  Simulator simulator(30., 1., 0., 0., 1, &track);
+  EXPECT_NEAR(1., simulator.GetCte(), 1e-3);
+  Pid pid(0.12, 1e-5, 4.);
+  auto max_cte = 0.;
+  while (simulator.GetDistance() < track.GetLength()) {
+    auto cte = simulator.GetCte();
+    max_cte = std::max(max_cte, std::fabs(cte));
+    auto steering = std::max(-1., std::min(1., pid.GetSteering(
+      cte, simulator.GetSpeed())));
+    simulator.Control(steering, 0.3);
+  }
+  // The curve needs steady steering, which PID without integral lags
+  EXPECT_LT(max_cte, 2.);
+  EXPECT_GT(std::fabs(simulator.GetCte()), 0.05);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
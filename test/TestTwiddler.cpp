@@ -1,6 +1,6 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
-#include "Robot.h"
+#include "../src/Robot.h"
 #include "../src/Twiddler.h"
 
 using ::testing::Pointwise;
@@ -123,6 +123,79 @@ TEST(Twiddler, Robot) {
   EXPECT_THAT(p0_final, Pointwise(NearPointwise(1e-9), p1_final));
 }
 
+// Twiddles until the robot error is below the target.
+// @return  Number of laps driven
+int CountLapsToTarget(const Twiddler::ParameterSequence& p0, double target) {
+  Twiddler twiddler(p0);
+  auto p = p0;
+  auto laps = 0;
+  for (; laps < 1000; ++laps) {
+    auto robot = MakeRobot();
+    auto error = RunRobot(robot, p[0].p, p[1].p, p[2].p, 100);
+    if (error < target) {
+      break;
+    }
+    p = twiddler.UpdateError(error);
+  }
+  return laps;
+}
+
+TEST(Twiddler, LogScale) {
+  const auto kLog = Twiddler::Transform::kLog;
+  Twiddler twiddler({{1e-5, 1e-5, kLog},
+                     {4, -2, kLog}});
+  // The first steps are the deltas, further ones are taken as factors
+  auto p = twiddler.UpdateError(1);
+  EXPECT_NEAR(2e-5, p[0].p, 1e-15);
+  EXPECT_NEAR(2e-5, p[0].dp, 1e-15);
+  EXPECT_EQ(4, p[1].p);
+  p = twiddler.UpdateError(2);
+  EXPECT_NEAR(5e-6, p[0].p, 1e-15);
+  p = twiddler.UpdateError(2);
+  EXPECT_NEAR(1e-5, p[0].p, 1e-15);
+  EXPECT_NEAR(4 / 1.5, p[1].p, 1e-12);
+  EXPECT_NEAR(4 / 1.5 / 1.5 - 4 / 1.5, p[1].dp, 1e-12);
+  EXPECT_EQ(0, twiddler.GetRejectedCount());
+}
+
+TEST(Twiddler, LogitScale) {
+  Twiddler twiddler({{0.5, 0.25, Twiddler::Transform::kLogit,
+                      0, 1}});
+  // Steps of the log-odds approach the bounds but never reach them
+  double p = 0.5;
+  for (auto i = 0; i < 12; ++i) {
+    auto next = twiddler.UpdateError(-i)[0].p;
+    EXPECT_GT(next, p);
+    EXPECT_LT(next, 1);
+    p = next;
+  }
+  EXPECT_NEAR(1, p, 1e-6);
+}
+
+TEST(Twiddler, InfeasibleCandidatesAreRejected) {
+  Twiddler twiddler({{0, 1, Twiddler::Transform::kLinear,
+                      0, 2},
+                     {0, 10}});
+  EXPECT_EQ(1, twiddler.UpdateError(1)[0].p);
+  // Without driving Kp = -1, the next parameter changes
+  Twiddler::ParameterSequence p0
+    = {{0, 0.9, Twiddler::Transform::kLinear, 0,
+        2},
+       {10, 10}};
+  EXPECT_THAT(p0, Pointwise(NearPointwise(1e-9), twiddler.UpdateError(1)));
+  EXPECT_EQ(1, twiddler.GetRejectedCount());
+}
+
+TEST(Twiddler, LogScaleConvergesInFewerLaps) {
+  const auto kLog = Twiddler::Transform::kLog;
+  auto linear_laps = CountLapsToTarget(
+    {{0.1, 0.1}, {1e-4, 1e-4}, {1, 1}}, 1e-5);
+  auto log_laps = CountLapsToTarget(
+    {{0.1, 0.1, kLog}, {1e-4, 1e-4, kLog},
+     {1, 1, kLog}}, 1e-5);
+  EXPECT_LT(log_laps, linear_laps / 2);
+}
+
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
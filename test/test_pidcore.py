@@ -0,0 +1,65 @@
+"""Smoke test of the Python bindings, loads the built library by ctypes.
+
+Run by ctest with PIDCORE_LIBRARY set to the shared library, or e.g.
+
+    PIDCORE_LIBRARY=build/libpidcore.so PYTHONPATH=python \
+        python3 test/test_pidcore.py
+"""
+
+import os
+import unittest
+
+import pidcore
+
+KP = 0.12
+KI = 1e-5
+KD = 4.0
+OFF_TRACK_CTE = 5.0
+
+
+def get_thread_count():
+    return len(os.listdir("/proc/self/task"))
+
+
+class TestPidCore(unittest.TestCase):
+
+    def test_version(self):
+        self.assertGreaterEqual(pidcore._lib.pidcore_get_version(),
+                                pidcore.VERSION)
+
+    def test_session_step(self):
+        with pidcore.Session(KP, KI, KD, OFF_TRACK_CTE) as session:
+            steering, throttle = session.update(0.5, 30.)
+            self.assertLess(steering, 0.)
+            self.assertGreaterEqual(steering, -1.)
+            self.assertLessEqual(abs(throttle), 1.)
+            self.assertEqual((KP, KI, KD), session.coefficients)
+        with self.assertRaises(ValueError):
+            pidcore.Session(KP, KI, KD, 0.)
+
+    @unittest.skipUnless(os.path.isdir("/proc/self/task"), "needs procfs")
+    def test_tuning_is_quiet(self):
+        # Getting off track logs nothing and starts no logger thread
+        n_threads = get_thread_count()
+        session = pidcore.Session.tuning(KP, KI, KD, OFF_TRACK_CTE, 0.01,
+                                         1e-5, 0.1, 100.)
+        self.assertIsNotNone(session.update(0.5, 30.))
+        self.assertIsNone(session.update(2 * OFF_TRACK_CTE, 30.))
+        session.close()
+        self.assertEqual(n_threads, get_thread_count())
+
+    @unittest.skipIf(pidcore.np is None, "needs NumPy")
+    def test_batch_matches_steps(self):
+        np = pidcore.np
+        cte = np.sin(np.arange(100) * 0.1)
+        speed = np.full(100, 30.)
+        with pidcore.Session(KP, KI, KD, OFF_TRACK_CTE) as batch:
+            steering, _ = batch.update_batch(cte, speed)
+        with pidcore.Session(KP, KI, KD, OFF_TRACK_CTE) as session:
+            for i in range(100):
+                self.assertEqual(steering[i],
+                                 session.update(cte[i], speed[i])[0])
+
+
+if __name__ == "__main__":
+    unittest.main()
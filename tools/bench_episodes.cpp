@@ -0,0 +1,97 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include "../src/AsyncLogger.h"
+#include "../src/EpisodeDriver.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Number of tuning episodes
+const auto kEpisodeCount = 2048;
+
+// Numbers of episodes stepped together
+const size_t kBatchSizes[] = {1, 16, 256, 2048};
+
+// Initial PID coefficients and their deltas, Kp differs between episodes
+const auto kKp = 0.08;
+const auto kKi = 0.;
+const auto kKd = 3.0;
+const auto kDkp = 0.01;
+const auto kDki = 0.;
+const auto kDkd = 0.5;
+const auto kKpSpread = 0.08;
+
+// Off-track CTE, track length and the lap budget of tuning
+const auto kOffTrackCte = 5.;
+const auto kTrackLength = 300.;
+const auto kMaxLaps = 3.;
+
+// Max speed in miles-per-hour and the initial CTE
+const auto kMaxSpeed = 50.;
+const auto kInitialCte = 1.;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the monotonic time in nanoseconds.
+double GetNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Tunes all episodes in batches.
+// @param[in]  batch_size  Number of episodes stepped together
+// @param[out] n_ticks     Number of ticks of all episodes
+// @return                 Wall-clock time in seconds
+double RunEpisodes(size_t batch_size, unsigned long int& n_ticks) {
+  std::vector<std::unique_ptr<ControllerEpisode>> episodes;
+  EpisodeDriver driver({batch_size,    // batch_size
+                        0,             // n_threads
+                        kMaxSpeed,     // max_speed
+                        kInitialCte,   // initial_cte
+                        0,             // max_ticks
+                        nullptr});     // track
+  for (auto i = 0; i < kEpisodeCount; ++i) {
+    std::unique_ptr<PidController> controller(new PidController(
+      kKp + kKpSpread * i / kEpisodeCount, kKi, kKd, kOffTrackCte,
+      kDkp, kDki, kDkd, kTrackLength));
+    // Min delta sum, max stalled cycles, max seconds and max laps
+    controller->SetTuningLimits({0., 0, 0., kMaxLaps});
+    episodes.emplace_back(new ControllerEpisode(std::move(controller),
+                                                kMaxLaps * kTrackLength));
+    driver.Add(episodes.back().get());
+  }
+  auto start = GetNanoseconds();
+  n_ticks = driver.Run();
+  return (GetNanoseconds() - start) / 1e9;
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main() {
+  std::ostringstream oss;
+  oss << kEpisodeCount << " tuning episodes of up to " << kMaxLaps
+      << " laps, all hardware threads" << std::endl
+      << std::setw(8) << "batch" << std::setw(14) << "ticks" << std::setw(10)
+      << "time,s" << std::setw(14) << "ticks/s" << std::setw(14)
+      << "episodes/s" << std::endl << std::fixed;
+  for (auto batch_size : kBatchSizes) {
+    // Controllers report every lap, keep the output to the summary
+    auto cout_buffer = std::cout.rdbuf(nullptr);
+    unsigned long int n_ticks;
+    auto seconds = RunEpisodes(batch_size, n_ticks);
+    AsyncLogger::GetDefault().Flush();
+    std::cout.rdbuf(cout_buffer);
+    oss << std::setw(8) << batch_size << std::setw(14) << n_ticks
+        << std::setprecision(3) << std::setw(10) << seconds
+        << std::setprecision(0) << std::setw(14) << n_ticks / seconds
+        << std::setw(14) << kEpisodeCount / seconds << std::endl;
+  }
+  std::cout << oss.str();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,620 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <uWS/uWS.h>
+#include "../src/AsyncLogger.h"
+#include "../src/Server.h"
+#include "../src/json.hpp"
+#include "../src/Simulator.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Default latency SLO: p99 of telemetry-to-steer in milliseconds
+const auto kDefaultSloMs = 10.;
+
+// Seconds of warming up and of measuring per session count
+const auto kWarmUpSeconds = 1.;
+const auto kDefaultSeconds = 2.;
+
+// Max seconds to wait for the clients to connect or close, polled at an
+// interval in milliseconds
+const auto kMaxWaitSeconds = 10.;
+const auto kWaitMs = 10;
+
+// Session counts per loop thread: doubled from the min one until the SLO is
+// crossed, then bisected this many times. The max one is also bounded by the
+// file descriptors, two per session besides the reserved ones.
+const auto kMinSessionCount = 16u;
+const auto kMaxSessionCount = 1u << 16;
+const auto kBisectionCount = 4;
+const rlim_t kDefaultFileLimit = 1024;
+const rlim_t kReservedFileCount = 64;
+
+// Coefficients, the off-track CTE, and the deltas and track length of tuning
+const auto kKp = 0.12;
+const auto kKi = 1e-5;
+const auto kKd = 4.;
+const auto kOffTrackCte = 5.;
+const auto kDkp = 0.01;
+const auto kDki = 1e-6;
+const auto kDkd = 0.5;
+const auto kTrackLength = 500.;
+
+// Defaults of pid: limits of tuning, frame budget in seconds, max steering
+// commands not sent in a row, and the MPC deadline in nanoseconds
+const auto kMinDeltaSum = 0.01;
+const auto kMaxStalledCycles = 20u;
+const auto kFrameBudget = 0.04;
+const auto kMaxSteerAge = 10u;
+const auto kMpcDeadlineNs = 200000u;
+
+// Max speed in miles-per-hour, max initial CTE and the steering noise
+const auto kMaxSpeed = 50.;
+const auto kMaxInitialCte = 2.;
+const auto kSteeringNoise = 0.5 / 180. * M_PI;
+
+// Interval of the timer of a client loop sending the telemetry, in
+// milliseconds
+const auto kTickMs = 1;
+
+// Telemetry of the simulator
+const char kTelemetryFormat[] =
+  "42[\"telemetry\",{\"cte\":\"%.4f\",\"speed\":\"%.4f\","
+  "\"steering_angle\":\"0.0000\"}]";
+
+// Prefixes of the numbers of a steering command, and of a reset
+const char kSteeringPrefix[] = "42[\"steer\",{\"steering_angle\":";
+const char kThrottlePrefix[] = ",\"throttle\":";
+const char kResetPrefix[] = "42[\"reset\"";
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Controller modes of the sessions
+enum class Mode {
+  kFinal,
+  kTuning
+};
+
+
+// Simulated client of a session, a vehicle of the kinematic Robot model
+// connected to pid by a WebSocket. Like the simulator, it sends its telemetry
+// at the simulator framerate but waits for the reply to the last one, skipping
+// the frames in between.
+struct Client {
+  Client(unsigned int seed, double initial_cte, double next_frame)
+    : simulator(kMaxSpeed, initial_cte, 0., kSteeringNoise, seed),
+      is_open(),
+      is_waiting(),
+      sent(),
+      next_frame(next_frame),
+      steering(),
+      throttle() {}
+
+  Simulator simulator;
+  uWS::WebSocket<uWS::CLIENT> ws;
+  // Indicates the connection is open, and the client waits for a reply
+  bool is_open;
+  bool is_waiting;
+  // Send time of the last telemetry, and time of the next frame in seconds
+  double sent;
+  double next_frame;
+  // Last steering command, applied again by manual driving
+  double steering;
+  double throttle;
+};
+
+// Loop thread of clients with its own hub. It connects or closes clients to
+// the count set by the main thread, which takes the latencies.
+class ClientLoop {
+public:
+  // Starts the loop thread, which runs until the process exits.
+  // @param seed  Seed of the first client
+  explicit ClientLoop(unsigned int seed)
+    : seed_(seed),
+      generator_(seed),
+      hub_(),
+      n_target_(),
+      offset_(),
+      n_open_() {
+    std::thread(&ClientLoop::Run, this).detach();
+  }
+
+  // Sets the number of clients, connected round robin to the URLs of pid
+  // from an offset on. The URLs change only once all clients are closed.
+  // @param urls    URLs of pid
+  // @param n       Number of clients
+  // @param offset  Index of the URL of the first client
+  void SetCount(const std::vector<std::string>& urls, unsigned int n,
+                unsigned int offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    urls_ = urls;
+    n_target_ = n;
+    offset_ = offset;
+  }
+
+  // Gets the number of open clients.
+  unsigned int GetOpenCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return n_open_;
+  }
+
+  // Takes the latencies of the replies since the last call.
+  // @param[out] latencies  Latencies in seconds, appended
+  void Take(std::vector<double>& latencies) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latencies.insert(latencies.end(), latencies_.begin(), latencies_.end());
+    latencies_.clear();
+  }
+
+private:
+  // Seed of the next client
+  unsigned int seed_;
+  std::mt19937 generator_;
+
+  // Hub of the loop thread, and its clients which aren't closed
+  uWS::Hub* hub_;
+  std::vector<Client*> clients_;
+
+  // Guards the members below
+  std::mutex mutex_;
+
+  // URLs of pid, number of clients set, the index of the URL of the first
+  // one, and the number of open ones
+  std::vector<std::string> urls_;
+  unsigned int n_target_;
+  unsigned int offset_;
+  unsigned int n_open_;
+
+  // Latencies in seconds since taken
+  std::vector<double> latencies_;
+
+  // Runs the hub of the clients.
+  void Run();
+
+  // Connects or closes clients to the set count, and sends the telemetry of
+  // the clients at their frames.
+  void Tick();
+
+  // Sends the telemetry of a client.
+  // @param client  Client
+  // @param now     Time in seconds
+  void Send(Client& client, double now);
+
+  // Applies the reply of pid to the last telemetry.
+  // @param client  Client
+  // @param data    Message
+  // @param length  Length of the message
+  void Receive(Client& client, const char* data, size_t length);
+
+  // Forgets a client which isn't closed.
+  void Remove(Client* client) {
+    clients_.erase(std::remove(clients_.begin(), clients_.end(), client),
+                   clients_.end());
+  }
+};
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the time of the steady clock.
+// @return  Time in seconds
+double GetSeconds() {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Gets a percentile of samples.
+// @param[in,out] samples     Samples, sorted
+// @param[in]     percentile  Percentile within 0..100
+// @return                    Value of the percentile, 0 if there are none
+double GetPercentile(std::vector<double>& samples, double percentile) {
+  if (samples.empty()) {
+    return 0.;
+  }
+  std::sort(samples.begin(), samples.end());
+  auto i = static_cast<size_t>(percentile / 100. * (samples.size() - 1));
+  return samples[i];
+}
+
+// Gets the name of a mode.
+const char* GetModeName(Mode mode) {
+  return mode == Mode::kFinal ? "final" : "tuning";
+}
+
+// Gets a free ephemeral TCP port of the loopback interface.
+// @return  Port, 0 if there's none
+int GetFreePort() {
+  auto fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(address);
+  auto port = 0;
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), length) == 0
+      && getsockname(fd, reinterpret_cast<sockaddr*>(&address),
+                     &length) == 0) {
+    port = ntohs(address.sin_port);
+  }
+  close(fd);
+  return port;
+}
+
+// Raises the limit of open files to the hard one.
+// @return  Limit of open files
+rlim_t RaiseFileLimit() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+    return kDefaultFileLimit;
+  }
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+  getrlimit(RLIMIT_NOFILE, &limit);
+  return limit.rlim_cur;
+}
+
+// Gets the settings of pid in a mode, its defaults otherwise.
+// @param mode  Controller mode
+// @return      Settings of PID controllers
+ControllerConfig GetConfig(Mode mode) {
+  ControllerConfig config = {};
+  config.kp = kKp;
+  config.ki = kKi;
+  config.kd = kKd;
+  config.off_track_cte = kOffTrackCte;
+  config.is_tuning = mode == Mode::kTuning;
+  config.dkp = kDkp;
+  config.dki = kDki;
+  config.dkd = kDkd;
+  config.track_length = kTrackLength;
+  config.tuner = "twiddle";
+  config.transform = Tuner::Transform::kLinear;
+  config.limits.min_delta_sum = kMinDeltaSum;
+  config.limits.max_stalled_cycles = kMaxStalledCycles;
+  config.output.max_age = kMaxSteerAge;
+  config.scheduling.budget = kFrameBudget;
+  config.scheduling.off_track_cte = kOffTrackCte;
+  config.steering = "pid";
+  config.mpc_deadline_ns = kMpcDeadlineNs;
+  return config;
+}
+
+// Starts pid on its own loop thread the way main does, on a port. The loop
+// runs until the process exits. Several of them are as many pid processes,
+// e.g. behind a load balancer.
+// @param config  Settings of PID controllers
+// @param port    TCP port
+// @return        True if listening
+bool StartServer(const ControllerConfig& config, int port) {
+  std::shared_ptr<std::promise<bool>> is_listening(new std::promise<bool>());
+  auto future = is_listening->get_future();
+  std::thread([config, port, is_listening]() {
+    uWS::Hub hub;
+    auto is_served = Serve(hub, config, port);
+    is_listening->set_value(is_served);
+    if (is_served) {
+      hub.run();
+    }
+  }).detach();
+  return future.get();
+}
+
+// Sets the number of clients of the client loops, spread evenly over the
+// loop threads of pid, and waits until they are open.
+// @param loops  Client loops
+// @param urls   URLs of the loop threads of pid
+// @param n      Number of clients
+// @return       True if open in time
+bool SetClientCount(const std::vector<ClientLoop*>& loops,
+                    const std::vector<std::string>& urls, unsigned int n) {
+  auto offset = 0u;
+  for (size_t i = 0; i < loops.size(); ++i) {
+    auto n_loop = n / loops.size() + (i < n % loops.size());
+    loops[i]->SetCount(urls, n_loop, offset % urls.size());
+    offset += n_loop;
+  }
+  for (auto end = GetSeconds() + kMaxWaitSeconds; GetSeconds() < end;) {
+    auto n_open = 0u;
+    for (auto loop : loops) {
+      n_open += loop->GetOpenCount();
+    }
+    if (n_open == n) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitMs));
+  }
+  return false;
+}
+
+// Measures the p99 latency of a number of sessions, from sending the
+// telemetry to receiving the reply. The frames the clients skipped, waiting
+// for a late reply, count as late.
+// @param loops       Client loops
+// @param urls        URLs of the loop threads of pid
+// @param n_sessions  Number of sessions
+// @param seconds     Measured seconds
+// @return            p99 latency in seconds, infinite if the clients didn't
+//                    connect in time
+double MeasureP99(const std::vector<ClientLoop*>& loops,
+                  const std::vector<std::string>& urls,
+                  unsigned int n_sessions, double seconds) {
+  if (!SetClientCount(loops, urls, n_sessions)) {
+    return HUGE_VAL;
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(kWarmUpSeconds));
+  std::vector<double> latencies;
+  for (auto loop : loops) {
+    loop->Take(latencies);
+  }
+  latencies.clear();
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  for (auto loop : loops) {
+    loop->Take(latencies);
+  }
+  auto n_frames = static_cast<size_t>(n_sessions * seconds
+                                      * Simulator::kFrameRate);
+  if (latencies.size() < n_frames) {
+    latencies.resize(n_frames, HUGE_VAL);
+  }
+  return GetPercentile(latencies, 99.);
+}
+
+// Client Loop Private Members
+// -----------------------------------------------------------------------------
+
+void ClientLoop::Run() {
+  uWS::Hub hub;
+  hub_ = &hub;
+  hub.onConnection([this](uWS::WebSocket<uWS::CLIENT> ws,
+                          uWS::HttpRequest request) {
+    auto client = static_cast<Client*>(ws.getUserData());
+    client->ws = ws;
+    client->is_open = true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++n_open_;
+  });
+  hub.onError([this](void* user) {
+    // The client is connected again by the next tick
+    auto client = static_cast<Client*>(user);
+    Remove(client);
+    delete client;
+  });
+  hub.onMessage([this](uWS::WebSocket<uWS::CLIENT> ws,
+                       char* data,
+                       size_t length,
+                       uWS::OpCode opCode) {
+    Receive(*static_cast<Client*>(ws.getUserData()), data, length);
+  });
+  hub.onDisconnection([this](uWS::WebSocket<uWS::CLIENT> ws,
+                             int code,
+                             char* message,
+                             size_t length) {
+    auto client = static_cast<Client*>(ws.getUserData());
+    Remove(client);
+    if (client->is_open) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --n_open_;
+    }
+    delete client;
+  });
+  auto timer = new uS::Timer(hub.getLoop());
+  timer->setData(this);
+  timer->start([](uS::Timer* timer) {
+    static_cast<ClientLoop*>(timer->getData())->Tick();
+  }, kTickMs, kTickMs);
+  hub.run();
+}
+
+void ClientLoop::Tick() {
+  std::vector<std::string> urls;
+  unsigned int n_target;
+  unsigned int offset;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (clients_.size() < n_target_) {
+      urls = urls_;
+    }
+    n_target = n_target_;
+    offset = offset_;
+  }
+  // The first frames of new clients are spread over a period
+  auto period = 1. / Simulator::kFrameRate;
+  auto now = GetSeconds();
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  while (clients_.size() < n_target) {
+    auto client = new Client(seed_++, kMaxInitialCte * uniform(generator_),
+                             now + period * uniform(generator_));
+    auto url = urls[(offset + clients_.size()) % urls.size()];
+    clients_.push_back(client);
+    hub_->connect(url, client);
+  }
+  // Surplus clients are closed once connected, forgotten first since closing
+  // may delete them
+  for (auto i = clients_.size(); i > n_target; --i) {
+    auto client = clients_[i - 1];
+    if (client->is_open) {
+      client->is_open = false;
+      clients_.erase(clients_.begin() + (i - 1));
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --n_open_;
+      }
+      client->ws.close();
+    }
+  }
+  for (auto client : clients_) {
+    if (client->is_open && !client->is_waiting && client->next_frame <= now) {
+      Send(*client, now);
+    }
+  }
+}
+
+void ClientLoop::Send(Client& client, double now) {
+  char telemetry[256];
+  auto length = std::snprintf(telemetry, sizeof(telemetry), kTelemetryFormat,
+                              client.simulator.GetCte(),
+                              client.simulator.GetSpeed());
+  client.ws.send(telemetry, length, uWS::OpCode::TEXT);
+  client.is_waiting = true;
+  client.sent = now;
+  // Frames until the reply are skipped
+  auto period = 1. / Simulator::kFrameRate;
+  while (client.next_frame <= now) {
+    client.next_frame += period;
+  }
+}
+
+void ClientLoop::Receive(Client& client, const char* data, size_t length) {
+  if (!client.is_open || !client.is_waiting) {
+    return;
+  }
+  auto now = GetSeconds();
+  client.is_waiting = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latencies_.push_back(now - client.sent);
+  }
+  // The client applies the command, or the last one when driving manually
+  char message[256];
+  length = std::min(length, sizeof(message) - 1);
+  std::memcpy(message, data, length);
+  message[length] = '\0';
+  if (std::strncmp(message, kSteeringPrefix,
+                   sizeof(kSteeringPrefix) - 1) == 0) {
+    char* number_end;
+    client.steering = std::strtod(message + sizeof(kSteeringPrefix) - 1,
+                                  &number_end);
+    if (std::strncmp(number_end, kThrottlePrefix,
+                     sizeof(kThrottlePrefix) - 1) == 0) {
+      client.throttle = std::strtod(number_end + sizeof(kThrottlePrefix) - 1,
+                                    nullptr);
+    }
+  } else if (std::strncmp(message, kResetPrefix,
+                          sizeof(kResetPrefix) - 1) == 0) {
+    client.simulator.Reset();
+    client.steering = 0.;
+    client.throttle = 0.;
+    return;
+  }
+  client.simulator.Control(client.steering, client.throttle);
+  if (client.next_frame <= now) {
+    Send(client, now);
+  }
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+  auto n_cores = std::max(1u, std::thread::hardware_concurrency());
+  if (argc > 4) {
+    std::cerr << "Usage: bench_frame_path [sloMs [maxThreads [seconds]]]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  auto slo = 1e-3 * (argc > 1 ? std::atof(argv[1]) : kDefaultSloMs);
+  auto max_threads = std::max(1, argc > 2 ? std::atoi(argv[2]) :
+                                            static_cast<int>(n_cores));
+  auto seconds = argc > 3 ? std::atof(argv[3]) : kDefaultSeconds;
+  std::vector<unsigned int> thread_counts;
+  for (auto n = 1; n < max_threads; n *= 2) {
+    thread_counts.push_back(n);
+  }
+  thread_counts.push_back(max_threads);
+  // Two file descriptors per session, the client and the server ones
+  auto max_total = static_cast<unsigned int>(
+    (RaiseFileLimit() - kReservedFileCount) / 2);
+  // The clients run on the other cores than a loop thread of pid
+  auto n_client_loops = std::max(2u, n_cores) - 1;
+  std::vector<ClientLoop*> loops;
+  for (unsigned int i = 0; i < n_client_loops; ++i) {
+    loops.push_back(new ClientLoop((i + 1) * kMaxSessionCount));
+  }
+
+  // pid logs per connection, silenced while measuring
+  AsyncLogger::GetDefault().SetQuiet(true);
+  for (auto mode : {Mode::kFinal, Mode::kTuning}) {
+    std::vector<std::string> urls;
+    for (auto i = 0; i < max_threads; ++i) {
+      auto port = GetFreePort();
+      if (port == 0 || !StartServer(GetConfig(mode), port)) {
+        std::cerr << "Failed to listen on an ephemeral port" << std::endl;
+        return EXIT_FAILURE;
+      }
+      urls.push_back("ws://127.0.0.1:" + std::to_string(port) + "/");
+    }
+    for (auto n_threads : thread_counts) {
+      std::vector<std::string> thread_urls(urls.begin(),
+                                           urls.begin() + n_threads);
+      auto max_sessions = std::max(1u, std::min(kMaxSessionCount,
+                                                max_total / n_threads));
+
+      // Doubles the sessions per loop thread until the SLO is violated, then
+      // bisects
+      auto n_good = 0u;
+      auto p99_good = 0.;
+      auto n_bad = 0u;
+      for (auto n = std::min(kMinSessionCount, max_sessions); n_bad == 0;
+           n *= 2) {
+        n = std::min(n, max_sessions);
+        auto p99 = MeasureP99(loops, thread_urls, n * n_threads, seconds);
+        if (p99 > slo) {
+          n_bad = n;
+        } else {
+          n_good = n;
+          p99_good = p99;
+          if (n == max_sessions) {
+            break;
+          }
+        }
+      }
+      for (auto i = 0; i < kBisectionCount && n_bad > n_good + 1; ++i) {
+        auto n = (n_good + n_bad) / 2;
+        auto p99 = MeasureP99(loops, thread_urls, n * n_threads, seconds);
+        if (p99 > slo) {
+          n_bad = n;
+        } else {
+          n_good = n;
+          p99_good = p99;
+        }
+      }
+      SetClientCount(loops, thread_urls, 0);
+
+      // Loop threads beyond the cores share them
+      nlohmann::json result;
+      result["mode"] = GetModeName(mode);
+      result["slo_ms"] = 1e3 * slo;
+      result["threads"] = n_threads;
+      result["client_threads"] = n_client_loops;
+      result["sessions_per_thread"] = n_good;
+      result["sessions"] = n_good * n_threads;
+      result["sessions_per_core"] = 1. * n_good * n_threads
+                                    / std::min(n_threads, n_cores);
+      result["p99_ms"] = 1e3 * p99_good;
+      result["first_violating_sessions_per_thread"] = n_bad;
+      std::printf("%s\n", result.dump().c_str());
+      std::fflush(stdout);
+    }
+  }
+  return EXIT_SUCCESS;
+}
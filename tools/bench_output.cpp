@@ -0,0 +1,134 @@
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../src/Session.h"
+#include "../src/SteerOutput.h"
+#include "../src/Simulator.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Steering epsilons of the output stage, 0 sends every command
+const double kEpsilons[] = {0., 0.001, 0.005, 0.02};
+
+// Corking intervals in frames, 1 writes every frame at once
+const unsigned int kCorkFrames[] = {1, 2};
+
+// Max number of commands suppressed in a row
+const auto kMaxAge = 10u;
+
+// Number of simulated connections, and frames driven by every one
+const auto kConnectionCount = 100;
+const auto kFrameCount = 3000;
+
+// Final PID coefficients and the off-track CTE
+const auto kKp = 0.12;
+const auto kKi = 1e-5;
+const auto kKd = 4.0;
+const auto kOffTrackCte = 5.;
+
+// Target speed in miles-per-hour
+const auto kSpeed = 50.;
+
+// Initial CTE, steering drift and noise of the offline vehicle
+const auto kInitialCte = 2.;
+const auto kSteeringDrift = 1. / 180. * M_PI;
+const auto kSteeringNoise = 0.5 / 180. * M_PI;
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Result of driving all connections through the output stage
+struct OutputResult {
+  SteerOutput::Counters counters;
+  uint64_t n_telemetry;
+  double avg_cte;
+};
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Drives the connections through an output stage. As the simulator does,
+// every vehicle keeps applying the last command it received, and sends the
+// next telemetry event only after a reply to the last one.
+// @param[in] epsilon      Steering epsilon of the output stage
+// @param[in] cork_frames  Corking interval in frames
+// @return                 Counters, telemetry events and the average CTE of
+//                         all vehicles
+OutputResult Drive(double epsilon, unsigned int cork_frames) {
+  OutputResult result = {};
+  SessionPool sessions;
+  for (auto c = 0; c < kConnectionCount; ++c) {
+    auto session = sessions.Acquire(kKp, kKi, kKd, kOffTrackCte);
+    SteerOutput output({epsilon, kMaxAge}, result.counters);
+    Simulator simulator(kSpeed, kInitialCte, kSteeringDrift, kSteeringNoise,
+                        c + 1);
+    auto received_steering = 0.;
+    auto received_throttle = 0.;
+    auto last_steering = 0.;
+    auto last_throttle = 0.;
+    auto is_waiting = false;
+    for (auto frame = 1; frame <= kFrameCount; ++frame) {
+      auto cte = simulator.GetCte();
+      result.avg_cte += std::fabs(cte) / (kConnectionCount * kFrameCount);
+      if (!is_waiting) {
+        ++result.n_telemetry;
+        is_waiting = true;
+        double steering;
+        double throttle;
+        session->Update(cte, simulator.GetSpeed(), steering, throttle);
+        if (output.Control(steering, throttle)) {
+          last_steering = steering;
+          last_throttle = throttle;
+        }
+      }
+      if (frame % cork_frames == 0) {
+        output.Flush([&](std::vector<std::string>&) {
+          received_steering = last_steering;
+          received_throttle = last_throttle;
+          is_waiting = false;
+        });
+      }
+      simulator.Control(received_steering, received_throttle);
+    }
+    sessions.Release(session);
+  }
+  return result;
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main() {
+  auto seconds = kConnectionCount * kFrameCount / Simulator::kFrameRate;
+  std::ostringstream oss;
+  oss << "Per connection-second of " << kConnectionCount << " connections at "
+      << kSpeed << "mph, max age " << kMaxAge << " frames" << std::endl
+      << std::setw(10) << "epsilon" << std::setw(8) << "cork"
+      << std::setw(12) << "messages/s" << std::setw(10) << "writes/s"
+      << std::setw(10) << "bytes/s" << std::setw(13) << "telemetry/s"
+      << std::setw(12) << "suppressed"
+      << std::setw(10) << "avg CTE" << std::endl << std::fixed;
+  for (auto epsilon : kEpsilons) {
+    for (auto cork_frames : kCorkFrames) {
+      auto result = Drive(epsilon, cork_frames);
+      const auto& counters = result.counters;
+      oss << std::setw(10) << std::setprecision(3) << epsilon << std::setw(8)
+          << cork_frames << std::setprecision(1) << std::setw(12)
+          << counters.n_messages / seconds << std::setw(10)
+          << counters.n_writes / seconds << std::setw(10)
+          << counters.n_bytes / seconds << std::setw(13)
+          << result.n_telemetry / seconds << std::setw(11)
+          << 100. * counters.n_suppressed / counters.n_commands << "%"
+          << std::setprecision(4) << std::setw(10) << result.avg_cte
+          << std::endl;
+    }
+  }
+  std::cout << oss.str();
+  return EXIT_SUCCESS;
+}
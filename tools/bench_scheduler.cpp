@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "../src/FrameScheduler.h"
+#include "../src/Session.h"
+#include "../src/Simulator.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Loads of the loop thread, the compute time of all frames per second
+const double kLoads[] = {0.5, 0.8, 0.95, 1.05};
+
+// Frame budgets of the scheduler in seconds, 0 runs frames in the order of
+// arrival, as the sockets got ready
+const double kBudgets[] = {0., 0.04};
+
+// Compute time of a frame in seconds, e.g. mpc at its default deadline
+const auto kFrameSeconds = 200e-6;
+
+// Part of the frame period the frames of all simulators arrive within, the
+// simulators render at the same rate, so the loop is overloaded in bursts
+const auto kArrivalSpread = 0.25;
+
+// Max number of frames run at once, before draining newly ready sockets
+const auto kSliceCount = 8u;
+
+// Simulated duration in seconds
+const auto kSeconds = 20.;
+
+// Final PID coefficients and the off-track CTE
+const auto kKp = 0.12;
+const auto kKi = 1e-5;
+const auto kKd = 4.0;
+const auto kOffTrackCte = 5.;
+
+// Frames with |CTE| above it are urgent
+const auto kUrgentCte = 0.5 * kOffTrackCte;
+
+// Target speed in miles-per-hour
+const auto kSpeed = 50.;
+
+// Max initial CTE, max steering drift and the noise of the vehicles
+const auto kMaxInitialCte = 4.;
+const auto kMaxSteeringDrift = 3. / 180. * M_PI;
+const auto kSteeringNoise = 0.5 / 180. * M_PI;
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Simulated vehicle of a connection
+struct Vehicle {
+  Session* session;
+  Simulator simulator;
+  // Time of the next frame
+  double next_frame;
+  // Last received steering and throttle
+  double steering;
+  double throttle;
+};
+
+// Latencies of the frames and the off-track events of all vehicles
+struct SchedulerResult {
+  std::vector<double> urgent_latencies;
+  std::vector<double> latencies;
+  unsigned int n_off_track;
+};
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets a percentile of samples.
+// @param[in,out] samples     Samples, sorted
+// @param[in]     percentile  Percentile within 0..100
+// @return                    Value of the percentile, 0 if there are none
+double GetPercentile(std::vector<double>& samples, double percentile) {
+  if (samples.empty()) {
+    return 0.;
+  }
+  std::sort(samples.begin(), samples.end());
+  auto i = static_cast<size_t>(percentile / 100. * (samples.size() - 1));
+  return samples[i];
+}
+
+// Drives vehicles served by one loop thread. The loop drains the frames of
+// the ready sockets, then runs a slice of the pending ones, every frame taking
+// the same compute time, and a vehicle applies a command from its next frame
+// after it's sent.
+// @param[in] load    Load of the loop thread
+// @param[in] budget  Frame budget of the scheduler
+// @return            Latencies and off-track events
+SchedulerResult Drive(double load, double budget) {
+  SchedulerResult result = {};
+  auto period = 1. / Simulator::kFrameRate;
+  auto vehicle_count = static_cast<int>(load * period / kFrameSeconds + 0.5);
+  SessionPool sessions;
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  std::vector<Vehicle> vehicles;
+  vehicles.reserve(vehicle_count);
+  for (auto v = 0; v < vehicle_count; ++v) {
+    vehicles.push_back({sessions.Acquire(kKp, kKi, kKd, kOffTrackCte),
+                        Simulator(kSpeed, kMaxInitialCte * uniform(generator),
+                                  kMaxSteeringDrift * uniform(generator),
+                                  kSteeringNoise, v + 1),
+                        kArrivalSpread * period * uniform(generator), 0.,
+                        0.});
+  }
+
+  FrameScheduler scheduler({budget, kOffTrackCte});
+  std::vector<FrameScheduler::Frame> ready;
+  auto now = 0.;
+  // Steps the vehicles with frames before the time, their sockets get ready
+  auto step = [&](double time) {
+    for (auto& vehicle : vehicles) {
+      while (vehicle.next_frame < time) {
+        vehicle.simulator.Control(vehicle.steering, vehicle.throttle);
+        auto cte = vehicle.simulator.GetCte();
+        if (std::fabs(cte) > kOffTrackCte) {
+          ++result.n_off_track;
+          vehicle.simulator.Reset();
+          cte = vehicle.simulator.GetCte();
+        }
+        ready.push_back({&vehicle, vehicle.next_frame, 0., cte,
+                         vehicle.simulator.GetSpeed(), 0});
+        vehicle.next_frame += period;
+      }
+    }
+  };
+  auto run = [&](const FrameScheduler::Frame& frame) {
+    auto vehicle = static_cast<Vehicle*>(frame.context);
+    step(now + kFrameSeconds);
+    now += kFrameSeconds;
+    vehicle->session->Update(frame.cte, frame.speed, vehicle->steering,
+                             vehicle->throttle);
+    if (frame.arrival > 1.) {
+      // Latencies after the first second of starting up
+      result.latencies.push_back(now - frame.arrival);
+      if (std::fabs(frame.cte) > kUrgentCte) {
+        result.urgent_latencies.push_back(now - frame.arrival);
+      }
+    }
+  };
+  while (now < kSeconds) {
+    step(now);
+    if (ready.empty() && scheduler.GetPendingCount() == 0) {
+      // Idle until the next frame
+      auto next = std::min_element(vehicles.begin(), vehicles.end(),
+                                   [](const Vehicle& a, const Vehicle& b) {
+                                     return a.next_frame < b.next_frame;
+                                   });
+      now = std::nextafter(next->next_frame, 2. * kSeconds);
+      continue;
+    }
+    for (const auto& frame : ready) {
+      scheduler.Push(frame.context, frame.arrival, frame.cte, frame.speed);
+    }
+    ready.clear();
+    scheduler.Run(run, kSliceCount);
+  }
+  for (auto& vehicle : vehicles) {
+    sessions.Release(vehicle.session);
+  }
+  return result;
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main() {
+  std::ostringstream oss;
+  oss << "Frame latency in ms of " << kSpeed << "mph vehicles, "
+      << 1e6 * kFrameSeconds << "us per frame, urgent at |CTE| > "
+      << kUrgentCte << std::endl
+      << std::setw(6) << "load" << std::setw(10) << "budget"
+      << std::setw(10) << "urgent" << std::setw(10) << "p50"
+      << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+      << std::setw(10) << "all p50" << std::setw(10) << "all p99"
+      << std::setw(11) << "off-track" << std::endl << std::fixed;
+  for (auto load : kLoads) {
+    for (auto budget : kBudgets) {
+      auto result = Drive(load, budget);
+      auto& urgent = result.urgent_latencies;
+      auto& all = result.latencies;
+      oss << std::setprecision(2) << std::setw(6) << load
+          << std::setprecision(0) << std::setw(8) << 1e3 * budget << "ms"
+          << std::setprecision(2) << std::setw(9)
+          << 100. * urgent.size() / all.size() << "%"
+          << std::setprecision(1) << std::setw(10)
+          << 1e3 * GetPercentile(urgent, 50.) << std::setw(10)
+          << 1e3 * GetPercentile(urgent, 99.) << std::setw(10)
+          << 1e3 * GetPercentile(urgent, 99.9) << std::setw(10)
+          << 1e3 * GetPercentile(all, 50.) << std::setw(10)
+          << 1e3 * GetPercentile(all, 99.) << std::setw(11)
+          << result.n_off_track << std::endl;
+    }
+  }
+  std::cout << oss.str();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,335 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "../src/AsyncLogger.h"
+#include "../src/PidController.h"
+#include "../src/Session.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Numbers of concurrent sessions
+const size_t kSessionCounts[] = {1000, 10000, 100000};
+
+// Number of frames updated per measurement, round-robin over the sessions
+const auto kFrameCount = 2000000ul;
+
+// CTE when the vehicle is considered off-track
+const auto kOffTrackCte = 5.;
+
+// Final PID coefficients
+const auto kKp = 0.12;
+const auto kKi = 1e-5;
+const auto kKd = 4.0;
+
+// Numbers of threads serving connections
+const int kThreadCounts[] = {1, 4};
+
+// Number of connections per thread when churning, and frames per connection
+const auto kConnectionCount = 200000;
+const auto kConnectionFrameCount = 10;
+
+// Number of sessions running shadow candidates, and frames per measurement
+const auto kShadowSessionCount = 10000ul;
+const auto kShadowFrameCount = 10000000ul;
+
+// Speed in miles-per-hour
+const auto kSpeed = 50.;
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Result of a measurement
+struct Measurement {
+  double bytes_per_session;
+  double frames_per_second;
+};
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Number of bytes allocated by operator new and not deleted yet
+std::atomic<size_t> g_allocated_size(0);
+
+// Gets the CTE of a session at a frame, different phases across sessions.
+// @param[in] i      Index of the session
+// @param[in] frame  Index of the frame
+// @return           CTE
+double GetCte(size_t i, size_t frame) {
+  return std::sin(0.05 * frame + 0.001 * i);
+}
+
+// Measures controllers allocated one by one on the heap, the way every
+// connection was served before sessions.
+// @param[in] n  Number of controllers
+// @return       Memory and throughput
+Measurement MeasureControllers(size_t n) {
+  size_t allocated_size = g_allocated_size;
+  std::vector<std::unique_ptr<PidController>> controllers;
+  controllers.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    controllers.emplace_back(new PidController(kKp, kKi, kKd, kOffTrackCte));
+  }
+  AsyncLogger::GetDefault().Flush();
+  Measurement result = {};
+  result.bytes_per_session = static_cast<double>(
+    g_allocated_size - allocated_size - n * sizeof(PidController*)) / n;
+
+  auto sum_steering = 0.;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t frame = 0; frame < kFrameCount; ++frame) {
+    auto i = frame % n;
+    controllers[i]->Update(GetCte(i, frame / n), kSpeed,
+                           [&sum_steering](double steering, double) {
+                             sum_steering += steering;
+                           },
+                           []() { });
+  }
+  std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  result.frames_per_second = kFrameCount / elapsed.count();
+  return sum_steering == 0. ? Measurement() : result;
+}
+
+// Measures sessions with inline PID allocated from a pool.
+// @param[in] n  Number of sessions
+// @return       Memory and throughput
+Measurement MeasureSessions(size_t n) {
+  size_t allocated_size = g_allocated_size;
+  SessionPool pool;
+  std::vector<Session*> sessions;
+  sessions.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    sessions.push_back(pool.Acquire(kKp, kKi, kKd, kOffTrackCte));
+  }
+  Measurement result = {};
+  // The slabs are allocated with posix_memalign rather than operator new
+  result.bytes_per_session = static_cast<double>(
+    g_allocated_size - allocated_size - n * sizeof(Session*)
+    + pool.GetReservedSize()) / n;
+
+  auto sum_steering = 0.;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t frame = 0; frame < kFrameCount; ++frame) {
+    auto i = frame % n;
+    double steering;
+    double throttle;
+    sessions[i]->Update(GetCte(i, frame / n), kSpeed, steering, throttle);
+    sum_steering += steering;
+  }
+  std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  result.frames_per_second = kFrameCount / elapsed.count();
+  for (auto session : sessions) {
+    pool.Release(session);
+  }
+  return sum_steering == 0. ? Measurement() : result;
+}
+
+// Measures the time per frame of sessions running shadow candidates.
+// @param[in] n_shadows  Number of shadow candidates per session
+// @return               Nanoseconds per frame
+double MeasureShadows(int n_shadows) {
+  SessionPool pool;
+  std::vector<Session*> sessions;
+  for (size_t i = 0; i < kShadowSessionCount; ++i) {
+    sessions.push_back(pool.Acquire(kKp, kKi, kKd, kOffTrackCte));
+    for (auto k = 0; k < n_shadows; ++k) {
+      sessions.back()->AddShadow((1.1 + 0.1 * k) * kKp, kKi, kKd);
+    }
+  }
+  auto sum_steering = 0.;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t frame = 0; frame < kShadowFrameCount; ++frame) {
+    auto i = frame % kShadowSessionCount;
+    double steering;
+    double throttle;
+    sessions[i]->Update(GetCte(i, frame / kShadowSessionCount), kSpeed,
+                        steering, throttle);
+    sum_steering += steering;
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  for (auto session : sessions) {
+    pool.Release(session);
+  }
+  return sum_steering == 0. ? 0. : elapsed.count() / kShadowFrameCount;
+}
+
+// Measures connections per second, every connection creating a session or a
+// controller, driving a few frames and destroying it.
+// @param[in] n_threads    Number of threads serving connections
+// @param[in] is_pooled    Indication whether sessions come from a pool
+// @return                 Connections per second
+double MeasureChurn(int n_threads, bool is_pooled) {
+  SessionPool pool;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (auto t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&pool, is_pooled, t]() {
+      double steering;
+      double throttle;
+      for (auto i = 0; i < kConnectionCount; ++i) {
+        std::unique_ptr<PidController> controller;
+        auto session = is_pooled ?
+          pool.Acquire(kKp, kKi, kKd, kOffTrackCte) : nullptr;
+        if (!is_pooled) {
+          controller.reset(new PidController(kKp, kKi, kKd, kOffTrackCte));
+        }
+        for (auto frame = 0; frame < kConnectionFrameCount; ++frame) {
+          auto cte = GetCte(t, frame);
+          if (is_pooled) {
+            session->Update(cte, kSpeed, steering, throttle);
+          } else {
+            controller->Update(cte, kSpeed, [](double, double) { },
+                               []() { });
+          }
+        }
+        pool.Release(session);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return n_threads * kConnectionCount / elapsed.count();
+}
+
+// Allocation counting
+// -----------------------------------------------------------------------------
+
+namespace {
+
+// Counts and allocates memory. Blocks count with their usable size, which is
+// known again on release without keeping a size prefix.
+// @param size  Size in bytes
+// @return      Memory, nullptr if out of memory
+void* Allocate(size_t size) {
+  auto memory = std::malloc(size > 0 ? size : 1);
+  if (memory) {
+    g_allocated_size += malloc_usable_size(memory);
+  }
+  return memory;
+}
+
+// Counts and allocates memory, throws if out of memory.
+// @param size  Size in bytes
+// @return      Memory
+void* AllocateOrThrow(size_t size) {
+  auto memory = Allocate(size);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+// Counts and releases memory.
+// @param memory  Memory, may be nullptr
+void Release(void* memory) {
+  g_allocated_size -= malloc_usable_size(memory);
+  std::free(memory);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+  return AllocateOrThrow(size);
+}
+
+void* operator new[](size_t size) {
+  return AllocateOrThrow(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+  Release(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  Release(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  Release(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+  Release(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  Release(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+  Release(memory);
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main() {
+  // Controllers report to the standard output, keep the table readable
+  std::ostringstream log;
+  auto cout_buffer = std::cout.rdbuf(log.rdbuf());
+  std::ostringstream oss;
+  oss << std::setw(10) << "sessions" << std::setw(14) << "kind"
+      << std::setw(14) << "bytes/session" << std::setw(14) << "frames/s"
+      << std::endl << std::fixed;
+  for (auto n : kSessionCounts) {
+    auto controllers = MeasureControllers(n);
+    auto sessions = MeasureSessions(n);
+    oss << std::setw(10) << n << std::setw(14) << "controller"
+        << std::setprecision(0) << std::setw(14)
+        << controllers.bytes_per_session << std::setw(14)
+        << controllers.frames_per_second << std::endl
+        << std::setw(10) << n << std::setw(14) << "session"
+        << std::setw(14) << sessions.bytes_per_session << std::setw(14)
+        << sessions.frames_per_second << std::endl;
+  }
+  oss << std::endl << std::setw(10) << "threads" << std::setw(14) << "kind"
+      << std::setw(14) << "connects/s" << std::endl;
+  for (auto n_threads : kThreadCounts) {
+    auto controllers = MeasureChurn(n_threads, false);
+    auto sessions = MeasureChurn(n_threads, true);
+    oss << std::setw(10) << n_threads << std::setw(14) << "controller"
+        << std::setw(14) << controllers << std::endl
+        << std::setw(10) << n_threads << std::setw(14) << "session"
+        << std::setw(14) << sessions << std::endl;
+  }
+  oss << std::endl << std::setw(10) << "shadows" << std::setw(14)
+      << "ns/frame" << std::setw(14) << "ns/shadow" << std::endl
+      << std::setprecision(1);
+  auto production_ns = 0.;
+  for (auto n_shadows = 0; n_shadows <= Session::kMaxShadowCount;
+       ++n_shadows) {
+    auto ns = MeasureShadows(n_shadows);
+    production_ns = n_shadows == 0 ? ns : production_ns;
+    oss << std::setw(10) << n_shadows << std::setw(14) << ns << std::setw(14)
+        << (n_shadows == 0 ? 0. : (ns - production_ns) / n_shadows)
+        << std::endl;
+  }
+  AsyncLogger::GetDefault().Flush();
+  std::cout.rdbuf(cout_buffer);
+  std::cout << oss.str();
+  return EXIT_SUCCESS;
+}
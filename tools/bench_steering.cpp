@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "../src/PidController.h"
+#include "../src/Simulator.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Target speeds in miles-per-hour
+const double kSpeeds[] = {30, 50, 70, 90};
+
+// Lap length in meters
+const auto kLapLength = 2000.;
+
+// CTE when the vehicle is considered off-track
+const auto kOffTrackCte = 5.;
+
+// Default PID coefficients
+const auto kKp = 0.12;
+const auto kKi = 1e-5;
+const auto kKd = 4.0;
+
+// Default Stanley gains
+const auto kK = 2.0;
+const auto kKSoft = 1.0;
+const auto kKHeading = 0.8;
+
+// Initial part of the lap where max CTE updates are skipped
+const auto kSkipMaxCtePart = 0.1;
+
+// Initial CTE, steering drift and noise of the offline vehicle
+const auto kInitialCte = 2.;
+const auto kSteeringDrift = 1. / 180. * M_PI;
+const auto kSteeringNoise = 0.5 / 180. * M_PI;
+
+// Per-frame compute deadline of model-predictive control
+const auto kMpcDeadlineNs = 200000;
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Statistics of a lap
+struct LapResult {
+  double time;
+  double max_cte;
+  double avg_cte;
+  bool is_off_track;
+};
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Drives a lap with the given steering backend.
+// @param[in] backend  Steering backend
+// @param[in] speed    Target speed in miles-per-hour
+// @return             Statistics of the lap
+LapResult DriveLap(SteeringBackend backend, double speed) {
+  auto is_stanley = backend == SteeringBackend::kStanley;
+  PidController controller(is_stanley ? kK : kKp,
+                           is_stanley ? kKSoft : kKi,
+                           is_stanley ? kKHeading : kKd,
+                           kOffTrackCte);
+  controller.SetSteeringBackend(backend, kMpcDeadlineNs);
+  Simulator simulator(speed, kInitialCte, kSteeringDrift, kSteeringNoise);
+  LapResult result = {};
+  auto sum_cte = 0.;
+  while (simulator.GetDistance() < kLapLength && !result.is_off_track) {
+    auto cte = simulator.GetCte();
+    sum_cte += std::fabs(cte);
+    if (simulator.GetDistance() > kSkipMaxCtePart * kLapLength) {
+      result.max_cte = std::max(result.max_cte, std::fabs(cte));
+    }
+    result.is_off_track = std::fabs(cte) > kOffTrackCte;
+    controller.Update(cte, simulator.GetSpeed(),
+                      [&simulator](double steering, double throttle) {
+                        simulator.Control(steering, throttle);
+                      },
+                      [&result]() { result.is_off_track = true; });
+  }
+  result.time = simulator.GetFrameCount() / Simulator::kFrameRate;
+  result.avg_cte = sum_cte / std::max(1ul, simulator.GetFrameCount());
+  return result;
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main() {
+  const SteeringBackend backends[] = {SteeringBackend::kPid,
+                                      SteeringBackend::kStanley,
+                                      SteeringBackend::kMpc};
+  const char* names[] = {"pid", "stanley", "mpc"};
+  std::ostringstream oss;
+  oss << std::setw(8) << "speed" << std::setw(10) << "backend"
+      << std::setw(10) << "time,s" << std::setw(10) << "max CTE"
+      << std::setw(10) << "avg CTE" << std::setw(11) << "off track"
+      << std::endl << std::fixed << std::setprecision(3);
+  for (auto speed : kSpeeds) {
+    for (auto i = 0; i < 3; ++i) {
+      auto result = DriveLap(backends[i], speed);
+      oss << std::setw(8) << std::setprecision(0) << speed << std::setw(10)
+          << names[i] << std::setprecision(3) << std::setw(10) << result.time
+          << std::setw(10) << result.max_cte << std::setw(10)
+          << result.avg_cte << std::setw(11)
+          << (result.is_off_track ? "yes" : "no") << std::endl;
+    }
+  }
+  std::cout << oss.str();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../src/AsyncLogger.h"
+#include "../src/PidController.h"
+#include "../src/TelemetryArchive.h"
+#include "../src/Simulator.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Archive of the recorded sessions
+const auto kPath = "bench_telemetry.tlm";
+
+// Number of recorded sessions and frames per session
+const auto kSessionCount = 8;
+const auto kFrameCount = 100000;
+
+// Frame interval and the standard deviation of its jitter in microseconds
+const auto kFrameInterval = 40000.;
+const auto kFrameJitter = 1000.;
+
+// Tuning of the recorded sessions, Kp differs between them
+const auto kKp = 0.08;
+const auto kKpSpread = 0.04;
+const auto kKi = 1e-4;
+const auto kKd = 3.;
+const auto kOffTrackCte = 5.;
+const auto kDkp = 0.02;
+const auto kDki = 1e-5;
+const auto kDkd = 0.5;
+const auto kTrackLength = 500.;
+
+// Max speed in miles-per-hour and the steering noise in radians
+const auto kMaxSpeed = 100.;
+const auto kSteeringNoise = 0.5 / 180. * M_PI;
+
+// Size of a raw frame: the timestamp and four doubles
+const auto kRawFrameSize = sizeof(TelemetryFrame);
+
+// Number of random lap seeks
+const auto kSeekCount = 10000;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the monotonic time in nanoseconds.
+double GetNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Records tuning sessions on the offline simulator, one after another, with
+// laps and resets as the boundaries.
+// @param[out] seconds  Time of appending the frames in seconds
+// @return              True if the archive was written
+bool Record(double& seconds) {
+  std::mt19937 rng(1);
+  std::normal_distribution<double> jitter(0., kFrameJitter);
+  TelemetryWriter writer;
+  if (!writer.Open(kPath, 0)) {
+    return false;
+  }
+  seconds = 0.;
+  auto timestamp = 0.;
+  for (auto session = 0; session < kSessionCount; ++session) {
+    PidController controller(kKp + kKpSpread * session / kSessionCount, kKi,
+                             kKd, kOffTrackCte, kDkp, kDki, kDkd,
+                             kTrackLength);
+    Simulator simulator(kMaxSpeed, 1., 0., kSteeringNoise, session + 1);
+    for (auto i = 0; i < kFrameCount; ++i) {
+      timestamp += kFrameInterval + jitter(rng);
+      TelemetryFrame frame = {static_cast<uint64_t>(timestamp),
+                              simulator.GetCte(), simulator.GetSpeed(),
+                              0., 0.};
+      auto n_laps = controller.GetLapCount();
+      auto is_reset = false;
+      controller.Update(frame.cte, frame.speed,
+                        [&](double steering, double throttle) {
+                          frame.steering = steering;
+                          frame.throttle = throttle;
+                          simulator.Control(steering, throttle);
+                        },
+                        [&]() {
+                          is_reset = true;
+                          simulator.Reset();
+                        });
+      auto start = GetNanoseconds();
+      writer.Append(frame);
+      if (controller.GetLapCount() != n_laps) {
+        writer.EndLap(LapEnd::kComplete);
+      } else if (is_reset) {
+        writer.EndLap(LapEnd::kReset);
+      }
+      seconds += (GetNanoseconds() - start) / 1e9;
+    }
+    writer.EndLap(LapEnd::kOpen);
+  }
+  auto start = GetNanoseconds();
+  auto is_written = writer.Close();
+  seconds += (GetNanoseconds() - start) / 1e9;
+  return is_written;
+}
+
+// Reports the laps of an archive and its decode throughput.
+// @param[in] reader  Loaded archive
+// @param[in] oss     Output stream
+void ReportArchive(const TelemetryReader& reader, std::ostream& oss) {
+  size_t n_laps[3] = {};
+  for (size_t i = 0; i < reader.GetLapCount(); ++i) {
+    ++n_laps[static_cast<int>(reader.GetLap(i).end)];
+  }
+  auto n_frames = reader.GetFrameCount();
+  oss << std::fixed << "Archive of " << n_frames << " frames, "
+      << reader.GetLapCount() << " laps: "
+      << n_laps[static_cast<int>(LapEnd::kComplete)] << " complete, "
+      << n_laps[static_cast<int>(LapEnd::kReset)] << " reset, "
+      << n_laps[static_cast<int>(LapEnd::kOpen)] << " open" << std::endl
+      << "Size " << reader.GetSize() << " bytes against "
+      << std::setprecision(0) << 1. * n_frames * kRawFrameSize << " raw, ratio "
+      << std::setprecision(2) << 1. * n_frames * kRawFrameSize
+                                 / reader.GetSize()
+      << ", " << std::setprecision(1) << 8. * reader.GetSize() / n_frames
+      << " bits per frame" << std::endl;
+
+  // Decoding every lap in order
+  std::vector<TelemetryFrame> frames;
+  frames.reserve(n_frames);
+  auto start = GetNanoseconds();
+  for (size_t i = 0; i < reader.GetLapCount(); ++i) {
+    reader.ReadLap(i, frames);
+  }
+  auto seconds = (GetNanoseconds() - start) / 1e9;
+  oss << "Decode: " << std::setprecision(0) << n_frames / seconds
+      << " frames/s, " << std::setprecision(1)
+      << n_frames * kRawFrameSize / seconds / 1e6 << " MB/s of raw frames"
+      << std::endl;
+
+  // Seeking to random laps and decoding them
+  if (reader.GetLapCount() > 0) {
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<size_t> lap(0, reader.GetLapCount() - 1);
+    unsigned long int n_seek_frames = 0;
+    start = GetNanoseconds();
+    for (auto i = 0; i < kSeekCount; ++i) {
+      frames.clear();
+      reader.ReadLap(lap(rng), frames);
+      n_seek_frames += frames.size();
+    }
+    seconds = (GetNanoseconds() - start) / 1e9;
+    oss << "Random lap: " << std::setprecision(1)
+        << 1e6 * seconds / kSeekCount << "us per lap of "
+        << std::setprecision(0) << 1. * n_seek_frames / kSeekCount
+        << " frames on average" << std::endl;
+  }
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+  if (argc > 2) {
+    std::cerr << "Usage instructions: " << argv[0] << " [archive]"
+              << std::endl
+              << "  Reports the laps, the compression ratio and the decode"
+              << " throughput of an archive recorded by the --record option of"
+              << " pid. Without an archive, records " << kSessionCount
+              << " tuning sessions of " << kFrameCount << " frames on the"
+              << " offline simulator first." << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::ostringstream oss;
+  TelemetryReader reader;
+  if (argc == 2) {
+    if (!reader.Load(argv[1])) {
+      std::cerr << "Error: failed to load archive " << argv[1] << std::endl;
+      return EXIT_FAILURE;
+    }
+    ReportArchive(reader, std::cout);
+    return EXIT_SUCCESS;
+  }
+
+  // Controllers report every lap, keep the output to the summary
+  auto cout_buffer = std::cout.rdbuf(nullptr);
+  double seconds;
+  auto is_recorded = Record(seconds);
+  AsyncLogger::GetDefault().Flush();
+  std::cout.rdbuf(cout_buffer);
+  if (!is_recorded || !reader.Load(kPath)) {
+    std::cerr << "Error: failed to write " << kPath << std::endl;
+    return EXIT_FAILURE;
+  }
+  oss << std::fixed << "Encode: " << std::setprecision(0)
+      << reader.GetFrameCount() / seconds << " frames/s" << std::endl;
+  ReportArchive(reader, oss);
+  std::cout << oss.str();
+  std::remove(kPath);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "../src/DynamicBicycle.h"
+#include "../src/Robot.h"
+#include "../src/Simulator.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Numbers of vehicles stepped together
+const size_t kVehicleCounts[] = {1, 100, 10000};
+
+// Vehicle steps per measurement
+const auto kStepCount = 2000000;
+
+// Fixed step of the dynamic model in seconds, as in the offline simulator
+const auto kDt = 1. / (Simulator::kFrameRate * Simulator::kDynamicStepCount);
+
+// Speeds in meters-per-second and the front wheel angle of the understeer
+// table
+const double kSpeeds[] = {5., 10., 20., 30., 40., 50.};
+const auto kSteering = 0.02;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the monotonic time in nanoseconds.
+double GetNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Measures the steps per second of kinematic robots, stepped one by one.
+// @param n  Number of vehicles
+// @return   Vehicle steps per second
+double BenchKinematic(size_t n) {
+  std::vector<Robot> robots(n, Robot(2.67));
+  for (size_t i = 0; i < n; ++i) {
+    robots[i].Set(i, 0., 0.);
+  }
+  auto n_rounds = kStepCount / n;
+  auto start = GetNanoseconds();
+  for (size_t round = 0; round < n_rounds; ++round) {
+    for (size_t i = 0; i < n; ++i) {
+      robots[i].Move(0.01 * (i % 5), 20. * kDt);
+    }
+  }
+  auto seconds = (GetNanoseconds() - start) / 1e9;
+  double x, y, yaw;
+  robots[0].Get(x, y, yaw);
+  return std::isfinite(x) ? n_rounds * n / seconds : 0.;
+}
+
+// Measures the steps per second of dynamic vehicles, stepped as a batch.
+// @param n  Number of vehicles
+// @return   Vehicle steps per second
+double BenchDynamic(size_t n) {
+  DynamicBicycle vehicles(DynamicBicycle::GetSedan(), n, kDt);
+  std::vector<double> steering(n);
+  std::vector<double> acceleration(n, 1.);
+  for (size_t i = 0; i < n; ++i) {
+    vehicles.Reset(i, i, 0., 0., 20.);
+    steering[i] = 0.01 * (i % 5);
+  }
+  auto n_rounds = kStepCount / n;
+  auto start = GetNanoseconds();
+  for (size_t round = 0; round < n_rounds; ++round) {
+    vehicles.Step(steering.data(), acceleration.data(), 30.);
+  }
+  auto seconds = (GetNanoseconds() - start) / 1e9;
+  auto x = vehicles.Get(DynamicBicycle::kX)[0];
+  return std::isfinite(x) ? n_rounds * n / seconds : 0.;
+}
+
+// Drives a dynamic vehicle with a constant steering angle at a constant speed
+// until the steady state.
+// @param speed  Speed in meters-per-second
+// @return       Yaw rate in radians-per-second
+double GetSteadyYawRate(double speed) {
+  DynamicBicycle vehicle(DynamicBicycle::GetSedan(), 1, kDt);
+  vehicle.Reset(0, 0., 0., 0., speed);
+  auto steering = kSteering;
+  for (auto step = 0; step < 5000; ++step) {
+    auto acceleration = -vehicle.Get(DynamicBicycle::kVy)[0]
+                        * vehicle.Get(DynamicBicycle::kYawRate)[0];
+    vehicle.Step(&steering, &acceleration, speed);
+  }
+  return vehicle.Get(DynamicBicycle::kYawRate)[0];
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main() {
+  std::ostringstream oss;
+  oss << "Vehicle steps per second on one core, dt " << std::fixed
+      << std::setprecision(0) << 1e3 * kDt << "ms" << std::endl
+      << std::setw(10) << "vehicles" << std::setw(14) << "kinematic"
+      << std::setw(14) << "dynamic RK4" << std::endl;
+  for (auto n : kVehicleCounts) {
+    oss << std::setw(10) << n << std::setprecision(2) << std::scientific
+        << std::setw(14) << BenchKinematic(n) << std::setw(14)
+        << BenchDynamic(n) << std::fixed << std::endl;
+  }
+  auto sedan = DynamicBicycle::GetSedan();
+  auto wheelbase = sedan.front_distance + sedan.rear_distance;
+  oss << std::endl << "Steady yaw rate at " << std::setprecision(2)
+      << kSteering << "rad steering" << std::endl
+      << std::setw(10) << "speed,m/s" << std::setw(14) << "kinematic"
+      << std::setw(14) << "dynamic" << std::setw(10) << "ratio" << std::endl;
+  for (auto speed : kSpeeds) {
+    auto kinematic = speed * std::tan(kSteering) / wheelbase;
+    auto dynamic = GetSteadyYawRate(speed);
+    oss << std::setw(10) << std::setprecision(0) << speed
+        << std::setprecision(4) << std::setw(14) << kinematic
+        << std::setw(14) << dynamic << std::setprecision(3) << std::setw(10)
+        << dynamic / kinematic << std::endl;
+  }
+  std::cout << oss.str();
+  return EXIT_SUCCESS;
+}
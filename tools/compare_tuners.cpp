@@ -0,0 +1,164 @@
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/AsyncLogger.h"
+#include "../src/BayesOptimizer.h"
+#include "../src/PidController.h"
+#include "../src/SuccessiveHalving.h"
+#include "../src/Twiddler.h"
+#include "../src/Simulator.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Initial PID coefficients and their deltas, deliberately poor
+const auto kKp = 0.02;
+const auto kKi = 0.;
+const auto kKd = 0.2;
+const auto kDkp = 0.05;
+const auto kDki = 1e-4;
+const auto kDkd = 1.;
+
+// Track length in meters and the off-track CTE
+const auto kTrackLength = 500.;
+const auto kOffTrackCte = 0.4;
+
+// Max speed, initial CTE, steering drift and noise of the offline vehicle
+const auto kMaxSpeed = 60.;
+const auto kInitialCte = 0.2;
+const auto kSteeringDrift = 2. / 180. * M_PI;
+const auto kSteeringNoise = 0.5 / 180. * M_PI;
+
+// Max laps per tuning session
+const auto kMaxLaps = 300;
+
+// Number of parallel simulators for successive halving
+const auto kHalvingWorkers = 4;
+
+// Number of scenarios, differing by the noise seed
+const auto kScenarioCount = 5;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Tunes the controller on the offline simulator until it reaches the target
+// or the stop flag is set.
+// @param[in]     tuner       Tuner, Twiddler if null
+// @param[in]     parameters  Initial parameters of the tuner
+// @param[in]     seed        Seed of the scenario
+// @param[in,out] stop        Stop flag, set when the target is reached
+// @return                    Distance driven in laps
+double DriveToTarget(std::unique_ptr<Tuner> tuner,
+                     const Tuner::ParameterSequence& parameters,
+                     unsigned int seed, std::atomic<bool>& stop) {
+  PidController controller(parameters[0].p, parameters[1].p, parameters[2].p,
+                           kOffTrackCte, parameters[0].dp, parameters[1].dp,
+                           parameters[2].dp, kTrackLength);
+  if (tuner) {
+    controller.SetTuner(std::move(tuner));
+  }
+  Simulator simulator(kMaxSpeed, kInitialCte, kSteeringDrift, kSteeringNoise,
+                      seed);
+  auto distance = 0.;
+  while (!controller.HasFinalCoefficients() && !stop
+         && distance < kMaxLaps * kTrackLength) {
+    controller.Update(simulator.GetCte(), simulator.GetSpeed(),
+                      [&simulator](double steering, double throttle) {
+                        simulator.Control(steering, throttle);
+                      },
+                      [&simulator, &distance]() {
+                        distance += simulator.GetDistance();
+                        simulator.Reset();
+                      });
+  }
+  if (controller.HasFinalCoefficients()) {
+    stop = true;
+  }
+  return (distance + simulator.GetDistance()) / kTrackLength;
+}
+
+// Tunes the controller until it reaches the target.
+// @param[in] tuner_name  Name of the tuner, twiddle, bayes or halving
+// @param[in] seed        Seed of the scenario
+// @return                Distance driven in laps by all simulators, kMaxLaps
+//                        if no success
+double CountLapsToTarget(const std::string& tuner_name, unsigned int seed) {
+  std::atomic<bool> stop(false);
+  Tuner::ParameterSequence parameters = {
+    {kKp, kDkp, Tuner::Transform::kLinear, 0., 0.},
+    {kKi, kDki, Tuner::Transform::kLinear, 0., 0.},
+    {kKd, kDkd, Tuner::Transform::kLinear, 0., 0.}};
+  if (tuner_name == "twiddle") {
+    return std::min<double>(kMaxLaps, DriveToTarget(nullptr, parameters, seed,
+                                                    stop));
+  }
+  if (tuner_name == "bayes") {
+    return std::min<double>(kMaxLaps, DriveToTarget(
+      std::unique_ptr<Tuner>(new BayesOptimizer(parameters, 0, seed)),
+      parameters, seed, stop));
+  }
+  // Simulators run in parallel, each stops when any reaches the target
+  auto scheduler = std::make_shared<SuccessiveHalving>(parameters, 27, 3, 3,
+                                                       seed);
+  std::vector<double> laps(kHalvingWorkers);
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < kHalvingWorkers; ++i) {
+    threads.emplace_back([&, i]() {
+      std::unique_ptr<SuccessiveHalving::Worker> worker(
+        new SuccessiveHalving::Worker(scheduler));
+      auto initial = worker->GetParameters();
+      laps[i] = DriveToTarget(std::move(worker), initial,
+                              seed * kHalvingWorkers + i, stop);
+    });
+  }
+  auto total = 0.;
+  for (auto i = 0; i < kHalvingWorkers; ++i) {
+    threads[i].join();
+    total += laps[i];
+  }
+  return stop ? std::min<double>(kMaxLaps, total) : kMaxLaps;
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main() {
+  const char* tuners[] = {"twiddle", "bayes", "halving"};
+  const auto n_tuners = sizeof(tuners) / sizeof(tuners[0]);
+  std::ostringstream oss;
+  oss << std::setw(10) << "scenario";
+  for (auto tuner : tuners) {
+    oss << std::setw(10) << tuner;
+  }
+  oss << std::endl << std::fixed << std::setprecision(1);
+  double total[n_tuners] = {};
+  // Controllers report every lap, keep the output to the summary
+  auto cout_buffer = std::cout.rdbuf(nullptr);
+  for (unsigned int seed = 1; seed <= kScenarioCount; ++seed) {
+    oss << std::setw(10) << seed;
+    for (size_t i = 0; i < n_tuners; ++i) {
+      auto laps = CountLapsToTarget(tuners[i], seed);
+      total[i] += laps;
+      oss << std::setw(10) << laps;
+    }
+    oss << std::endl;
+  }
+  AsyncLogger::GetDefault().Flush();
+  std::cout.rdbuf(cout_buffer);
+  oss << std::setw(10) << "mean";
+  for (size_t i = 0; i < n_tuners; ++i) {
+    oss << std::setw(10) << total[i] / kScenarioCount;
+  }
+  oss << std::endl;
+  std::cout << "Laps driven to reach max CTE < " << std::setprecision(3)
+            << 0.65 * kOffTrackCte << " (" << kMaxLaps
+            << " means not reached), halving drives " << kHalvingWorkers
+            << " simulators in parallel" << std::endl << oss.str();
+  return EXIT_SUCCESS;
+}
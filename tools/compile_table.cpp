@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../src/ControlTable.h"
+#include "../src/Mpc.h"
+#include "../src/Pid.h"
+#include "../src/PidController.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Default grid sizes along CTE, change of CTE, sum of CTE, speed
+const uint32_t kGridSize[ControlTable::kDimensions] = {49, 33, 5, 11};
+
+// Ranges of change of CTE, sum of CTE, and speed
+const auto kMaxCteChange = 1.0;
+const auto kMaxCteSum = 2000.0;
+const auto kMaxSpeed = 100.0;
+
+// Range of CTE w.r.t. the off-track CTE
+const auto kCteRangeMargin = 1.2;
+
+// Number of random points for estimating the error and the speed
+const auto kSampleCount = 1000000;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the monotonic time in nanoseconds.
+double GetNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Creates the source controller.
+// @param[in] name           Name of the source, pid or mpc
+// @param[in] kp             Coefficient Kp of PID
+// @param[in] ki             Coefficient Ki of PID
+// @param[in] kd             Coefficient Kd of PID
+// @param[in] off_track_cte  CTE when the vehicle is considered off-track
+// @return                   Source, empty if the name is unknown
+ControlTable::Source CreateSource(const std::string& name,
+                                  double kp, double ki, double kd,
+                                  double off_track_cte) {
+  if (name == "pid") {
+    Pid pid(kp, ki, kd);
+    return [pid, off_track_cte](const double point[], double& steering,
+                                double& throttle) {
+      steering = std::max(-1., std::min(1., pid.Evaluate(point[0], point[2],
+                                                         point[1])));
+      throttle = PidController::ComputeThrottle(point[0], point[3],
+                                                off_track_cte);
+    };
+  }
+  if (name == "mpc") {
+    return [off_track_cte](const double point[], double& steering,
+                           double& throttle) {
+      // Prime the model with the previous CTE, so it sees the change of CTE
+      Mpc mpc(std::numeric_limits<uint64_t>::max());
+      mpc.GetSteering(point[0] - point[1], point[3]);
+      steering = std::max(-1., std::min(1., mpc.GetSteering(point[0],
+                                                            point[3])));
+      throttle = PidController::ComputeThrottle(point[0], point[3],
+                                                off_track_cte);
+    };
+  }
+  return ControlTable::Source();
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+  std::stringstream oss;
+  oss << "Usage instructions: " << argv[0]
+      << " [--source=pid|mpc] [--grid=N,N,N,N] Kp Ki Kd offTrackCte output"
+      << std::endl
+      << "  Samples the source controller over the grid of (CTE, change of"
+      << " CTE, sum of CTE, speed) and writes the table to the output file."
+      << std::endl;
+  std::string source_name("pid");
+  uint32_t size[ControlTable::kDimensions];
+  std::copy(kGridSize, kGridSize + ControlTable::kDimensions, size);
+  std::vector<std::string> args;
+  for (auto i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg.compare(0, 9, "--source=") == 0) {
+      source_name = arg.substr(9);
+    } else if (arg.compare(0, 7, "--grid=") == 0) {
+      std::istringstream iss(arg.substr(7));
+      char comma;
+      iss >> size[0] >> comma >> size[1] >> comma >> size[2] >> comma
+          >> size[3];
+    } else {
+      args.push_back(arg);
+    }
+  }
+  if (args.size() != 5) {
+    std::cerr << oss.str();
+    return EXIT_FAILURE;
+  }
+
+  double kp, ki, kd, off_track_cte;
+  try {
+    kp = std::stod(args[0]);
+    ki = std::stod(args[1]);
+    kd = std::stod(args[2]);
+    off_track_cte = std::stod(args[3]);
+  }
+  catch (const std::exception& e) {
+    std::cerr << "Error: invalid data format: " << e.what() << std::endl
+              << oss.str();
+    return EXIT_FAILURE;
+  }
+  auto source = CreateSource(source_name, kp, ki, kd, off_track_cte);
+  if (!source || !(off_track_cte > 0)) {
+    std::cerr << "Error: invalid source or offTrackCte" << std::endl
+              << oss.str();
+    return EXIT_FAILURE;
+  }
+
+  auto max_cte = kCteRangeMargin * off_track_cte;
+  ControlTable::Grid grid = {{-max_cte, -kMaxCteChange, -kMaxCteSum, 0},
+                             {max_cte, kMaxCteChange, kMaxCteSum, kMaxSpeed},
+                             {size[0], size[1], size[2], size[3]}};
+  auto start = GetNanoseconds();
+  if (!ControlTable::Compile(args[4], grid, source)) {
+    std::cerr << "Error: failed to compile table " << args[4] << std::endl;
+    return EXIT_FAILURE;
+  }
+  ControlTable table;
+  if (!table.Load(args[4])) {
+    std::cerr << "Error: failed to load table " << args[4] << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Compiled " << source_name << " table " << size[0] << "x"
+            << size[1] << "x" << size[2] << "x" << size[3] << " of "
+            << table.GetSize() << " bytes in "
+            << (GetNanoseconds() - start) / 1e6 << "ms" << std::endl;
+
+  // Compare with the source at random points within the grid
+  std::mt19937 rng(1);
+  std::vector<double> points(ControlTable::kDimensions * kSampleCount);
+  for (size_t i = 0; i < points.size(); ++i) {
+    auto d = i % ControlTable::kDimensions;
+    points[i] = std::uniform_real_distribution<double>(grid.min[d],
+                                                       grid.max[d])(rng);
+  }
+  auto n_source_samples = source_name == "pid" ? kSampleCount
+                                               : kSampleCount / 100;
+  auto max_steering_error = 0.;
+  auto max_throttle_error = 0.;
+  auto sum_steering_error = 0.;
+  auto sum_throttle_error = 0.;
+  volatile double sink = 0;
+  start = GetNanoseconds();
+  for (auto i = 0; i < n_source_samples; ++i) {
+    double steering, throttle;
+    source(&points[ControlTable::kDimensions * i], steering, throttle);
+    sink = sink + steering + throttle;
+  }
+  auto source_ns = (GetNanoseconds() - start) / n_source_samples;
+  start = GetNanoseconds();
+  for (auto i = 0; i < kSampleCount; ++i) {
+    const auto* p = &points[ControlTable::kDimensions * i];
+    double steering, throttle;
+    table.Evaluate(p[0], p[1], p[2], p[3], steering, throttle);
+    sink = sink + steering + throttle;
+  }
+  auto table_ns = (GetNanoseconds() - start) / kSampleCount;
+  for (auto i = 0; i < n_source_samples; ++i) {
+    const auto* p = &points[ControlTable::kDimensions * i];
+    double steering, throttle, table_steering, table_throttle;
+    source(p, steering, throttle);
+    table.Evaluate(p[0], p[1], p[2], p[3], table_steering, table_throttle);
+    auto steering_error = std::fabs(steering - table_steering);
+    auto throttle_error = std::fabs(throttle - table_throttle);
+    max_steering_error = std::max(max_steering_error, steering_error);
+    max_throttle_error = std::max(max_throttle_error, throttle_error);
+    sum_steering_error += steering_error;
+    sum_throttle_error += throttle_error;
+  }
+  std::cout << "Steering error: max " << max_steering_error << ", mean "
+            << sum_steering_error / n_source_samples << std::endl
+            << "Throttle error: max " << max_throttle_error << ", mean "
+            << sum_throttle_error / n_source_samples << std::endl
+            << "Per-frame time: source " << source_ns << "ns, table "
+            << table_ns << "ns, speedup " << source_ns / table_ns << "x"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <uWS/uWS.h>
+#include "../src/NetworkImpairment.h"
+#include "../src/SocketIo.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Default TCP port accepting the simulator, and the URL of pid
+enum { kTcpPort = 4568 };
+const char kUpstreamUrl[] = "ws://127.0.0.1:4567";
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Proxied connection of a simulator to pid. Messages in flight each way share
+// one channel, so they keep the order of sending: the events, such as
+// telemetry and steering, are impaired, the Socket.IO handshake and
+// heartbeats are only delayed, as dropping them would stall the session rather
+// than lose a frame.
+struct Link {
+  // Constructor.
+  // @param client    Connection of the simulator
+  // @param settings  Settings of both ways
+  // @param seed      Seed of the random generators
+  Link(uWS::WebSocket<uWS::SERVER> client,
+       const NetworkImpairment::Settings& settings,
+       unsigned int seed)
+    : client(client),
+      is_client_open(true),
+      is_server_open(false),
+      is_connecting(true),
+      up(settings, 2 * seed),
+      down(settings, 2 * seed + 1) {
+    // Empty.
+  }
+
+  // Connections of the simulator and of pid, whether they are open, and
+  // whether pid is being connected
+  uWS::WebSocket<uWS::SERVER> client;
+  uWS::WebSocket<uWS::CLIENT> server;
+  bool is_client_open;
+  bool is_server_open;
+  bool is_connecting;
+  // Messages to pid and to the simulator
+  ImpairedChannel<std::string> up;
+  ImpairedChannel<std::string> down;
+};
+
+// Links and the timer delivering their messages
+struct Proxy {
+  std::set<Link*> links;
+  uS::Timer* timer;
+  // Delivery time the timer is armed for, infinity if it's stopped
+  double armed_delivery;
+};
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the monotonic time in seconds.
+double GetSeconds() {
+  return std::chrono::duration_cast<std::chrono::duration<double>>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Sends a message over a channel, impairing only the events.
+// @param[in,out] channel  Channel
+// @param[in]     data     Message
+// @param[in]     length   Length of the message
+void Send(ImpairedChannel<std::string>& channel, const char* data,
+          size_t length) {
+  channel.Send(GetSeconds(), std::string(data, length),
+               SocketIo::IsEvent(data, length));
+}
+
+// Gets the delivery time of the next message of a link, which can be sent.
+// Messages to pid wait until it accepts the connection.
+// @param[in] link  Link
+// @return          Delivery time in seconds, or infinity if none
+double GetNextDelivery(const Link& link) {
+  return std::min(link.is_server_open ? link.up.GetNextDelivery() : HUGE_VAL,
+                  link.is_client_open ? link.down.GetNextDelivery() :
+                                        HUGE_VAL);
+}
+
+void Deliver(uS::Timer* timer);
+
+// Arms the timer for a delivery, unless it's armed earlier. Timers of the loop
+// count whole milliseconds, so the delivery time is rounded up: a message
+// arrives up to 1ms later than the model, e.g. sweep_latency, delivers it.
+// @param[in,out] proxy     Proxy
+// @param[in]     delivery  Delivery time in seconds, may be infinity
+void Arm(Proxy& proxy, double delivery) {
+  if (delivery >= proxy.armed_delivery) {
+    return;
+  }
+  proxy.timer->stop();
+  proxy.armed_delivery = delivery;
+  auto timeout = std::ceil((delivery - GetSeconds()) * 1000.);
+  proxy.timer->start(Deliver, static_cast<int>(std::max(0., timeout)), 0);
+}
+
+// Delivers the messages in flight, which are due, on all links, then arms the
+// timer for the next delivery.
+// @param[in] timer  Delivery timer, its data is the proxy
+void Deliver(uS::Timer* timer) {
+  auto& proxy = *static_cast<Proxy*>(timer->getData());
+  proxy.armed_delivery = HUGE_VAL;
+  auto time = GetSeconds();
+  auto next_delivery = HUGE_VAL;
+  std::vector<std::string> messages;
+  for (auto link : proxy.links) {
+    if (link->is_server_open) {
+      messages.clear();
+      link->up.Receive(time, messages);
+      for (const auto& message : messages) {
+        link->server.send(message.data(), message.length(),
+                          uWS::OpCode::TEXT);
+      }
+    }
+    if (link->is_client_open) {
+      messages.clear();
+      link->down.Receive(time, messages);
+      for (const auto& message : messages) {
+        link->client.send(message.data(), message.length(),
+                          uWS::OpCode::TEXT);
+      }
+    }
+    next_delivery = std::min(next_delivery, GetNextDelivery(*link));
+  }
+  if (next_delivery < HUGE_VAL) {
+    Arm(proxy, next_delivery);
+  }
+}
+
+// Closes a side of a link, and deletes the link once both sides are closed.
+// A link connecting to pid is kept until the connection completes or fails.
+// @param[in,out] links  Links
+// @param[in]     link   Link
+void Close(std::set<Link*>& links, Link* link) {
+  if (link->is_client_open) {
+    link->client.close();
+  } else if (link->is_server_open) {
+    link->server.close();
+  } else if (!link->is_connecting) {
+    links.erase(link);
+    delete link;
+  }
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+  std::stringstream oss;
+  oss << "Usage instructions: " << argv[0]
+      << " [--port=N] [--upstream=url] [--latency=ms] [--jitter=ms]"
+      << " [--distribution=constant|uniform|normal|exponential|pareto]"
+      << " [--reorder=rate] [--drop=rate] [--seed=N]" << std::endl
+      << "  Proxies the simulator connections from the port, default is "
+      << kTcpPort << ", to pid at the upstream URL, default is "
+      << kUpstreamUrl << ", impairing the messages each way like a slow"
+      << " network: delayed by the latency plus jitter of the mean and the"
+      << " distribution, default is exponential, reordered and dropped at"
+      << " the rates. Only Socket.IO events are reordered and dropped, the"
+      << " other messages keep their order. Deliveries are rounded up to"
+      << " whole milliseconds of the event loop timer. The simulator connects"
+      << " to the port instead of pid. sweep_latency drives the same"
+      << " impairment offline." << std::endl;
+  int port = kTcpPort;
+  std::string upstream_url = kUpstreamUrl;
+  NetworkImpairment::Settings settings = {
+    0., 0., NetworkImpairment::Distribution::kExponential, 0., 0.};
+  unsigned int seed = 1;
+  try {
+    for (auto i = 1; i < argc; ++i) {
+      std::string arg(argv[i]);
+      if (arg.compare(0, 7, "--port=") == 0) {
+        port = std::stoi(arg.substr(7));
+      } else if (arg.compare(0, 11, "--upstream=") == 0) {
+        upstream_url = arg.substr(11);
+      } else if (arg.compare(0, 10, "--latency=") == 0) {
+        settings.latency = std::stod(arg.substr(10)) / 1000.;
+      } else if (arg.compare(0, 9, "--jitter=") == 0) {
+        settings.jitter = std::stod(arg.substr(9)) / 1000.;
+      } else if (arg.compare(0, 15, "--distribution=") == 0) {
+        if (!NetworkImpairment::GetDistribution(arg.substr(15),
+                                                settings.distribution)) {
+          throw std::invalid_argument("unknown distribution "
+                                      + arg.substr(15));
+        }
+      } else if (arg.compare(0, 10, "--reorder=") == 0) {
+        settings.reorder_rate = std::stod(arg.substr(10));
+      } else if (arg.compare(0, 7, "--drop=") == 0) {
+        settings.drop_rate = std::stod(arg.substr(7));
+      } else if (arg.compare(0, 7, "--seed=") == 0) {
+        seed = std::stoul(arg.substr(7));
+      } else {
+        throw std::invalid_argument("unknown option " + arg);
+      }
+    }
+  }
+  catch (const std::exception& e) {
+    std::cerr << "Error: invalid data format: " << e.what() << std::endl
+              << oss.str();
+    return EXIT_FAILURE;
+  }
+
+  uWS::Hub hub;
+  // Messages in flight are delivered by a timer armed for the next one
+  Proxy proxy;
+  proxy.timer = new uS::Timer(hub.getLoop());
+  proxy.timer->setData(&proxy);
+  proxy.armed_delivery = HUGE_VAL;
+  hub.onConnection([&hub, &proxy, &settings, &seed, &upstream_url](
+                     uWS::WebSocket<uWS::SERVER> ws,
+                     uWS::HttpRequest request) {
+    // The path and query of the simulator pass through, e.g. ?steering=
+    auto link = new Link(ws, settings, seed++);
+    proxy.links.insert(link);
+    ws.setUserData(link);
+    hub.connect(upstream_url + request.getUrl().toString(), link);
+  });
+
+  hub.onConnection([&proxy](uWS::WebSocket<uWS::CLIENT> ws,
+                            uWS::HttpRequest request) {
+    auto link = static_cast<Link*>(ws.getUserData());
+    link->server = ws;
+    link->is_server_open = true;
+    link->is_connecting = false;
+    // The simulator left while connecting
+    if (!link->is_client_open) {
+      ws.close();
+      return;
+    }
+    Arm(proxy, link->up.GetNextDelivery());
+  });
+
+  hub.onError([&proxy](void* user) {
+    auto link = static_cast<Link*>(user);
+    std::cerr << "Failed to connect to pid" << std::endl;
+    link->is_connecting = false;
+    Close(proxy.links, link);
+  });
+
+  hub.onMessage([&proxy](uWS::WebSocket<uWS::SERVER> ws,
+                         char* data,
+                         size_t length,
+                         uWS::OpCode opCode) {
+    auto link = static_cast<Link*>(ws.getUserData());
+    Send(link->up, data, length);
+    if (link->is_server_open) {
+      Arm(proxy, link->up.GetNextDelivery());
+    }
+  });
+
+  hub.onMessage([&proxy](uWS::WebSocket<uWS::CLIENT> ws,
+                         char* data,
+                         size_t length,
+                         uWS::OpCode opCode) {
+    auto link = static_cast<Link*>(ws.getUserData());
+    Send(link->down, data, length);
+    if (link->is_client_open) {
+      Arm(proxy, link->down.GetNextDelivery());
+    }
+  });
+
+  hub.onDisconnection([&proxy](uWS::WebSocket<uWS::SERVER> ws,
+                               int code,
+                               char* message,
+                               size_t length) {
+    auto link = static_cast<Link*>(ws.getUserData());
+    link->is_client_open = false;
+    Close(proxy.links, link);
+  });
+
+  hub.onDisconnection([&proxy](uWS::WebSocket<uWS::CLIENT> ws,
+                               int code,
+                               char* message,
+                               size_t length) {
+    auto link = static_cast<Link*>(ws.getUserData());
+    link->is_server_open = false;
+    Close(proxy.links, link);
+  });
+
+  if (hub.listen(port)) {
+    std::cout << "Listening on port " << port << ", proxying to "
+              << upstream_url << std::endl;
+  } else {
+    std::cerr << "Failed to listen on port " << port << std::endl;
+    return -1;
+  }
+
+  hub.run();
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../src/OffsetProfile.h"
+#include "../src/RacingLine.h"
+#include "../src/Track.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Default bucket length and max offset from the centerline in meters
+const auto kBucketLength = 5.;
+const auto kMaxOffset = 1.5;
+
+// Default max number of gradient steps
+const auto kIterations = 500;
+
+// Limits of the vehicle: max speed of 100mph, accelerations in
+// meters-per-second^2
+const auto kMaxSpeed = 100. * 1609.344 / (60. * 60.);
+const auto kMaxLateralAcceleration = 8.;
+const auto kMaxAcceleration = 6.;
+const auto kMaxDeceleration = 8.;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the monotonic time in nanoseconds.
+double GetNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+  std::stringstream oss;
+  oss << "Usage instructions: " << argv[0]
+      << " [--bucket-m=X] [--max-offset-m=X] [--iterations=N] [--threads=N]"
+      << " track output" << std::endl
+      << "  Optimizes the minimum-time racing line over the closed"
+      << " centerline through the control points of the track file, a point"
+      << " \"x,y\" per line, and writes the target offset from the"
+      << " centerline of every distance bucket as CSV to the output file,"
+      << " for the --offset-profile option of pid. Defaults are "
+      << kBucketLength << "m buckets, " << kMaxOffset << "m max offset, "
+      << kIterations << " iterations, all hardware threads." << std::endl;
+  RacingLine::Settings settings = {
+    kBucketLength,
+    kMaxOffset,
+    kMaxSpeed,
+    kMaxLateralAcceleration,
+    kMaxAcceleration,
+    kMaxDeceleration};
+  unsigned int iterations = kIterations;
+  unsigned int n_threads = 0;
+  std::vector<std::string> args;
+  try {
+    for (auto i = 1; i < argc; ++i) {
+      std::string arg(argv[i]);
+      if (arg.compare(0, 11, "--bucket-m=") == 0) {
+        settings.bucket_length = std::stod(arg.substr(11));
+      } else if (arg.compare(0, 15, "--max-offset-m=") == 0) {
+        settings.max_offset = std::stod(arg.substr(15));
+      } else if (arg.compare(0, 13, "--iterations=") == 0) {
+        iterations = std::stoul(arg.substr(13));
+      } else if (arg.compare(0, 10, "--threads=") == 0) {
+        n_threads = std::stoul(arg.substr(10));
+      } else {
+        args.push_back(arg);
+      }
+    }
+  }
+  catch (const std::exception& e) {
+    std::cerr << "Error: invalid data format: " << e.what() << std::endl
+              << oss.str();
+    return EXIT_FAILURE;
+  }
+  if (args.size() != 2 || !(settings.bucket_length > 0)
+      || !(settings.max_offset >= 0)) {
+    std::cerr << oss.str();
+    return EXIT_FAILURE;
+  }
+
+  Track track;
+  if (!track.Load(args[0])) {
+    std::cerr << "Error: failed to load track " << args[0] << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  RacingLine line(track, settings);
+  auto center_time = line.GetLapTime();
+  auto start = GetNanoseconds();
+  auto n_steps = line.Optimize(iterations, n_threads);
+  auto seconds = (GetNanoseconds() - start) / 1e9;
+
+  OffsetProfile profile;
+  if (!profile.SetOffsets(line.GetBucketLength(), line.GetOffsets())
+      || !profile.Save(args[1])) {
+    std::cerr << "Error: failed to write " << args[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+  const auto& offsets = line.GetOffsets();
+  auto max_offset = 0.;
+  for (auto offset : offsets) {
+    max_offset = std::max(max_offset, std::fabs(offset));
+  }
+  std::cout << "Optimized " << offsets.size() << " buckets of " << std::fixed
+            << std::setprecision(2) << line.GetBucketLength() << "m over "
+            << track.GetLength() << "m by " << n_steps << " steps in "
+            << seconds << "s" << std::endl
+            << "Lap time: centerline " << std::setprecision(3) << center_time
+            << "s, racing line " << line.GetLapTime() << "s, "
+            << std::setprecision(1)
+            << 100. * (1. - line.GetLapTime() / center_time) << "% faster, "
+            << "max offset " << std::setprecision(2) << max_offset << "m"
+            << std::endl
+            << "Profile written to " << args[1] << std::endl;
+  return EXIT_SUCCESS;
+}
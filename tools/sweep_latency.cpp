@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/LapStatistics.h"
+#include "../src/NetworkImpairment.h"
+#include "../src/Pid.h"
+#include "../src/PidController.h"
+#include "../src/Track.h"
+#include "../src/Simulator.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Final PID coefficients, as tuned offline
+const auto kKp = 0.12;
+const auto kKi = 1e-5;
+const auto kKd = 4.0;
+
+// Length in meters of the straight track, and the off-track CTE as pid by
+// default
+const auto kTrackLength = 1000.;
+const auto kOffTrackCte = 5.;
+
+// Max speed, initial CTE, steering drift and noise of the offline vehicle
+const auto kMaxSpeed = 50.;
+const auto kInitialCte = 1.;
+const auto kSteeringDrift = 1. / 180. * M_PI;
+const auto kSteeringNoise = 0.5 / 180. * M_PI;
+
+// Default one-way latencies in milliseconds and number of laps per latency
+const std::vector<double> kLatencies = {0., 10., 20., 40., 60., 80., 100.,
+                                        150., 200.};
+const auto kRunCount = 8;
+
+// Local Types
+// -----------------------------------------------------------------------------
+
+// Telemetry message of the simulator
+struct Telemetry {
+  double cte;
+  double speed;
+};
+
+// Steering message of pid
+struct Command {
+  double steering;
+  double throttle;
+};
+
+// Outcome of a lap
+struct Lap {
+  bool is_complete;
+  double time;
+  double max_cte;
+  double average_cte;
+};
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Drives a lap with the final coefficients on the offline simulator, while
+// the telemetry and the steering messages cross impaired links. The
+// simulator keeps applying the latest steering message it received, like
+// the real one, and pid answers every telemetry message when it arrives.
+// @param[in]  track     Track, nullptr for the straight one
+// @param[in]  model     Vehicle model
+// @param[in]  settings  Settings of both links
+// @param[in]  seed      Seed of the vehicle noise and of the links
+// @param[out] lap       Outcome of the lap
+void DriveLap(const Track* track,
+              Simulator::Model model,
+              const NetworkImpairment::Settings& settings,
+              unsigned int seed,
+              Lap& lap) {
+  Pid pid(kKp, kKi, kKd);
+  Simulator simulator(kMaxSpeed, kInitialCte, kSteeringDrift, kSteeringNoise,
+                      seed, track, model);
+  LapStatistics statistics(kOffTrackCte,
+                           track ? track->GetLength() : kTrackLength);
+  ImpairedChannel<Telemetry> uplink(settings, 2 * seed);
+  ImpairedChannel<Command> downlink(settings, 2 * seed + 1);
+  std::vector<Telemetry> telemetry;
+  std::vector<double> deliveries;
+  std::vector<Command> commands;
+  Command command = {0., 0.};
+  auto status = LapStatistics::Status::kDriving;
+  for (auto frame = 0ul; ; ++frame) {
+    auto time = frame / Simulator::kFrameRate;
+    auto cte = simulator.GetCte();
+    auto speed = simulator.GetSpeed();
+    status = statistics.Update(cte, speed);
+    if (status != LapStatistics::Status::kDriving) {
+      break;
+    }
+    uplink.Send(time, {cte, speed});
+
+    // pid answers at the delivery of every telemetry message
+    telemetry.clear();
+    deliveries.clear();
+    uplink.Receive(time, telemetry, &deliveries);
+    for (size_t i = 0; i < telemetry.size(); ++i) {
+      auto steering = std::max(-1., std::min(1., pid.GetSteering(
+        telemetry[i].cte, telemetry[i].speed)));
+      downlink.Send(deliveries[i], {steering, PidController::ComputeThrottle(
+        telemetry[i].cte, telemetry[i].speed, kOffTrackCte)});
+    }
+
+    commands.clear();
+    if (downlink.Receive(time, commands) > 0) {
+      command = commands.back();
+    }
+    statistics.AddSteering(command.steering);
+    simulator.Control(command.steering, command.throttle);
+  }
+  lap = {status == LapStatistics::Status::kComplete, statistics.GetTime(),
+         statistics.GetMaxAbsoluteCte(), statistics.GetAverageCte()};
+}
+
+// Parses a comma-separated list of numbers.
+// @param text  List
+// @return      Numbers
+std::vector<double> ParseList(const std::string& text) {
+  std::vector<double> values;
+  std::istringstream iss(text);
+  std::string value;
+  while (std::getline(iss, value, ',')) {
+    values.push_back(std::stod(value));
+  }
+  return values;
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+  std::stringstream oss;
+  oss << "Usage instructions: " << argv[0]
+      << " [--latencies=ms,ms..] [--jitter=ms]"
+      << " [--distribution=constant|uniform|normal|exponential|pareto]"
+      << " [--reorder=rate] [--drop=rate] [--runs=N] [--track=path]"
+      << " [--model=kinematic|dynamic] [output]" << std::endl
+      << "  Drives laps with the final PID coefficients on the offline"
+      << " simulator while the telemetry and steering messages cross links"
+      << " impaired like by impair_proxy: each way delayed by the latency"
+      << " plus jitter of the mean and the distribution, reordered and"
+      << " dropped at the rates. Prints the max CTE and the lap time against"
+      << " the one-way latency, and writes them as CSV to the output file."
+      << std::endl;
+  auto latencies = kLatencies;
+  NetworkImpairment::Settings settings = {
+    0., 0., NetworkImpairment::Distribution::kExponential, 0., 0.};
+  auto n_runs = kRunCount;
+  std::string track_path;
+  auto model = Simulator::Model::kKinematic;
+  std::vector<std::string> args;
+  try {
+    for (auto i = 1; i < argc; ++i) {
+      std::string arg(argv[i]);
+      if (arg.compare(0, 12, "--latencies=") == 0) {
+        latencies = ParseList(arg.substr(12));
+      } else if (arg.compare(0, 9, "--jitter=") == 0) {
+        settings.jitter = std::stod(arg.substr(9)) / 1000.;
+      } else if (arg.compare(0, 15, "--distribution=") == 0) {
+        if (!NetworkImpairment::GetDistribution(arg.substr(15),
+                                                settings.distribution)) {
+          throw std::invalid_argument("unknown distribution "
+                                      + arg.substr(15));
+        }
+      } else if (arg.compare(0, 10, "--reorder=") == 0) {
+        settings.reorder_rate = std::stod(arg.substr(10));
+      } else if (arg.compare(0, 7, "--drop=") == 0) {
+        settings.drop_rate = std::stod(arg.substr(7));
+      } else if (arg.compare(0, 7, "--runs=") == 0) {
+        n_runs = std::stoi(arg.substr(7));
+      } else if (arg.compare(0, 8, "--track=") == 0) {
+        track_path = arg.substr(8);
+      } else if (arg == "--model=kinematic") {
+        model = Simulator::Model::kKinematic;
+      } else if (arg == "--model=dynamic") {
+        model = Simulator::Model::kDynamic;
+      } else if (arg.compare(0, 8, "--model=") == 0) {
+        throw std::invalid_argument("unknown model " + arg.substr(8));
+      } else {
+        args.push_back(arg);
+      }
+    }
+  }
+  catch (const std::exception& e) {
+    std::cerr << "Error: invalid data format: " << e.what() << std::endl
+              << oss.str();
+    return EXIT_FAILURE;
+  }
+  if (args.size() > 1 || latencies.empty() || n_runs < 1) {
+    std::cerr << oss.str();
+    return EXIT_FAILURE;
+  }
+
+  Track track;
+  if (!track_path.empty() && !track.Load(track_path)) {
+    std::cerr << "Error: failed to load track " << track_path << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream file;
+  if (!args.empty()) {
+    file.open(args[0]);
+    file << "latency_ms,complete_laps,lap_time_s,max_cte,worst_max_cte,"
+         << "average_cte" << std::endl;
+  }
+  std::cout << std::setw(10) << "latency" << std::setw(10) << "laps"
+            << std::setw(10) << "time,s" << std::setw(10) << "max CTE"
+            << std::setw(10) << "worst" << std::setw(10) << "avg CTE"
+            << std::endl;
+  for (auto latency : latencies) {
+    settings.latency = latency / 1000.;
+    // Lap time over the complete laps, CTE over all laps
+    auto n_complete = 0;
+    auto time = 0.;
+    auto max_cte = 0.;
+    auto worst_max_cte = 0.;
+    auto average_cte = 0.;
+    for (auto run = 1; run <= n_runs; ++run) {
+      Lap lap;
+      DriveLap(track.IsLoaded() ? &track : nullptr, model, settings, run,
+               lap);
+      if (lap.is_complete) {
+        ++n_complete;
+        time += lap.time;
+      }
+      max_cte += lap.max_cte / n_runs;
+      worst_max_cte = std::max(worst_max_cte, lap.max_cte);
+      average_cte += lap.average_cte / n_runs;
+    }
+    time = n_complete > 0 ? time / n_complete : NAN;
+
+    std::cout << std::fixed << std::setprecision(0) << std::setw(10)
+              << latency << std::setw(7) << n_complete << '/'
+              << std::left << std::setw(2) << n_runs << std::right
+              << std::setprecision(3) << std::setw(10) << time
+              << std::setw(10) << max_cte << std::setw(10) << worst_max_cte
+              << std::setw(10) << average_cte << std::endl;
+    if (file.is_open()) {
+      file << latency << ',' << n_complete << ',' << time << ',' << max_cte
+           << ',' << worst_max_cte << ',' << average_cte << std::endl;
+    }
+  }
+  if (file.is_open() && !file) {
+    std::cerr << "Error: failed to write " << args[0] << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
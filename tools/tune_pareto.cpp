@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/LapStatistics.h"
+#include "../src/Nsga2.h"
+#include "../src/Pid.h"
+#include "../src/PidController.h"
+#include "../src/Track.h"
+#include "../src/Simulator.h"
+
+// Local Constants
+// -----------------------------------------------------------------------------
+
+// Initial PID coefficients and their deltas, the search box is 10 deltas
+const auto kKp = 0.12;
+const auto kKi = 1e-5;
+const auto kKd = 4.0;
+const auto kDkp = 0.01;
+const auto kDki = 1e-5;
+const auto kDkd = 0.4;
+
+// Default population size and number of generations
+const auto kPopulation = 64;
+const auto kGenerations = 40;
+
+// Length in meters of the straight track and the off-track CTE
+const auto kTrackLength = 1000.;
+const auto kOffTrackCte = 2.;
+
+// Max speed, initial CTE, steering drift and noise of the offline vehicle,
+// the throttle of PidController keeps the speed below the max one
+const auto kMaxSpeed = 100.;
+const auto kInitialCte = 1.;
+const auto kSteeringDrift = 1. / 180. * M_PI;
+const auto kSteeringNoise = 0.5 / 180. * M_PI;
+
+// Local Helper-Functions
+// -----------------------------------------------------------------------------
+
+// Gets the monotonic time in nanoseconds.
+double GetNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Drives a lap with PID coefficients on the offline simulator. Every call
+// drives the same scenario, so the coefficients are compared fairly.
+// @param[in]  track       Track, nullptr for the straight one
+// @param[in]  model       Vehicle model
+// @param[in]  parameters  Coefficients Kp, Ki, Kd
+// @param[out] objectives  Lap time in seconds, max absolute CTE, steering
+//                         effort
+// @param[out] violation   Part of the lap not driven when getting off track
+void DriveLap(const Track* track,
+              Simulator::Model model,
+              const Tuner::ParameterSequence& parameters,
+              std::vector<double>& objectives,
+              double& violation) {
+  Pid pid(parameters[0].p, parameters[1].p, parameters[2].p);
+  Simulator simulator(kMaxSpeed, kInitialCte, kSteeringDrift, kSteeringNoise,
+                      1, track, model);
+  auto track_length = track ? track->GetLength() : kTrackLength;
+  LapStatistics statistics(kOffTrackCte, track_length);
+  auto status = LapStatistics::Status::kDriving;
+  while (status == LapStatistics::Status::kDriving) {
+    auto cte = simulator.GetCte();
+    auto speed = simulator.GetSpeed();
+    status = statistics.Update(cte, speed);
+    auto steering = std::max(-1., std::min(1., pid.GetSteering(cte, speed)));
+    statistics.AddSteering(steering);
+    simulator.Control(steering, PidController::ComputeThrottle(
+      cte, speed, kOffTrackCte));
+  }
+  objectives = {statistics.GetTime(), statistics.GetMaxAbsoluteCte(),
+                statistics.GetSteeringEffort()};
+  violation = status == LapStatistics::Status::kOffTrack ?
+              1. - statistics.GetDistance() / track_length : 0.;
+}
+
+// main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+  std::stringstream oss;
+  oss << "Usage instructions: " << argv[0]
+      << " [--population=N] [--generations=N] [--threads=N] [--track=path]"
+      << " [--model=kinematic|dynamic] output" << std::endl
+      << "  Tunes PID coefficients on the offline simulator by NSGA-II,"
+      << " minimizing lap time, max CTE and steering effort, and writes"
+      << " the Pareto front as CSV to the output file. Laps are driven on"
+      << " a straight track, or on the closed centerline through the"
+      << " control points of the track file, a point \"x,y\" per line,"
+      << " by the kinematic vehicle, or by the dynamic one with tire slip"
+      << " and steering lag, for tuning at high speed." << std::endl;
+  size_t population = kPopulation;
+  auto generations = kGenerations;
+  unsigned int n_threads = 0;
+  std::string track_path;
+  auto model = Simulator::Model::kKinematic;
+  std::vector<std::string> args;
+  try {
+    for (auto i = 1; i < argc; ++i) {
+      std::string arg(argv[i]);
+      if (arg.compare(0, 13, "--population=") == 0) {
+        population = std::stoul(arg.substr(13));
+      } else if (arg.compare(0, 14, "--generations=") == 0) {
+        generations = std::stoi(arg.substr(14));
+      } else if (arg.compare(0, 10, "--threads=") == 0) {
+        n_threads = std::stoul(arg.substr(10));
+      } else if (arg.compare(0, 8, "--track=") == 0) {
+        track_path = arg.substr(8);
+      } else if (arg == "--model=kinematic") {
+        model = Simulator::Model::kKinematic;
+      } else if (arg == "--model=dynamic") {
+        model = Simulator::Model::kDynamic;
+      } else if (arg.compare(0, 8, "--model=") == 0) {
+        throw std::invalid_argument("unknown model " + arg.substr(8));
+      } else {
+        args.push_back(arg);
+      }
+    }
+  }
+  catch (const std::exception& e) {
+    std::cerr << "Error: invalid data format: " << e.what() << std::endl
+              << oss.str();
+    return EXIT_FAILURE;
+  }
+  if (args.size() != 1) {
+    std::cerr << oss.str();
+    return EXIT_FAILURE;
+  }
+
+  Track track;
+  if (!track_path.empty() && !track.Load(track_path)) {
+    std::cerr << "Error: failed to load track " << track_path << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  auto start = GetNanoseconds();
+  Nsga2 nsga2({{kKp, kDkp, Tuner::Transform::kLinear, 0., 0.},
+               {kKi, kDki, Tuner::Transform::kLinear, 0., 0.},
+               {kKd, kDkd, Tuner::Transform::kLinear, 0., 0.}},
+              population,
+              std::bind(DriveLap, track.IsLoaded() ? &track : nullptr, model,
+                        std::placeholders::_1, std::placeholders::_2,
+                        std::placeholders::_3),
+              n_threads);
+  nsga2.Initialize();
+  for (auto generation = 0; generation < generations; ++generation) {
+    nsga2.Evolve();
+  }
+  auto seconds = (GetNanoseconds() - start) / 1e9;
+  auto front = nsga2.GetFront();
+
+  std::ofstream file(args[0]);
+  Nsga2::WriteCsv(file, front, {"kp", "ki", "kd"},
+                  {"lap_time_s", "max_cte", "steering_effort"});
+  if (!file) {
+    std::cerr << "Error: failed to write " << args[0] << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Evaluated " << nsga2.GetEvaluationCount() << " laps in "
+            << std::fixed << std::setprecision(2) << seconds << "s, "
+            << front.size() << " coefficients on the Pareto front written to "
+            << args[0] << std::endl
+            << std::setw(10) << "Kp" << std::setw(12) << "Ki" << std::setw(10)
+            << "Kd" << std::setw(10) << "time,s" << std::setw(10) << "max CTE"
+            << std::setw(10) << "effort" << std::endl;
+  for (const auto& individual : front) {
+    const auto& p = individual.parameters;
+    const auto& f = individual.objectives;
+    std::cout << std::setprecision(4) << std::setw(10) << p[0].p
+              << std::scientific << std::setprecision(2) << std::setw(12)
+              << p[1].p << std::fixed << std::setprecision(3) << std::setw(10)
+              << p[2].p << std::setw(10) << f[0] << std::setw(10) << f[1]
+              << std::setprecision(4) << std::setw(10) << f[2] << std::endl;
+  }
+  return EXIT_SUCCESS;
+}